@@ -0,0 +1,372 @@
+/*
+    cpubudget.c:
+
+    Copyright (C) 2026 The Csound Developers
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+/* Voice management under --cpu-budget.
+ *
+ * kperf times the instrument part of every k-cycle; the rolling load is
+ * that time as a fraction of the k-period, rising quickly and falling
+ * slowly.  Every CPUBUDGET_COST_PERIOD k-cycles each instance is timed
+ * too (under -j the DAG does it), giving running means per instance
+ * and per instrument, and for the quietest policy the power each
+ * instance adds to the output.
+ *
+ * A new voice is costed at its instrument's mean, or the mean of all
+ * instances if the instrument has not been measured yet.  If the load
+ * plus the voices started since the last measurement would go over the
+ * budget, the refuse policy drops the voice; the steal policies let it
+ * start and, before the instruments of the next k-cycle run, turn off
+ * older voices of no higher cpuprio, lowest cpuprio first, until their
+ * cost covers the excess.  The skip policy starts every voice, and while
+ * the load is over budget stops performing the instruments of the lowest
+ * cpuprio, one level at a time.
+ */
+
+#include "csoundCore.h"
+#include "cpubudget.h"
+#include <limits.h>
+
+#define CPUBUDGET_COST_PERIOD (16)      /* k-cycles between costings */
+#define CPUBUDGET_HOLD        (0.1)     /* seconds between skip changes */
+#define CPUBUDGET_LOW         (0.8)     /* of the budget: stop skipping */
+
+typedef struct {
+    double  budget;             /* fraction of the k-period */
+    int     policy;
+    double  load;               /* rolling, fraction of the k-period */
+    double  pending;            /* cost of the voices started since the
+                                   last k-cycle began */
+    double  inflight;           /* of those in their first k-cycle */
+    double  debt;               /* seconds per k-cycle to turn off */
+    int     debtprio;           /* highest cpuprio of the voices over */
+    int     newest;             /* csound->actcount when first over */
+    double  avgcost;            /* running mean cost of an instance */
+    int     skip;               /* cpuprio below this sits out */
+    int     hold;               /* k-cycles before skip may change */
+    unsigned long kcount;
+    int     costing;            /* timing instances this k-cycle */
+    MYFLT   **before;           /* by thread: its spout before an instance */
+    int     nthreads, nbefore;
+    long    stolen, refused;
+    long    warned;             /* refused when last warned */
+    unsigned long warnkcount;   /* kcount then */
+    volatile long skipped;
+} CPUBUDGET;
+
+void cpubudget_start(CSOUND *csound)
+{
+    CPUBUDGET *b = (CPUBUDGET*) csound->Calloc(csound, sizeof(CPUBUDGET));
+
+    b->budget = csound->oparms->cpuBudget / 100.0;
+    b->policy = csound->oparms->cpuBudgetPolicy;
+    b->skip = INT_MIN;
+    csound->cpubudget = b;
+}
+
+static inline double voice_cost(CPUBUDGET *b, INSTRTXT *tp)
+{
+    return (tp->perfcost > 0.0 ? tp->perfcost : b->avgcost);
+}
+
+/* A burst of notes over budget would give a warning each: warn at most
+   once a second, with the number refused since the last warning */
+
+static void refuse_warning(CSOUND *csound, CPUBUDGET *b)
+{
+    long    n;
+
+    if (b->warned > 0 && b->kcount - b->warnkcount < (unsigned long) csound->ekr)
+      return;
+    n = b->refused - b->warned;
+    if (n == 1)
+      csoundWarning(csound, Str("cannot allocate last note because "
+                                "it exceeds the cpu budget"));
+    else
+      csoundWarning(csound, Str("cannot allocate %ld notes because "
+                                "they exceed the cpu budget"), n);
+    b->warned = b->refused;
+    b->warnkcount = b->kcount;
+}
+
+/* Called as a voice of tp is about to start, on the event insertion
+   thread under --realtime: returns 0 if it is refused. */
+
+int cpubudget_admit(CSOUND *csound, INSTRTXT *tp)
+{
+    CPUBUDGET *b = (CPUBUDGET*) csound->cpubudget;
+    double  period = csound->ksmps / csound->esr;
+    double  cost = voice_cost(b, tp);
+    double  over = b->load + (b->inflight + b->pending + cost) / period
+                   - b->budget;
+
+    if (over > 0.0) {
+      switch (b->policy) {
+      case CPU_BUDGET_REFUSE:
+        b->refused++;
+        refuse_warning(csound, b);
+        return 0;
+      case CPU_BUDGET_OLDEST:
+      case CPU_BUDGET_QUIETEST:
+        if (b->debt <= 0.0) {
+          b->newest = csound->actcount;
+          b->debtprio = tp->cpuprio;
+        }
+        else if (tp->cpuprio > b->debtprio)
+          b->debtprio = tp->cpuprio;
+        b->debt = over * period;
+        break;
+      }
+    }
+    b->pending += cost;
+    return 1;
+}
+
+/* is voice a a better one to turn off than voice v? */
+
+static int steal_before(CPUBUDGET *b, INSDS *a, INSDS *v)
+{
+    if (a->instr->cpuprio != v->instr->cpuprio)
+      return (a->instr->cpuprio < v->instr->cpuprio);
+    if (b->policy == CPU_BUDGET_QUIETEST) {
+      MYFLT la = INSEXT(a)->level, lv = INSEXT(v)->level;
+      if ((la >= FL(0.0)) != (lv >= FL(0.0)))
+        return (la >= FL(0.0));         /* measured first */
+      if (la != lv)
+        return (la < lv);
+    }
+    return (INSEXT(a)->actno - INSEXT(v)->actno < 0);   /* oldest */
+}
+
+static void steal(CSOUND *csound, CPUBUDGET *b)
+{
+    INSDS   *ip, *victim;
+    double  c;
+
+    while (b->debt > 0.0) {
+      victim = NULL;
+      for (ip = csound->actanchor.nxtact; ip != NULL; ip = ip->nxtact) {
+        if (INSEXT(ip)->actno - b->newest > 0 || ip->instr->cpuprio > b->debtprio ||
+            ATOMIC_GET(ip->init_done) != 1)
+          continue;
+        if (victim == NULL || steal_before(b, ip, victim))
+          victim = ip;
+      }
+      if (victim == NULL)
+        break;                  /* the new voices play over budget */
+      c = (INSEXT(victim)->perfcost > 0.0 ? INSEXT(victim)->perfcost :
+           voice_cost(b, victim->instr));
+      b->debt -= (c > 0.0 ? c : b->debt);
+      b->stolen++;
+      xturnoff_now(csound, victim);
+    }
+    b->debt = 0.0;
+}
+
+/* At the start of a k-cycle, before the instruments: turn off voices
+   for those started over budget.  Returns the time, for
+   cpubudget_kcycle(). */
+
+double cpubudget_settle(CSOUND *csound)
+{
+    CPUBUDGET *b = (CPUBUDGET*) csound->cpubudget;
+    int     rt = csound->oparms->realtime;
+
+    b->costing = (b->kcount++ % CPUBUDGET_COST_PERIOD == 0);
+    if (UNLIKELY(b->costing && b->policy == CPU_BUDGET_QUIETEST &&
+                 b->nbefore < csound->nspout)) {
+      int     t;
+      if (b->before == NULL) {
+        b->nthreads = (csound->oparms->numThreads > 1 ?
+                       csound->oparms->numThreads : 1);
+        b->before = (MYFLT**) csound->Calloc(csound,
+                                             b->nthreads * sizeof(MYFLT*));
+      }
+      for (t = 0; t < b->nthreads; t++)
+        b->before[t] = (MYFLT*) csound->ReAlloc(csound, b->before[t],
+                                             csound->nspout * sizeof(MYFLT));
+      b->nbefore = csound->nspout;
+    }
+    /* under --realtime voices are started by the event insertion thread;
+       if it is busy, settle at the next k-cycle */
+    if (!rt || csoundSpinTryLock(&csound->alloc_spinlock) == CSOUND_SUCCESS) {
+      if (b->debt > 0.0)
+        steal(csound, b);
+      b->inflight += b->pending;
+      b->pending = 0.0;
+      if (rt)
+        csoundSpinUnLock(&csound->alloc_spinlock);
+    }
+    return csoundGetRealTime(csound->csRtClock);
+}
+
+/* the skip policy: move the level by one cpuprio if over budget, or
+   well under it */
+
+static void skip_update(CSOUND *csound, CPUBUDGET *b)
+{
+    INSDS   *ip;
+    int     p, lo = INT_MAX, hi = INT_MIN;
+
+    if (b->hold > 0) {
+      b->hold--;
+      return;
+    }
+    if (b->load > b->budget) {
+      for (ip = csound->actanchor.nxtact; ip != NULL; ip = ip->nxtact) {
+        p = ip->instr->cpuprio;
+        if (p >= b->skip && p < lo) lo = p;
+        if (p > hi) hi = p;
+      }
+      if (lo >= hi)
+        return;                 /* never skip the highest */
+      b->skip = lo + 1;
+    }
+    else if (b->skip != INT_MIN && b->load < CPUBUDGET_LOW * b->budget) {
+      for (ip = csound->actanchor.nxtact; ip != NULL; ip = ip->nxtact) {
+        p = ip->instr->cpuprio;
+        if (p < b->skip && p > hi) hi = p;
+      }
+      b->skip = hi;             /* INT_MIN: none left to skip */
+    }
+    else return;
+    b->hold = (int) (CPUBUDGET_HOLD * csound->ekr) + 1;
+}
+
+/* after the instruments of a k-cycle that began at 'start' */
+
+void cpubudget_kcycle(CSOUND *csound, double start)
+{
+    CPUBUDGET *b = (CPUBUDGET*) csound->cpubudget;
+    double  x = (csoundGetRealTime(csound->csRtClock) - start)
+                * csound->esr / csound->ksmps;
+
+    b->load += (x > b->load ? 0.5 : 0.05) * (x - b->load);
+    b->inflight = 0.0;
+    b->costing = 0;
+    if (b->policy == CPU_BUDGET_SKIP)
+      skip_update(csound, b);
+}
+
+int cpubudget_costing(CSOUND *csound)
+{
+    return ((CPUBUDGET*) csound->cpubudget)->costing;
+}
+
+/* In a costing k-cycle, the power an instance adds to the output that
+   thread 'index' mixes into (the quietest policy).  Under -j these run
+   on the DAG threads, each for instances of its own. */
+
+void cpubudget_level_begin(CSOUND *csound, int index, const MYFLT *out)
+{
+    CPUBUDGET *b = (CPUBUDGET*) csound->cpubudget;
+
+    if (b->policy == CPU_BUDGET_QUIETEST && index < b->nthreads)
+      memcpy(b->before[index], out, csound->nspout * sizeof(MYFLT));
+}
+
+void cpubudget_level_end(CSOUND *csound, INSDS *ip, int index,
+                         const MYFLT *out)
+{
+    CPUBUDGET *b = (CPUBUDGET*) csound->cpubudget;
+    INSDS_EXT *x = INSEXT(ip);
+    double  d, e = 0.0;
+    int     i, n = csound->nspout;
+
+    if (b->policy != CPU_BUDGET_QUIETEST || index >= b->nthreads)
+      return;
+    for (i = 0; i < n; i++) {
+      d = out[i] - b->before[index][i];
+      e += d * d;
+    }
+    e /= n;
+    x->level = (x->level < FL(0.0) ? (MYFLT) e :
+                FL(0.75) * x->level + FL(0.25) * (MYFLT) e);
+}
+
+/* fold the time an instance took into the running means; single
+   threaded, after the DAG under -j */
+
+void cpubudget_inst_cost(CSOUND *csound, INSDS *ip, double c)
+{
+    CPUBUDGET *b = (CPUBUDGET*) csound->cpubudget;
+    INSDS_EXT *x = INSEXT(ip);
+    INSTRTXT *tp = ip->instr;
+
+    x->perfcost = (x->perfcost > 0.0 ? 0.75*x->perfcost + 0.25*c : c);
+    tp->perfcost = (tp->perfcost > 0.0 ? 0.75*tp->perfcost + 0.25*c : c);
+    b->avgcost = (b->avgcost > 0.0 ? 0.9*b->avgcost + 0.1*c : c);
+}
+
+/* time an instance in a costing k-cycle (single threaded) */
+
+double cpubudget_inst_begin(CSOUND *csound)
+{
+    cpubudget_level_begin(csound, 0, csound->spraw);
+    return csoundGetRealTime(csound->csRtClock);
+}
+
+void cpubudget_inst_end(CSOUND *csound, INSDS *ip, double start)
+{
+    double  c = csoundGetRealTime(csound->csRtClock) - start;
+
+    cpubudget_level_end(csound, ip, 0, csound->spraw);
+    cpubudget_inst_cost(csound, ip, c);
+}
+
+int cpubudget_skip(CSOUND *csound, INSDS *ip)
+{
+    CPUBUDGET *b = (CPUBUDGET*) csound->cpubudget;
+
+    if (LIKELY(ip->instr->cpuprio >= b->skip))
+      return 0;
+    ATOMIC_INCR(b->skipped);
+    return 1;
+}
+
+PUBLIC int csoundGetVoiceStats(CSOUND *csound, CS_VOICE_STATS *stats)
+{
+    CPUBUDGET *b = (CPUBUDGET*) csound->cpubudget;
+
+    if (UNLIKELY(b == NULL || stats == NULL))
+      return CSOUND_ERROR;
+    stats->load = b->load;
+    stats->stolenOldest = (b->policy == CPU_BUDGET_OLDEST ? b->stolen : 0);
+    stats->stolenQuietest = (b->policy == CPU_BUDGET_QUIETEST ? b->stolen : 0);
+    stats->refused = b->refused;
+    stats->skipped = b->skipped;
+    return CSOUND_SUCCESS;
+}
+
+/* end of performance */
+
+void cpubudget_report(CSOUND *csound)
+{
+    CS_VOICE_STATS s;
+
+    if (csoundGetVoiceStats(csound, &s) != CSOUND_SUCCESS)
+      return;
+    csound->Message(csound, Str("cpu budget: load %.0f%%, voices stolen: "
+                                "%ld oldest, %ld quietest; %ld refused; "
+                                "%ld instance k-cycles skipped\n"),
+                    100.0 * s.load, s.stolenOldest, s.stolenQuietest,
+                    s.refused, s.skipped);
+}
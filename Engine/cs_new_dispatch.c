@@ -38,7 +38,11 @@
 #include "csoundCore.h"
 #include "cs_par_base.h"
 #include "cs_par_orc_semantics.h"
+#include "cstrace.h"
+#include "namedins.h"
+#include "cpubudget.h"
 #include <stdbool.h>
+#include <ctype.h>
 
 #if defined(_MSC_VER)
 /* For InterlockedCompareExchange */
@@ -82,7 +86,9 @@ static void dag_print_state(CSOUND *csound)
     watchList *w;
     printf("*** %d tasks\n", csound->dag_num_active);
     for (i=0; i<csound->dag_num_active; i++) {
-      printf("%d(%d): ", i, csound->dag_task_map[i]->insno);
+      int first = csound->dag_task_first[i];
+      printf("%d(%d x%d): ", i, csound->dag_task_map[first]->insno,
+             csound->dag_task_first[i+1] - first);
       switch (csound->dag_task_status[i].s) {
       case DONE:
         printf("status=DONE (watchList ");
@@ -127,6 +133,8 @@ static void create_dag(CSOUND *csound)
     csound->dag_task_map    = csound->Calloc(csound, sizeof(INSDS*)*max);
     csound->dag_task_dep    = (char **)csound->Calloc(csound, sizeof(char*)*max);
     csound->dag_wlmm = (watchList *)csound->Calloc(csound, sizeof(watchList)*max);
+    csound->dag_task_first  = (int *)csound->Calloc(csound, sizeof(int)*(max+1));
+    csound->dag_inst_cost   = (double *)csound->Calloc(csound, sizeof(double)*max);
 }
 
 static void recreate_dag(CSOUND *csound)
@@ -145,6 +153,10 @@ static void recreate_dag(CSOUND *csound)
       (char **)csound->ReAlloc(csound, csound->dag_task_dep, sizeof(char*)*max);
     csound->dag_wlmm        =
       (watchList *)csound->ReAlloc(csound, csound->dag_wlmm, sizeof(watchList)*max);
+    csound->dag_task_first  =
+      (int *)csound->ReAlloc(csound, csound->dag_task_first, sizeof(int)*(max+1));
+    csound->dag_inst_cost   =
+      (double *)csound->ReAlloc(csound, csound->dag_inst_cost, sizeof(double)*max);
 }
 
 static INSTR_SEMANTICS *dag_get_info(CSOUND* csound, int insno)
@@ -164,112 +176,307 @@ static INSTR_SEMANTICS *dag_get_info(CSOUND* csound, int insno)
     return current_instr;
 }
 
+/* globals in both sets, other than those in ignore */
 static int dag_intersect(CSOUND *csound, struct set_t *current,
-                         struct set_t *later, int cnt)
+                         struct set_t *later, struct set_t *ignore)
 {
-    IGN(cnt);
     struct set_t *ans;
     int res = 0;
     struct set_element_t *ele;
     ans = csp_set_intersection(csound, current, later);
-    res = ans->count;
     ele = ans->head;
     while (ele != NULL) {
       struct set_element_t *next = ele->next;
+      if (ignore == NULL || !csp_set_exists(ignore, ele->data)) res++;
       csound->Free(csound, ele);
-      ele = next; res++;
+      ele = next;
     }
     csound->Free(csound, ans);
     return res;
 }
 
+/* Pipelining (--pipeline=N).  Each instrument has a stage, 0 to N: the
+   one given by pipestage, or else one above the highest stage of the
+   instruments that accumulate ('g += ...') into a global it reads or
+   assigns.  A global is piped when all the instruments accumulating
+   into it are in lower stages than all those reading or assigning it.
+   The sums of a piped global stay in the per-thread copies of
+   cs_par_reduce.c until the end of the k-period, so its readers see the
+   sum of the previous block and need no edge to its accumulators: the
+   stages run side by side, each adding one block of latency. */
+
+static int dag_accumulates(INSTR_SEMANTICS *s, void *name)
+{
+    return (csp_set_exists(s->read_write, name) &&
+            !csp_set_exists(s->read, name) && !csp_set_exists(s->write, name));
+}
+
+static int dag_reads(INSTR_SEMANTICS *s, void *name)
+{
+    return (csp_set_exists(s->read, name) || csp_set_exists(s->write, name));
+}
+
+static INSTRTXT *dag_instr_txt(CSOUND *csound, INSTR_SEMANTICS *s)
+{
+    int insno = s->insno;
+
+    if (insno <= 0)
+      insno = (isdigit((unsigned char) *s->name) ? atoi(s->name) :
+               (int) named_instr_find(csound, s->name));
+    if (insno > 0 && insno <= csound->engineState.maxinsno)
+      return csound->engineState.instrtxtp[insno];
+    return NULL;
+}
+
+static int dag_piped(INSTR_SEMANTICS **sem, INSTRTXT **txt, int n,
+                     void *name)
+{
+    int i, acc = -1, rd = INT_MAX;
+
+    for (i = 0; i < n; i++) {
+      if (dag_accumulates(sem[i], name)) {
+        if (txt[i]->stage > acc) acc = txt[i]->stage;
+      }
+      else if (csp_set_exists(sem[i]->read_write, name))
+        return 0;               /* accumulates and reads: summed in place */
+      else if (dag_reads(sem[i], name) && txt[i]->stage < rd)
+        rd = txt[i]->stage;
+    }
+    return (acc >= 0 && rd != INT_MAX && acc < rd);
+}
+
+/* Stages depend only on the orchestra and on pipestage, so they are
+   kept in INSTRTXT and recomputed only when dag_stages_changed is set
+   by the semantic analysis or by pipestage, not on every DAG rebuild */
+
+static void dag_stages(CSOUND *csound)
+{
+    INSTR_SEMANTICS *a, **sem;
+    INSTRTXT **txt;
+    struct set_element_t *ele;
+    struct set_t *piped;
+    int max = csound->oparms->pipeline, n = 0, i, j, pass, changed = 1;
+
+    for (a = csound->instRoot; a != NULL; a = a->next) n++;
+    sem = (INSTR_SEMANTICS**) csound->Malloc(csound, (n+1)*sizeof(void*));
+    txt = (INSTRTXT**) csound->Malloc(csound, (n+1)*sizeof(void*));
+    /* only instruments with a definition can have instances */
+    for (a = csound->instRoot, n = 0; a != NULL; a = a->next) {
+      INSTRTXT *tp = dag_instr_txt(csound, a);
+      if (tp == NULL) continue;
+      tp->stage = (tp->pipestage > 0 ? tp->pipestage - 1 : -1);
+      if (tp->stage > max) tp->stage = max;
+      sem[n] = a; txt[n++] = tp;
+    }
+    /* automatic stages: -1 until raised, then 0 */
+    for (pass = 0; changed && pass <= n; pass++) {
+      changed = 0;
+      for (i = 0; i < n; i++)
+        for (ele = sem[i]->read_write->head; ele != NULL; ele = ele->next) {
+          int sa = (txt[i]->stage < 0 ? 0 : txt[i]->stage);
+          if (sa >= max || !dag_accumulates(sem[i], ele->data))
+            continue;
+          for (j = 0; j < n; j++) {
+            if (txt[j] == txt[i] || txt[j]->stage > sa ||
+                txt[j]->pipestage > 0 || !dag_reads(sem[j], ele->data))
+              continue;
+            txt[j]->stage = sa + 1;
+            changed = 1;
+          }
+        }
+    }
+    for (i = 0; i < n; i++)
+      if (txt[i]->stage < 0) txt[i]->stage = 0;
+
+    piped = csp_set_alloc_string(csound);
+    for (i = 0; i < n; i++)
+      for (ele = sem[i]->read_write->head; ele != NULL; ele = ele->next)
+        if (!csp_set_exists(piped, ele->data) &&
+            dag_piped(sem, txt, n, ele->data))
+          csp_set_add(csound, piped, ele->data);
+    if (UNLIKELY(csound->oparms->odebug)) {
+      for (i = 0; i < n; i++)
+        printf("instr %s: stage %d\n", sem[i]->name, txt[i]->stage);
+      printf("piped globals: ");
+      csp_set_print(csound, piped);
+    }
+    if (csound->dag_piped != NULL)
+      csp_set_dealloc(csound, (struct set_t **) &csound->dag_piped);
+    csound->dag_piped = piped;
+    csound->dag_piped_gen++;
+    csound->dag_stages_changed = 0;
+    csound->Free(csound, sem);
+    csound->Free(csound, txt);
+}
+
+/* Task coarsening.  A task is a run of consecutive instances of the
+   active chain.  Instances cheaper than a target, 1/DAG_TASKS_PER_THREAD
+   of one thread's share of the k-period, are packed into runs costing
+   up to the target; heavier instances, and those of instruments not
+   costed yet, are tasks of their own.  Every DAG_COST_PERIOD k-cycles
+   each instance is timed, the running mean cost of its instrument is
+   updated, and the tasks are rebuilt. */
+
+#define DAG_TASKS_PER_THREAD (4)
+#define DAG_COST_PERIOD      (256)
+
+static int dag_group(CSOUND *csound, int n)
+{
+    INSDS **task_map = csound->dag_task_map;
+    int *first = csound->dag_task_first;
+    double total = 0.0, target, bundle = 0.0;
+    int i, ntasks = 0, open = 0;
+
+    for (i=0; i<n; i++)
+      total += task_map[i]->instr->perfcost;
+    target = total / (csound->oparms->numThreads * DAG_TASKS_PER_THREAD);
+    for (i=0; i<n; i++) {
+      double c = task_map[i]->instr->perfcost;
+      if (open && c > 0.0 && bundle + c <= target)
+        bundle += c;
+      else {
+        first[ntasks++] = i;
+        bundle = c;
+        open = (c > 0.0 && c < target);
+      }
+    }
+    first[ntasks] = n;
+    return ntasks;
+}
+
+/* dag_costing is 1 in the k-cycles that regroup the tasks, 2 in those
+   that only time the instances for --cpu-budget */
+
+static void dag_cost_start(CSOUND *csound, int n)
+{
+    csound->dag_costing = (csound->dag_kcount++ % DAG_COST_PERIOD == 0);
+    if (!csound->dag_costing && csound->cpubudget != NULL &&
+        cpubudget_costing(csound))
+      csound->dag_costing = 2;
+    if (csound->dag_costing)
+      memset(csound->dag_inst_cost, 0, sizeof(double)*n);
+}
+
+/* after the DAG: fold the times taken in a costing k-cycle into the
+   instruments' running means, and regroup with them */
+
+void dag_cost_end(CSOUND *csound)
+{
+    int i, n;
+
+    if (!csound->dag_costing)
+      return;
+    n = csound->dag_task_first[csound->dag_num_active];
+    for (i=0; i<n; i++) {
+      INSDS *ip = csound->dag_task_map[i];
+      INSTRTXT *tp = ip->instr;
+      double c = csound->dag_inst_cost[i];
+      if (c <= 0.0) continue;
+      if (csound->cpubudget != NULL)
+        cpubudget_inst_cost(csound, ip, c);
+      else
+        tp->perfcost = (tp->perfcost > 0.0 ? 0.75*tp->perfcost + 0.25*c : c);
+    }
+    if (csound->dag_costing == 1)
+      csound->dag_changed++;
+    csound->dag_costing = 0;
+}
+
 void dag_build(CSOUND *csound, INSDS *chain)
 {
     INSDS *save = chain;
     INSDS **task_map;
-    int i;
+    int i, j, n = 0, ti, tj;
 
     //printf("DAG BUILD***************************************\n");
-    csound->dag_num_active = 0;
+    TRACE_BEGIN(csound, "dag_build", -1);
     while (chain != NULL) {
-      csound->dag_num_active++;
+      n++;
       chain = chain->nxtact;
     }
-    if (csound->dag_num_active>csound->dag_task_max_size) {
+    if (n>csound->dag_task_max_size) {
       //printf("**************need to extend task vector\n");
-      csound->dag_task_max_size = csound->dag_num_active+INIT_SIZE;
+      csound->dag_task_max_size = n+INIT_SIZE;
       recreate_dag(csound);
     }
     if (csound->dag_task_status == NULL)
       create_dag(csound); /* Should move elsewhere */
-    else {
-      memset((void*)csound->dag_task_watch, '\0',
-             sizeof(watchList*)*csound->dag_task_max_size);
-      for (i=0; i<csound->dag_task_max_size; i++) {
-        if (csound->dag_task_dep[i]) {
-          csound->dag_task_dep[i]= NULL;
-        }
-        csound->dag_wlmm[i].id = INVALID;
+    task_map = csound->dag_task_map;
+    for (i=0, chain=save; i<n; i++, chain=chain->nxtact)
+      task_map[i] = chain;
+    csound->dag_num_active = dag_group(csound, n);
+    if (csound->oparms->pipeline > 0 && csound->dag_stages_changed)
+      dag_stages(csound);
+    memset((void*)csound->dag_task_watch, '\0',
+           sizeof(watchList*)*csound->dag_task_max_size);
+    for (i=0; i<csound->dag_task_max_size; i++) {
+      if (csound->dag_task_dep[i]) {
+        csound->dag_task_dep[i]= NULL;
       }
+      csound->dag_wlmm[i].id = INVALID;
     }
-    task_map = csound->dag_task_map;
     for (i=0; i<csound->dag_num_active; i++) {
       csound->dag_task_status[i].s = AVAILABLE;
       csound->dag_wlmm[i].id=i;
     }
     csound->dag_changed = 0;
+    dag_cost_start(csound, n);
     if (UNLIKELY(csound->oparms->odebug))
-      printf("dag_num_active = %d\n", csound->dag_num_active);
-    i = 0; chain = save;
-    while (chain != NULL) {     /* for each instance check against later */
-      int j = i+1;              /* count of instance */
+      printf("dag_num_active = %d (%d instances)\n",
+             csound->dag_num_active, n);
+    /* for each instance check against later ones in other tasks;
+       instances of one task are performed in chain order */
+    for (i=0, ti=0; i<n; i++) {
+      INSTR_SEMANTICS *current_instr = dag_get_info(csound, task_map[i]->insno);
+      if (i == csound->dag_task_first[ti+1]) ti++;
       if (UNLIKELY(csound->oparms->odebug))
-        printf("\nWho depends on %d (instr %d)?\n", i, chain->insno);
-      INSDS *next = chain->nxtact;
-      INSTR_SEMANTICS *current_instr = dag_get_info(csound, chain->insno);
-      //csp_set_print(csound, current_instr->read);
-      //csp_set_print(csound, current_instr->write);
-      while (next) {
-        INSTR_SEMANTICS *later_instr = dag_get_info(csound, next->insno);
-        int cnt = 0;
+        printf("\nWho depends on %d (instr %d)?\n", i, task_map[i]->insno);
+      for (j=i+1, tj=ti; j<n; j++) {
+        INSTR_SEMANTICS *later_instr;
+        struct set_t *piped = (struct set_t *) csound->dag_piped;
+        char *tt;
+        if (j == csound->dag_task_first[tj+1]) tj++;
+        tt = csound->dag_task_dep[tj];
+        if (tj == ti || (tt != NULL && tt[ti]))
+          continue;
+        later_instr = dag_get_info(csound, task_map[j]->insno);
         if (UNLIKELY(csound->oparms->odebug)) printf("%d ", j);
         //csp_set_print(csound, later_instr->read);
         //csp_set_print(csound, later_instr->write);
         //csp_set_print(csound, later_instr->read_write);
+        /* an accumulator of a piped global does not depend on its
+           readers, nor they on it */
         if (dag_intersect(csound, current_instr->write,
-                          later_instr->read, cnt++)       ||
+                          later_instr->read, NULL)        ||
             dag_intersect(csound, current_instr->read_write,
-                          later_instr->read, cnt++)       ||
+                          later_instr->read, piped)       ||
             dag_intersect(csound, current_instr->read,
-                          later_instr->write, cnt++)      ||
+                          later_instr->write, NULL)       ||
             dag_intersect(csound, current_instr->write,
-                          later_instr->write, cnt++)      ||
+                          later_instr->write, NULL)       ||
             dag_intersect(csound, current_instr->read_write,
-                          later_instr->write, cnt++)      ||
+                          later_instr->write, piped)      ||
             dag_intersect(csound, current_instr->read,
-                          later_instr->read_write, cnt++) ||
+                          later_instr->read_write, piped) ||
             dag_intersect(csound, current_instr->write,
-                          later_instr->read_write, cnt++)) {
-          char *tt = csound->dag_task_dep[j];
+                          later_instr->read_write, piped)) {
           if (tt==NULL) {
             /* get dep vector if missing and set watch first time */
-            tt = csound->dag_task_dep[j] =
-              (char*)csound->Calloc(csound, sizeof(char)*(j+1));
-            csound->dag_task_status[j].s = WAITING;
-            csound->dag_wlmm[j].next = csound->dag_task_watch[i];
-            csound->dag_wlmm[j].id = j;
-            csound->dag_task_watch[i] = &(csound->dag_wlmm[j]);
-            //printf("set watch %d to %d\n", j, i);
+            tt = csound->dag_task_dep[tj] =
+              (char*)csound->Calloc(csound, sizeof(char)*(tj+1));
+            csound->dag_task_status[tj].s = WAITING;
+            csound->dag_wlmm[tj].next = csound->dag_task_watch[ti];
+            csound->dag_wlmm[tj].id = tj;
+            csound->dag_task_watch[ti] = &(csound->dag_wlmm[tj]);
+            //printf("set watch %d to %d\n", tj, ti);
           }
-          tt[i] = 1;
+          tt[ti] = 1;
           //printf("-yes ");
         }
-        j++; next = next->nxtact;
       }
-      task_map[i] = chain;
-      i++; chain = chain->nxtact;
     }
     if (UNLIKELY(csound->oparms->odebug)) dag_print_state(csound);
+    TRACE_END(csound, "dag_build", -1);
 }
 
 void dag_reinit(CSOUND *csound)
@@ -281,6 +488,7 @@ void dag_reinit(CSOUND *csound)
     watchList *wlmm = csound->dag_wlmm;
     if (UNLIKELY(csound->oparms->odebug))
       printf("DAG REINIT************************\n");
+    dag_cost_start(csound, csound->dag_task_first[csound->dag_num_active]);
     for (i=csound->dag_num_active; i<max; i++)
       task_status[i].s = DONE;
     task_status[0].s = AVAILABLE;
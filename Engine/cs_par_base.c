@@ -27,7 +27,6 @@
 #include "csoundCore.h"
 
 #include "cs_par_base.h"
-static int csp_set_exists(struct set_t *set, void *data);
 
 int csp_thread_index_get(CSOUND *csound)
 {
@@ -416,7 +415,7 @@ void csp_set_remove(CSOUND *csound, struct set_t *set, void *data)
     return;
 }
 
-static int csp_set_exists(struct set_t *set, void *data)
+int csp_set_exists(struct set_t *set, void *data)
 {
     struct set_element_t *ele = NULL;
 /* #ifdef SET_DEBUG */
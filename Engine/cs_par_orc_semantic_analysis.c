@@ -258,12 +258,19 @@ static void csp_orc_sa_interlocksf(CSOUND *csound, int code, char *name)
       csp_orc_sa_global_read_write_add_list(csound, ww, rr);
       //      printf("code&qq=%4x msglevel = %4x bit=%4x\n",
       //   code&_QQ, csound->oparms_.msglevel, csound->oparms_.msglevel&CS_NOQQ );
-      if (UNLIKELY((code&_QQ) && !(csound->oparms_.msglevel&CS_NOQQ))) {
-        csound->Message(csound, Str("opcode %s deprecated\n"), name);
+      if (UNLIKELY(code&_QQ)) {
+        orc_cache_note(csound, ORCCACHE_SA_DEPRECATED, name);
+        csp_orc_sa_deprecated(csound, name);
       }
     }
 }
 
+void csp_orc_sa_deprecated(CSOUND *csound, char *name)
+{
+    if (!(csound->oparms_.msglevel&CS_NOQQ))
+      csound->Message(csound, Str("opcode %s deprecated\n"), name);
+}
+
 void csp_orc_sa_interlocks(CSOUND *csound, ORCTOKEN *opcode)
 {
     char *name = opcode->lexeme;
@@ -278,6 +285,7 @@ void csp_orc_sa_instr_add(CSOUND *csound, char *name)
     name = cs_strdup(csound, name); // JPff:  leaks: necessary?? Think it is correct
     //printf("csp_orc_sa_instr_add name=%s\n", name);
     csound->inInstr = 1;
+    csound->dag_stages_changed = 1;
     if (csound->instRoot == NULL) {
       //printf("instRoot id NULL\n");
       csound->instRoot = instr_semantics_alloc(csound, name);
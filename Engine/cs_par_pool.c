@@ -0,0 +1,286 @@
+/*
+    cs_par_pool.c:
+
+    Copyright (C) 2026 The Csound Developers
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+/* Process-wide worker pool for multicore performance (--thread-pool).
+ *
+ * Without the pool every instance started with -j N creates N-1 threads
+ * of its own, which wait on the instance's barriers.  Instances that
+ * opt in share one set of threads instead.  At each k-period the
+ * performance thread builds the DAG, posts a job for its instance and
+ * works through the DAG itself; idle pool threads join in, up to N-1
+ * of them.  Jobs are served by priority (--thread-pool-priority) and
+ * then by deadline, the real time by which the k-period should be
+ * complete.  The pool is started by the first instance that uses it,
+ * with the size and core pinning asked for by that instance, and is
+ * stopped when the last one leaves, so the number of threads no longer
+ * grows with the number of instances.
+ */
+
+#include "csoundCore.h"
+#include "cs_par_base.h"
+#include "cstrace.h"
+
+#if defined(WIN32)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+#if defined(LINUX) && defined(HAVE_PTHREAD)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+extern void csoundLock(void);
+extern void csoundUnLock(void);
+
+typedef int (*POOL_PERF)(CSOUND *, int index, int numThreads);
+
+typedef struct pool_job_ {
+    CSOUND  *csound;
+    POOL_PERF perf;
+    int     priority;           /* higher first */
+    int     helpers;            /* pool threads wanted: -j N - 1 */
+    int     joined;             /* pool threads taken in this k-period */
+    int     active;             /* of these, still working */
+    int     open;               /* the k-period is in progress */
+    double  deadline;           /* pool clock, seconds */
+    void    *done;              /* signalled when active drops to zero */
+    struct pool_job_ *nxt;
+} POOL_JOB;
+
+typedef struct {
+    void    *lock;
+    void    *wake;              /* signalled when a job is posted */
+    void    **threads;
+    int     nthreads;
+    int     pin;                /* pin thread n to core n */
+    int     users;
+    int     stop;
+    POOL_JOB *jobs;             /* one per attached instance */
+    RTCLOCK clock;
+} THREAD_POOL;
+
+/* guarded by csoundLock() */
+static THREAD_POOL *pool = NULL;
+
+static int pool_cores(void)
+{
+#if defined(WIN32)
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return (int) si.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return (n > 0 ? (int) n : 1);
+#else
+    return 1;
+#endif
+}
+
+/* the open job that most needs a thread, or NULL; lock held */
+
+static POOL_JOB *pool_pick(void)
+{
+    POOL_JOB *job, *best = NULL;
+
+    for (job = pool->jobs; job != NULL; job = job->nxt) {
+      if (!job->open || job->joined >= job->helpers)
+        continue;
+      if (best == NULL || job->priority > best->priority ||
+          (job->priority == best->priority && job->deadline < best->deadline))
+        best = job;
+    }
+    return best;
+}
+
+static uintptr_t pool_thread(void *arg)
+{
+    POOL_JOB *job;
+    int     slot;
+
+    _MM_SET_DENORMALS_ZERO_MODE(_MM_DENORMALS_ZERO_ON);
+    cstrace_thread(TRACE_POOL + (int) (intptr_t) arg);
+#if defined(LINUX) && defined(HAVE_PTHREAD)
+    if (pool->pin) {
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      CPU_SET((int) (intptr_t) arg % pool_cores(), &set);
+      pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+#endif
+    csoundLockMutex(pool->lock);
+    while (!pool->stop) {
+      if ((job = pool_pick()) == NULL) {
+        csoundCondWait(pool->wake, pool->lock);
+        continue;
+      }
+      slot = ++job->joined;             /* the performance thread is 0 */
+      job->active++;
+      csoundUnlockMutex(pool->lock);
+      job->perf(job->csound, slot, job->helpers + 1);
+      csoundLockMutex(pool->lock);
+      if (--job->active == 0 && !job->open)
+        csoundCondSignal(job->done);
+    }
+    csoundUnlockMutex(pool->lock);
+    return 0;
+}
+
+static THREAD_POOL *pool_start(int nthreads, int pin)
+{
+    THREAD_POOL *p = (THREAD_POOL*) calloc(1, sizeof(THREAD_POOL));
+    int     i;
+
+    if (UNLIKELY(p == NULL))
+      return NULL;
+    p->threads = (void**) calloc(nthreads, sizeof(void*));
+    p->lock = csoundCreateMutex(0);
+    p->wake = csoundCreateCondVar();
+    if (UNLIKELY(p->threads == NULL || p->lock == NULL || p->wake == NULL)) {
+      free(p->threads);
+      free(p);
+      return NULL;
+    }
+    p->pin = pin;
+    csoundInitTimerStruct(&p->clock);
+    pool = p;
+    for (i = 0; i < nthreads; i++) {
+      if ((p->threads[i] = csoundCreateThread(pool_thread,
+                                              (void*) (intptr_t) i)) == NULL)
+        break;
+      p->nthreads++;
+    }
+    return p;
+}
+
+static void pool_stop(void)
+{
+    int     i;
+
+    csoundLockMutex(pool->lock);
+    pool->stop = 1;
+    for (i = 0; i < pool->nthreads; i++)
+      csoundCondSignal(pool->wake);
+    csoundUnlockMutex(pool->lock);
+    for (i = 0; i < pool->nthreads; i++)
+      csoundJoinThread(pool->threads[i]);
+    csoundDestroyCondVar(pool->wake);
+    csoundDestroyMutex(pool->lock);
+    free(pool->threads);
+    free(pool);
+    pool = NULL;
+}
+
+/* join the shared pool; perf(csound, index, numThreads) runs part of a
+   k-period's DAG as thread 'index' */
+
+int csp_pool_attach(CSOUND *csound, POOL_PERF perf)
+{
+    OPARMS  *O = csound->oparms;
+    POOL_JOB *job;
+
+    job = (POOL_JOB*) csound->Calloc(csound, sizeof(POOL_JOB));
+    job->csound = csound;
+    job->perf = perf;
+    job->priority = O->threadPoolPriority;
+    if (UNLIKELY((job->done = csoundCreateCondVar()) == NULL)) {
+      csound->Free(csound, job);
+      return NOTOK;
+    }
+    csoundLock();
+    if (pool == NULL &&
+        pool_start(O->threadPool > 0 ? O->threadPool : pool_cores(),
+                   O->threadPoolPin) == NULL) {
+      csoundUnLock();
+      csoundDestroyCondVar(job->done);
+      csound->Free(csound, job);
+      return NOTOK;
+    }
+    job->helpers = O->numThreads - 1;
+    if (job->helpers > pool->nthreads)
+      job->helpers = pool->nthreads;
+    csoundLockMutex(pool->lock);
+    job->nxt = pool->jobs;
+    pool->jobs = job;
+    pool->users++;
+    csoundUnlockMutex(pool->lock);
+    csound->Message(csound, Str("Multithread performance: up to %d threads "
+                                "from the shared pool of %d\n"),
+                    job->helpers, pool->nthreads);
+    csoundUnLock();
+    csound->threadPoolJob = job;
+    return OK;
+}
+
+/* leave the pool, stopping it if this was the last instance */
+
+void csp_pool_detach(CSOUND *csound)
+{
+    POOL_JOB *job = (POOL_JOB*) csound->threadPoolJob, **pp;
+    int     last;
+
+    if (job == NULL)
+      return;
+    csoundLock();
+    csoundLockMutex(pool->lock);
+    for (pp = &pool->jobs; *pp != NULL; pp = &(*pp)->nxt)
+      if (*pp == job) {
+        *pp = job->nxt;
+        break;
+      }
+    last = (--pool->users == 0);
+    csoundUnlockMutex(pool->lock);
+    if (last)
+      pool_stop();
+    csoundUnLock();
+    csoundDestroyCondVar(job->done);
+    csound->Free(csound, job);
+    csound->threadPoolJob = NULL;
+}
+
+/* perform the current DAG on the calling thread and any pool threads
+   that are free, returning when all tasks are done */
+
+void csp_pool_perform(CSOUND *csound)
+{
+    POOL_JOB *job = (POOL_JOB*) csound->threadPoolJob;
+    int     i;
+
+    csoundLockMutex(pool->lock);
+    job->deadline = csoundGetRealTime(&pool->clock)
+                    + (double) csound->ksmps / csound->esr;
+    job->joined = 0;
+    job->open = 1;
+    for (i = 0; i < job->helpers; i++)
+      csoundCondSignal(pool->wake);
+    csoundUnlockMutex(pool->lock);
+
+    job->perf(csound, 0, job->helpers + 1);
+
+    /* no task is left to start, wait for those still running */
+    csoundLockMutex(pool->lock);
+    job->open = 0;
+    while (job->active > 0)
+      csoundCondWait(job->done, pool->lock);
+    csoundUnlockMutex(pool->lock);
+}
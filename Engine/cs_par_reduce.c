@@ -0,0 +1,281 @@
+/*
+    cs_par_reduce.c:
+
+    Copyright (C) 2026 The Csound Developers
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+/* Per-thread reduction buffers for multicore performance (-j N).
+ *
+ * Without them every out, outs, outch ... and every 'g += x' takes the
+ * instance's spout spinlock, so voices running on different threads
+ * queue on one lock for each block they mix.  Instead, while the DAG
+ * is performed, each thread mixes into a spout of its own, and the
+ * copies are summed into spraw when the k-period's tasks are done.
+ *
+ * Globals are treated the same way when the semantic analysis shows
+ * that the instrument only ever accumulates into them (the variable is
+ * in its read_write set, and neither in its read nor in its write set).
+ * Such writers have no DAG edges between them, so each thread adds into
+ * its own zeroed copy.  Readers of the global do have edges to all its
+ * writers: when a task that reads or assigns the variable starts, the
+ * writers before it in the chain have finished and those after it have
+ * not started, so the copies are summed into the variable at that point;
+ * whatever is left is summed at the end of the k-period.
+ *
+ * Copies are added in pairs (a tree over the threads), in loops over
+ * contiguous blocks that the compiler vectorises.
+ */
+
+#include "csoundCore.h"
+#include "cs_par_base.h"
+#include "cs_par_orc_semantics.h"
+
+#if defined(_MSC_VER)
+#define REDUCE_TLS __declspec(thread)
+#else
+#define REDUCE_TLS __thread
+#endif
+
+typedef struct reduce_var_ {
+    MYFLT   *dest;              /* the global */
+    int     n;                  /* its size in MYFLTs */
+    char    *name;              /* as in the semantic sets */
+    MYFLT   **copy;             /* per thread, kept zeroed when not dirty */
+    char    *dirty;             /* per thread */
+    volatile int pending;       /* some copy is dirty */
+    spin_lock_t lock;           /* taken by readers summing the copies */
+    signed char *reads;         /* by insno: 1, 0, or -1 not known yet */
+    int     nreads;
+    struct reduce_var_ *nxt;
+} REDUCE_VAR;
+
+typedef struct {
+    int     nthreads;
+    int     nspout;
+    MYFLT   **spout;            /* per thread, allocated by the first DAG */
+    REDUCE_VAR *vars;
+    spin_lock_t lock;           /* guards additions to vars */
+    int     piped_gen;          /* of csound->dag_piped the reads are for */
+} CSP_REDUCE;
+
+/* index of the calling thread in the current DAG */
+static REDUCE_TLS int reduce_thread = 0;
+
+static inline void reduce_add(MYFLT *a, const MYFLT *b, int n)
+{
+    int     i;
+    for (i = 0; i < n; i++)
+      a[i] += b[i];
+}
+
+/* sum the dirty copies in pairs into copy[0], then into dest */
+
+static void reduce_merge(CSP_REDUCE *r, REDUCE_VAR *v)
+{
+    int     s, t, nt = r->nthreads, n = v->n;
+
+    for (s = 1; s < nt; s <<= 1)
+      for (t = 0; t + s < nt; t += 2 * s)
+        if (v->dirty[t + s]) {
+          reduce_add(v->copy[t], v->copy[t + s], n);
+          memset(v->copy[t + s], 0, n * sizeof(MYFLT));
+          v->dirty[t + s] = 0;
+          v->dirty[t] = 1;
+        }
+    if (v->dirty[0]) {
+      reduce_add(v->dest, v->copy[0], n);
+      memset(v->copy[0], 0, n * sizeof(MYFLT));
+      v->dirty[0] = 0;
+    }
+    v->pending = 0;
+}
+
+static INSTR_SEMANTICS *reduce_semantics(CSOUND *csound, int insno)
+{
+    INSTR_SEMANTICS *s = csp_orc_sa_instr_get_by_num(csound, insno);
+
+    if (s == NULL && insno <= csound->engineState.maxinsno &&
+        csound->engineState.instrtxtp[insno] != NULL &&
+        csound->engineState.instrtxtp[insno]->insname != NULL)
+      s = csp_orc_sa_instr_get_by_name(csound,
+                                csound->engineState.instrtxtp[insno]->insname);
+    return s;
+}
+
+/* does instrument insno read or assign v, so that it must see the sum?
+   Readers of a piped global (--pipeline) see the previous block's. */
+
+static int reduce_reads(CSOUND *csound, REDUCE_VAR *v, int insno)
+{
+    INSTR_SEMANTICS *s;
+    int     res;
+
+    if (insno < v->nreads && v->reads[insno] >= 0)
+      return v->reads[insno];
+    s = reduce_semantics(csound, insno);
+    res = (s != NULL && (csp_set_exists(s->read, v->name) ||
+                         csp_set_exists(s->write, v->name)));
+    if (res && csound->dag_piped != NULL &&
+        csp_set_exists((struct set_t *) csound->dag_piped, v->name))
+      res = 0;
+    if (insno < v->nreads)
+      v->reads[insno] = (signed char) res;
+    return res;
+}
+
+/* set up reduction for an instance started with numThreads threads */
+
+void csp_reduce_alloc(CSOUND *csound, int numThreads)
+{
+    CSP_REDUCE *r = (CSP_REDUCE*) csound->Calloc(csound, sizeof(CSP_REDUCE));
+
+    r->nthreads = numThreads;
+    csoundSpinLockInit(&r->lock);
+    csound->reduce = r;
+}
+
+/* Called by the init pass of 'name += ...' on a global of n MYFLTs at
+   dest: returns the reduction of the global, or NULL if the instrument
+   also reads or assigns it, in which case the sum has to be done in
+   place. */
+
+void *csp_reduce_var(CSOUND *csound, INSDS *ip, char *name,
+                     MYFLT *dest, int n)
+{
+    CSP_REDUCE *r = (CSP_REDUCE*) csound->reduce;
+    INSTR_SEMANTICS *s;
+    REDUCE_VAR *v;
+    int     t;
+
+    /* UDO bodies are not covered by the semantic analysis */
+    if (r == NULL || ip->opcod_iobufs != NULL)
+      return NULL;
+    s = reduce_semantics(csound, ip->insno);
+    if (s == NULL || !csp_set_exists(s->read_write, name) ||
+        csp_set_exists(s->read, name) || csp_set_exists(s->write, name))
+      return NULL;
+    csoundSpinLock(&r->lock);
+    for (v = r->vars; v != NULL; v = v->nxt)
+      if (v->dest == dest)
+        break;
+    if (v == NULL) {
+      v = (REDUCE_VAR*) csound->Calloc(csound, sizeof(REDUCE_VAR));
+      v->dest = dest;
+      v->n = n;
+      v->name = cs_strdup(csound, name);
+      v->copy = (MYFLT**) csound->Calloc(csound, r->nthreads * sizeof(MYFLT*));
+      for (t = 0; t < r->nthreads; t++)
+        v->copy[t] = (MYFLT*) csound->Calloc(csound, n * sizeof(MYFLT));
+      v->dirty = (char*) csound->Calloc(csound, r->nthreads);
+      v->nreads = csound->engineState.maxinsno + 1;
+      v->reads = (signed char*) csound->Malloc(csound, v->nreads);
+      memset(v->reads, -1, v->nreads);
+      csoundSpinLockInit(&v->lock);
+      v->nxt = r->vars;
+      r->vars = v;
+    }
+    csoundSpinUnLock(&r->lock);
+    return v;
+}
+
+/* the calling thread's copy of a reduced global */
+
+MYFLT *csp_reduce_buffer(void *var)
+{
+    REDUCE_VAR *v = (REDUCE_VAR*) var;
+    int     t = reduce_thread;
+
+    if (!v->dirty[t]) {
+      v->dirty[t] = 1;
+      v->pending = 1;
+    }
+    return v->copy[t];
+}
+
+/* start of the DAG: out opcodes write to per thread spouts from now on */
+
+void csp_reduce_begin(CSOUND *csound)
+{
+    CSP_REDUCE *r = (CSP_REDUCE*) csound->reduce;
+    REDUCE_VAR *v;
+    int     t;
+
+    if (UNLIKELY(r->piped_gen != csound->dag_piped_gen)) {
+      for (v = r->vars; v != NULL; v = v->nxt)
+        memset(v->reads, -1, v->nreads);
+      r->piped_gen = csound->dag_piped_gen;
+    }
+    if (UNLIKELY(r->spout == NULL)) {
+      r->spout = (MYFLT**) csound->Calloc(csound,
+                                          r->nthreads * sizeof(MYFLT*));
+      for (t = 0; t < r->nthreads; t++)
+        r->spout[t] = (MYFLT*) csound->Calloc(csound,
+                                              csound->nspout * sizeof(MYFLT));
+      r->nspout = csound->nspout;
+    }
+    csound->reducing = 1;
+}
+
+/* called by each thread as it starts on its part of the DAG */
+
+MYFLT *csp_reduce_thread(CSOUND *csound, int index)
+{
+    reduce_thread = index;
+    return ((CSP_REDUCE*) csound->reduce)->spout[index];
+}
+
+/* called before a task of instrument insno is performed */
+
+void csp_reduce_task(CSOUND *csound, int insno)
+{
+    CSP_REDUCE *r = (CSP_REDUCE*) csound->reduce;
+    REDUCE_VAR *v;
+
+    for (v = r->vars; v != NULL; v = v->nxt)
+      if (v->pending && reduce_reads(csound, v, insno)) {
+        csoundSpinLock(&v->lock);
+        if (v->pending)           /* not already summed by a concurrent reader */
+          reduce_merge(r, v);
+        csoundSpinUnLock(&v->lock);
+      }
+}
+
+/* end of the DAG, all tasks done: sum what is left into the globals and
+   the thread spouts into spraw */
+
+void csp_reduce_end(CSOUND *csound)
+{
+    CSP_REDUCE *r = (CSP_REDUCE*) csound->reduce;
+    REDUCE_VAR *v;
+    int     s, t, nt = r->nthreads, n = r->nspout;
+
+    csound->reducing = 0;
+    for (v = r->vars; v != NULL; v = v->nxt)
+      if (v->pending)
+        reduce_merge(r, v);
+    if (!csound->spoutactive)
+      return;
+    for (s = 1; s < nt; s <<= 1)
+      for (t = 0; t + s < nt; t += 2 * s)
+        reduce_add(r->spout[t], r->spout[t + s], n);
+    reduce_add(csound->spraw, r->spout[0], n);
+    for (t = 0; t < nt; t++)
+      memset(r->spout[t], 0, n * sizeof(MYFLT));
+}
@@ -972,7 +972,7 @@ void free_instrtxt(CSOUND *csound, INSTRTXT *instrtxt) {
     free_instr_var_memory(csound, active);
     if (active->opcod_iobufs != NULL)
       csound->Free(csound, active->opcod_iobufs);
-    csound->Free(csound, active);
+    csound->Free(csound, INSEXT(active));
     active = nxt;
   }
   OPTXT *t = ip->nxtop;
@@ -1010,6 +1010,7 @@ void free_instrtxt(CSOUND *csound, INSTRTXT *instrtxt) {
   }
 
   csoundFreeVarPool(csound, ip->varPool);
+  csound->Free(csound, ip->p1hash);
   csound->Free(csound, ip);
   if (UNLIKELY(csound->oparms->odebug))
     csound->Message(csound, Str("-- deleted instr from deadpool\n"));
@@ -1346,6 +1347,7 @@ end:
 
   instrtxt->instance = instrtxt->act_instance = instrtxt->lst_instance = NULL;
   engineState->instrtxtp[instrNum] = instrtxt;
+  if (merge) csound->dag_stages_changed = 1;   /* stage is per definition */
   //csound->Message(csound, "instrument %d of %d: %p \n",
   //                instrNum, engineState->maxinsno, instrtxt);
 }
@@ -1571,9 +1573,13 @@ static char *node2string(int type) {
 */
 void merge_state(CSOUND *csound, ENGINE_STATE *engineState,
                  TYPE_TABLE *typetable, OPDS *ids) {
+  INSTRTXT *tp;
   if (csound->init_pass_threadlock)
     csoundLockMutex(csound->init_pass_threadlock);
   engineState_merge(csound, engineState);
+  /* new code may assign globals: --init-ahead checks again */
+  for (tp = &csound->engineState.instxtanchor; tp != NULL; tp = tp->nxtinstxt)
+    tp->preinit = 0;
   engineState_free(csound, engineState);
   free_typetable(csound, typetable);
   /* run global i-time code */
@@ -1931,6 +1937,7 @@ void sanitize(CSOUND *csound) {}
 #else
 extern void sanitize(CSOUND *csound);
 #endif
+extern TREE *csoundParseExpandedOrc(CSOUND *csound, const char *text);
 
 /**
    Parse and compile an orchestra given on an string (OPTIONAL)
@@ -1940,7 +1947,8 @@ extern void sanitize(CSOUND *csound);
    async determines asynchronous operation of the
    merge stage.
 */
-int csoundCompileOrcInternal(CSOUND *csound, const char *str, int async) {
+static int compile_orc(CSOUND *csound, const char *str, int async,
+                       int expanded) {
   TREE *root;
   int retVal = 1;
   volatile jmp_buf tmpExitJmp;
@@ -1951,7 +1959,8 @@ int csoundCompileOrcInternal(CSOUND *csound, const char *str, int async) {
     return retVal;
   }
   // retVal = 1;
-  root = csoundParseOrc(csound, str);
+  root = expanded ? csoundParseExpandedOrc(csound, str)
+                  : csoundParseOrc(csound, str);
   if (LIKELY(root != NULL)) {
     retVal = csoundCompileTreeInternal(csound, root, async);
 #ifdef PARCS
@@ -1959,6 +1968,14 @@ int csoundCompileOrcInternal(CSOUND *csound, const char *str, int async) {
     sanitize(csound);
 #endif
     csoundDeleteTree(csound, root);
+    /* keep the preprocessed code for csoundCreateRecompiled(),
+       if csoundKeepOrcHistory() asked for it */
+    if (retVal == CSOUND_SUCCESS && csound->lastExpandedOrc != NULL) {
+      csound->orcHistory =
+        cs_cons_append(csound->orcHistory,
+                       cs_cons(csound, csound->lastExpandedOrc, NULL));
+      csound->lastExpandedOrc = NULL;
+    }
   } else {
     // csoundDeleteTree(csound, root);
     memcpy((void *)&csound->exitjmp, (void *)&tmpExitJmp, sizeof(jmp_buf));
@@ -1971,6 +1988,18 @@ int csoundCompileOrcInternal(CSOUND *csound, const char *str, int async) {
   return retVal;
 }
 
+int csoundCompileOrcInternal(CSOUND *csound, const char *str, int async) {
+  return compile_orc(csound, str, async, 0);
+}
+
+/**
+   Compile orchestra code that has already been preprocessed,
+   as recorded in csound->orcHistory by a previous compilation.
+*/
+int csoundCompileExpandedOrc(CSOUND *csound, const char *str) {
+  return compile_orc(csound, str, 0, 1);
+}
+
 /* prep an instr template for efficient allocs  */
 /* repl arg refs by offset ndx to lcl/gbl space */
 static void insprep(CSOUND *csound, INSTRTXT *tp, ENGINE_STATE *engineState)
@@ -2352,6 +2381,8 @@ void debugPrintCsound(CSOUND *csound) {
 void query_deprecated_opcode(CSOUND *csound, ORCTOKEN *o) {
     char *name = o->lexeme;
     OENTRY *ep = find_opcode(csound, name);
+    if (UNLIKELY(ep->flags &_QQ))
+      orc_cache_note(csound, ORCCACHE_DEPRECATED, name);
     if (UNLIKELY((ep->flags &_QQ) &&
                  (csound->oparms_.msglevel&CS_NOQQ)==CS_NOQQ))
       csound->Warning(csound, Str("Opcode \"%s\" is deprecated\n"), name);
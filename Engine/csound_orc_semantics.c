@@ -34,6 +34,7 @@
 #include "csound_standard_types.h"
 #include "csound_orc_expressions.h"
 #include "csound_orc_semantics.h"
+#include "csmodule.h"
 
 extern char *csound_orcget_text ( void *scanner );
 static int is_label(char* ident, CONS_CELL* labelList);
@@ -628,6 +629,8 @@ OENTRY* find_opcode(CSOUND *csound, char *opname)
     shortName = get_opcode_short_name(csound, opname);
 
     head = cs_hash_table_get(csound, csound->opcodes, shortName);
+    if (UNLIKELY(head == NULL) && csoundLoadDeferredOpcode(csound, shortName))
+      head = cs_hash_table_get(csound, csound->opcodes, shortName);
 
     retVal = (head != NULL) ? head->value : NULL;
     if (shortName != opname) csound->Free(csound, shortName);
@@ -657,6 +660,8 @@ OENTRIES* find_opcode2(CSOUND* csound, char* opname)
 
     shortName = get_opcode_short_name(csound, opname);
     head = cs_hash_table_get(csound, csound->opcodes, shortName);
+    if (UNLIKELY(head == NULL) && csoundLoadDeferredOpcode(csound, shortName))
+      head = cs_hash_table_get(csound, csound->opcodes, shortName);
     retVal = get_entries(csound, cs_cons_length(head));
     while (head != NULL) {
       retVal->entries[i++] = head->value;
@@ -0,0 +1,237 @@
+/*
+    cstrace.c:
+
+    Copyright (C) 2026 The Csound Developers
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+/* Timeline tracing of k-cycles, init passes, table generation, DAG
+ * builds, instrument performance and I/O threads, exported as Chrome
+ * trace JSON.  Any thread may record: a slot in the ring is claimed
+ * with one atomic increment, so recording never blocks.
+ */
+
+#include "csoundCore.h"
+#include "cstrace.h"
+
+#if defined(_MSC_VER)
+#define TRACE_TLS __declspec(thread)
+#else
+#define TRACE_TLS __thread
+#endif
+
+typedef struct {
+    double  t;                  /* seconds since tracing started */
+    const char *name;           /* NULL: slot not written yet */
+    long    seq;                /* order of recording */
+    int32_t arg;                /* instrument or table number, or -1 */
+    int32_t track;
+    char    ph;                 /* 'B'egin or 'E'nd */
+} TRACE_EVENT;
+
+typedef struct {
+    TRACE_EVENT *ring;
+    unsigned long mask;         /* ring size - 1 */
+    volatile long wp;
+    RTCLOCK clock;
+    char    *file;              /* written by csoundCleanup(), or NULL */
+} CSTRACE;
+
+static TRACE_TLS int trace_track = TRACE_PERF;
+
+/* the name recorded for instrument performance; written out as the
+   instrument name or number */
+const char cstrace_instr[] = "instr";
+
+void cstrace_thread(int track)
+{
+    trace_track = track;
+}
+
+void cstrace_event(CSOUND *csound, const char *name, int32_t arg, char ph)
+{
+    CSTRACE *tr = (CSTRACE*) csound->trace;
+    TRACE_EVENT *e;
+    long    seq;
+
+    if (UNLIKELY(tr == NULL))
+      return;
+    seq = ATOMIC_INCR(tr->wp);
+    e = &tr->ring[(unsigned long) seq & tr->mask];
+    e->name = NULL;
+    e->t = csoundGetRealTime(&tr->clock);
+    e->seq = seq;
+    e->arg = arg;
+    e->track = trace_track;
+    e->ph = ph;
+    e->name = name;
+}
+
+/* Start recording into a new ring of at least nevents events, dropping
+   anything recorded so far; nevents <= 0 stops tracing.  The old ring is
+   not freed, as other threads may still be writing to it; all trace
+   memory is released by csoundReset(). */
+
+PUBLIC int csoundSetTrace(CSOUND *csound, int nevents)
+{
+    CSTRACE *tr, *old = (CSTRACE*) csound->trace;
+    unsigned long size = 1024;
+
+    if (nevents <= 0) {
+      csound->trace = NULL;
+      return CSOUND_SUCCESS;
+    }
+    while (size < (unsigned long) nevents && size < (1UL << 30))
+      size <<= 1;
+    tr = (CSTRACE*) csound->Calloc(csound, sizeof(CSTRACE));
+    tr->ring = (TRACE_EVENT*) csound->Calloc(csound,
+                                             size * sizeof(TRACE_EVENT));
+    tr->mask = size - 1;
+    tr->file = (old != NULL ? old->file : NULL);
+    csoundInitTimerStruct(&tr->clock);
+    csound->trace = tr;
+    return CSOUND_SUCCESS;
+}
+
+/* --trace=FILE */
+
+int cstrace_start(CSOUND *csound, const char *file)
+{
+    CSTRACE *tr;
+
+    csoundSetTrace(csound, TRACE_DFLT_SIZE);
+    tr = (CSTRACE*) csound->trace;
+    tr->file = cs_strdup(csound, (char*) file);
+    return CSOUND_SUCCESS;
+}
+
+static int cmp_seq(const void *a, const void *b)
+{
+    long x = (*(const TRACE_EVENT**) a)->seq;
+    long y = (*(const TRACE_EVENT**) b)->seq;
+    return (x < y ? -1 : (x > y ? 1 : 0));
+}
+
+static const char *track_name(int track, char *buf)
+{
+    if (track == TRACE_PERF) return "performance";
+    if (track == TRACE_ALLOC) return "event insertion";
+    if (track == TRACE_FILEIO) return "file I/O";
+    if (track == TRACE_DISKIN) return "diskin2 I/O";
+    if (track == TRACE_PVSIO) return "pvsfwrite I/O";
+    if (track >= TRACE_POOL)
+      snprintf(buf, 32, "pool thread %d", track - TRACE_POOL + 1);
+    else
+      snprintf(buf, 32, "worker %d", track);
+    return buf;
+}
+
+static void write_event(CSOUND *csound, FILE *f, const TRACE_EVENT *e,
+                        int first)
+{
+    INSTRTXT **instrs = csound->engineState.instrtxtp;
+
+    fprintf(f, "%s\n{\"ph\":\"%c\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,",
+            first ? "" : ",", e->ph, e->track, e->t * 1.0e6);
+    if (e->name == cstrace_instr) {
+      if (e->arg > 0 && e->arg <= csound->engineState.maxinsno &&
+          instrs[e->arg] != NULL && instrs[e->arg]->insname != NULL)
+        fprintf(f, "\"name\":\"instr %s\"}", instrs[e->arg]->insname);
+      else
+        fprintf(f, "\"name\":\"instr %d\"}", e->arg);
+    }
+    else if (e->arg >= 0)
+      fprintf(f, "\"name\":\"%s\",\"args\":{\"n\":%d}}", e->name, e->arg);
+    else
+      fprintf(f, "\"name\":\"%s\"}", e->name);
+}
+
+/* Write the events in the ring to 'filename' as Chrome trace JSON.
+   Begin/end pairs cut in half by the ring wrapping around are dropped.
+   Tracing goes on. */
+
+PUBLIC int csoundWriteTrace(CSOUND *csound, const char *filename)
+{
+    CSTRACE *tr = (CSTRACE*) csound->trace;
+    TRACE_EVENT **ev;
+    FILE    *f;
+    void    *fd;
+    unsigned long i, n = 0;
+    int     *depth, *seen, ntracks = TRACE_PVSIO + 1, first = 1;
+    char    buf[32];
+
+    if (UNLIKELY(tr == NULL || filename == NULL))
+      return CSOUND_ERROR;
+    fd = csound->FileOpen2(csound, &f, CSFILE_STD, filename, "w", NULL,
+                           CSFTYPE_OTHER_TEXT, 0);
+    if (UNLIKELY(fd == NULL)) {
+      csound->ErrorMsg(csound, Str("trace: cannot open %s"), filename);
+      return CSOUND_ERROR;
+    }
+    ev = (TRACE_EVENT**) csound->Malloc(csound, sizeof(TRACE_EVENT*)
+                                        * (tr->mask + 1));
+    for (i = 0; i <= tr->mask; i++)
+      if (tr->ring[i].name != NULL)
+        ev[n++] = &tr->ring[i];
+    qsort(ev, n, sizeof(TRACE_EVENT*), cmp_seq);
+    depth = (int*) csound->Calloc(csound, sizeof(int) * 2 * ntracks);
+    seen = depth + ntracks;
+
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    for (i = 0; i < n; i++) {
+      TRACE_EVENT *e = ev[i];
+      if (e->track < 0 || e->track >= ntracks)
+        continue;
+      if (e->ph == 'E') {
+        if (depth[e->track] == 0)       /* its begin has been overwritten */
+          continue;
+        depth[e->track]--;
+      }
+      else depth[e->track]++;
+      seen[e->track] = 1;
+      write_event(csound, f, e, first);
+      first = 0;
+    }
+    for (i = 0; i < (unsigned long) ntracks; i++)
+      if (seen[i]) {
+        fprintf(f, "%s\n{\"ph\":\"M\",\"pid\":1,\"tid\":%lu,"
+                "\"name\":\"thread_name\",\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",", i, track_name((int) i, buf));
+        first = 0;
+      }
+    fprintf(f, "\n]}\n");
+    csound->FileClose(csound, fd);
+    csound->Free(csound, depth);
+    csound->Free(csound, ev);
+    csound->Message(csound, Str("trace: %lu events written to %s\n"),
+                    n, filename);
+    return CSOUND_SUCCESS;
+}
+
+/* called by csoundCleanup(): write the --trace file */
+
+void cstrace_cleanup(CSOUND *csound)
+{
+    CSTRACE *tr = (CSTRACE*) csound->trace;
+
+    if (tr == NULL || tr->file == NULL)
+      return;
+    csoundWriteTrace(csound, tr->file);
+    tr->file = NULL;
+}
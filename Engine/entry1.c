@@ -125,6 +125,7 @@ OENTRY opcodlst_1[] = {
   { "turnon", S(TURNON),  0,1,      "",     "io", turnon, NULL, NULL, NULL},
   { "turnon.S", S(TURNON),  0,1,    "",     "So", turnon_S, NULL, NULL, NULL},
   { "remoteport", S(REMOTEPORT), 0,1, "",  "i", remoteport, NULL, NULL, NULL},
+  { "remoteaudio", S(REMOTEAUDIO), 0,1, "", "p", remoteaudio, NULL, NULL, NULL},
   { "insremot",S(INSREMOT),0,1,     "",     "SSm",insremot, NULL, NULL, NULL},
   { "midremot",S(MIDREMOT),0,1,     "",     "SSm",midremot, NULL, NULL, NULL},
   { "insglobal",S(INSGLOBAL),0,1,   "",     "Sm", insglobal, NULL, NULL, NULL},
@@ -200,14 +201,14 @@ OENTRY opcodlst_1[] = {
   { "##mul.aa",  S(AOP),0,    2,      "a",    "aa",   NULL,   mulaa   },
   { "##div.aa",  S(AOP),0,    2,      "a",    "aa",   NULL,   divaa   },
   { "##mod.aa",  S(AOP),0,    2,      "a",    "aa",   NULL,   modaa   },
-  { "##addin.i", S(ASSIGN),0, 1,      "i",    "i",    addin,  NULL    },
-  { "##addin.k", S(ASSIGN),0, 2,      "k",    "k",    NULL,   addin   },
-  { "##addin.K", S(ASSIGN),0, 2,      "a",    "k",    NULL,   addinak },
-  { "##addin.a", S(ASSIGN),0, 2,      "a",    "a",    NULL,   addina  },
-  { "##subin.i", S(ASSIGN),0, 1,      "i",    "i",    subin,  NULL    },
-  { "##subin.k", S(ASSIGN),0, 2,      "k",    "k",    NULL,   subin   },
-  { "##subin.K", S(ASSIGN),0, 2,      "a",    "k",    NULL,   subinak },
-  { "##subin.a", S(ASSIGN),0, 2,      "a",    "a",    NULL,   subina  },
+  { "##addin.i", S(ADDIN),0,  1,      "i",    "i",    addin,  NULL    },
+  { "##addin.k", S(ADDIN),0,  3,      "k",    "k",    addin_set, addin },
+  { "##addin.K", S(ADDIN),0,  3,      "a",    "k",    addin_set, addinak },
+  { "##addin.a", S(ADDIN),0,  3,      "a",    "a",    addin_set, addina },
+  { "##subin.i", S(ADDIN),0,  1,      "i",    "i",    subin,  NULL    },
+  { "##subin.k", S(ADDIN),0,  3,      "k",    "k",    addin_set, subin },
+  { "##subin.K", S(ADDIN),0,  3,      "a",    "k",    addin_set, subinak },
+  { "##subin.a", S(ADDIN),0,  3,      "a",    "a",    addin_set, subina },
   //{ "divz",   0xfffc                                                      },
   { "divz.ii", S(DIVZ),0,   1,      "i",    "iii",  divzkk, NULL,   NULL    },
   { "divz.kk", S(DIVZ),0,   2,      "k",    "kkk",  NULL,   divzkk, NULL    },
@@ -853,6 +854,8 @@ OENTRY opcodlst_1[] = {
     (SUBR)lphasor_set, (SUBR)lphasor },
   { "tablexkt", S(TABLEXKT),TR, 3, "a", "xkkiooo", (SUBR)tablexkt_set,
     (SUBR)tablexkt              },
+  { "tablexs", S(TABLEXS),TR, 3, "a", "xkipooo", (SUBR)tablexs_set,
+    (SUBR)tablexs               },
   { "reverb2",  S(NREV2),0,  3,     "a",    "akkoojoj",
     (SUBR)reverbx_set,(SUBR)reverbx  },
   { "nreverb",  S(NREV2),0,  3,     "a",    "akkoojoj",
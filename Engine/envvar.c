@@ -39,6 +39,7 @@
 
 
 #include "namedins.h"
+#include "cstrace.h"
 
 /* list of environment variables used by Csound */
 
@@ -70,10 +71,20 @@ typedef struct CSFILE_ {
     SNDFILE         *sf;
     void            *cb;
     int             async_flag;
-    int             items;
+    /* asynchronous files only, see csoundFileOpenWithType_Async() */
+    int             writing;        /* perf thread writes, I/O thread reads */
+    int             elemsize;       /* sizeof(MYFLT), or 1 for byte streams */
+    int             items;          /* elements of buf not yet in the ring */
     int             pos;
-    MYFLT           *buf;
+    void            *buf;           /* I/O thread's transfer buffer */
     int             bufsize;
+    int             ringsize;
+    unsigned int    queued;         /* elements enqueued by the perf thread */
+    unsigned int    done;           /* ... and written out by the I/O thread */
+    int             eof;            /* reader: ring holds the rest of file */
+    int             ungot;          /* byte pushed back by csoundUngetAsync() */
+    unsigned int    overflows;      /* elements dropped, ring was full */
+    unsigned int    underruns;      /* reads that found the ring short */
     char            fullName[1];
 } CSFILE;
 
@@ -1276,6 +1287,9 @@ char *csoundGetFileName(void *fd)
     return &(((CSFILE*) fd)->fullName[0]);
 }
 
+static int async_drain(CSOUND *, CSFILE *);
+static void async_report(CSOUND *, CSFILE *);
+
 /**
  * Close a file previously opened with csoundFileOpen().
  */
@@ -1286,6 +1300,10 @@ int csoundFileClose(CSOUND *csound, void *fd)
     int     retval = -1;
     if (p->async_flag == ASYNC_GLOBAL) {
       csound->WaitThreadLockNoTimeout(csound->file_io_threadlock);
+      /* write out whatever is still queued before closing */
+      if (p->writing)
+        async_drain(csound, p);
+      async_report(csound, p);
       /* close file */
       switch (p->type) {
       case CSFILE_FD_R:
@@ -1354,11 +1372,14 @@ void close_all_files(CSOUND *csound)
     while (csound->open_files != NULL)
       csoundFileClose(csound, csound->open_files);
     if (csound->file_io_start) {
+      ATOMIC_SET(csound->file_io_start, 0);
 #ifndef __EMSCRIPTEN__
       csound->JoinThread(csound->file_io_thread);
 #endif
+      csound->file_io_thread = NULL;
       if (csound->file_io_threadlock != NULL)
         csound->DestroyThreadLock(csound->file_io_threadlock);
+      csound->file_io_threadlock = NULL;
     }
 }
 
@@ -1394,18 +1415,186 @@ void *fopen_path(CSOUND *csound, FILE **fp, char *name, char *basename,
     return fd;
 }
 
+/* Asynchronous files
+ *
+ * Files opened with csoundFileOpenWithType_Async() are read and written
+ * by a single I/O thread per Csound instance, so that a slow disk does
+ * not stall the performance thread.  Each file has a lock-free ring
+ * (single producer, single consumer) between the opcode and the I/O
+ * thread: writers enqueue and the thread drains to disk, readers are
+ * kept topped up ahead of time.  The thread lock only guards the list
+ * of open files, seeking and closing; the rings are never locked.
+ *
+ * Sound files carry MYFLT samples, CSFILE_STD files carry bytes.  When
+ * the thread falls behind, writes that do not fit are dropped and reads
+ * are padded with silence; both are counted and reported when the file
+ * is flushed or closed.
+ */
+
+#define ASYNC_RING_TIME   (0.5)     /* seconds of audio held per sound file */
+#define ASYNC_RING_BYTES  (65536)   /* minimum ring size of byte streams */
+
 uintptr_t file_iothread(void *p);
 
+/* read the next block of an asynchronous reader into p->buf */
+
+static int async_read_block(CSFILE *p)
+{
+    int n = 0;
+
+    switch (p->type) {
+    case CSFILE_SND_R:
+      n = (int) sf_read_MYFLT(p->sf, (MYFLT*) p->buf, p->bufsize);
+      break;
+    case CSFILE_STD:
+      n = (int) fread(p->buf, 1, p->bufsize, p->f);
+      break;
+    }
+    return (n > 0 ? n : 0);
+}
+
+/* top up the ring of a reader, until it is full or the file has been
+   read to the end; returns non-zero if anything was transferred */
+
+static int async_fill(CSOUND *csound, CSFILE *p)
+{
+    int busy = 0;
+
+    while (!p->eof) {
+      int n = p->items, m = p->pos, l;
+      if (n == 0) {
+        if ((n = async_read_block(p)) == 0) {
+          ATOMIC_SET(p->eof, 1);
+          break;
+        }
+        m = 0;
+      }
+      l = csound->WriteCircularBuffer(csound, p->cb,
+                                      (char*) p->buf + m * p->elemsize, n);
+      p->items = n - l;
+      p->pos = m + l;
+      if (l > 0) busy = 1;
+      if (p->items > 0)         /* ring is full */
+        break;
+    }
+    return busy;
+}
+
+/* write out everything a writer has queued so far */
+
+static int async_drain(CSOUND *csound, CSFILE *p)
+{
+    int n, busy = 0;
+
+    while ((n = csound->ReadCircularBuffer(csound, p->cb,
+                                           p->buf, p->bufsize)) > 0) {
+      switch (p->type) {
+      case CSFILE_SND_W:
+        sf_write_MYFLT(p->sf, (MYFLT*) p->buf, n);
+        break;
+      case CSFILE_STD:
+        if (UNLIKELY(fwrite(p->buf, 1, n, p->f) != (size_t) n))
+          csound->Warning(csound, Str("write failure on '%s'"), p->fullName);
+        break;
+      }
+      ATOMIC_SET(p->done, p->done + n);
+      busy = 1;
+    }
+    return busy;
+}
+
+static void async_report(CSOUND *csound, CSFILE *p)
+{
+    if (UNLIKELY(p->overflows))
+      csound->Warning(csound, Str("%s: %u %s dropped, file I/O fell behind"),
+                      p->fullName, p->overflows,
+                      p->elemsize == 1 ? Str("bytes") : Str("samples"));
+    if (UNLIKELY(p->underruns))
+      csound->Warning(csound, Str("%s: %u reads not ready in time, "
+                                  "file I/O fell behind"),
+                      p->fullName, p->underruns);
+    p->overflows = p->underruns = 0;
+}
+
+/* one pass of the I/O thread over all asynchronous files */
+
+static int async_service(CSOUND *csound)
+{
+    CSFILE *current = (CSFILE *) csound->open_files;
+    int busy = 0;
+
+    for ( ; current != NULL; current = current->nxt) {
+      if (current->async_flag != ASYNC_GLOBAL)
+        continue;
+      if (current->writing)
+        busy |= async_drain(csound, current);
+      else
+        busy |= async_fill(csound, current);
+    }
+    return busy;
+}
+
+/* Write out everything queued on asynchronous writers and bring their
+   files up to date on disk; called by csoundCleanup() so that files are
+   complete when the performance ends, not only when they are closed. */
+
+void flush_async_files(CSOUND *csound)
+{
+    CSFILE *current;
+
+    if (!csound->file_io_start || csound->file_io_threadlock == NULL)
+      return;
+    csound->WaitThreadLockNoTimeout(csound->file_io_threadlock);
+    for (current = (CSFILE *) csound->open_files; current != NULL;
+         current = current->nxt) {
+      if (current->async_flag != ASYNC_GLOBAL)
+        continue;
+      if (current->writing) {
+        async_drain(csound, current);
+        if (current->type == CSFILE_SND_W)
+          sf_write_sync(current->sf);
+        else if (current->type == CSFILE_STD)
+          fflush(current->f);
+      }
+      async_report(csound, current);
+    }
+    csound->NotifyThreadLock(csound->file_io_threadlock);
+}
+
 void *csoundFileOpenWithType_Async(CSOUND *csound, void *fd, int type,
-                                   const char *name, void *param, const char *env,
-                                   int csFileType, int buffsize, int isTemporary)
+                                   const char *name, void *param,
+                                   const char *env, int csFileType,
+                                   int buffsize, int isTemporary)
 {
 #ifndef __EMSCRIPTEN__
     CSFILE *p;
+    int    ringsize;
+
+    if (UNLIKELY(type != CSFILE_SND_R && type != CSFILE_SND_W &&
+                 type != CSFILE_STD)) {
+      csoundErrorMsg(csound, Str("internal error: csoundFileOpenAsync(): "
+                                 "invalid type: %d"), type);
+      return NULL;
+    }
     if ((p = (CSFILE *) csoundFileOpenWithType(csound,fd,type,name,param,env,
                                                csFileType,isTemporary)) == NULL)
       return NULL;
 
+    if (buffsize < 1) buffsize = 1024;
+    ringsize = buffsize * 4;
+    if (type == CSFILE_STD) {
+      p->elemsize = 1;
+      p->writing = (((char*) param)[0] != 'r');
+      if (ringsize < ASYNC_RING_BYTES) ringsize = ASYNC_RING_BYTES;
+    }
+    else {
+      int  minsize = (int) (csound->esr * ASYNC_RING_TIME)
+                       * ((SF_INFO*) param)->channels;
+      p->elemsize = (int) sizeof(MYFLT);
+      p->writing = (type == CSFILE_SND_W);
+      if (ringsize < minsize) ringsize = minsize;
+    }
+
     if (csound->file_io_start == 0) {
       csound->file_io_start = 1;
       csound->file_io_threadlock = csound->CreateThreadLock();
@@ -1416,11 +1605,19 @@ void *csoundFileOpenWithType_Async(CSOUND *csound, void *fd, int type,
     csound->WaitThreadLockNoTimeout(csound->file_io_threadlock);
     p->async_flag = ASYNC_GLOBAL;
 
-    p->cb = csound->CreateCircularBuffer(csound, buffsize*4, sizeof(MYFLT));
+    p->cb = csound->CreateCircularBuffer(csound, ringsize, p->elemsize);
+    p->ringsize = ringsize;
     p->items = 0;
     p->pos = 0;
     p->bufsize = buffsize;
-    p->buf = (MYFLT *) csound->Calloc(csound, sizeof(MYFLT)*buffsize);
+    p->buf = csound->Calloc(csound, (size_t) p->elemsize * buffsize);
+    p->queued = p->done = 0;
+    p->eof = 0;
+    p->ungot = -1;
+    p->overflows = p->underruns = 0;
+    /* readers start with a full ring */
+    if (p->cb != NULL && p->buf != NULL && !p->writing)
+      async_fill(csound, p);
     csound->NotifyThreadLock(csound->file_io_threadlock);
 
     if (p->cb == NULL || p->buf == NULL) {
@@ -1434,22 +1631,100 @@ void *csoundFileOpenWithType_Async(CSOUND *csound, void *fd, int type,
 #endif
 }
 
+/* Reads from the ring of an asynchronous reader.  If the I/O thread has
+   not caught up, the missing samples are returned as silence so that
+   callers do not take a late read for the end of the file. */
+
 unsigned int csoundReadAsync(CSOUND *csound, void *handle,
                              MYFLT *buf, int items)
 {
     CSFILE *p = handle;
-    if (p != NULL &&  p->cb != NULL)
-      return csound->ReadCircularBuffer(csound, p->cb, buf, items);
-    else return 0;
+    int    eof, n;
+
+    if (p == NULL || p->cb == NULL)
+      return 0;
+    eof = ATOMIC_GET(p->eof);   /* before reading: no data comes after it */
+    n = csound->ReadCircularBuffer(csound, p->cb, buf, items);
+    if (UNLIKELY(n < items && !eof)) {
+      p->underruns++;
+      memset(buf + n, 0, sizeof(MYFLT) * (items - n));
+      n = items;
+    }
+    return (unsigned int) n;
 }
 
+/* Queues samples on an asynchronous writer; what does not fit in the
+   ring is dropped and counted. */
+
 unsigned int csoundWriteAsync(CSOUND *csound, void *handle,
                               MYFLT *buf, int items)
 {
     CSFILE *p = handle;
-    if (p != NULL &&  p->cb != NULL)
-      return csound->WriteCircularBuffer(csound, p->cb, buf, items);
-    else return 0;
+    int    n;
+
+    if (p == NULL || p->cb == NULL)
+      return 0;
+    n = csound->WriteCircularBuffer(csound, p->cb, buf, items);
+    p->queued += n;
+    if (UNLIKELY(n < items))
+      p->overflows += items - n;
+    return (unsigned int) n;
+}
+
+/* Byte stream versions for CSFILE_STD files.  Reads and writes are all
+   or nothing, so that binary records are never split: a read that the
+   ring cannot satisfy yet returns 0 (and is counted) unless the file is
+   at its end, and a write that does not fit is dropped whole. */
+
+unsigned int csoundReadAsyncBytes(CSOUND *csound, void *handle,
+                                  char *buf, int items)
+{
+    CSFILE *p = handle;
+    int    eof, n, first = 0;
+
+    if (p == NULL || p->cb == NULL || items <= 0)
+      return 0;
+    eof = ATOMIC_GET(p->eof);
+    if (p->ungot >= 0)
+      first = 1;
+    n = csoundPeekCircularBuffer(csound, p->cb, buf + first, items - first);
+    if (UNLIKELY(n < items - first && !eof)) {
+      p->underruns++;
+      return 0;
+    }
+    n = csound->ReadCircularBuffer(csound, p->cb, buf + first, n);
+    if (first) {
+      buf[0] = (char) p->ungot;
+      p->ungot = -1;
+    }
+    return (unsigned int) (n + first);
+}
+
+/* push back one byte, like ungetc() */
+
+void csoundUngetAsync(CSOUND *csound, void *handle, int c)
+{
+    IGN(csound);
+    if (handle != NULL && c >= 0)
+      ((CSFILE*) handle)->ungot = (unsigned char) c;
+}
+
+unsigned int csoundWriteAsyncBytes(CSOUND *csound, void *handle,
+                                   const char *buf, int items)
+{
+    CSFILE *p = handle;
+    int    n;
+
+    if (p == NULL || p->cb == NULL)
+      return 0;
+    if (UNLIKELY((int) (p->queued - ATOMIC_GET(p->done)) + items
+                 > p->ringsize - 1)) {
+      p->overflows += items;
+      return 0;
+    }
+    n = csound->WriteCircularBuffer(csound, p->cb, buf, items);
+    p->queued += n;
+    return (unsigned int) n;
 }
 
 int csoundFSeekAsync(CSOUND *csound, void *handle, int pos, int whence){
@@ -1465,70 +1740,40 @@ int csoundFSeekAsync(CSOUND *csound, void *handle, int pos, int whence){
       break;
     case CSFILE_SND_R:
     case CSFILE_SND_W:
+      if (p->writing)
+        async_drain(csound, p);
       ret = sf_seek(p->sf,pos,whence);
       //csoundMessage(csound, "seek set %d\n", pos);
       csound->FlushCircularBuffer(csound, p->cb);
       p->items = 0;
+      /* refill at once, so the next read does not find the ring empty */
+      if (!p->writing) {
+        p->eof = 0;
+        async_fill(csound, p);
+      }
       break;
     }
     csound->NotifyThreadLock(csound->file_io_threadlock);
     return ret;
 }
 
-
-static int read_files(CSOUND *csound){
-    CSFILE *current = (CSFILE *) csound->open_files;
-    if (current == NULL) return 0;
-    while (current) {
-      if (current->async_flag == ASYNC_GLOBAL) {
-        int m = current->pos, l, n = current->items;
-        int items = current->bufsize;
-        MYFLT *buf = current->buf;
-        switch (current->type) {
-        case CSFILE_FD_R:
-          break;
-        case CSFILE_FD_W:
-          break;
-        case CSFILE_STD:
-          break;
-        case CSFILE_SND_R:
-          if (n == 0) {
-            n = sf_read_MYFLT(current->sf, buf, items);
-            m = 0;
-          }
-          l = csound->WriteCircularBuffer(csound,current->cb,&buf[m],n);
-          m += l;
-          n -= l;
-          current->items = n;
-          current->pos = m;
-          break;
-        case CSFILE_SND_W:
-          items = csound->ReadCircularBuffer(csound, current->cb, buf, items);
-          if (items == 0) { csoundSleep(10); break;}
-          sf_write_MYFLT(current->sf, buf, items);
-          break;
-        }
-      }
-      current = current->nxt;
-    }
-    return 1;
-}
-
-
-
-
 uintptr_t file_iothread(void *p){
-    int res = 1;
     CSOUND *csound = p;
     int wakeup = (int) (1000*csound->ksmps/csound->esr);
     _MM_SET_DENORMALS_ZERO_MODE(_MM_DENORMALS_ZERO_ON);
     if (wakeup == 0) wakeup = 1;
-    while (res){
-      csoundSleep(wakeup);
+    cstrace_thread(TRACE_FILEIO);
+    /* runs until close_all_files() clears file_io_start */
+    while (ATOMIC_GET(csound->file_io_start)) {
+      int busy;
       csound->WaitThreadLockNoTimeout(csound->file_io_threadlock);
-      res = read_files(csound);
+      TRACE_BEGIN(csound, "file_io", -1);
+      busy = async_service(csound);
+      TRACE_END(csound, "file_io", -1);
       csound->NotifyThreadLock(csound->file_io_threadlock);
+      /* sleep only after a pass with nothing to do */
+      if (!busy)
+        csoundSleep(wakeup);
     }
-    csound->file_io_start = 0;
     return (uintptr_t)NULL;
 }
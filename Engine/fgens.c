@@ -32,6 +32,7 @@
 #include "fgens.h"
 #include "pstream.h"
 #include "pvfileio.h"
+#include "cstrace.h"
 #include <stdlib.h>
 /* #undef ISSTRCOD */
 
@@ -130,7 +131,22 @@ static inline unsigned int isPowerOfTwo (unsigned int x) {
  * Returns zero on success.
  */
 
+static int hfgens_(CSOUND *csound, FUNC **ftpp, const EVTBLK *evtblkp,
+                   int mode);
+
 int hfgens(CSOUND *csound, FUNC **ftpp, const EVTBLK *evtblkp, int mode)
+{
+    int     err;
+
+    TRACE_BEGIN(csound, "hfgens", (int32_t) evtblkp->p[1]);
+    err = hfgens_(csound, ftpp, evtblkp, mode);
+    ATOMIC_INCR(csound->ftables_made);  /* for --init-ahead */
+    TRACE_END(csound, "hfgens", (int32_t) evtblkp->p[1]);
+    return err;
+}
+
+static int hfgens_(CSOUND *csound, FUNC **ftpp, const EVTBLK *evtblkp,
+                   int mode)
 {
     int32    genum, ltest;
     int     lobits, msg_enabled, i;
@@ -387,6 +403,7 @@ int csoundFTDelete(CSOUND *csound, int tableNum)
       return -1;
     csound->flist[tableNum] = NULL;
     csound->Free(csound, ftp);
+    ATOMIC_INCR(csound->ftables_made);
 
     return 0;
 }
@@ -33,6 +33,8 @@
 #include "interlocks.h"
 #include "csound_type_system.h"
 #include "csound_standard_types.h"
+#include "cstrace.h"
+#include "cpubudget.h"
 #include <inttypes.h>
 
 static  void    showallocs(CSOUND *);
@@ -45,6 +47,10 @@ extern int argsRequired(char* argString);
 static int insert_midi(CSOUND *csound, int insno, MCHNBLK *chn,
                        MEVENT *mep);
 static int insert_event(CSOUND *csound, int insno, EVTBLK *newevtp);
+typedef struct preinit_ PREINIT;
+static void preinit_event(CSOUND *csound, PREINIT *pre);
+static void preinit_start(CSOUND *csound, PREINIT *pre);
+static int preinit_held(CSOUND *csound, INSDS *ip);
 
 static void print_messages(CSOUND *csound, int attr, const char *str){
 #if defined(WIN32)
@@ -107,6 +113,7 @@ static int init_pass(CSOUND *csound, INSDS *ip) {
   int error = 0;
   if(csound->oparms->realtime)
     csoundLockMutex(csound->init_pass_threadlock);
+  TRACE_BEGIN(csound, "init_pass", ip->insno);
   csound->curip = ip;
   csound->ids = (OPDS *)ip;
   csound->mode = 1;
@@ -117,6 +124,7 @@ static int init_pass(CSOUND *csound, INSDS *ip) {
     error = (*csound->ids->iopadr)(csound, csound->ids);
   }
   csound->mode = 0;
+  TRACE_END(csound, "init_pass", ip->insno);
   if(csound->oparms->realtime)
     csoundUnlockMutex(csound->init_pass_threadlock);
   return error;
@@ -129,6 +137,7 @@ static int reinit_pass(CSOUND *csound, INSDS *ip, OPDS *ids) {
   if(csound->oparms->realtime) {
     csoundLockMutex(csound->init_pass_threadlock);
   }
+  TRACE_BEGIN(csound, "reinit_pass", ip->insno);
   csound->curip = ip;
   csound->ids = ids;
   csound->mode = 1;
@@ -143,6 +152,7 @@ static int reinit_pass(CSOUND *csound, INSDS *ip, OPDS *ids) {
 
   ATOMIC_SET8(ip->actflg, 1);
   csound->reinitflag = ip->reinitflag = 0;
+  TRACE_END(csound, "reinit_pass", ip->insno);
   if(csound->oparms->realtime)
     csoundUnlockMutex(csound->init_pass_threadlock);
   return error;
@@ -178,13 +188,16 @@ uintptr_t event_insert_thread(void *p) {
  } else {
   csoundSetMessageCallback(csound, no_op);
  }
+  cstrace_thread(TRACE_ALLOC);
 
   while(csound->event_insert_loop) {
     // get the value of items_to_alloc
     items = ATOMIC_GET(csound->alloc_queue_items);
     if(items == 0)
        csoundSleep((int) ((int) wakeup > 0 ? wakeup : 1));
-    else while(items) {
+    else {
+      TRACE_BEGIN(csound, "alloc_queue", (int32_t) items);
+      while(items) {
         if (inst[rp].type == 3)  {
           INSDS *ip = inst[rp].ip;
           OPDS *ids = inst[rp].ids;
@@ -211,11 +224,23 @@ uintptr_t event_insert_thread(void *p) {
           insert_event(csound, inst[rp].insno, &inst[rp].blk);
           csoundSpinUnLock(&csound->alloc_spinlock);
         }
+        if (inst[rp].type == 4)  {       /* --init-ahead */
+          csoundSpinLock(&csound->alloc_spinlock);
+          preinit_event(csound, (PREINIT*) inst[rp].preinit);
+          csoundSpinUnLock(&csound->alloc_spinlock);
+        }
+        if (inst[rp].type == 5)  {
+          csoundSpinLock(&csound->alloc_spinlock);
+          preinit_start(csound, (PREINIT*) inst[rp].preinit);
+          csoundSpinUnLock(&csound->alloc_spinlock);
+        }
         // decrement the value of items_to_alloc
         ATOMIC_DECR(csound->alloc_queue_items);
         items--;
         rp = rp + 1 < MAX_ALLOC_QUEUE ? rp + 1 : 0;
       }
+      TRACE_END(csound, "alloc_queue", -1);
+    }
      items = ATOMIC_GET(csound->message_string_queue_items);
      while(items) {
        if(mess != NULL)
@@ -305,117 +330,168 @@ int insert(CSOUND *csound, int insno, EVTBLK *newevtp) {
   else return insert_event(csound, insno, newevtp);
 }
 
-int insert_event(CSOUND *csound, int insno, EVTBLK *newevtp)
+/* pop an instance of instr insno from its free chain, allocating one if
+   there is none */
+
+static INSDS *pop_instance(CSOUND *csound, INSTRTXT *tp, int insno)
 {
-  INSTRTXT  *tp;
-  INSDS     *ip, *prvp, *nxtp;
-  OPARMS    *O = csound->oparms;
-  CS_VAR_MEM *pfields = NULL;        /* *** was uninitialised *** */
-  int tie=0, i;
-  int  n, error = 0;
-  MYFLT  *flp, *fep;
+  INSDS     *ip;
 
-  if (UNLIKELY(csound->advanceCnt))
-    return 0;
-  if (UNLIKELY(O->odebug)) {
-    char *name = csound->engineState.instrtxtp[insno]->insname;
-    if (UNLIKELY(name))
-        csound->Message(csound, Str("activating instr %s at %"PRIi64"\n"),
-                      name, csound->icurTime);
-    else
-        csound->Message(csound, Str("activating instr %d at %"PRIi64"\n"),
-                      insno, csound->icurTime);
+  /* alloc new dspace if needed */
+  if (tp->act_instance == NULL || tp->isNew) {
+    if (UNLIKELY(csound->oparms->msglevel & CS_RNGEMSG)) {
+      char *name = csound->engineState.instrtxtp[insno]->insname;
+      if (UNLIKELY(name))
+        csound->ErrorMsg(csound, Str("new alloc for instr %s:\n"), name);
+      else
+        csound->ErrorMsg(csound, Str("new alloc for instr %d:\n"), insno);
+    }
+    instance(csound, insno);
+    tp->isNew=0;
   }
-  csound->inerrcnt = 0;
 
+  /* pop from free instance chain */
+  csoundDebugMsg(csound, "insert(): tp->act_instance = %p\n", tp->act_instance);
+  ip = tp->act_instance;
+  ATOMIC_SET(ip->init_done, 0);
+  tp->act_instance = ip->nxtact;
+  ip->insno = (int16) insno;
+  ip->ksmps = csound->ksmps;
+  ip->ekr = csound->ekr;
+  ip->kcounter = csound->kcounter;
+  ip->onedksmps = csound->onedksmps;
+  ip->onedkr = csound->onedkr;
+  ip->kicvt = csound->kicvt;
+  ip->pds = NULL;
+  return ip;
+}
 
-  tp = csound->engineState.instrtxtp[insno];
-  if (UNLIKELY(tp->muted == 0)) {
-    char *name = csound->engineState.instrtxtp[insno]->insname;
-    if (UNLIKELY(name))
-      csound->Warning(csound, Str("Instrument %s muted\n"), name);
-    else
-      csound->Warning(csound, Str("Instrument %d muted\n"), insno);
-    return 0;
-  }
-  if (tp->cpuload > FL(0.0)) {
-    csound->cpu_power_busy += tp->cpuload;
-    /* if there is no more cpu processing time*/
-    if (UNLIKELY(csound->cpu_power_busy > FL(100.0))) {
-      csound->cpu_power_busy -= tp->cpuload;
-      csoundWarning(csound, Str("cannot allocate last note because "
-                                "it exceeds 100%% of cpu time"));
-      return(0);
-    }
-  }
-  if (UNLIKELY(tp->maxalloc > 0 && tp->active >= tp->maxalloc)) {
-    csoundWarning(csound, Str("cannot allocate last note because it exceeds "
-                              "instr maxalloc"));
-    return(0);
+/* Index of the active instances of an instrument by p1.  With
+   fractional instrument numbers each note has a p1 of its own, and
+   ties, turnoffs by negative p1 and turnoff2 by p1 would otherwise
+   search all the instances of the instrument for it. */
+
+static inline unsigned int p1_hash(MYFLT p1)
+{
+  double    d = (double) p1;
+  uint64_t  h;
+
+  memcpy(&h, &d, sizeof(uint64_t));
+  return (unsigned int) ((h * UINT64_C(0x9E3779B97F4A7C15)) >> 32);
+}
+
+static void p1_index_insert(INSTRTXT *tp, INSDS *ip, MYFLT p1)
+{
+  INSDS     **pp = &tp->p1hash[p1_hash(p1) & (tp->p1size - 1)];
+  INSDS_EXT *x = INSEXT(ip);
+
+  if ((x->nxtp1 = *pp) != NULL)
+    INSEXT(*pp)->prvp1 = &x->nxtp1;
+  x->prvp1 = pp;
+  *pp = ip;
+}
+
+/* index an instance being activated, and number it */
+
+static void p1_index_add(CSOUND *csound, INSTRTXT *tp, INSDS *ip, MYFLT p1)
+{
+  if (UNLIKELY(tp->p1count >= tp->p1size)) {    /* double the buckets */
+    INSDS   **old = tp->p1hash, *jp, *nxt;
+    int     i, n = tp->p1size;
+
+    tp->p1size = (n ? 2 * n : 16);
+    tp->p1hash = (INSDS**) csound->Calloc(csound,
+                                          tp->p1size * sizeof(INSDS*));
+    for (i = 0; i < n; i++)
+      for (jp = old[i]; jp != NULL; jp = nxt) {
+        nxt = INSEXT(jp)->nxtp1;
+        p1_index_insert(tp, jp, jp->p1.value);
+      }
+    csound->Free(csound, old);
   }
-  /* If named ensure we have the fraction */
-  if (csound->engineState.instrtxtp[insno]->insname && newevtp->strarg)
-    newevtp->p[1] = named_instr_find(csound, newevtp->strarg);
+  p1_index_insert(tp, ip, p1);
+  INSEXT(ip)->actno = ++csound->actcount;
+  tp->p1count++;
+}
 
-  /* if find this insno, active, with indef (tie) & matching p1 */
-  for (ip = tp->instance; ip != NULL; ip = ip->nxtinstance) {
-    if (ip->actflg && ip->offtim < 0.0 && ip->p1.value == newevtp->p[1]) {
-      csound->tieflag++;
-      ip->tieflag = 1;
-      tie = 1;
-      /* goto init; */ /*     continue that event */
+static void p1_index_remove(INSDS *ip)
+{
+  INSDS_EXT *x = INSEXT(ip);
+
+  if (x->prvp1 == NULL)
+    return;
+  if ((*x->prvp1 = x->nxtp1) != NULL)
+    INSEXT(x->nxtp1)->prvp1 = x->prvp1;
+  x->nxtp1 = NULL;
+  x->prvp1 = NULL;
+  ip->instr->p1count--;
+}
+
+/* The active instance of instr tp with this p1, or of several the one
+   activated first, which is also the first of them in the active list;
+   held: only an instance of indefinite duration. */
+
+INSDS *find_instance_p1(INSTRTXT *tp, MYFLT p1, int held)
+{
+  INSDS     *ip, *found = NULL;
+
+  if (tp->p1hash == NULL)
+    return NULL;
+  for (ip = tp->p1hash[p1_hash(p1) & (tp->p1size - 1)];
+       ip != NULL; ip = INSEXT(ip)->nxtp1)
+    if (ip->p1.value == p1 && (!held || ip->offtim < 0.0) &&
+        (found == NULL || INSEXT(ip)->actno - INSEXT(found)->actno < 0))
+      found = ip;
+  return found;
+}
+
+/* forget what was measured of the instance's last voice (--cpu-budget) */
+
+static void voice_started(CSOUND *csound, INSDS *ip)
+{
+  IGN(csound);
+  INSEXT(ip)->perfcost = 0.0;
+  INSEXT(ip)->level = -FL(1.0);
+}
+
+/* splice an instance into the active list, in insno and p1 order */
+
+static void activate_instance(CSOUND *csound, INSTRTXT *tp, INSDS *ip,
+                              int insno, MYFLT p1)
+{
+  INSDS     *prvp, *nxtp;
+
+  /* Add an active instrument */
+  tp->active++;
+  tp->instcnt++;
+  csound->dag_changed++;      /* Need to remake DAG */
+  nxtp = &(csound->actanchor);    /* now splice into activ lst */
+  while ((prvp = nxtp) && (nxtp = prvp->nxtact) != NULL) {
+    if (nxtp->insno > insno ||
+        (nxtp->insno == insno && nxtp->p1.value > p1)) {
+      nxtp->prvact = ip;
       break;
     }
   }
+  ip->nxtact = nxtp;
+  ip->prvact = prvp;
+  prvp->nxtact = ip;
+  ip->tieflag = 0;
+  ip->actflg++;                   /*    and mark the instr active */
+  voice_started(csound, ip);
+  p1_index_add(csound, tp, ip, p1);
+}
 
-  if(!tie) {
-    /* alloc new dspace if needed */
-    if (tp->act_instance == NULL || tp->isNew) {
-      if (UNLIKELY(O->msglevel & CS_RNGEMSG)) {
-        char *name = csound->engineState.instrtxtp[insno]->insname;
-        if (UNLIKELY(name))
-          csound->ErrorMsg(csound, Str("new alloc for instr %s:\n"), name);
-        else
-          csound->ErrorMsg(csound, Str("new alloc for instr %d:\n"), insno);
-      }
-      instance(csound, insno);
-      tp->isNew=0;
-    }
-
-    /* pop from free instance chain */
-    csoundDebugMsg(csound, "insert(): tp->act_instance = %p\n", tp->act_instance);
-    ip = tp->act_instance;
-    ATOMIC_SET(ip->init_done, 0);
-    tp->act_instance = ip->nxtact;
-    ip->insno = (int16) insno;
-    ip->ksmps = csound->ksmps;
-    ip->ekr = csound->ekr;
-    ip->kcounter = csound->kcounter;
-    ip->onedksmps = csound->onedksmps;
-    ip->onedkr = csound->onedkr;
-    ip->kicvt = csound->kicvt;
-    ip->pds = NULL;
-    /* Add an active instrument */
-    tp->active++;
-    tp->instcnt++;
-    csound->dag_changed++;      /* Need to remake DAG */
-    nxtp = &(csound->actanchor);    /* now splice into activ lst */
-    while ((prvp = nxtp) && (nxtp = prvp->nxtact) != NULL) {
-      if (nxtp->insno > insno ||
-          (nxtp->insno == insno && nxtp->p1.value > newevtp->p[1])) {
-        nxtp->prvact = ip;
-        break;
-      }
-    }
-    ip->nxtact = nxtp;
-    ip->prvact = prvp;
-    prvp->nxtact = ip;
-    ip->tieflag = 0;
-    ip->actflg++;                   /*    and mark the instr active */
-  }
+/* copy the p-fields of an event into an instance */
 
+static void set_pfields(CSOUND *csound, INSTRTXT *tp, INSDS *ip, int insno,
+                        EVTBLK *newevtp)
+{
+  OPARMS    *O = csound->oparms;
+  CS_VAR_MEM *pfields;
+  int       i, n;
+  MYFLT     *flp, *fep;
 
-  /* init: */
   pfields = (CS_VAR_MEM*)&ip->p0;
   if (tp->psetdata) {
     int i;
@@ -476,12 +552,16 @@ int insert_event(CSOUND *csound, int insno, EVTBLK *newevtp)
   ip->nxtolap      = NULL;
   ip->opcod_iobufs = NULL;
   ip->strarg       = newevtp->strarg;  /* copy strarg so it does not get lost */
+}
+
+/* after the init pass of an active instance: turn it off if init failed,
+   else set its timing and put it in the turnoff list */
+
+static int start_instance(CSOUND *csound, INSDS *ip, int insno,
+                          EVTBLK *newevtp, int tie)
+{
+  OPARMS    *O = csound->oparms;
 
-  // current event needs to be reset here
-  csound->init_event = newevtp;
-  error = init_pass(csound, ip);
-  if(error == 0)
-    ATOMIC_SET(ip->init_done, 1);
   if (UNLIKELY(csound->inerrcnt || ip->p3.value == FL(0.0))) {
     xturnoff_now(csound, ip);
     return csound->inerrcnt;
@@ -567,6 +647,471 @@ int insert_event(CSOUND *csound, int insno, EVTBLK *newevtp)
   return 0;
 }
 
+int insert_event(CSOUND *csound, int insno, EVTBLK *newevtp)
+{
+  INSTRTXT  *tp;
+  INSDS     *ip;
+  OPARMS    *O = csound->oparms;
+  int tie=0;
+  int  error = 0;
+
+  if (UNLIKELY(csound->advanceCnt))
+    return 0;
+  if (UNLIKELY(O->odebug)) {
+    char *name = csound->engineState.instrtxtp[insno]->insname;
+    if (UNLIKELY(name))
+        csound->Message(csound, Str("activating instr %s at %"PRIi64"\n"),
+                      name, csound->icurTime);
+    else
+        csound->Message(csound, Str("activating instr %d at %"PRIi64"\n"),
+                      insno, csound->icurTime);
+  }
+  csound->inerrcnt = 0;
+
+
+  tp = csound->engineState.instrtxtp[insno];
+  if (UNLIKELY(tp->muted == 0)) {
+    char *name = csound->engineState.instrtxtp[insno]->insname;
+    if (UNLIKELY(name))
+      csound->Warning(csound, Str("Instrument %s muted\n"), name);
+    else
+      csound->Warning(csound, Str("Instrument %d muted\n"), insno);
+    return 0;
+  }
+  if (tp->cpuload > FL(0.0)) {
+    csound->cpu_power_busy += tp->cpuload;
+    /* if there is no more cpu processing time*/
+    if (UNLIKELY(csound->cpu_power_busy > FL(100.0))) {
+      csound->cpu_power_busy -= tp->cpuload;
+      csoundWarning(csound, Str("cannot allocate last note because "
+                                "it exceeds 100%% of cpu time"));
+      return(0);
+    }
+  }
+  if (UNLIKELY(tp->maxalloc > 0 && tp->active >= tp->maxalloc)) {
+    csoundWarning(csound, Str("cannot allocate last note because it exceeds "
+                              "instr maxalloc"));
+    return(0);
+  }
+  /* If named ensure we have the fraction */
+  if (csound->engineState.instrtxtp[insno]->insname && newevtp->strarg)
+    newevtp->p[1] = named_instr_find(csound, newevtp->strarg);
+
+  /* if find this insno, active, with indef (tie) & matching p1 */
+  if ((ip = find_instance_p1(tp, newevtp->p[1], 1)) != NULL) {
+    csound->tieflag++;
+    ip->tieflag = 1;
+    tie = 1;
+    /* goto init; */ /*     continue that event */
+  }
+
+  if(!tie) {
+    if (UNLIKELY(csound->cpubudget != NULL && !cpubudget_admit(csound, tp))) {
+      csound->cpu_power_busy -= tp->cpuload;
+      return 0;
+    }
+    ip = pop_instance(csound, tp, insno);
+    activate_instance(csound, tp, ip, insno, newevtp->p[1]);
+  }
+
+  /* init: */
+  set_pfields(csound, tp, ip, insno, newevtp);
+
+  // current event needs to be reset here
+  csound->init_event = newevtp;
+  error = init_pass(csound, ip);
+  if(error == 0)
+    ATOMIC_SET(ip->init_done, 1);
+  return start_instance(csound, ip, insno, newevtp, tie);
+}
+
+/* Look-ahead init (--init-ahead=N, with --realtime).
+ *
+ * sensevents() passes each 'i' event of the scheduled list that starts
+ * within N ms to insert_ahead().  The event insertion thread takes an
+ * instance of the instrument from its free chain and runs its init
+ * pass, without putting it in the active list.  At the start time the
+ * performance thread only has to splice the voice in, so expensive init
+ * passes no longer land on the k-cycle of the onset.  If the voice is
+ * not ready then, or the lock is held, the start is queued behind its
+ * init pass.  A voice that cannot start as initialised (the note now
+ * ties, the instrument has been muted or redefined, or maxalloc or the
+ * cpu limit is reached) is discarded and the event is inserted as usual.
+ *
+ * Only instruments whose init pass gives the same result whenever it
+ * runs are initialised ahead; see preinit_safe().  A voice that read a
+ * table at init is not started either if a table has been made or
+ * deleted since.
+ */
+
+struct preinit_ {
+  EVTBLK  evt;                  /* copy of the event, p1 resolved */
+  int     insno;
+  INSTRTXT *tp;                 /* the instrument when initialised */
+  INSDS   *ip;                  /* NULL until initialised */
+  int     inerrcnt;             /* init errors */
+  int     ftables;              /* csound->ftables_made before the init */
+  int     cancelled;
+  volatile int ready;           /* init pass done */
+  PREINIT *nxt;                 /* in csound->init_ahead */
+};
+
+/* opcodes whose init pass reads what may change before the start time,
+   or acts on the rest of the performance */
+static const char *preinit_unsafe[] = {
+  "active", "chani", "chano", "chnget", "chngeta", "chngeti", "chngetk",
+  "chngetks", "chngets", "chnmix", "chnset", "chnseta", "chnseti",
+  "chnsetk", "chnsetks", "chnsets", "event_i", "ftfree", "ftgen",
+  "ftgenonce", "ftgentmp", "invalue", "mute", "nstance", "outvalue",
+  "readscore", "remove", "schedule", "scoreline_i", "subinstr",
+  "subinstrinit", "system_i", "tableiw", "timeinstk", "timeinsts",
+  "timek", "times", "tival", "turnoff", "turnoff2_i", "turnoff3", "zir",
+  "ziw", "ziwm", NULL
+};
+
+/* i-time reads of a table, and the input that holds its number; the
+   other i-time opcodes reading a table are taken as reading any table */
+static const struct { const char *name; int arg; } preinit_tabread[] = {
+  { "table", 1 }, { "tablei", 1 }, { "table3", 1 }, { "tab_i", 1 },
+  { "tableng", 0 }, { "ftlen", 0 }, { "ftsr", 0 }, { "ftlptim", 0 },
+  { "ftchnls", 0 }, { "ftcps", 0 }, { "nsamp", 0 }, { NULL, 0 }
+};
+
+/* the same for opcodes writing a table; as above for the others */
+static const struct { const char *name; int arg; } preinit_tabwrite[] = {
+  { "tablew", 2 }, { "tableiw", 2 }, { "tablewkt", 2 }, { "tabw", 2 },
+  { "tabw_i", 2 }, { "ftgen", 0 }, { "ftgentmp", 0 }, { "ftgenonce", 0 },
+  { "ftfree", 0 }, { NULL, 0 }
+};
+
+/* does opname, less any .suffix, equal name? */
+static int opname_is(const char *opname, const char *name)
+{
+  size_t n = strlen(name);
+  return (strncmp(opname, name, n) == 0 &&
+          (opname[n] == '\0' || opname[n] == '.'));
+}
+
+/* is the global assigned by an instrument or UDO, rather than only by
+   the global code? */
+static int global_assigned(CSOUND *csound, CS_VARIABLE *var)
+{
+  INSTRTXT  *tp;
+  OPTXT     *op;
+  ARG       *arg;
+
+  for (tp = csound->engineState.instxtanchor.nxtinstxt;
+       tp != NULL; tp = tp->nxtinstxt) {
+    if (tp == csound->engineState.instrtxtp[0])
+      continue;
+    for (op = tp->nxtop; op != NULL; op = op->nxtop) {
+      if (op->t.oentry == NULL)
+        continue;
+      arg = op->t.outArgs;
+      if (opname_is(op->t.oentry->opname, "##array_set"))
+        arg = op->t.inArgs;               /* the array is the first input */
+      for ( ; arg != NULL; arg = arg->next)
+        if (arg->type == ARG_GLOBAL &&
+            strcmp(((CS_VARIABLE*) arg->argPtr)->varName, var->varName) == 0)
+          return 1;
+    }
+  }
+  return 0;
+}
+
+/* input n of op, or NULL */
+static ARG *table_arg(OPTXT *op, int n)
+{
+  ARG       *arg;
+
+  if (n < 0)
+    return NULL;
+  for (arg = op->t.inArgs; arg != NULL && n > 0; arg = arg->next)
+    n--;
+  return arg;
+}
+
+/* may an instrument or UDO write table fno, a constant? */
+static int table_written(CSOUND *csound, MYFLT fno)
+{
+  INSTRTXT  *tp;
+  OPTXT     *op;
+  ARG       *arg;
+  MYFLT     v;
+  int       i;
+
+  for (tp = csound->engineState.instxtanchor.nxtinstxt;
+       tp != NULL; tp = tp->nxtinstxt) {
+    if (tp == csound->engineState.instrtxtp[0])
+      continue;
+    for (op = tp->nxtop; op != NULL; op = op->nxtop) {
+      if (op->t.oentry == NULL || !(op->t.oentry->flags & TW))
+        continue;
+      for (i = 0; preinit_tabwrite[i].name != NULL; i++)
+        if (opname_is(op->t.oentry->opname, preinit_tabwrite[i].name))
+          break;
+      arg = table_arg(op, preinit_tabwrite[i].name != NULL ?
+                          preinit_tabwrite[i].arg : -1);
+      if (arg == NULL || arg->type != ARG_CONSTANT || arg->argPtr == NULL)
+        return 1;
+      v = ((CS_VAR_MEM*) arg->argPtr)->value;
+      if (v == fno || v <= FL(0.0))     /* 0: a number not known yet */
+        return 1;
+    }
+  }
+  return 0;
+}
+
+/* Does op read a table at i-time?  0 if not, 1 if the table is given by
+   a constant and no instrument writes it, -1 if it may be any table or
+   one that is written. */
+static int preinit_tabread_op(CSOUND *csound, OPTXT *op)
+{
+  OENTRY    *ep = op->t.oentry;
+  ARG       *arg;
+  int       i;
+
+  if (ep->thread != 1)
+    return 0;
+  for (i = 0; preinit_tabread[i].name != NULL; i++)
+    if (opname_is(ep->opname, preinit_tabread[i].name))
+      break;
+  if (preinit_tabread[i].name == NULL && !(ep->flags & TR))
+    return 0;
+  arg = table_arg(op, preinit_tabread[i].name != NULL ?
+                      preinit_tabread[i].arg : -1);
+  if (arg == NULL || arg->type != ARG_CONSTANT || arg->argPtr == NULL)
+    return -1;
+  return (table_written(csound, ((CS_VAR_MEM*) arg->argPtr)->value) ? -1 : 1);
+}
+
+/* Can the init pass of an instrument be run ahead of time?  Not if it,
+   or a UDO it calls, uses an opcode from the list above, has as an input
+   any global that an instrument assigns (i(gk), init from a global, or
+   an opcode reading a k input at init as tonset does), or reads at init
+   a table that is not given by a constant or that an instrument writes.
+   Returns 0 if not, 1 if it can, and 2 if it reads tables at init, so
+   that it can only while no table is made or deleted (from the score,
+   for instance) between the init pass and the start. */
+static int preinit_safe(CSOUND *csound, INSTRTXT *tp, int depth)
+{
+  OPTXT     *op;
+  OENTRY    *ep;
+  ARG       *arg;
+  CS_VARIABLE *var;
+  const char **u;
+  int       safe = 1, n;
+
+  if (depth > 16)
+    return 0;
+  for (op = tp->nxtop; op != NULL; op = op->nxtop) {
+    if ((ep = op->t.oentry) == NULL)
+      continue;
+    for (u = preinit_unsafe; *u != NULL; u++)
+      if (opname_is(ep->opname, *u))
+        return 0;
+    if (ep->useropinfo != NULL) {
+      if ((n = preinit_safe(csound, ((OPCODINFO*) ep->useropinfo)->ip,
+                            depth + 1)) == 0)
+        return 0;
+      if (n == 2)
+        safe = 2;
+    }
+    if ((n = preinit_tabread_op(csound, op)) < 0)
+      return 0;
+    if (n > 0)
+      safe = 2;
+    for (arg = op->t.inArgs; arg != NULL; arg = arg->next) {
+      if (arg->type != ARG_GLOBAL)
+        continue;
+      var = (CS_VARIABLE*) arg->argPtr;
+      if (global_assigned(csound, var))
+        return 0;
+    }
+  }
+  return safe;
+}
+
+static void enqueue_ahead(CSOUND *csound, int type, PREINIT *pre)
+{
+  unsigned long wp = csound->alloc_queue_wp;
+  csound->alloc_queue[wp].type = type;
+  csound->alloc_queue[wp].preinit = pre;
+  csound->alloc_queue_wp = wp + 1 < MAX_ALLOC_QUEUE ? wp + 1 : 0;
+  ATOMIC_INCR(csound->alloc_queue_items);
+}
+
+static void preinit_free(CSOUND *csound, PREINIT *pre)
+{
+  PREINIT   **pp;
+
+  for (pp = (PREINIT**) &csound->init_ahead; *pp != NULL; pp = &(*pp)->nxt)
+    if (*pp == pre) {
+      *pp = pre->nxt;
+      break;
+    }
+  if (pre->evt.strarg != NULL)
+    csound->Free(csound, pre->evt.strarg);
+  csound->Free(csound, pre);
+}
+
+/* is ip held by a voice initialised ahead?  alloc_spinlock held */
+static int preinit_held(CSOUND *csound, INSDS *ip)
+{
+  PREINIT   *pre;
+
+  for (pre = (PREINIT*) csound->init_ahead; pre != NULL; pre = pre->nxt)
+    if (pre->ip == ip)
+      return 1;
+  return 0;
+}
+
+/* the init pass, on the event insertion thread; alloc_spinlock held */
+static void preinit_event(CSOUND *csound, PREINIT *pre)
+{
+  INSTRTXT  *tp = csound->engineState.instrtxtp[pre->insno];
+  INSDS     *ip;
+
+  if (pre->cancelled) {
+    preinit_free(csound, pre);
+    return;
+  }
+  if (tp == pre->tp) {          /* else left to insert_event() at the start */
+    csound->inerrcnt = 0;
+    ip = pop_instance(csound, tp, pre->insno);
+    ip->nxtact = ip->prvact = NULL;
+    set_pfields(csound, tp, ip, pre->insno, &pre->evt);
+    pre->ftables = ATOMIC_GET(csound->ftables_made);
+    csound->init_event = &pre->evt;
+    if (init_pass(csound, ip) == 0)
+      ATOMIC_SET(ip->init_done, 1);
+    pre->inerrcnt = csound->inerrcnt;
+    pre->ip = ip;
+  }
+  pre->nxt = (PREINIT*) csound->init_ahead;
+  csound->init_ahead = (void*) pre;
+  ATOMIC_SET(pre->ready, 1);
+}
+
+/* can the voice start as it is?  alloc_spinlock held */
+static int preinit_startable(CSOUND *csound, PREINIT *pre)
+{
+  INSTRTXT  *tp = csound->engineState.instrtxtp[pre->insno];
+
+  if (UNLIKELY(pre->ip == NULL || tp != pre->tp || tp->muted == 0 || csound->advanceCnt ||
+               (tp->preinit == 2 && pre->ftables != csound->ftables_made) ||
+               (tp->cpuload > FL(0.0) &&
+                csound->cpu_power_busy + tp->cpuload > FL(100.0)) ||
+               (tp->maxalloc > 0 && tp->active >= tp->maxalloc)))
+    return 0;
+  return (find_instance_p1(tp, pre->evt.p[1], 1) == NULL);  /* or would tie */
+}
+
+/* turn off a voice that will not be started; alloc_spinlock held */
+static void preinit_discard(CSOUND *csound, PREINIT *pre)
+{
+  INSTRTXT  *tp = pre->tp;
+
+  if (pre->ip == NULL)
+    return;
+  csound->cpu_power_busy += tp->cpuload;        /* as deact() takes it off */
+  activate_instance(csound, tp, pre->ip, pre->insno, pre->evt.p[1]);
+  xturnoff_now(csound, pre->ip);
+}
+
+/* start the voice, or insert the event as usual; alloc_spinlock held */
+static void preinit_start(CSOUND *csound, PREINIT *pre)
+{
+  INSDS     *ip = pre->ip;
+
+  if (UNLIKELY(!preinit_startable(csound, pre))) {
+    preinit_discard(csound, pre);
+    insert_event(csound, pre->insno, &pre->evt);
+  }
+  else if (UNLIKELY(csound->cpubudget != NULL &&
+                    !cpubudget_admit(csound, pre->tp)))
+    preinit_discard(csound, pre);       /* over the cpu budget */
+  else {
+    csound->cpu_power_busy += pre->tp->cpuload;
+    ip->kcounter = csound->kcounter;
+    activate_instance(csound, pre->tp, ip, pre->insno, pre->evt.p[1]);
+    csound->inerrcnt = pre->inerrcnt;
+    start_instance(csound, ip, pre->insno, &pre->evt, 0);
+  }
+  preinit_free(csound, pre);
+}
+
+/* Called by sensevents() for an event starting within the look-ahead
+   time.  Returns the handle to pass to insert_ahead_start() at the start
+   time, or NULL if the event is to be inserted as usual. */
+void *insert_ahead(CSOUND *csound, EVTBLK *evt)
+{
+  INSTRTXT  *tp;
+  PREINIT   *pre;
+  MYFLT     p1 = evt->p[1];
+  int       insno, safe;
+
+  if (evt->opcod != 'i' || csound->advanceCnt || csound->oparms->Beatmode ||
+      ATOMIC_GET(csound->alloc_queue_items) >= MAX_ALLOC_QUEUE / 2)
+    return NULL;
+  if (csound->ISSTRCOD(p1) && evt->strarg)
+    p1 = named_instr_find(csound, evt->strarg);
+  insno = (int) p1;
+  if (insno <= 0 || insno > csound->engineState.maxinsno ||
+      (tp = csound->engineState.instrtxtp[insno]) == NULL || tp->muted == 0)
+    return NULL;
+  if (tp->preinit == 0)
+    tp->preinit = ((safe = preinit_safe(csound, tp, 0)) != 0 ? safe : -1);
+  if (tp->preinit < 0)
+    return NULL;
+  pre = (PREINIT*) csound->Calloc(csound, sizeof(PREINIT));
+  pre->evt = *evt;
+  pre->evt.p[1] = p1;
+  if (evt->strarg != NULL) {            /* the strings go with the event node */
+    int n = evt->scnt;
+    char *s = evt->strarg;
+    while (n--) s += strlen(s) + 1;
+    pre->evt.strarg = (char*) csound->Malloc(csound, (size_t) (s-evt->strarg)+1);
+    memcpy(pre->evt.strarg, evt->strarg, (size_t) (s-evt->strarg)+1);
+  }
+  pre->insno = insno;
+  pre->tp = tp;
+  enqueue_ahead(csound, 4, pre);
+  return pre;
+}
+
+/* the start time of an event given to insert_ahead() */
+void insert_ahead_start(CSOUND *csound, void *p)
+{
+  PREINIT   *pre = (PREINIT*) p;
+
+  if (ATOMIC_GET(pre->ready) &&
+      csoundSpinTryLock(&csound->alloc_spinlock) == CSOUND_SUCCESS) {
+    if (preinit_startable(csound, pre)) {
+      TRACE_BEGIN(csound, "init_ahead_start", pre->insno);
+      preinit_start(csound, pre);
+      TRACE_END(csound, "init_ahead_start", pre->insno);
+      csoundSpinUnLock(&csound->alloc_spinlock);
+      return;
+    }
+    csoundSpinUnLock(&csound->alloc_spinlock);
+  }
+  enqueue_ahead(csound, 5, pre);        /* after its init pass */
+}
+
+/* an event given to insert_ahead() has been deleted before its start */
+void insert_ahead_cancel(CSOUND *csound, void *p)
+{
+  PREINIT   *pre = (PREINIT*) p;
+
+  csoundSpinLock(&csound->alloc_spinlock);
+  if (pre->ready) {
+    preinit_discard(csound, pre);
+    preinit_free(csound, pre);
+  }
+  else pre->cancelled = 1;              /* freed by the insertion thread */
+  csoundSpinUnLock(&csound->alloc_spinlock);
+}
 
 /* insert a MIDI instr copy into active list */
 /*  then run an init pass                    */
@@ -616,6 +1161,10 @@ int insert_midi(CSOUND *csound, int insno, MCHNBLK *chn, MEVENT *mep)
                               "instr maxalloc"));
     return(0);
   }
+  if (UNLIKELY(csound->cpubudget != NULL && !cpubudget_admit(csound, tp))) {
+    csound->cpu_power_busy -= tp->cpuload;
+    return(0);
+  }
   tp->active++;
   tp->instcnt++;
   csound->dag_changed++;      /* Need to remake DAG */
@@ -683,6 +1232,8 @@ int insert_midi(CSOUND *csound, int insno, MCHNBLK *chn, MEVENT *mep)
   ip->offtim       = -1.0;              /* set indef duration */
   ip->opcod_iobufs = NULL;              /* IV - Sep 8 2002:            */
   ip->p1.value     = (MYFLT) insno;     /* set these required p-fields */
+  voice_started(csound, ip);
+  p1_index_add(csound, tp, ip, ip->p1.value);
   ip->p2.value     = (MYFLT) (csound->icurTime/csound->esr - csound->timeOffs);
   ip->p3.value     = FL(-1.0);
   ip->ksmps        = csound->ksmps;
@@ -811,6 +1362,13 @@ int insert_midi(CSOUND *csound, int insno, MCHNBLK *chn, MEVENT *mep)
     xturnoff_now(csound, ip);
     return csound->inerrcnt;
   }
+  /* time-stamped MIDI input: start inside the k-period */
+  if (O->sampleAccurate && mep->ofs > 0 && mep->ofs < (int32) csound->ksmps)
+    ip->ksmps_offset = mep->ofs;
+  else
+    ip->ksmps_offset = 0;
+  ip->ksmps_no_end = 0;
+  ip->no_end = 0;
   ip->tieflag = ip->reinitflag = 0;
   csound->tieflag = csound->reinitflag = 0;
 
@@ -936,6 +1494,7 @@ static void deact(CSOUND *csound, INSDS *ip)
     nxtp->prvact = ip->prvact;
   }
   ip->actflg = 0;
+  p1_index_remove(ip);
   /* link into free instance chain */
   /* This also destroys ip->nxtact causing loops */
   if (csound->engineState.instrtxtp[ip->insno] == ip->instr){
@@ -1050,7 +1609,7 @@ void orcompact(CSOUND *csound)          /* free all inactive instr spaces */
       prvip = NULL;
       prvnxtloc = &txtp->instance;
       do {
-        if (!ip->actflg) {
+        if (!ip->actflg && !preinit_held(csound, ip)) {
           cnt++;
           if (ip->opcod_iobufs && ip->insno > csound->engineState.maxinsno)
             csound->Free(csound, ip->opcod_iobufs);   /* IV - Nov 10 2002 */
@@ -1062,7 +1621,7 @@ void orcompact(CSOUND *csound)          /* free all inactive instr spaces */
           if ((nxtip = ip->nxtinstance) != NULL)
             nxtip->prvinstance = prvip;
           *prvnxtloc = nxtip;
-          csound->Free(csound, (char *)ip);
+          csound->Free(csound, (char *)INSEXT(ip));
         }
         else {
           prvip = ip;
@@ -1090,7 +1649,7 @@ void orcompact(CSOUND *csound)          /* free all inactive instr spaces */
       if (csound->dead_instr_pool[i] != NULL) {
         INSDS *active = csound->dead_instr_pool[i]->instance;
         while (active != NULL) {
-          if (active->actflg) {
+          if (active->actflg || preinit_held(csound, active)) {
             // add_to_deadpool(csound,csound->dead_instr_pool[i]);
             break;
           }
@@ -1116,21 +1675,15 @@ void infoff(CSOUND *csound, MYFLT p1)   /* turn off an indef copy of instr p1 */
   int   insno;
 
   insno = (int) p1;
-  if (LIKELY((ip = (csound->engineState.instrtxtp[insno])->instance) != NULL)) {
-    do {
-      if (ip->insno == insno          /* if find the insno */
-          && ip->actflg               /*      active       */
-          && ip->offtim < 0.0         /*  but indef, VL: currently this condition
-                                          cannot be removed, as it breaks turning
-                                          off extratime instances */
-          && ip->p1.value == p1) {
-        if (UNLIKELY(csound->oparms->odebug))
-          csound->Message(csound, "turning off inf copy of instr %d\n",
-                          insno);
-        xturnoff(csound, ip);
-        return;                       /*      turn it off  */
-      }
-    } while ((ip = ip->nxtinstance) != NULL);
+  /* active but indef, VL: currently the indef condition cannot be
+     removed, as it breaks turning off extratime instances */
+  if (LIKELY((ip = find_instance_p1(csound->engineState.instrtxtp[insno],
+                                    p1, 1)) != NULL)) {
+    if (UNLIKELY(csound->oparms->odebug))
+      csound->Message(csound, "turning off inf copy of instr %d\n",
+                      insno);
+    xturnoff(csound, ip);
+    return;                           /*      turn it off  */
   }
   csound->Message(csound,
                   Str("could not find playing instr %f\n"),
@@ -2385,13 +2938,14 @@ static void instance(CSOUND *csound, int insno)
   pextrab = ((i = tp->pmax - 3L) > 0 ? (int) i * sizeof(CS_VAR_MEM) : 0);
   /* alloc new space,  */
   pextent = sizeof(INSDS) + pextrab + pextra*sizeof(CS_VAR_MEM);
+  /* the INSDS_EXT goes in front */
   ip =
-    (INSDS*) csound->Calloc(csound,
+    (INSDS*) ((char*) csound->Calloc(csound, INSDS_EXT_SIZE +
                             (size_t) pextent + tp->varPool->poolSize +
                             (tp->varPool->varCount *
                              CS_FLOAT_ALIGN(CS_VAR_TYPE_OFFSET)) +
                             (tp->varPool->varCount * sizeof(CS_VARIABLE*)) +
-                            tp->opdstot);
+                            tp->opdstot) + INSDS_EXT_SIZE);
   ip->csound = csound;
   ip->m_chnbp = (MCHNBLK*) NULL;
   ip->instr = tp;
@@ -2654,7 +3208,7 @@ int delete_instr(CSOUND *csound, DELETEIN *p)
     if (active->auxchp != NULL)
       auxchfree(csound, active);
     free_instr_var_memory(csound, active);
-    csound->Free(csound, active);
+    csound->Free(csound, INSEXT(active));
     active = nxt;
   }
   csound->engineState.instrtxtp[n] = NULL;
@@ -2670,6 +3224,7 @@ int delete_instr(CSOUND *csound, DELETEIN *p)
         csound->Free(csound, t);
         t = s;
       }
+      csound->Free(csound, ip->p1hash);
       csound->Free(csound, ip);
       return OK;
     }
@@ -2739,9 +3294,12 @@ int csoundKillInstanceInternal(CSOUND *csound, MYFLT instr, char *instrName,
     csoundUnlockMutex(csound->API_lock);
     return CSOUND_ERROR;
   }
-  ip = &(csound->actanchor);
-
-  while ((ip = ip->nxtact) != NULL && (int) ip->insno != insno);
+  if (mode & 4)                 /* the first instance with this p1 */
+    ip = find_instance_p1(csound->engineState.instrtxtp[insno], instr, 0);
+  else {
+    ip = &(csound->actanchor);
+    while ((ip = ip->nxtact) != NULL && (int) ip->insno != insno);
+  }
   if (UNLIKELY(ip == NULL)) {
     return CSOUND_ERROR;
   }
@@ -86,6 +86,7 @@ void *mmalloc(CSOUND *csound, size_t size)
     if (MEMALLOC_DB != NULL)
       ((memAllocBlock_t*) MEMALLOC_DB)->prv = (memAllocBlock_t*) p;
     MEMALLOC_DB = (void*) p;
+    csound->memalloc_count++;
     CSOUND_MEM_SPINUNLOCK
     /* return with data pointer */
     return DATA_PTR(p);
@@ -124,6 +125,7 @@ void *mcalloc(CSOUND *csound, size_t size)
     if (MEMALLOC_DB != NULL)
       ((memAllocBlock_t*) MEMALLOC_DB)->prv = (memAllocBlock_t*) p;
     MEMALLOC_DB = (void*) p;
+    csound->memalloc_count++;
     CSOUND_MEM_SPINUNLOCK
     /* return with data pointer */
     return DATA_PTR(p);
@@ -233,6 +235,7 @@ void *mrealloc(CSOUND *csound, void *oldp, size_t size)
       else
         MEMALLOC_DB = (void*) pp;
     }
+    csound->memalloc_count++;
     CSOUND_MEM_SPINUNLOCK
     /* return with data pointer */
     return DATA_PTR(pp);
@@ -30,6 +30,9 @@
 #include "remote.h"
 #include <math.h>
 #include "corfile.h"
+#include "cs_par_base.h"
+#include "cstrace.h"
+#include "cpubudget.h"
 
 #include "csdebug.h"
 
@@ -48,6 +51,7 @@ int     MIDIinsert(CSOUND *, int, MCHNBLK*, MEVENT*);
   void    MidiClose(CSOUND *);
   void    RTclose(CSOUND *);
   void    remote_Cleanup(CSOUND *);
+  void    flush_async_files(CSOUND *);
   char    **csoundGetSearchPathFromEnv(CSOUND *, const char *);
 void    openMIDIout(CSOUND *);
 void print_csound_version(CSOUND*);
@@ -425,12 +429,21 @@ static void deactivate_all_notes(CSOUND *csound)
     }
 }
 
+/* --init-ahead, in insert.c */
+extern void *insert_ahead(CSOUND *, EVTBLK *);
+extern void insert_ahead_start(CSOUND *, void *);
+extern void insert_ahead_cancel(CSOUND *, void *);
+
 static void delete_pending_rt_events(CSOUND *csound)
 {
   EVTNODE *ep = csound->OrcTrigEvts;
 
   while (ep != NULL) {
     EVTNODE *nxt = ep->nxt;
+    if (ep->preinit != NULL) {
+      insert_ahead_cancel(csound, ep->preinit);
+      ep->preinit = NULL;
+    }
     if (ep->evt.strarg != NULL) {
       csound->Free(csound,ep->evt.strarg);
       ep->evt.strarg = NULL;
@@ -455,6 +468,10 @@ void delete_selected_rt_events(CSOUND *csound, MYFLT instr)
         (((int)(ep->evt.p[1]) == instr) || (ep->evt.p[1] == instr))) {
       //printf(" ** found\n");
       // Found an event to cancel
+      if (ep->preinit != NULL) {
+        insert_ahead_cancel(csound, ep->preinit);
+        ep->preinit = NULL;
+      }
       if (ep->evt.strarg != NULL) {
         // clearstring if necessary
         csound->Free(csound,ep->evt.strarg);
@@ -528,6 +545,9 @@ PUBLIC int csoundCleanup(CSOUND *csound)
     }
 
     orcompact(csound);
+    /* instruments have flushed their buffers: get files written through
+       the I/O thread onto disk before reporting */
+    flush_async_files(csound);
 
     corfile_rm(csound, &csound->scstr);
 
@@ -553,6 +573,7 @@ PUBLIC int csoundCleanup(CSOUND *csound)
       }
       csound->ErrorMsg(csound, Str("\n%d errors in performance\n"),
                       csound->perferrcnt);
+      cpubudget_report(csound);
       print_benchmark_info(csound, Str("end of performance"));
       if (csound->print_version) print_csound_version(csound);
     }
@@ -573,6 +594,11 @@ PUBLIC int csoundCleanup(CSOUND *csound)
     }
     /* close any remote.c sockets */
     if (csound->remoteGlobals) remote_Cleanup(csound);
+#ifdef PARCS
+    /* leave the shared worker pool */
+    if (csound->threadPoolJob != NULL) csp_pool_detach(csound);
+#endif
+    cstrace_cleanup(csound);
     if (UNLIKELY(csound->oparms->ringbell))
       cs_beep(csound);
 
@@ -953,7 +979,11 @@ static int process_rt_event(CSOUND *csound, int sensType)
     }
     /* pop from the list */
     csound->OrcTrigEvts = e->nxt;
-    retval = process_score_event(csound, evt, 1);
+    if (e->preinit != NULL) {           /* initialised ahead */
+      insert_ahead_start(csound, e->preinit);
+      e->preinit = NULL;
+    }
+    else retval = process_score_event(csound, evt, 1);
     if (evt->strarg != NULL) {
       csound->Free(csound, evt->strarg);
       evt->strarg = NULL;
@@ -984,6 +1014,41 @@ static int process_rt_event(CSOUND *csound, int sensType)
 
 extern  int     sensMidi(CSOUND *);
 
+/* RM: act on one message from a remote client; returns 0, the code of
+   a score event that ends the section or score, or -1 for a Trkend */
+
+static int remote_message(CSOUND *csound, REMOT_BUF *bp, EVTBLK *e)
+{
+    int retval;
+
+    if (bp->type == SCOR_EVT) {
+      EVTBLK *evt = (EVTBLK*)bp->data;
+      evt->p[2] = (double)csound->icurTime/csound->esr;
+      if ((retval = process_score_event(csound, evt, 1)) != 0) {
+        e->opcod = evt->opcod;        /* pass any s, e, or l */
+        return retval;
+      }
+    }
+    else if (bp->type == MIDI_EVT) {
+      MEVENT *mep = (MEVENT *)bp->data;
+      MCHNBLK *chn = csound->m_chnbp[mep->chan];
+      process_midi_event(csound, mep, chn);
+    }
+    else if (bp->type == MIDI_MSG) {
+      MEVENT *mep = (MEVENT *)bp->data;
+      if (UNLIKELY(mep->type == 0xFF && mep->dat1 == 0x2F)) {
+        csound->MTrkend = 1;                     /* catch a Trkend    */
+        csound->ErrorMsg(csound, "SERVER%c: ", remoteID(csound));
+        csound->ErrorMsg(csound, "caught a Trkend\n");
+        /*csoundCleanup(csound);
+          exit(0);*/
+        return -1;  /* end of performance */
+      }
+      else m_chanmsg(csound, mep);               /* or a chan msg     */
+    }
+    return 0;
+}
+
 /* sense events for one k-period            */
 /* return value is one of the following:    */
 /*   0: continue performance                */
@@ -1167,9 +1232,39 @@ int sensevents(CSOUND *csound)
         goto scode;
       }
     }
+    /* --init-ahead: start init passes of the events due soon */
+    if (O->initAhead > 0 && O->realtime && csound->event_insert_loop &&
+        !getRemoteInsRfdCount(csound)) {
+      EVTNODE *e;
+      uint32 ahead = (uint32) csound->global_kcounter +
+        (uint32) (O->initAhead * csound->ekr / 1000);
+      for (e = csound->OrcTrigEvts; e != NULL && e->start_kcnt <= ahead;
+           e = e->nxt)
+        if (!e->preinit_tried) {        /* once: a refusal is not retried */
+          e->preinit = insert_ahead(csound, &e->evt);
+          e->preinit_tried = 1;
+        }
+    }
     /* RM */
     if ((sinp = getRemoteSocksIn(csound))) {
-      while ((conn = *sinp++)) {
+      if (getRemoteAudioServer(csound)) {
+        /* lock step: wait for the client to ask for this k-period */
+        while ((conn = *sinp++)) {
+          do {
+            if (UNLIKELY(SVrecvmsg(csound, conn, &(csound->SVrecvbuf)) <= 0)) {
+              csound->ErrorMsg(csound, "SERVER%c: ", remoteID(csound));
+              csound->ErrorMsg(csound, Str("lost connection to client\n"));
+              return 2;  /* end of performance */
+            }
+            if ((retval = remote_message(csound, &(csound->SVrecvbuf), e))) {
+              if (retval < 0)
+                return 2;
+              goto scode;
+            }
+          } while (csound->SVrecvbuf.type != AUDIO_TICK);
+        }
+      }
+      else while ((conn = *sinp++)) {
         while ((nrecvd = SVrecv(csound, conn,
                                 (void*)&(csound->SVrecvbuf),
                                 sizeof(REMOT_BUF) )) > 0) {
@@ -1177,31 +1272,10 @@ int sensevents(CSOUND *csound)
           do {
             REMOT_BUF *bp = (REMOT_BUF*)((char*)(&(csound->SVrecvbuf))+lentot);
 
-            if (bp->type == SCOR_EVT) {
-              EVTBLK *evt = (EVTBLK*)bp->data;
-              evt->p[2] = (double)csound->icurTime/csound->esr;
-              if ((retval = process_score_event(csound, evt, 1)) != 0) {
-                e->opcod = evt->opcod;        /* pass any s, e, or l */
-
-                goto scode;
-              }
-            }
-            else if (bp->type == MIDI_EVT) {
-              MEVENT *mep = (MEVENT *)bp->data;
-              MCHNBLK *chn = csound->m_chnbp[mep->chan];
-              process_midi_event(csound, mep, chn);
-            }
-            else if (bp->type == MIDI_MSG) {
-              MEVENT *mep = (MEVENT *)bp->data;
-              if (UNLIKELY(mep->type == 0xFF && mep->dat1 == 0x2F)) {
-                csound->MTrkend = 1;                     /* catch a Trkend    */
-                csound->ErrorMsg(csound, "SERVER%c: ", remoteID(csound));
-                csound->ErrorMsg(csound, "caught a Trkend\n");
-                /*csoundCleanup(csound);
-                  exit(0);*/
-                return 2;  /* end of performance */
-              }
-              else m_chanmsg(csound, mep);               /* or a chan msg     */
+            if ((retval = remote_message(csound, bp, e))) {
+              if (retval < 0)
+                return 2;
+              goto scode;
             }
             lentot+=bp->len;
           } while (lentot < nrecvd);
@@ -1284,10 +1358,13 @@ static inline uint64_t time2kcnt(CSOUND *csound, double tval)
 /* made.                                                              */
 /* Return value is zero on success.                                   */
 
-int insert_score_event_at_sample(CSOUND *csound, EVTBLK *evt, int64_t time_ofs)
+/* make the queue node for an event, which is returned in *ep */
+
+static int score_event_node(CSOUND *csound, EVTBLK *evt, int64_t time_ofs,
+                            EVTNODE **ep)
 {
   double        start_time;
-  EVTNODE       *e, *prv;
+  EVTNODE       *e;
   CSOUND        *st = csound;
   MYFLT         *p;
   uint32        start_kcnt;
@@ -1298,6 +1375,8 @@ int insert_score_event_at_sample(CSOUND *csound, EVTBLK *evt, int64_t time_ofs)
   if (csound->freeEvtNodes != NULL) {             /* pop alloc from stack */
     e = csound->freeEvtNodes;                     /*   if available       */
     csound->freeEvtNodes = e->nxt;
+    e->preinit = NULL;
+    e->preinit_tried = 0;
   }
   else {
     e = (EVTNODE*) csound->Calloc(csound, sizeof(EVTNODE)); /* or alloc new one */
@@ -1420,16 +1499,38 @@ int insert_score_event_at_sample(CSOUND *csound, EVTBLK *evt, int64_t time_ofs)
                   evt->opcod);
     goto err_return;
   }
-  /* queue new event */
   e->start_kcnt = start_kcnt;
+  *ep = e;
+  return 0;
+
+ pfld_err:
+  csoundErrorMsg(csound, Str("insert_score_event(): insufficient p-fields\n"));
+ err_return:
+  /* clean up */
+  if (e->evt.strarg != NULL)
+    csound->Free(csound, e->evt.strarg);
+  e->evt.strarg = NULL;
+  e->nxt = csound->freeEvtNodes;
+  csound->freeEvtNodes = e;
+  return retval;
+}
+
+int insert_score_event_at_sample(CSOUND *csound, EVTBLK *evt, int64_t time_ofs)
+{
+  EVTNODE       *e, *prv;
+  int           retval;
+
+  if (UNLIKELY((retval = score_event_node(csound, evt, time_ofs, &e)) != 0))
+    return retval;
+  /* queue new event */
   prv = csound->OrcTrigEvts;
   /* if list is empty, or at beginning of list: */
-  if (prv == NULL || start_kcnt < prv->start_kcnt) {
+  if (prv == NULL || e->start_kcnt < prv->start_kcnt) {
     e->nxt = prv;
     csound->OrcTrigEvts = e;
   }
   else {                                      /* otherwise sort by time */
-    while (prv->nxt != NULL && start_kcnt >= prv->nxt->start_kcnt)
+    while (prv->nxt != NULL && e->start_kcnt >= prv->nxt->start_kcnt)
       prv = prv->nxt;
     e->nxt = prv->nxt;
     prv->nxt = e;
@@ -1437,17 +1538,97 @@ int insert_score_event_at_sample(CSOUND *csound, EVTBLK *evt, int64_t time_ofs)
   /* Make sure sensevents() looks for RT events */
   csound->oparms->RTevents = 1;
   return 0;
+}
 
- pfld_err:
-  csoundErrorMsg(csound, Str("insert_score_event(): insufficient p-fields\n"));
- err_return:
-  /* clean up */
-  if (e->evt.strarg != NULL)
-    csound->Free(csound, e->evt.strarg);
-  e->evt.strarg = NULL;
-  e->nxt = csound->freeEvtNodes;
-  csound->freeEvtNodes = e;
-  return retval;
+/* Sort a list of event nodes by start time: bottom-up merge sort,
+   which keeps events at the same time in the order given */
+
+static EVTNODE *sort_event_nodes(EVTNODE *list)
+{
+  EVTNODE       *a, *b, *e, **tail;
+  int           na, nb, k, merges;
+
+  for (k = 1; ; k *= 2) {
+    a = list;
+    list = NULL;
+    tail = &list;
+    merges = 0;
+    while (a != NULL) {
+      merges++;
+      for (b = a, na = 0; na < k && b != NULL; na++)
+        b = b->nxt;
+      nb = k;
+      while (na > 0 || (nb > 0 && b != NULL)) {
+        if (na == 0 || (nb > 0 && b != NULL &&
+                        b->start_kcnt < a->start_kcnt)) {
+          e = b; b = b->nxt; nb--;
+        }
+        else {
+          e = a; a = a->nxt; na--;
+        }
+        *tail = e;
+        tail = &e->nxt;
+      }
+      a = b;
+    }
+    *tail = NULL;
+    if (merges <= 1)
+      return list;
+  }
+}
+
+/* Schedule n note events at once (csoundScheduleEvents()): event k is
+   instrument instr[k], starting start[k] samples from now, with the
+   nfields p-fields from p3 on at pfields[k*nfields].  The nodes are
+   sorted by start time, unless they come in order as batches mostly
+   do, and merged into the queue in one pass.  Returns the number of
+   events rejected. */
+
+int insert_score_events(CSOUND *csound, const MYFLT *instr,
+                        const int64_t *start, const MYFLT *pfields,
+                        int nfields, int n)
+{
+  EVTBLK        evt;
+  EVTNODE       *e, *list = NULL, *last = NULL, **pp;
+  int           i, m = 0, sorted = 1;
+
+  memset(&evt, 0, sizeof(EVTBLK));
+  evt.opcod = 'i';
+  evt.pcnt = (int16) (nfields + 2);
+  for (i = 0; i < n; i++) {
+    evt.p[1] = instr[i];
+    evt.p[2] = FL(0.0);
+    memcpy(&evt.p[3], &pfields[i * nfields], nfields * sizeof(MYFLT));
+    if (score_event_node(csound, &evt, csound->icurTime + start[i], &e) != 0)
+      continue;
+    if (last == NULL)
+      list = e;
+    else {
+      if (e->start_kcnt < last->start_kcnt)
+        sorted = 0;
+      last->nxt = e;
+    }
+    last = e;
+    m++;
+  }
+  if (last == NULL)
+    return n;
+  last->nxt = NULL;
+  if (!sorted)
+    list = sort_event_nodes(list);
+  /* each goes after the queued events starting at the same time */
+  pp = &csound->OrcTrigEvts;
+  while (list != NULL) {
+    e = list;
+    list = e->nxt;
+    while (*pp != NULL && (*pp)->start_kcnt <= e->start_kcnt)
+      pp = &(*pp)->nxt;
+    e->nxt = *pp;
+    *pp = e;
+    pp = &e->nxt;
+  }
+  csound->oparms->RTevents = 1;
+  return n - m;
 }
 
 int insert_score_event(CSOUND *csound, EVTBLK *evt, double time_ofs)
@@ -139,10 +139,10 @@ static void add_include_udo_dir(CSOUND *csound, CORFIL *xx)
 #endif
 }
 
+static TREE *parse_expanded_orc(CSOUND *csound);
+
 TREE *csoundParseOrc(CSOUND *csound, const char *str)
 {
-    int err;
-    OPARMS *O = csound->oparms;
     csound->parserNamedInstrFlag = 2;
     {
       PRE_PARM    qq;
@@ -205,6 +205,25 @@ TREE *csoundParseOrc(CSOUND *csound, const char *str)
       corfile_rm(csound, &csound->orchstr);
 
     }
+    return parse_expanded_orc(csound);
+}
+
+/* Parse an orchestra that has already been through the preprocessor,
+   as kept by csoundCompileOrc() for csoundCreateRecompiled() */
+TREE *csoundParseExpandedOrc(CSOUND *csound, const char *text)
+{
+    csound->parserNamedInstrFlag = 2;
+    csound->expanded_orc = corfile_create_w(csound);
+    corfile_puts(csound, text, csound->expanded_orc);
+    corfile_putc(csound, '\0', csound->expanded_orc);
+    corfile_putc(csound, '\0', csound->expanded_orc);
+    return parse_expanded_orc(csound);
+}
+
+static TREE *parse_expanded_orc(CSOUND *csound)
+{
+    int err;
+    OPARMS *O = csound->oparms;
     {
       /* VL 15.3.2015 allocating memory here will cause
          unwanted growth.
@@ -229,10 +248,27 @@ TREE *csoundParseOrc(CSOUND *csound, const char *str)
 
       //csound_orcset_lineno(csound->orcLineOffset, pp.yyscanner);
       //printf("%p\n", astTree);
-      err = csound_orcparse(&pp, pp.yyscanner, csound, &astTree);
+      /* CS_ORC_CACHE: a tree parsed before from the same text */
+      astTree = orc_cache_load(csound, corfile_body(csound->expanded_orc),
+                               corfile_tell(csound->expanded_orc));
+      if (astTree != NULL)
+        err = 0;
+      else {
+        err = csound_orcparse(&pp, pp.yyscanner, csound, &astTree);
+        orc_cache_save(csound, corfile_tell(csound->expanded_orc),
+                       (err == 0 && !csound->synterrcnt) ? astTree : NULL);
+      }
       //printf("%p\n", astTree);
       //print_tree(csound, "AST - AFTER csound_orcparse()\n", astTree);
       //csp_orc_sa_cleanup(csound);
+      /* keep the preprocessed text until the compilation is complete */
+      if (csound->lastExpandedOrc != NULL) {
+        csound->Free(csound, csound->lastExpandedOrc);
+        csound->lastExpandedOrc = NULL;
+      }
+      if (csound->keepOrcHistory)
+        csound->lastExpandedOrc =
+          cs_strdup(csound, corfile_body(csound->expanded_orc));
       corfile_rm(csound, &csound->expanded_orc);
 #ifdef PARCS
       if (UNLIKELY(csound->oparms->odebug)) csp_orc_sa_print_list(csound);
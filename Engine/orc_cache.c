@@ -0,0 +1,604 @@
+/*
+    orc_cache.c:
+
+    Copyright (C) 2026 The Csound Developers
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+/* Persistent orchestra parse cache.
+ *
+ * If the environment variable CS_ORC_CACHE names a directory, the syntax
+ * tree made by the parser for each orchestra is written there, in a file
+ * named after a hash of the preprocessed text, the Csound and API
+ * versions, the size of MYFLT and the opcode names known to the lexer
+ * (including those of plugins still deferred by the plugin manifest).
+ * When the same orchestra is compiled again, with the same #included
+ * files and the same opcodes, the tree is read back instead of lexing
+ * and parsing the text.  Type checking, optimisation and compilation
+ * run as usual on the tree that is read.
+ *
+ * The grammar actions also declare user-defined opcodes, collect the
+ * globals and interlocks each instrument uses for multicore performance
+ * and report deprecated opcodes.  The opcodes are declared again from
+ * the tree read; the rest is recorded during the parse, kept with the
+ * tree and replayed.
+ */
+
+#include "csoundCore.h"
+#include "csound_orc.h"
+#include "csmodule.h"
+#ifdef PARCS
+#include "cs_par_base.h"
+#include "cs_par_orc_semantics.h"
+#endif
+
+static  const   char    *orccache_envvar = "CS_ORC_CACHE";
+static  const   char    orccache_magic[8] = "CSORCT\n";
+#define ORCCACHE_VERSION  2
+
+#define FNV_OFFSET  (14695981039346656037ULL)
+#define FNV_PRIME   (1099511628211ULL)
+
+extern int add_udo_definition(CSOUND *, char *, char *, char *);
+
+typedef struct {
+    char        magic[8];
+    int32_t     version;
+    int32_t     myfltsize;
+    uint64_t    key;
+    uint64_t    textlen;
+} ORCCACHE_HEADER;
+
+/* a tree node as stored; the strings of its token follow */
+typedef struct {
+    int32_t     type, rate, len, line;
+    uint64_t    locn;
+    int32_t     hasvalue;
+    int32_t     vtype, vvalue;
+    double      fvalue;
+} ORCCACHE_NODE;
+
+typedef struct {
+    const char  *p, *end;
+} ORCCACHE_CURSOR;
+
+static uint64_t fnv_add(uint64_t h, const void *s, size_t n)
+{
+    const unsigned char *p = (const unsigned char*) s;
+    while (n--) {
+      h ^= *p++;
+      h *= FNV_PRIME;
+    }
+    return h;
+}
+
+/* the hash of the tokens the lexer would find in the symbol table, in
+   any order */
+
+static uint64_t symbtab_key(CSOUND *csound)
+{
+    CONS_CELL *head, *top;
+    ORCTOKEN  *tok;
+    uint64_t  sum = 0;
+
+    if (csound->symbtab == NULL)
+      return 0;
+    top = head = cs_hash_table_values(csound, csound->symbtab);
+    for ( ; head != NULL; head = head->next) {
+      tok = (ORCTOKEN*) head->value;
+      sum += fnv_add(fnv_add(FNV_OFFSET, tok->lexeme, strlen(tok->lexeme)),
+                     &tok->type, sizeof(int));
+    }
+    cs_cons_free(csound, top);
+    return sum;
+}
+
+static uint64_t orc_cache_key(CSOUND *csound, const char *text, size_t len)
+{
+    uint64_t h = fnv_add(FNV_OFFSET, text, len), k;
+    int32_t  v[4];
+
+    v[0] = csoundGetVersion();
+    v[1] = CS_APIVERSION;
+    v[2] = CS_APISUBVER;
+    v[3] = (int32_t) sizeof(MYFLT);
+    h = fnv_add(h, v, sizeof(v));
+    k = symbtab_key(csound);
+    h = fnv_add(h, &k, sizeof(k));
+    k = csoundDeferredOpcodesKey(csound);
+    return fnv_add(h, &k, sizeof(k));
+}
+
+static char *orc_cache_path(CSOUND *csound, const char *dir, uint64_t key)
+{
+    size_t  n = strlen(dir) + 32;
+    char    *path = (char*) csound->Malloc(csound, n);
+
+    snprintf(path, n, "%s%c%016llx.orctree", dir, DIRSEP,
+             (unsigned long long) key);
+    return path;
+}
+
+/* write out */
+
+static void put_str(FILE *f, const char *s)
+{
+    int32_t n = (s == NULL ? -1 : (int32_t) strlen(s));
+
+    fwrite(&n, sizeof(int32_t), 1, f);
+    if (n > 0)
+      fwrite(s, 1, (size_t) n, f);
+}
+
+/* a list linked by next: each node, then its left and right lists, and
+   a zero byte at the end */
+
+static int put_tree(FILE *f, TREE *t)
+{
+    ORCCACHE_NODE r;
+
+    for ( ; t != NULL; t = t->next) {
+      if (UNLIKELY(t->markup != NULL))  /* only untyped trees are kept */
+        return -1;
+      memset(&r, 0, sizeof(ORCCACHE_NODE));
+      r.type = t->type;
+      r.rate = t->rate;
+      r.len = t->len;
+      r.line = t->line;
+      r.locn = t->locn;
+      if (t->value != NULL) {
+        r.hasvalue = 1;
+        r.vtype = t->value->type;
+        r.vvalue = t->value->value;
+        r.fvalue = t->value->fvalue;
+      }
+      putc(1, f);
+      fwrite(&r, sizeof(ORCCACHE_NODE), 1, f);
+      if (t->value != NULL) {
+        put_str(f, t->value->lexeme);
+        put_str(f, t->value->optype);
+      }
+      if (put_tree(f, t->left) != 0 || put_tree(f, t->right) != 0)
+        return -1;
+    }
+    putc(0, f);
+    return (ferror(f) ? -1 : 0);
+}
+
+/* read back */
+
+static int get_bytes(ORCCACHE_CURSOR *c, void *dst, size_t n)
+{
+    if (UNLIKELY((size_t) (c->end - c->p) < n))
+      return -1;
+    memcpy(dst, c->p, n);
+    c->p += n;
+    return 0;
+}
+
+static int get_str(CSOUND *csound, ORCCACHE_CURSOR *c, char **s)
+{
+    int32_t n;
+
+    *s = NULL;
+    if (UNLIKELY(get_bytes(c, &n, sizeof(int32_t)) != 0 ||
+                 n < -1 || n > c->end - c->p))
+      return -1;
+    if (n >= 0) {
+      *s = (char*) csound->Malloc(csound, (size_t) n + 1);
+      memcpy(*s, c->p, (size_t) n);
+      (*s)[n] = '\0';
+      c->p += n;
+    }
+    return 0;
+}
+
+/* nodes are linked in before their children are read, so that whatever
+   has been read can be deleted on error */
+
+static TREE *get_tree(CSOUND *csound, ORCCACHE_CURSOR *c, int *err)
+{
+    TREE    *head = NULL, **tail = &head, *t;
+    ORCCACHE_NODE r;
+    char    tag;
+
+    while (!*err) {
+      if (UNLIKELY(get_bytes(c, &tag, 1) != 0)) {
+        *err = 1;
+        break;
+      }
+      if (tag == 0)
+        break;
+      if (UNLIKELY(get_bytes(c, &r, sizeof(ORCCACHE_NODE)) != 0)) {
+        *err = 1;
+        break;
+      }
+      t = (TREE*) csound->Calloc(csound, sizeof(TREE));
+      t->type = r.type;
+      t->rate = r.rate;
+      t->len = r.len;
+      t->line = r.line;
+      t->locn = r.locn;
+      *tail = t;
+      tail = &t->next;
+      if (r.hasvalue) {
+        t->value = (ORCTOKEN*) csound->Calloc(csound, sizeof(ORCTOKEN));
+        t->value->type = r.vtype;
+        t->value->value = r.vvalue;
+        t->value->fvalue = r.fvalue;
+        if (UNLIKELY(get_str(csound, c, &t->value->lexeme) != 0 ||
+                     get_str(csound, c, &t->value->optype) != 0)) {
+          *err = 1;
+          break;
+        }
+      }
+      t->left = get_tree(csound, c, err);
+      t->right = get_tree(csound, c, err);
+    }
+    return head;
+}
+
+/* What parsing does besides building the tree.  The grammar actions
+   collect the globals and interlocks each instrument uses under -j into
+   csound->instRoot, and report deprecated opcodes; both are recorded
+   while an orchestra that is not in the cache is parsed, and written
+   after its tree. */
+
+typedef struct orccache_note_ {
+    struct orccache_note_ *nxt;
+    int32_t     kind;           /* ORCCACHE_DEPRECATED etc. */
+    char        *name;
+} ORCCACHE_NOTE;
+
+typedef struct {
+    uint64_t    key;
+#ifdef PARCS
+    INSTR_SEMANTICS *last;      /* the last instrument before the parse */
+#endif
+    ORCCACHE_NOTE *notes, **tail;
+} ORCCACHE_REC;
+
+static void rec_free(CSOUND *csound, ORCCACHE_REC *rec)
+{
+    ORCCACHE_NOTE *n;
+
+    while ((n = rec->notes) != NULL) {
+      rec->notes = n->nxt;
+      csound->Free(csound, n->name);
+      csound->Free(csound, n);
+    }
+    csound->Free(csound, rec);
+}
+
+static void rec_start(CSOUND *csound, uint64_t key)
+{
+    ORCCACHE_REC *rec = (ORCCACHE_REC*) csound->orcCacheRec;
+
+    if (rec != NULL)            /* left by a parse that did not return */
+      rec_free(csound, rec);
+    rec = (ORCCACHE_REC*) csound->Calloc(csound, sizeof(ORCCACHE_REC));
+    rec->key = key;
+#ifdef PARCS
+    for (rec->last = csound->instRoot;
+         rec->last != NULL && rec->last->next != NULL;
+         rec->last = rec->last->next)
+      ;
+#endif
+    rec->tail = &rec->notes;
+    csound->orcCacheRec = rec;
+}
+
+/* called by the parser for each message that should be given again
+   when the tree is read from the cache */
+
+void orc_cache_note(CSOUND *csound, int kind, const char *name)
+{
+    ORCCACHE_REC *rec = (ORCCACHE_REC*) csound->orcCacheRec;
+    ORCCACHE_NOTE *n;
+
+    if (rec == NULL)
+      return;
+    n = (ORCCACHE_NOTE*) csound->Calloc(csound, sizeof(ORCCACHE_NOTE));
+    n->kind = kind;
+    n->name = cs_strdup(csound, (char*) name);
+    *rec->tail = n;
+    rec->tail = &n->nxt;
+}
+
+#ifdef PARCS
+static void put_set(FILE *f, struct set_t *set)
+{
+    struct set_element_t *ele;
+    int32_t n = set->count;
+
+    fwrite(&n, sizeof(int32_t), 1, f);
+    for (ele = set->head; ele != NULL; ele = ele->next)
+      put_str(f, (char*) ele->data);
+}
+#endif
+
+/* the instruments added by the parse, each with its read, write and
+   read_write sets, then the notes */
+
+static int put_record(CSOUND *csound, FILE *f, ORCCACHE_REC *rec)
+{
+    ORCCACHE_NOTE *note;
+    int32_t n = 0;
+#ifdef PARCS
+    INSTR_SEMANTICS *first, *p;
+
+    first = (rec->last != NULL ? rec->last->next : csound->instRoot);
+    for (p = first; p != NULL; p = p->next)
+      n++;
+    fwrite(&n, sizeof(int32_t), 1, f);
+    for (p = first; p != NULL; p = p->next) {
+      put_str(f, p->name);
+      put_set(f, p->read);
+      put_set(f, p->write);
+      put_set(f, p->read_write);
+    }
+#else
+    fwrite(&n, sizeof(int32_t), 1, f);
+#endif
+    for (n = 0, note = rec->notes; note != NULL; note = note->nxt)
+      n++;
+    fwrite(&n, sizeof(int32_t), 1, f);
+    for (note = rec->notes; note != NULL; note = note->nxt) {
+      fwrite(&note->kind, sizeof(int32_t), 1, f);
+      put_str(f, note->name);
+    }
+    return (ferror(f) ? -1 : 0);
+}
+
+/* Replay the record: with dry set, only check that it is all there.
+   Set 0 of an instrument is read, 1 write and 2 read_write. */
+
+static int replay_set(CSOUND *csound, ORCCACHE_CURSOR *c, int which,
+                      int dry)
+{
+    int32_t n, i;
+    char    *s;
+#ifdef PARCS
+    struct set_t *set = NULL, *w, *r;
+#endif
+
+    if (UNLIKELY(get_bytes(c, &n, sizeof(int32_t)) != 0 || n < 0))
+      return -1;
+    for (i = 0; i < n; i++) {
+      if (UNLIKELY(get_str(csound, c, &s) != 0 || s == NULL))
+        return -1;
+#ifdef PARCS
+      if (dry)
+        csound->Free(csound, s);
+      else if (which == 2) {
+        w = csp_set_alloc_string(csound);
+        r = csp_set_alloc_string(csound);
+        csp_set_add(csound, w, s);
+        csp_set_add(csound, r, s);
+        csp_orc_sa_global_read_write_add_list1(csound, w, r);
+        csp_set_dealloc(csound, &w);
+        csp_set_dealloc(csound, &r);
+      }
+      else {
+        if (set == NULL)
+          set = csp_set_alloc_string(csound);
+        csp_set_add(csound, set, s);
+      }
+#else
+      csound->Free(csound, s);
+#endif
+    }
+#ifdef PARCS
+    if (set != NULL) {
+      if (which == 0)
+        csp_orc_sa_global_read_add_list(csound, set);
+      else
+        csp_orc_sa_global_write_add_list(csound, set);
+    }
+#else
+    (void) which;
+#endif
+    return 0;
+}
+
+static int replay_record(CSOUND *csound, ORCCACHE_CURSOR *c, int dry)
+{
+    ORCTOKEN tok;
+    int32_t n, i, j, kind;
+    char    *s;
+
+    if (UNLIKELY(get_bytes(c, &n, sizeof(int32_t)) != 0 || n < 0))
+      return -1;
+    for (i = 0; i < n; i++) {
+      if (UNLIKELY(get_str(csound, c, &s) != 0 || s == NULL))
+        return -1;
+#ifdef PARCS
+      if (!dry)
+        csp_orc_sa_instr_add(csound, s);
+#endif
+      csound->Free(csound, s);
+      for (j = 0; j < 3; j++)
+        if (UNLIKELY(replay_set(csound, c, j, dry) != 0))
+          return -1;
+#ifdef PARCS
+      if (!dry)
+        csp_orc_sa_instr_finalize(csound);
+#endif
+    }
+    if (UNLIKELY(get_bytes(c, &n, sizeof(int32_t)) != 0 || n < 0))
+      return -1;
+    for (i = 0; i < n; i++) {
+      if (UNLIKELY(get_bytes(c, &kind, sizeof(int32_t)) != 0 ||
+                   get_str(csound, c, &s) != 0 || s == NULL))
+        return -1;
+      if (!dry && kind == ORCCACHE_DEPRECATED) {
+        memset(&tok, 0, sizeof(ORCTOKEN));
+        tok.lexeme = s;
+        query_deprecated_opcode(csound, &tok);
+      }
+#ifdef PARCS
+      else if (!dry && kind == ORCCACHE_SA_DEPRECATED)
+        csp_orc_sa_deprecated(csound, s);
+#endif
+      csound->Free(csound, s);
+    }
+    return 0;
+}
+
+/* user-defined opcodes are declared by the grammar as they are read */
+
+static void replay_udos(CSOUND *csound, TREE *t)
+{
+    for ( ; t != NULL; t = t->next) {
+      if (t->type == UDO_TOKEN) {
+        add_udo_definition(csound, t->left->value->lexeme,
+                           t->left->left->value->lexeme,
+                           t->left->right->value->lexeme);
+        csound->parserUdoflag = -1;
+      }
+      else if (t->type == INSTR_TOKEN)
+        csound->parserNamedInstrFlag = 0;
+    }
+}
+
+static TREE *orc_cache_read(CSOUND *csound, const char *dir, uint64_t key,
+                            size_t len)
+{
+    ORCCACHE_HEADER hdr;
+    ORCCACHE_CURSOR c, rc;
+    FILE    *f;
+    char    *path, *buf;
+    long    size;
+    TREE    *t;
+    int     err = 0;
+
+    path = orc_cache_path(csound, dir, key);
+    f = fopen(path, "rb");
+    csound->Free(csound, path);
+    if (f == NULL)
+      return NULL;
+    if (fseek(f, 0L, SEEK_END) != 0 || (size = ftell(f)) <= 0 ||
+        fseek(f, 0L, SEEK_SET) != 0) {
+      fclose(f);
+      return NULL;
+    }
+    buf = (char*) csound->Malloc(csound, (size_t) size);
+    if (fread(buf, 1, (size_t) size, f) != (size_t) size) {
+      fclose(f);
+      csound->Free(csound, buf);
+      return NULL;
+    }
+    fclose(f);
+    c.p = buf;
+    c.end = buf + size;
+    if (get_bytes(&c, &hdr, sizeof(ORCCACHE_HEADER)) != 0 ||
+        memcmp(hdr.magic, orccache_magic, sizeof(hdr.magic)) != 0 ||
+        hdr.version != ORCCACHE_VERSION ||
+        hdr.myfltsize != (int32_t) sizeof(MYFLT) ||
+        hdr.key != key || hdr.textlen != (uint64_t) len) {
+      csound->Free(csound, buf);
+      return NULL;
+    }
+    t = get_tree(csound, &c, &err);
+    rc = c;
+    if (UNLIKELY(err || t == NULL || replay_record(csound, &rc, 1) != 0 ||
+                 rc.p != c.end)) {
+      csound->Free(csound, buf);
+      csoundDeleteTree(csound, t);
+      return NULL;
+    }
+    replay_udos(csound, t);
+    replay_record(csound, &c, 0);
+    csound->Free(csound, buf);
+    return t;
+}
+
+/* Look the preprocessed orchestra up in the cache.  Returns its tree, or
+   NULL if it is not there, or the cache is not in use; in the first case
+   the parse that follows is recorded for orc_cache_save(). */
+
+TREE *orc_cache_load(CSOUND *csound, const char *text, size_t len)
+{
+    const char *dir = getenv(orccache_envvar);
+    uint64_t key;
+    TREE    *t;
+
+    if (dir == NULL || dir[0] == '\0')
+      return NULL;
+    key = orc_cache_key(csound, text, len);
+    if ((t = orc_cache_read(csound, dir, key, len)) == NULL) {
+      rec_start(csound, key);
+      return NULL;
+    }
+    csound->DebugMsg(csound, "orchestra tree %016llx read from the cache\n",
+                     (unsigned long long) key);
+    return t;
+}
+
+/* keep the tree just parsed, before type checking changes it, and what
+   was recorded while parsing it; t is NULL if the parse failed */
+
+void orc_cache_save(CSOUND *csound, size_t len, TREE *t)
+{
+    const char *dir = getenv(orccache_envvar);
+    ORCCACHE_REC *rec = (ORCCACHE_REC*) csound->orcCacheRec;
+    ORCCACHE_HEADER hdr;
+    FILE    *f;
+    char    *path, *tmp;
+    size_t  n;
+    int     err;
+
+    if (rec == NULL)
+      return;
+    csound->orcCacheRec = NULL;
+    if (dir == NULL || dir[0] == '\0' || t == NULL) {
+      rec_free(csound, rec);
+      return;
+    }
+    path = orc_cache_path(csound, dir, rec->key);
+    /* written under another name first, so that no one reads half a file */
+    n = strlen(path) + 32;
+    tmp = (char*) csound->Malloc(csound, n);
+    snprintf(tmp, n, "%s.%p", path, (void*) csound);
+    if ((f = fopen(tmp, "wb")) == NULL) {
+      csound->Warning(csound, Str("orchestra cache: could not write '%s': %s"),
+                      tmp, strerror(errno));
+      csound->Free(csound, tmp);
+      csound->Free(csound, path);
+      rec_free(csound, rec);
+      return;
+    }
+    memset(&hdr, 0, sizeof(ORCCACHE_HEADER));
+    memcpy(hdr.magic, orccache_magic, sizeof(hdr.magic));
+    hdr.version = ORCCACHE_VERSION;
+    hdr.myfltsize = (int32_t) sizeof(MYFLT);
+    hdr.key = rec->key;
+    hdr.textlen = (uint64_t) len;
+    fwrite(&hdr, sizeof(ORCCACHE_HEADER), 1, f);
+    err = put_tree(f, t);
+    if (err == 0)
+      err = put_record(csound, f, rec);
+    if (fclose(f) != 0)
+      err = -1;
+    if (err != 0 || rename(tmp, path) != 0)
+      remove(tmp);
+    csound->Free(csound, tmp);
+    csound->Free(csound, path);
+    rec_free(csound, rec);
+}
@@ -33,6 +33,7 @@
 #include "interlocks.h"
 #include "csound_orc_semantics.h"
 #include "csound_standard_types.h"
+#include "csmodule.h"
 
 #ifndef PARSER_DEBUG
 #define PARSER_DEBUG (0)
@@ -215,6 +216,9 @@ ORCTOKEN *lookup_token(CSOUND *csound, char *s, void *yyscanner)
     }
 
     a = cs_hash_table_get(csound, csound->symbtab, s);
+    /* opcode from a plugin library that has not been loaded yet */
+    if (UNLIKELY(a == NULL) && csoundLoadDeferredOpcode(csound, s))
+      a = cs_hash_table_get(csound, csound->symbtab, s);
 
     if (a != NULL) {
       ans = (ORCTOKEN*)csound->Malloc(csound, sizeof(ORCTOKEN));
@@ -25,14 +25,24 @@
 
 #define CSOUND_SPIN_SPINLOCK csoundSpinLock(&csound->spinlock);
 #define CSOUND_SPIN_SPINUNLOCK csoundSpinUnLock(&csound->spinlock);
-#define CSOUND_SPOUT_SPINLOCK csoundSpinLock(&csound->spoutlock);
-#define CSOUND_SPOUT_SPINUNLOCK csoundSpinUnLock(&csound->spoutlock);
+/* under -j each thread has its own spout while the DAG is performed */
+#define CSOUND_SPOUT_SPINLOCK                                   \
+  if (!csound->reducing) csoundSpinLock(&csound->spoutlock);
+#define CSOUND_SPOUT_SPINUNLOCK                                 \
+  if (!csound->reducing) csoundSpinUnLock(&csound->spoutlock);
 
 typedef struct {
     OPDS    h;
     MYFLT   *r, *a;
 } ASSIGN;
 
+/* g += x, g -= x */
+typedef struct {
+    OPDS    h;
+    MYFLT   *r, *a;
+    void    *red;               /* per-thread copies of r under -j, or NULL */
+} ADDIN;
+
 #define ASSIGNM_MAX (24)
 typedef struct {
     OPDS    h;
@@ -0,0 +1,61 @@
+/*
+    cpubudget.h:
+
+    Copyright (C) 2026 The Csound Developers
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+#ifndef CSOUND_CPUBUDGET_H
+#define CSOUND_CPUBUDGET_H
+
+/* Voice management against a measured DSP load (--cpu-budget=N).
+ *
+ * The time taken by each k-cycle is kept as a rolling fraction of the
+ * k-period, and the cost of each instrument and instance is measured
+ * every few k-cycles.  A new voice whose cost would take the projected
+ * load over N% of the k-period is handled by the policy chosen with
+ * --cpu-budget-policy.  Instruments are ranked with cpuprio; the lowest
+ * go first.
+ */
+
+/* --cpu-budget-policy */
+#define CPU_BUDGET_REFUSE     0   /* do not start the new voice */
+#define CPU_BUDGET_OLDEST     1   /* turn off the oldest voices */
+#define CPU_BUDGET_QUIETEST   2   /* turn off the quietest voices */
+#define CPU_BUDGET_SKIP       3   /* do not perform the lowest priority
+                                     instruments while over budget */
+
+void   cpubudget_start(CSOUND *);
+int    cpubudget_admit(CSOUND *, INSTRTXT *tp);
+double cpubudget_settle(CSOUND *);
+void   cpubudget_kcycle(CSOUND *, double start);
+int    cpubudget_costing(CSOUND *);
+double cpubudget_inst_begin(CSOUND *);
+void   cpubudget_inst_end(CSOUND *, INSDS *, double start);
+void   cpubudget_level_begin(CSOUND *, int index, const MYFLT *out);
+void   cpubudget_level_end(CSOUND *, INSDS *, int index, const MYFLT *out);
+void   cpubudget_inst_cost(CSOUND *, INSDS *, double cost);
+int    cpubudget_skip(CSOUND *, INSDS *);
+void   cpubudget_report(CSOUND *);
+
+/* should instance ip sit out this k-cycle? */
+#define CPUBUDGET_SKIP(cs, ip)                                  \
+    (UNLIKELY((cs)->cpubudget != NULL) && cpubudget_skip(cs, ip))
+
+#endif      /* CSOUND_CPUBUDGET_H */
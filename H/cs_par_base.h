@@ -142,6 +142,7 @@ struct set_t *csp_set_alloc_string(CSOUND *csound);
 void csp_set_add(CSOUND *csound,     struct set_t *set, void *data);
 void csp_set_remove(CSOUND *csound,  struct set_t *set, void *data);
 /* check element existance returns 1 if data exists */
+int csp_set_exists(struct set_t *set, void *data);
 void csp_set_print(CSOUND *csound, struct set_t *set);
 
 /* get a count and access members */
@@ -202,4 +203,33 @@ void csp_semaphore_release_end(CSOUND *csound, sem_t *sem);
 /* print semaphore info */
 void csp_semaphore_release_print(CSOUND *csound, sem_t *sem);
 
+/* process-wide worker pool shared by all instances run with --thread-pool */
+
+/* join the pool; perf(csound, index, numThreads) performs the current
+ * DAG as thread 'index' of 'numThreads' */
+int csp_pool_attach(CSOUND *csound,
+                    int (*perf)(CSOUND *, int index, int numThreads));
+/* leave the pool, which is stopped when its last instance leaves */
+void csp_pool_detach(CSOUND *csound);
+/* perform the current DAG on the calling thread and free pool threads,
+ * returning when all of it is done */
+void csp_pool_perform(CSOUND *csound);
+
+/* per-thread reduction of spout and of globals that instruments only
+ * accumulate into (cs_par_reduce.c) */
+
+void csp_reduce_alloc(CSOUND *csound, int numThreads);
+/* reduction of a global written by 'name += ...', or NULL */
+void *csp_reduce_var(CSOUND *csound, INSDS *ip, char *name,
+                     MYFLT *dest, int n);
+/* the calling thread's zeroed copy of a reduced global */
+MYFLT *csp_reduce_buffer(void *var);
+/* around the performance of the DAG */
+void csp_reduce_begin(CSOUND *csound);
+void csp_reduce_end(CSOUND *csound);
+/* thread 'index' starts on the DAG: returns its spout */
+MYFLT *csp_reduce_thread(CSOUND *csound, int index);
+/* sum the copies of globals read by a task before it runs */
+void csp_reduce_task(CSOUND *csound, int insno);
+
 #endif /* end of include guard: __CS_PAR_BASE_H__ */
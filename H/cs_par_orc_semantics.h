@@ -86,6 +86,8 @@ struct instr_semantics_t
 
 /* interlocks */
 void csp_orc_sa_interlocks(CSOUND *, ORCTOKEN *);
+/* the message for a deprecated opcode found by csp_orc_sa_interlocks */
+void csp_orc_sa_deprecated(CSOUND *, char *name);
 
 void csp_orc_analyze_tree(CSOUND *, TREE*);
 
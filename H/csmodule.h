@@ -107,6 +107,30 @@ extern "C" {
    */
   int csoundDestroyModules(CSOUND *csound);
 
+  /**
+   * Load the deferred plugin libraries that provide opcode 'opname',
+   * according to the plugin manifest (see CS_PLUGIN_MANIFEST).
+   * Returns non-zero if any library was loaded.
+   */
+  int csoundLoadDeferredOpcode(CSOUND *csound, const char *opname);
+
+  /**
+   * Load all plugin libraries that are still deferred.
+   */
+  void csoundLoadAllDeferredModules(CSOUND *csound);
+
+  /**
+   * Returns a hash identifying the plugin libraries that are still
+   * deferred, or zero if none are; used by the orchestra cache.
+   */
+  uint64_t csoundDeferredOpcodesKey(CSOUND *csound);
+
+  /**
+   * Record an opcode added while a plugin manifest is in use;
+   * 'existed' is non-zero if the name was already defined.
+   */
+  void csoundManifestAddOpcode(CSOUND *csound, const char *name, int existed);
+
   /**
    * Initialise opcodes not in entry1.c
    */
@@ -70,6 +70,14 @@ extern int ksmps, nchnls; */
 void query_deprecated_opcode(CSOUND *, ORCTOKEN *);
 int  query_reversewrite_opcode(CSOUND *, ORCTOKEN *);
 
+/* orc_cache.c */
+TREE *orc_cache_load(CSOUND *, const char *text, size_t len);
+void orc_cache_save(CSOUND *, size_t len, TREE *);
+/* notes of messages given by the parser, replayed from the cache */
+#define ORCCACHE_DEPRECATED     (0)     /* query_deprecated_opcode() */
+#define ORCCACHE_SA_DEPRECATED  (1)     /* csp_orc_sa_deprecated() */
+void orc_cache_note(CSOUND *, int kind, const char *name);
+
     // holds matching oentries from opcodeList
     // has space for 16 matches and next pointer in case more are found
     // (unlikely though)
@@ -0,0 +1,62 @@
+/*
+    cstrace.h:
+
+    Copyright (C) 2026 The Csound Developers
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+#ifndef CSOUND_CSTRACE_H
+#define CSOUND_CSTRACE_H
+
+/* Timeline tracing (--trace=FILE, csoundSetTrace()).
+ *
+ * Threads record the begin and end of engine activities in a ring held
+ * by the instance; when the ring is full the oldest events are lost.
+ * The ring is written out in Chrome trace format, which Perfetto and
+ * chrome://tracing read.  Names must be string constants: only the
+ * pointer is stored.  When tracing is off each trace point costs one
+ * test of csound->trace.
+ */
+
+/* tracks (trace "threads"): set by each thread with cstrace_thread() */
+#define TRACE_PERF        0     /* performance thread */
+#define TRACE_WORKER      1     /* -j workers, 1 .. numThreads-1 */
+#define TRACE_POOL        128   /* shared pool threads (--thread-pool) */
+#define TRACE_ALLOC       256   /* realtime event insertion thread */
+#define TRACE_FILEIO      257   /* asynchronous file thread */
+#define TRACE_DISKIN      258   /* diskin2 read thread */
+#define TRACE_PVSIO       259   /* pvsfwrite thread */
+
+#define TRACE_DFLT_SIZE   (1 << 20)   /* events kept by --trace */
+
+extern const char cstrace_instr[];    /* name for instrument performance */
+
+int  cstrace_start(CSOUND *, const char *file);
+void cstrace_thread(int track);
+void cstrace_event(CSOUND *, const char *name, int32_t arg, char ph);
+void cstrace_cleanup(CSOUND *);
+
+#define TRACE_BEGIN(cs, name, arg)                      \
+    do { if (UNLIKELY((cs)->trace != NULL))             \
+           cstrace_event(cs, name, arg, 'B'); } while (0)
+#define TRACE_END(cs, name, arg)                        \
+    do { if (UNLIKELY((cs)->trace != NULL))             \
+           cstrace_event(cs, name, arg, 'E'); } while (0)
+
+#endif      /* CSOUND_CSTRACE_H */
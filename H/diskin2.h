@@ -25,6 +25,7 @@
 #define CSOUND_DISKIN2_H
 
 #include <sndfile.h>
+#include "resample.h"
 
 #define DISKIN2_MAXCHN  40              /* for consistency with soundin   */
 #define POS_FRAC_SHIFT  28              /* allows pitch accuracy of 2^-28 */
@@ -63,6 +64,7 @@ typedef struct {
     MYFLT   *prvBuf;
     MYFLT   prv_kTranspose;
     MYFLT   winFact;
+    const RESAMPLER *rsmp;      /* sinc kernel for window sizes > 4 */
     double  warpScale;
     SNDFILE *sf;
     FDCH    fdch;
@@ -106,6 +108,7 @@ typedef struct {
     MYFLT   *prvBuf;
     MYFLT   prv_kTranspose;
     MYFLT   winFact;
+    const RESAMPLER *rsmp;      /* sinc kernel for window sizes > 4 */
     double  warpScale;
     SNDFILE *sf;
     FDCH    fdch;
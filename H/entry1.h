@@ -90,6 +90,7 @@ int32_t modaa(CSOUND *, void *);
 int32_t addin(CSOUND *, void *), addina(CSOUND *, void *);
 int32_t subin(CSOUND *, void *), subina(CSOUND *, void *);
 int32_t addinak(CSOUND *, void *), subinak(CSOUND *, void *);
+int32_t addin_set(CSOUND *, void *);
 int32_t divzkk(CSOUND *, void *), divzka(CSOUND *, void *);
 int32_t divzak(CSOUND *, void *), divzaa(CSOUND *, void *);
 int32_t int1(CSOUND *, void *), int1a(CSOUND *, void *);
@@ -415,7 +416,7 @@ int32_t loop_g_p(CSOUND *, void *), loop_ge_p(CSOUND *, void *);
 int32_t delete_instr(CSOUND *, void *);
 int32_t insremot(CSOUND *, void *), insglobal(CSOUND *, void *);
 int32_t midremot(CSOUND *, void *), midglobal(CSOUND *, void *);
-int32_t remoteport(CSOUND *, void *);
+int32_t remoteport(CSOUND *, void *), remoteaudio(CSOUND *, void *);
 int32_t globallock(CSOUND *, void *);
 int32_t globalunlock(CSOUND *, void *);
 int32_t filebit(CSOUND *, void *); int32_t filebit_S(CSOUND *, void *);
@@ -241,6 +241,20 @@ extern "C" {
 
   int csoundFSeekAsync(CSOUND *csound, void *handle, int pos, int whence);
 
+  /**
+   * Byte stream access to CSFILE_STD files opened with
+   * csoundFileOpenWithType_Async().  Reads and writes transfer all
+   * 'items' bytes or nothing; csoundUngetAsync() pushes back one byte
+   * like ungetc().
+   */
+  unsigned int csoundReadAsyncBytes(CSOUND *csound, void *handle,
+                                    char *buf, int items);
+
+  unsigned int csoundWriteAsyncBytes(CSOUND *csound, void *handle,
+                                     const char *buf, int items);
+
+  void csoundUngetAsync(CSOUND *csound, void *handle, int c);
+
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,73 @@
+/*
+    oscbank.h:
+
+    Copyright (C) 2026 The Csound Developers
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+#ifndef CSOUND_OSCBANK_H
+#define CSOUND_OSCBANK_H
+
+/* Oscillator bank kernels shared by the additive synthesis opcodes
+ * (adsynt, adsynt2, oscbnk and pvadsyn).
+ *
+ * Oscillator state is kept as structure of arrays, one entry per
+ * partial, and a whole bank is rendered for a block of samples in one
+ * call.  Partials are run side by side so that their phase updates,
+ * which each depend on the previous sample, can overlap instead of
+ * being executed one partial after another.
+ */
+
+/* wavetable description for oscbank_table() */
+typedef struct {
+    const MYFLT *ftable;
+    uint32  phmask;             /* phase wraps at phmask + 1 */
+    uint32  lobits;             /* table index is phase >> lobits */
+    uint32  fracmask;           /* fractional phase bits, 0: truncate */
+    MYFLT   pfrac;              /* 1 / (fracmask + 1) */
+} OSCBANK_TAB;
+
+/* per partial state for oscbank_table(), see oscbank_alloc() */
+typedef struct {
+    int32_t count;
+    uint32  *phs, *inc;         /* phase and phase increment */
+    MYFLT   *amp, *damp;        /* amplitude and its change per sample */
+} OSCBANK;
+
+/* point the arrays of b at 'aux', (re)allocating it for count partials;
+   existing contents are kept if the allocation is large enough */
+void oscbank_alloc(CSOUND *, OSCBANK *b, AUXCH *aux, int32_t count);
+
+/* add the first 'count' partials of b to out[0..nsmps-1].  Partial c
+   contributes amp[c] * table(phs[c]) and then steps phs[c] by inc[c]
+   and amp[c] by damp[c] (damp may be NULL for fixed amplitudes).  On
+   return phs[] holds the phase of the next sample and amp[] the
+   amplitude used for the last one.  Partials are mixed into out in
+   order, so results match a loop over partials one at a time. */
+void oscbank_table(const OSCBANK_TAB *t, OSCBANK *b, int32_t count,
+                   MYFLT *out, int32_t nsmps);
+
+/* recursive quadrature sine bank ("magic circle"): for every partial
+   x -= a * y; y += a * x; with a = 2 * sin(pi * f / sr), y limited to
+   [-1, 1].  Adds (amp[c] + n * damp[c]) * y[c] to out[n]. */
+void oscbank_quad(MYFLT *x, MYFLT *y, const MYFLT *a, const MYFLT *amp,
+                  const MYFLT *damp, int32_t count, MYFLT *out,
+                  int32_t nsmps);
+
+#endif      /* CSOUND_OSCBANK_H */
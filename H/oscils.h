@@ -26,6 +26,8 @@
 #ifndef CSOUND_OSCILS_H
 #define CSOUND_OSCILS_H
 
+#include "resample.h"
+
 /* oscils opcode struct */
 
 typedef struct {
@@ -61,6 +63,17 @@ typedef struct {
 /*  double  wsized2_d, pidwsize_d; */           /* for oscils_hann.c */
 } TABLEXKT;
 
+/* tablexs opcode struct */
+
+typedef struct {
+    OPDS    h;
+    MYFLT   *ar, *xndx, *kfn, *iwsize, *iwarp;              /* opcode       */
+    MYFLT   *ixmode, *ixoff, *iwrap;                        /* args         */
+    /* internal variables */
+    int     raw_ndx, ndx_scl, wrap_ndx;
+    const RESAMPLER *rsmp;
+} TABLEXS;
+
 /* these functions are exported to entry*.c */
 
 #ifndef CSOUND_OSCILS_C
@@ -70,6 +83,8 @@ extern int lphasor_set (CSOUND *, void*);
 extern int lphasor (CSOUND *, void*);
 extern int tablexkt_set (CSOUND *, void*);
 extern int tablexkt (CSOUND *, void*);
+extern int tablexs_set (CSOUND *, void*);
+extern int tablexs (CSOUND *, void*);
 #endif
 
 #endif              /* CSOUND_OSCILS_H */
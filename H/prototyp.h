@@ -87,6 +87,7 @@ void    remove_tmpfiles(CSOUND *);
 void    add_tmpfile(CSOUND *, char *);
 void    xturnoff(CSOUND *, INSDS *);
 void    xturnoff_now(CSOUND *, INSDS *);
+INSDS   *find_instance_p1(INSTRTXT *, MYFLT p1, int held);
 int     insert_score_event(CSOUND *, EVTBLK *, double);
 //MEMFIL  *ldmemfile(CSOUND *, const char *);
 //MEMFIL  *ldmemfile2(CSOUND *, const char *, int);
@@ -111,6 +112,8 @@ int     csoundCheckOpcodePluginFile(CSOUND *, const char *);
 int     csoundLoadAndInitModule(CSOUND *, const char *);
 void    csoundNotifyFileOpened(CSOUND *, const char *, int, int, int);
 int     insert_score_event_at_sample(CSOUND *, EVTBLK *, int64_t);
+int     insert_score_events(CSOUND *, const MYFLT *, const int64_t *,
+                            const MYFLT *, int, int);
 
 char *get_arg_string(CSOUND *, MYFLT);
 
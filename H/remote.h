@@ -69,6 +69,8 @@ char remoteID(CSOUND *csound);
 #define SCOR_EVT 1
 #define MIDI_EVT 2
 #define MIDI_MSG 3
+#define AUDIO_TICK 4                    /* client: render k-period data[0]  */
+#define AUDIO_BLK 5                     /* server: spout of that k-period   */
 #define MAXSEND (sizeof(EVTBLK) + 2*sizeof(int))
 #define GLOBAL_REMOT -99
 
@@ -80,6 +82,7 @@ typedef struct {                        /* Remote Communication buffer
 
 #ifdef HAVE_SOCKETS
 
+#define MAXREMOTES 10
 
 typedef struct {
     char *adr;
@@ -100,6 +103,15 @@ typedef struct {
   struct sockaddr_in local_addr;
   REMOT_BUF CLsendbuf;          /* rt evt output Communications buffer */
   int   remote_port;            /* = 40002 default */
+  /* audio return, see remoteaudio */
+  int   audio_latency;          /* k-periods, 0: no audio return */
+  int   audio_tick;             /* server: k-period asked for by the client */
+  int   audio_kcnt;             /* client: k-periods ticked so far */
+  int   audio_dpos;             /* client: position in audio_delay */
+  int   audio_rfd[MAXREMOTES]; /* client: one connection per server */
+  MYFLT *audio_delay;           /* client: local spout, latency k-periods */
+  MYFLT *audio_buf;             /* block being received or sent */
+  uint32 audio_late;            /* client: blocks that missed their slot */
 } REMOTE_GLOBALS;
 
 #endif /* HAVE_SOCKETS */
@@ -109,6 +121,11 @@ typedef struct {                        /* structs for INSTR 0 opcodes */
     MYFLT   *port;
 } REMOTEPORT;
 
+typedef struct {                        /* structs for INSTR 0 opcodes */
+    OPDS    h;
+    MYFLT   *latency;
+} REMOTEAUDIO;
+
 typedef struct {                        /* structs for INSTR 0 opcodes */
     OPDS    h;
    STRINGDAT  *str1, *str2;
@@ -135,6 +152,8 @@ typedef struct {                                /* structs for INSTR 0 opcodes *
 
 int CLsend(CSOUND *csound, int conn, void *data, int length);
 int SVrecv(CSOUND *csound, int conn, void *data, int length);
+/* read one whole message, waiting for it; 0 when the connection closed */
+int SVrecvmsg(CSOUND *csound, int conn, REMOT_BUF *bp);
 
 /* musmon:      divert a score insno event to a remote machine */
 int insSendevt(CSOUND *p, EVTBLK *evt, int rfd);
@@ -168,4 +187,11 @@ int getRemoteInsRfdCount(CSOUND *csound);
 /* musmon: determine whether MIDI channel accepts remove events */
 int getRemoteChnRfd(CSOUND *csound, int chan);
 
+/* musmon: non-zero if this server returns its audio to a client, and
+   so has to wait for the client before each k-period */
+int getRemoteAudioServer(CSOUND *csound);
+
+/* kperf: exchange audio with remote machines once spout is complete */
+void remote_audio(CSOUND *csound);
+
 #endif      /* CSOUND_REMOTE_H */
@@ -0,0 +1,69 @@
+/*
+    resample.h:
+
+    Copyright (C) 2026 The Csound Developers
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+#ifndef CSOUND_RESAMPLE_H
+#define CSOUND_RESAMPLE_H
+
+/* Polyphase windowed-sinc interpolation kernel.
+ *
+ * The impulse response is tabulated once for 'phases' evenly spaced
+ * fractional positions; row r holds the 'taps' weights for an output
+ * point r / phases samples after input sample taps/2 - 1.  Positions
+ * between rows are linearly interpolated from 'coef' and 'dcoef', so
+ * computing one output point costs two contiguous dot products and no
+ * transcendental functions.  Rows are padded to a multiple of four so
+ * the inner loops vectorise.
+ */
+
+#define RESAMP_MAXTAPS  (1024)
+
+typedef struct resampler_ {
+    int32_t taps;               /* kernel length, a multiple of 4 */
+    int32_t phases;             /* number of tabulated fractional offsets */
+    MYFLT   cutoff;             /* relative to input Nyquist (0 - 1] */
+    MYFLT   *coef;              /* (phases + 1) * taps weights */
+    MYFLT   *dcoef;             /* coef[r + 1] - coef[r], same layout */
+    struct resampler_ *nxt;     /* list of shared kernels */
+} RESAMPLER;
+
+/* build a kernel, or free one created by resamp_new */
+RESAMPLER *resamp_new(CSOUND *, int32_t taps, MYFLT cutoff);
+void resamp_free(CSOUND *, RESAMPLER *);
+/* kernel shared by all opcodes of an instance, freed on reset */
+const RESAMPLER *resamp_shared(CSOUND *, int32_t taps, MYFLT cutoff);
+
+/* interpolated weights for fractional position frac (0 <= frac < 1) */
+void resamp_coefs(const RESAMPLER *, double frac, MYFLT *w);
+
+/* one output point; x[0] is input sample (position - taps/2 + 1) and
+   consecutive taps are 'stride' MYFLTs apart */
+MYFLT resamp_point(const RESAMPLER *, const MYFLT *x, int32_t stride,
+                   double frac);
+
+/* resample one channel of in[0..nin-1] (stride 'stride', zero outside
+   the range) at the input positions pos[0..nout-1] */
+void resamp_gather(const RESAMPLER *, const MYFLT *in, int32_t nin,
+                   int32_t stride, const double *pos, MYFLT *out,
+                   int32_t nout, int32_t ostride);
+
+#endif      /* CSOUND_RESAMPLE_H */
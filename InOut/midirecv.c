@@ -43,6 +43,17 @@
       as a note on status without the data bytes) should not be
       returned.
 
+    int (*MidiReadTimedCallback)(CSOUND *csound, void *userData,
+                                 unsigned char *buf, int nbytes,
+                                 double *times);
+
+      Optional; like MidiReadCallback, but also stores in times[i] the
+      age of byte i (how long before the call it was received, in
+      seconds).  A message is timed by its last byte.  With sample
+      accurate timing, note-ons are then started that far before the
+      end of the k-period, which delays them by a constant k-period
+      instead of quantising them to its start.
+
     int (*MidiInCloseCallback)(CSOUND *csound, void *userData);
 
       Close MIDI input device associated with 'userData'.
@@ -84,6 +95,10 @@
     void csoundSetExternalMidiReadCallback(CSOUND *csound,
                     int (*func)(CSOUND *, void *, unsigned char *, int));
 
+    void csoundSetExternalMidiReadTimedCallback(CSOUND *csound,
+                    int (*func)(CSOUND *, void *, unsigned char *, int,
+                                double *));
+
     void csoundSetExternalMidiInCloseCallback(CSOUND *csound,
                     int (*func)(CSOUND *, void *));
 
@@ -130,7 +145,7 @@ void MidiOpen(CSOUND *csound)
     if (O->Midiin) {
       if (p->MidiInOpenCallback == NULL)
         csound->Die(csound, Str(" *** no callback for opening MIDI input"));
-      if (p->MidiReadCallback == NULL)
+      if (p->MidiReadCallback == NULL && p->MidiReadTimedCallback == NULL)
         csound->Die(csound, Str(" *** no callback for reading MIDI data"));
       err = p->MidiInOpenCallback(csound, &(p->midiInUserData), O->Midiname);
       if (err != 0) {
@@ -473,6 +488,25 @@ static void midNotesOff(CSOUND *csound)
     } while (++chan < MAXCHAN);
 }
 
+/* sample offset in the k-period for a byte received 'age' seconds
+   before it was read; untimed bytes (age < 0) start the k-period */
+
+static int32 midi_offset(CSOUND *csound, double age)
+{
+    int32 ofs, ksmps = (int32) csound->ksmps;
+
+    if (age < 0.0)
+      return 0;
+    ofs = ksmps - (int32) (age * csound->esr + 0.5);
+    return (ofs < 0 ? 0 : (ofs >= ksmps ? ksmps - 1 : ofs));
+}
+
+static void midi_untimed(MGLOBAL *p, int first, int n)
+{
+    while (n-- > 0)
+      p->mtime[first++] = -1.0;
+}
+
 /* sense a MIDI event, collect the data & dispatch */
 /* called from sensevents(), returns 2 if MIDI on/off */
 
@@ -489,7 +523,13 @@ int sensMidi(CSOUND *csound)
       p->bufp = &(p->mbuf[0]);
       p->endatp = p->bufp;
       if (O->Midiin && !csound->advanceCnt) {   /* read MIDI device */
-        n = p->MidiReadCallback(csound, p->midiInUserData, p->bufp, MBUFSIZ);
+        if (p->MidiReadTimedCallback != NULL)
+          n = p->MidiReadTimedCallback(csound, p->midiInUserData, p->bufp,
+                                       MBUFSIZ, p->mtime);
+        else {
+          n = p->MidiReadCallback(csound, p->midiInUserData, p->bufp, MBUFSIZ);
+          midi_untimed(p, 0, n);
+        }
         if (n < 0)
           csoundErrorMsg(csound, Str(" *** error reading MIDI device: %d (%s)"),
                                  n, csoundExternalMidiErrorString(csound, n));
@@ -499,8 +539,10 @@ int sensMidi(CSOUND *csound)
       if (O->FMidiin) {                         /* read MIDI file */
         n = csoundMIDIFileRead(csound, p->endatp,
                                MBUFSIZ - (int) (p->endatp - p->bufp));
-        if (n > 0)
+        if (n > 0) {
+          midi_untimed(p, (int) (p->endatp - p->bufp), n);
           p->endatp += (int) n;
+        }
       }
       if (p->endatp <= p->bufp)
         return 0;               /* no events were received */
@@ -596,6 +638,7 @@ int sensMidi(CSOUND *csound)
       *pMessage = (p->datreq < 2 ? (unsigned char) 0 : mep->dat2);
     }
     p->datcnt = 0;                      /* else allow a repeat  */
+    mep->ofs = midi_offset(csound, p->mtime[p->bufp - p->mbuf - 1]);
     /* NB:  this allows repeat in syscom 1,2,3 too */
     if (mep->type > NOTEON_TYPE) {      /* if control or syscom */
       m_chanmsg(csound, mep);           /*   handle from here   */
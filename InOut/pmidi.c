@@ -376,11 +376,13 @@ static int OpenMidiOutDevice_(CSOUND *csound, void **userData, const char *dev)
 }
 
 static int ReadMidiData_(CSOUND *csound, void *userData,
-                         unsigned char *mbuf, int nbytes)
+                         unsigned char *mbuf, int nbytes, double *times)
 {
-  int             n, retval, st, d1, d2;
+  int             n, retval, st, d1, d2, i, len;
   unsigned char port = 0, map = 0;
     PmEvent         mev;
+    PmTimestamp     now = Pt_Time();
+    double          age;
     pmall_data *data;
     /*
      * Reads from MIDI input device linked list.
@@ -407,13 +409,19 @@ static int ReadMidiData_(CSOUND *csound, void *userData,
                        !(st == 0xF8 || st == 0xFA || st == 0xFB ||
                          st == 0xFC || st == 0xFF)))
             continue;
-          nbytes -= (datbyts[(st - 0x80) >> 4] + 1 + map);
+          /* no port byte if there is no data byte to follow */
+          len = datbyts[(st - 0x80) >> 4] + 1;
+          if (len > 1) len += map;
+          nbytes -= len;
           if (UNLIKELY(nbytes < 0)) {
             portMidiErrMsg(csound, Str("buffer overflow in MIDI input"));
             break;
           }
-          /* channel messages */
-          n += (datbyts[(st - 0x80) >> 4] + 1 + map);
+          /* channel messages, all bytes carry the event's age */
+          age = (now > mev.timestamp ? 0.001 * (now - mev.timestamp) : 0.0);
+          for (i = len; i > 0; i--)
+            *times++ = age;
+          n += len;
           switch (datbyts[(st - 0x80) >> 4]) {
             case 0:
               *mbuf++ = (unsigned char) st;
@@ -549,7 +557,7 @@ PUBLIC int csoundModuleInit(CSOUND *csound)
       return 0;
      csound->ErrorMsg(csound, "%s", Str("rtmidi: PortMIDI module enabled\n"));
     csound->SetExternalMidiInOpenCallback(csound, OpenMidiInDevice_);
-    csound->SetExternalMidiReadCallback(csound, ReadMidiData_);
+    csound->SetExternalMidiReadTimedCallback(csound, ReadMidiData_);
     csound->SetExternalMidiInCloseCallback(csound, CloseMidiInDevice_);
     csound->SetExternalMidiOutOpenCallback(csound, OpenMidiOutDevice_);
     csound->SetExternalMidiWriteCallback(csound, WriteMidiData_);
@@ -22,6 +22,9 @@
 
 #include "csoundCore.h" /*                                      AOPS.C  */
 #include "aops.h"
+#ifdef PARCS
+#include "cs_par_base.h"
+#endif
 #include <math.h>
 #include <time.h>
 
@@ -2141,81 +2144,112 @@ int32_t outrep(CSOUND *csound, OUTM *p)
 }
 
 /* For parallel mixin template */
-int32_t addina(CSOUND *csound, ASSIGN *p)
+
+/* Under -j, a global that the instrument only accumulates into is summed
+   in a copy private to the thread (cs_par_reduce.c); otherwise the sum
+   is done in place, under the spout lock. */
+int32_t addin_set(CSOUND *csound, ADDIN *p)
+{
+    ARG *arg = p->h.optext->t.outArgs;
+
+    p->red = NULL;
+#ifdef PARCS
+    if (csound->reduce != NULL && arg != NULL && arg->type == ARG_GLOBAL)
+      p->red = csp_reduce_var(csound, p->h.insdshead,
+                              ((CS_VARIABLE*) arg->argPtr)->varName, p->r,
+                              p->h.optext->t.oentry->outypes[0] == 'a' ?
+                              (int) csound->ksmps : 1);
+#else
+    IGN(arg);
+#endif
+    return OK;
+}
+
+static inline MYFLT *addin_begin(CSOUND *csound, ADDIN *p)
+{
+#ifdef PARCS
+    if (p->red != NULL && csound->reducing)
+      return csp_reduce_buffer(p->red);
+#endif
+    csoundSpinLock(&csound->spoutlock);
+    return p->r;
+}
+
+static inline void addin_end(CSOUND *csound, ADDIN *p, MYFLT *ans)
+{
+    if (ans == p->r)
+      csoundSpinUnLock(&csound->spoutlock);
+}
+
+int32_t addina(CSOUND *csound, ADDIN *p)
 {
     MYFLT* val = p->a;
-    MYFLT* ans = p->r;
+    MYFLT* ans = addin_begin(csound, p);
     uint32_t    offset = p->h.insdshead->ksmps_offset;
     uint32_t    nsmps = CS_KSMPS, n;
     uint32_t    early = nsmps-p->h.insdshead->ksmps_no_end;
 
-    CSOUND_SPOUT_SPINLOCK
     for (n=offset; n<early; n++)
       ans[n] += val[n];
-    CSOUND_SPOUT_SPINUNLOCK
+    addin_end(csound, p, ans);
     return OK;
 }
 
-int32_t addinak(CSOUND *csound, ASSIGN *p)
+int32_t addinak(CSOUND *csound, ADDIN *p)
 {
-    MYFLT val;
-    MYFLT* ans = p->r;
+    MYFLT val = *p->a;
+    MYFLT* ans = addin_begin(csound, p);
     uint32_t    offset = p->h.insdshead->ksmps_offset;
     uint32_t    nsmps = CS_KSMPS, n;
     uint32_t    early = nsmps-p->h.insdshead->ksmps_no_end;
 
-    CSOUND_SPOUT_SPINLOCK
-    val = *p->a;
     for (n=offset; n<early; n++)
       ans[n] += val;
-    CSOUND_SPOUT_SPINUNLOCK
+    addin_end(csound, p, ans);
     return OK;
 }
 
-int32_t addin(CSOUND *csound, ASSIGN *p)
+int32_t addin(CSOUND *csound, ADDIN *p)
 {
-    CSOUND_SPOUT_SPINLOCK
-    *p->r += *p->a;
-    CSOUND_SPOUT_SPINUNLOCK
+    MYFLT* ans = addin_begin(csound, p);
+    *ans += *p->a;
+    addin_end(csound, p, ans);
     return OK;
 }
 
-int32_t subin(CSOUND *csound, ASSIGN *p)
+int32_t subin(CSOUND *csound, ADDIN *p)
 {
-    CSOUND_SPOUT_SPINLOCK
-    *p->r -= *p->a;
-    CSOUND_SPOUT_SPINUNLOCK
+    MYFLT* ans = addin_begin(csound, p);
+    *ans -= *p->a;
+    addin_end(csound, p, ans);
     return OK;
 }
 
-int32_t subina(CSOUND *csound, ASSIGN *p)
+int32_t subina(CSOUND *csound, ADDIN *p)
 {
     MYFLT* val = p->a;
-    MYFLT* ans = p->r;
+    MYFLT* ans = addin_begin(csound, p);
     uint32_t    offset = p->h.insdshead->ksmps_offset;
     uint32_t    nsmps = CS_KSMPS, n;
     uint32_t    early = nsmps-p->h.insdshead->ksmps_no_end;
 
-    CSOUND_SPOUT_SPINLOCK
     for (n=offset; n<early; n++)
       ans[n] -= val[n];
-    CSOUND_SPOUT_SPINUNLOCK
+    addin_end(csound, p, ans);
     return OK;
 }
 
-int32_t subinak(CSOUND *csound, ASSIGN *p)
+int32_t subinak(CSOUND *csound, ADDIN *p)
 {
-    MYFLT val;
-    MYFLT* ans = p->r;
+    MYFLT val = *p->a;
+    MYFLT* ans = addin_begin(csound, p);
     uint32_t    offset = p->h.insdshead->ksmps_offset;
     uint32_t    nsmps = CS_KSMPS, n;
     uint32_t    early = nsmps-p->h.insdshead->ksmps_no_end;
 
-    CSOUND_SPOUT_SPINLOCK
-    val = *p->a;
     for (n=offset; n<early; n++)
       ans[n] -= val;
-    CSOUND_SPOUT_SPINUNLOCK
+    addin_end(csound, p, ans);
     return OK;
 }
 
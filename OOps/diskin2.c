@@ -24,6 +24,7 @@
 #include "csoundCore.h"
 #include "soundio.h"
 #include "diskin2.h"
+#include "cstrace.h"
 #include <math.h>
 #include <inttypes.h>
 
@@ -375,6 +376,9 @@ static int32_t diskin2_init_(CSOUND *csound, DISKIN2 *p, int32_t stringname)
       /* constant for window calculation */
       p->winFact = (FL(1.0) - POWER(p->winSize * FL(0.85172), -FL(0.89624)))
         / ((MYFLT)((p->winSize * p->winSize) >> 2));
+      /* precomputed kernel for the sinc modes */
+      if (p->winSize > 4)
+        p->rsmp = resamp_shared(csound, p->winSize, FL(1.0));
     }
     /* set file parameters from header info */
     p->fileLength = (int32_t) sfinfo.frames;
@@ -569,6 +573,7 @@ int32_t diskin2_perf_synchronous(CSOUND *csound, DISKIN2 *p)
     MYFLT    frac, a0, a1, a2, a3, onedwarp, winFact;
     int32_t  ndx;
     int32_t  wsized2, warp;
+    MYFLT    coef[RESAMP_MAXTAPS];
 
 
     if (UNLIKELY(p->fdch.fd == NULL) ) goto file_error;
@@ -714,20 +719,10 @@ int32_t diskin2_perf_synchronous(CSOUND *csound, DISKIN2 *p)
             diskin2_get_sample(csound, p, ndx, nn, FL(1.0));
           }
           else {
-            a0 = (MYFLT)(sin(PI * frac_d) / PI);
-            i = wsized2;
-            do {
-              a1 = (MYFLT)d; a1 = FL(1.0) - a1 * a1 * winFact;
-              a1 = a1 * a1 / (MYFLT)d;
-              diskin2_get_sample(csound, p, ndx, nn, a1*a0);
-              d += 1.0;
-              ndx++;
-              a1 = (MYFLT)d; a1 = FL(1.0) - a1 * a1 * winFact;
-              a1 = -(a1 * a1 / (MYFLT)d);
-              diskin2_get_sample(csound, p, ndx, nn, a1*a0);
-              d += 1.0;
-              ndx++;
-            } while (--i);
+            /* tabulated kernel, see resample.c */
+            resamp_coefs(p->rsmp, frac_d, coef);
+            for (i = 0; i < p->winSize; i++, ndx++)
+              diskin2_get_sample(csound, p, ndx, nn, coef[i]);
           }
         }
         /* update file position */
@@ -757,6 +752,7 @@ int32_t diskin_file_read(CSOUND *csound, DISKIN2 *p)
     MYFLT   frac, a0, a1, a2, a3, onedwarp, winFact;
     int32_t ndx;
     int32_t wsized2, warp;
+    MYFLT   coef[RESAMP_MAXTAPS];
     MYFLT   *aOut = (MYFLT *)p->aOut_buf; /* needs to be allocated */
     MYFLT transpose = p->transpose;
 
@@ -902,20 +898,10 @@ int32_t diskin_file_read(CSOUND *csound, DISKIN2 *p)
             diskin2_get_sample(csound, p, ndx, nn, FL(1.0));
           }
           else {
-            a0 = (MYFLT)(sin(PI * frac_d) / PI);
-            i = wsized2;
-            do {
-              a1 = (MYFLT)d; a1 = FL(1.0) - a1 * a1 * winFact;
-              a1 = a0 * a1 * a1 / (MYFLT)d;
-              diskin2_get_sample(csound, p, ndx, nn, a1);
-              d += 1.0;
-              ndx++;
-              a1 = (MYFLT)d; a1 = FL(1.0) - a1 * a1 * winFact;
-              a1 = -(a0 * a1 * a1 / (MYFLT)d);
-              diskin2_get_sample(csound, p, ndx, nn, a1);
-              d += 1.0;
-              ndx++;
-            } while (--i);
+            /* tabulated kernel, see resample.c */
+            resamp_coefs(p->rsmp, frac_d, coef);
+            for (i = 0; i < p->winSize; i++, ndx++)
+              diskin2_get_sample(csound, p, ndx, nn, coef[i]);
           }
         }
         /* update file position */
@@ -983,11 +969,14 @@ uintptr_t diskin_io_thread(void *p){
     int32_t *start =
       current->csound->QueryGlobalVariable(current->csound,"DISKIN_THREAD_START");
     _MM_SET_DENORMALS_ZERO_MODE(_MM_DENORMALS_ZERO_ON);
+    cstrace_thread(TRACE_DISKIN);
     while(*start){
       current = (DISKIN_INST *) p;
       csoundSleep(wakeup > 0 ? wakeup : 1);
       while(current != NULL){
+        TRACE_BEGIN(current->csound, "diskin_read", -1);
         diskin_file_read(current->csound, current->diskin);
+        TRACE_END(current->csound, "diskin_read", -1);
         current = current->nxt;
       }
     }
@@ -1361,6 +1350,7 @@ int32_t diskin_file_read_array(CSOUND *csound, DISKIN2_ARRAY *p)
     MYFLT   frac, a0, a1, a2, a3, onedwarp, winFact;
     int32_t   ndx;
     int32_t     wsized2, warp;
+    MYFLT       coef[RESAMP_MAXTAPS];
     MYFLT  *aOut = (MYFLT *)p->aOut_buf; /* needs to be allocated */
 
     if (UNLIKELY(p->fdch.fd == NULL) ) goto file_error;
@@ -1505,20 +1495,10 @@ int32_t diskin_file_read_array(CSOUND *csound, DISKIN2_ARRAY *p)
             diskin2_get_sample_array(csound, p, ndx, nn, FL(1.0));
           }
           else {
-            a0 = (MYFLT)(sin(PI * frac_d) / PI);
-            i = wsized2;
-            do {
-              a1 = (MYFLT)d; a1 = FL(1.0) - a1 * a1 * winFact;
-              a1 = a0 * a1 * a1 / (MYFLT)d;
-              diskin2_get_sample_array(csound, p, ndx, nn, a1);
-              d += 1.0;
-              ndx++;
-              a1 = (MYFLT)d; a1 = FL(1.0) - a1 * a1 * winFact;
-              a1 = -(a0 * a1 * a1 / (MYFLT)d);
-              diskin2_get_sample_array(csound, p, ndx, nn, a1);
-              d += 1.0;
-              ndx++;
-            } while (--i);
+            /* tabulated kernel, see resample.c */
+            resamp_coefs(p->rsmp, frac_d, coef);
+            for (i = 0; i < p->winSize; i++, ndx++)
+              diskin2_get_sample_array(csound, p, ndx, nn, coef[i]);
           }
         }
         /* update file position */
@@ -1548,11 +1528,14 @@ uintptr_t diskin_io_thread_array(void *p){
       current->csound->QueryGlobalVariable(current->csound,
                                            "DISKIN_THREAD_START_ARRAY");
     _MM_SET_DENORMALS_ZERO_MODE(_MM_DENORMALS_ZERO_ON);
+    cstrace_thread(TRACE_DISKIN);
     while(*start){
       current = (DISKIN_INST *) p;
       csoundSleep(wakeup > 0 ? wakeup : 1);
       while(current != NULL){
+        TRACE_BEGIN(current->csound, "diskin_read", -1);
         diskin_file_read_array(current->csound, (DISKIN2_ARRAY *)current->diskin);
+        TRACE_END(current->csound, "diskin_read", -1);
         current = current->nxt;
       }
     }
@@ -1656,6 +1639,9 @@ static int32_t diskin2_init_array(CSOUND *csound, DISKIN2_ARRAY *p,
       /* constant for window calculation */
       p->winFact = (FL(1.0) - POWER(p->winSize * FL(0.85172), -FL(0.89624)))
         / ((MYFLT)((p->winSize * p->winSize) >> 2));
+      /* precomputed kernel for the sinc modes */
+      if (p->winSize > 4)
+        p->rsmp = resamp_shared(csound, p->winSize, FL(1.0));
     }
     /* set file parameters from header info */
     p->fileLength = (int32_t) sfinfo.frames;
@@ -1810,6 +1796,7 @@ int32_t diskin2_perf_synchronous_array(CSOUND *csound, DISKIN2_ARRAY *p)
     MYFLT   frac, a0, a1, a2, a3, onedwarp, winFact;
     int32_t   ndx;
     int32_t     wsized2, warp;
+    MYFLT       coef[RESAMP_MAXTAPS];
     MYFLT *aOut = (MYFLT *) p->aOut->data;
 
 
@@ -1956,20 +1943,10 @@ int32_t diskin2_perf_synchronous_array(CSOUND *csound, DISKIN2_ARRAY *p)
             diskin2_get_sample_array(csound, p, ndx, nn, FL(1.0));
           }
           else {
-            a0 = (MYFLT)(sin(PI * frac_d) / PI);
-            i = wsized2;
-            do {
-              a1 = (MYFLT)d; a1 = FL(1.0) - a1 * a1 * winFact;
-              a1 = a0 * a1 * a1 / (MYFLT)d;
-              diskin2_get_sample_array(csound, p, ndx, nn, a1);
-              d += 1.0;
-              ndx++;
-              a1 = (MYFLT)d; a1 = FL(1.0) - a1 * a1 * winFact;
-              a1 = -(a0 * a1 * a1 / (MYFLT)d);
-              diskin2_get_sample_array(csound, p, ndx, nn, a1);
-              d += 1.0;
-              ndx++;
-            } while (--i);
+            /* tabulated kernel, see resample.c */
+            resamp_coefs(p->rsmp, frac_d, coef);
+            for (i = 0; i < p->winSize; i++, ndx++)
+              diskin2_get_sample_array(csound, p, ndx, nn, coef[i]);
           }
         }
         /* update file position */
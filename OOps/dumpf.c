@@ -38,6 +38,67 @@ static const int32_t dumpf_format_table[9] = {
   CSFTYPE_FLOATS_TEXT,
 };
 
+/* In real-time mode dumpk and readk leave the file to the I/O thread
+   (see csoundFileOpenWithType_Async()); their FILE pointer is then NULL
+   and data goes through the file handle in fdch instead. */
+
+#define KD_ASYNC_BUFSIZE  (4096)
+
+static void *kd_open(CSOUND *csound, FILE **f, char *name, char *mode,
+                     const char *env, int32_t csFileType)
+{
+    void *fd;
+
+    if (csound->oparms->realtime == 0)
+      return csound->FileOpen2(csound, f, CSFILE_STD, name, mode, env,
+                               csFileType, 0);
+    fd = csound->FileOpenAsync(csound, f, CSFILE_STD, name, mode, env,
+                               csFileType, KD_ASYNC_BUFSIZE, 0);
+    *f = NULL;
+    return fd;
+}
+
+static int kd_read(CSOUND *csound, FILE *f, void *fd, char *buf, int32_t len)
+{
+    if (f != NULL)
+      return (int) fread(buf, 1, len, f);
+    return (int) csoundReadAsyncBytes(csound, fd, buf, len);
+}
+
+static int kd_getc(CSOUND *csound, FILE *f, void *fd)
+{
+    char c;
+
+    if (f != NULL)
+      return getc(f);
+    return (csoundReadAsyncBytes(csound, fd, &c, 1) == 1 ?
+            (int) (unsigned char) c : EOF);
+}
+
+static char *kd_gets(CSOUND *csound, char *buf, int32_t size, FILE *f,
+                     void *fd)
+{
+    int32_t n = 0;
+    int     c;
+
+    if (f != NULL)
+      return fgets(buf, size, f);
+    while (n < size - 1 && (c = kd_getc(csound, f, fd)) != EOF) {
+      buf[n++] = (char) c;
+      if (c == '\n') break;
+    }
+    buf[n] = '\0';
+    return (n > 0 ? buf : NULL);
+}
+
+static void kd_ungetc(CSOUND *csound, int c, FILE *f, void *fd)
+{
+    if (f != NULL)
+      ungetc(c, f);
+    else
+      csoundUngetAsync(csound, fd, c);
+}
+
 int32_t kdmpset_S(CSOUND *csound, KDUMP *p) {
     /* open in curdir or pathname */
     char soundoname[1024];
@@ -51,8 +112,8 @@ int32_t kdmpset_S(CSOUND *csound, KDUMP *p) {
     strNcpy(soundoname,  ((STRINGDAT *)p->ifilcod)->data, 1023);
     if (p->fdch.fd != NULL)
       csound_fd_close(csound, &(p->fdch));
-    p->fdch.fd = csound->FileOpen2(csound, &(p->f), CSFILE_STD, soundoname,
-                                   "wb", "", dumpf_format_table[p->format], 0);
+    p->fdch.fd = kd_open(csound, &(p->f), soundoname, "wb", "",
+                         dumpf_format_table[p->format]);
     if (UNLIKELY(p->fdch.fd == NULL))
       return csound->InitError(csound, Str("Cannot open %s"), soundoname);
     fdrecord(csound, &p->fdch);
@@ -80,8 +141,8 @@ int32_t kdmpset_p(CSOUND *csound, KDUMP *p)
     else csound->strarg2name(csound, soundoname, p->ifilcod, "dumpk.", 0);
     if (p->fdch.fd != NULL)
       csound_fd_close(csound, &(p->fdch));
-    p->fdch.fd = csound->FileOpen2(csound, &(p->f), CSFILE_STD, soundoname,
-                                   "wb", "", dumpf_format_table[p->format], 0);
+    p->fdch.fd = kd_open(csound, &(p->f), soundoname, "wb", "",
+                         dumpf_format_table[p->format]);
     if (UNLIKELY(p->fdch.fd == NULL))
       return csound->InitError(csound, Str("Cannot open %s"), soundoname);
     fdrecord(csound, &p->fdch);
@@ -105,8 +166,8 @@ int32_t kdmp2set_S(CSOUND *csound, KDUMP2 *p)
     strNcpy(soundoname,  ((STRINGDAT *)p->ifilcod)->data, 1023);
     if (p->fdch.fd != NULL)
       csound_fd_close(csound, &(p->fdch));
-    p->fdch.fd = csound->FileOpen2(csound, &(p->f), CSFILE_STD, soundoname,
-                                   "wb", "", dumpf_format_table[p->format], 0);
+    p->fdch.fd = kd_open(csound, &(p->f), soundoname, "wb", "",
+                         dumpf_format_table[p->format]);
     if (UNLIKELY(p->fdch.fd == NULL))
       return csound->InitError(csound, Str("Cannot open %s"), soundoname);
     fdrecord(csound, &p->fdch);
@@ -133,8 +194,8 @@ int32_t kdmp2set_p(CSOUND *csound, KDUMP2 *p)
     else csound->strarg2name(csound, soundoname, p->ifilcod, "dumpk.", 0);
     if (p->fdch.fd != NULL)
       csound_fd_close(csound, &(p->fdch));
-    p->fdch.fd = csound->FileOpen2(csound, &(p->f), CSFILE_STD, soundoname,
-                                   "wb", "", dumpf_format_table[p->format], 0);
+    p->fdch.fd = kd_open(csound, &(p->f), soundoname, "wb", "",
+                         dumpf_format_table[p->format]);
     if (UNLIKELY(p->fdch.fd == NULL))
       return csound->InitError(csound, Str("Cannot open %s"), soundoname);
     fdrecord(csound, &p->fdch);
@@ -159,8 +220,8 @@ int32_t kdmp3set_S(CSOUND *csound, KDUMP3 *p)
     strNcpy(soundoname,  ((STRINGDAT *)p->ifilcod)->data, 1023);
     if (p->fdch.fd != NULL)
       csound_fd_close(csound, &(p->fdch));
-    p->fdch.fd = csound->FileOpen2(csound, &(p->f), CSFILE_STD, soundoname,
-                                   "wb", "", dumpf_format_table[p->format], 0);
+    p->fdch.fd = kd_open(csound, &(p->f), soundoname, "wb", "",
+                         dumpf_format_table[p->format]);
     if (UNLIKELY(p->fdch.fd == NULL))
       return csound->InitError(csound, Str("Cannot open %s"), soundoname);
     fdrecord(csound, &p->fdch);
@@ -188,8 +249,8 @@ int32_t kdmp3set_p(CSOUND *csound, KDUMP3 *p)
     else csound->strarg2name(csound, soundoname, p->ifilcod, "dumpk.", 0);
     if (p->fdch.fd != NULL)
       csound_fd_close(csound, &(p->fdch));
-    p->fdch.fd = csound->FileOpen2(csound, &(p->f), CSFILE_STD, soundoname,
-                                   "wb", "", dumpf_format_table[p->format], 0);
+    p->fdch.fd = kd_open(csound, &(p->f), soundoname, "wb", "",
+                         dumpf_format_table[p->format]);
     if (UNLIKELY(p->fdch.fd == NULL))
       return csound->InitError(csound, Str("Cannot open %s"), soundoname);
     fdrecord(csound, &p->fdch);
@@ -213,8 +274,8 @@ int32_t kdmp4set_S(CSOUND *csound, KDUMP4 *p)
    strNcpy(soundoname,  ((STRINGDAT *)p->ifilcod)->data, 1023);
     if (p->fdch.fd != NULL)
       csound_fd_close(csound, &(p->fdch));
-    p->fdch.fd = csound->FileOpen2(csound, &(p->f), CSFILE_STD, soundoname,
-                                   "wb", "", dumpf_format_table[p->format], 0);
+    p->fdch.fd = kd_open(csound, &(p->f), soundoname, "wb", "",
+                         dumpf_format_table[p->format]);
     if (p->fdch.fd == NULL)
       return csound->InitError(csound, Str("Cannot open %s"), soundoname);
     fdrecord(csound, &p->fdch);
@@ -240,8 +301,8 @@ int32_t kdmp4set_p(CSOUND *csound, KDUMP4 *p)
     else csound->strarg2name(csound, soundoname, p->ifilcod, "dumpk.", 0);
     if (p->fdch.fd != NULL)
       csound_fd_close(csound, &(p->fdch));
-    p->fdch.fd = csound->FileOpen2(csound, &(p->f), CSFILE_STD, soundoname,
-                                   "wb", "", dumpf_format_table[p->format], 0);
+    p->fdch.fd = kd_open(csound, &(p->f), soundoname, "wb", "",
+                         dumpf_format_table[p->format]);
     if (p->fdch.fd == NULL)
       return csound->InitError(csound, Str("Cannot open %s"), soundoname);
     fdrecord(csound, &p->fdch);
@@ -251,8 +312,8 @@ int32_t kdmp4set_p(CSOUND *csound, KDUMP4 *p)
     return OK;
 }
 
-static void nkdump(CSOUND *csound, MYFLT *kp, FILE *ofd, int32_t format,
-                   int32_t nk, void *p)
+static void nkdump(CSOUND *csound, MYFLT *kp, FILE *ofd, void *fd,
+                   int32_t format, int32_t nk, void *p)
 {
     char  buf1[256], outbuf[256];
     int32_t   len = 0;
@@ -309,6 +370,10 @@ static void nkdump(CSOUND *csound, MYFLT *kp, FILE *ofd, int32_t format,
       csound->PerfError(csound,&(((KDUMP *)p)->h),
                         Str("unknown kdump format"));
     }
+    if (ofd == NULL) {          /* queue for the I/O thread */
+      csoundWriteAsyncBytes(csound, fd, outbuf, len);
+      return;
+    }
     if (UNLIKELY(fwrite(outbuf, len, 1, ofd)!=1)) { /* now write the buffer */
       csound->PerfError(csound, &(((KDUMP *)p)->h),
                         Str("write failure in dumpk"));
@@ -322,7 +387,7 @@ int32_t kdump(CSOUND *csound, KDUMP *p)
     if (--p->countdown <= 0) {
       p->countdown = p->timcount;
       kval[0] = *p->ksig;
-      nkdump(csound, kval, p->f, p->format, 1, p);
+      nkdump(csound, kval, p->f, p->fdch.fd, p->format, 1, p);
     }
     return OK;
 }
@@ -335,7 +400,7 @@ int32_t kdump2(CSOUND *csound, KDUMP2 *p)
       p->countdown = p->timcount;
       kval[0] = *p->ksig1;
       kval[1] = *p->ksig2;
-      nkdump(csound, kval, p->f, p->format, 2, p);
+      nkdump(csound, kval, p->f, p->fdch.fd, p->format, 2, p);
     }
     return OK;
 }
@@ -349,7 +414,7 @@ int32_t kdump3(CSOUND *csound, KDUMP3 *p)
       kval[0] = *p->ksig1;
       kval[1] = *p->ksig2;
       kval[2] = *p->ksig3;
-      nkdump(csound, kval, p->f, p->format, 3, p);
+      nkdump(csound, kval, p->f, p->fdch.fd, p->format, 3, p);
     }
     return OK;
 }
@@ -364,7 +429,7 @@ int32_t kdump4(CSOUND *csound, KDUMP4 *p)
       kval[1] = *p->ksig2;
       kval[2] = *p->ksig3;
       kval[3] = *p->ksig4;
-      nkdump(csound, kval, p->f, p->format, 4, p);
+      nkdump(csound, kval, p->f, p->fdch.fd, p->format, 4, p);
     }
     return OK;
 }
@@ -389,8 +454,8 @@ int32_t krdset_p(CSOUND *csound, KREAD *p)
     else csound->strarg2name(csound, soundiname, p->ifilcod, "readk.", 0);
     if (p->fdch.fd != NULL)
       csound_fd_close(csound, &(p->fdch));
-    p->fdch.fd = csound->FileOpen2(csound, &(p->f), CSFILE_STD, soundiname, "rb",
-                                   "SFDIR;SSDIR", dumpf_format_table[p->format], 0);
+    p->fdch.fd = kd_open(csound, &(p->f), soundiname, "rb", "SFDIR;SSDIR",
+                         dumpf_format_table[p->format]);
     if (UNLIKELY(p->fdch.fd == NULL))
       return csound->InitError(csound, Str("Cannot open %s"), soundiname);
     fdrecord(csound, &p->fdch);
@@ -415,8 +480,8 @@ int32_t krdset_S(CSOUND *csound, KREAD *p)
     strNcpy(soundiname,  ((STRINGDAT *)p->ifilcod)->data, 1023);
     if (p->fdch.fd != NULL)
       csound_fd_close(csound, &(p->fdch));
-    p->fdch.fd = csound->FileOpen2(csound, &(p->f), CSFILE_STD, soundiname, "rb",
-                                   "SFDIR;SSDIR", dumpf_format_table[p->format], 0);
+    p->fdch.fd = kd_open(csound, &(p->f), soundiname, "rb", "SFDIR;SSDIR",
+                         dumpf_format_table[p->format]);
     if (UNLIKELY(p->fdch.fd == NULL))
       return csound->InitError(csound, Str("Cannot open %s"), soundiname);
     fdrecord(csound, &p->fdch);
@@ -441,8 +506,8 @@ int32_t krd2set_S(CSOUND *csound, KREAD2 *p)
    strNcpy(soundiname,  ((STRINGDAT *)p->ifilcod)->data, 1023);
     if (p->fdch.fd != NULL)
       csound_fd_close(csound, &(p->fdch));
-    p->fdch.fd = csound->FileOpen2(csound, &(p->f), CSFILE_STD, soundiname, "rb",
-                                   "SFDIR;SSDIR", dumpf_format_table[p->format], 0);
+    p->fdch.fd = kd_open(csound, &(p->f), soundiname, "rb", "SFDIR;SSDIR",
+                         dumpf_format_table[p->format]);
     if (UNLIKELY(p->fdch.fd == NULL))
       return csound->InitError(csound, Str("Cannot open %s"), soundiname);
     fdrecord(csound, &p->fdch);
@@ -469,8 +534,8 @@ int32_t krd2set_p(CSOUND *csound, KREAD2 *p)
     else csound->strarg2name(csound, soundiname, p->ifilcod, "readk.", 0);
     if (p->fdch.fd != NULL)
       csound_fd_close(csound, &(p->fdch));
-    p->fdch.fd = csound->FileOpen2(csound, &(p->f), CSFILE_STD, soundiname, "rb",
-                                   "SFDIR;SSDIR", dumpf_format_table[p->format], 0);
+    p->fdch.fd = kd_open(csound, &(p->f), soundiname, "rb", "SFDIR;SSDIR",
+                         dumpf_format_table[p->format]);
     if (UNLIKELY(p->fdch.fd == NULL))
       return csound->InitError(csound, Str("Cannot open %s"), soundiname);
     fdrecord(csound, &p->fdch);
@@ -495,8 +560,8 @@ int32_t krd3set_S(CSOUND *csound, KREAD3 *p)
     strNcpy(soundiname,  ((STRINGDAT *)p->ifilcod)->data, 1023);
     if (p->fdch.fd != NULL)
       csound_fd_close(csound, &(p->fdch));
-    p->fdch.fd = csound->FileOpen2(csound, &(p->f), CSFILE_STD, soundiname, "rb",
-                                   "SFDIR;SSDIR", dumpf_format_table[p->format], 0);
+    p->fdch.fd = kd_open(csound, &(p->f), soundiname, "rb", "SFDIR;SSDIR",
+                         dumpf_format_table[p->format]);
     if (UNLIKELY(p->fdch.fd == NULL))
       return csound->InitError(csound, Str("Cannot open %s"), soundiname);
     fdrecord(csound, &p->fdch);
@@ -523,8 +588,8 @@ int32_t krd3set_p(CSOUND *csound, KREAD3 *p)
     else csound->strarg2name(csound, soundiname, p->ifilcod, "readk.", 0);
     if (p->fdch.fd != NULL)
       csound_fd_close(csound, &(p->fdch));
-    p->fdch.fd = csound->FileOpen2(csound, &(p->f), CSFILE_STD, soundiname, "rb",
-                                   "SFDIR;SSDIR", dumpf_format_table[p->format], 0);
+    p->fdch.fd = kd_open(csound, &(p->f), soundiname, "rb", "SFDIR;SSDIR",
+                         dumpf_format_table[p->format]);
     if (UNLIKELY(p->fdch.fd == NULL))
       return csound->InitError(csound, Str("Cannot open %s"), soundiname);
     fdrecord(csound, &p->fdch);
@@ -549,8 +614,8 @@ int32_t krd4set_S(CSOUND *csound, KREAD4 *p)
     strNcpy(soundiname,  ((STRINGDAT *)p->ifilcod)->data, 1023);
     if (p->fdch.fd != NULL)
       csound_fd_close(csound, &(p->fdch));
-    p->fdch.fd = csound->FileOpen2(csound, &(p->f), CSFILE_STD, soundiname, "rb",
-                                   "SFDIR;SSDIR", dumpf_format_table[p->format], 0);
+    p->fdch.fd = kd_open(csound, &(p->f), soundiname, "rb", "SFDIR;SSDIR",
+                         dumpf_format_table[p->format]);
     if (UNLIKELY(p->fdch.fd == NULL))
       return csound->InitError(csound, Str("Cannot open %s"), soundiname);
     fdrecord(csound, &p->fdch);
@@ -577,8 +642,8 @@ int32_t krd4set_p(CSOUND *csound, KREAD4 *p)
     else csound->strarg2name(csound, soundiname, p->ifilcod, "readk.", 0);
     if (p->fdch.fd != NULL)
       csound_fd_close(csound, &(p->fdch));
-    p->fdch.fd = csound->FileOpen2(csound, &(p->f), CSFILE_STD, soundiname, "rb",
-                                   "SFDIR;SSDIR", dumpf_format_table[p->format], 0);
+    p->fdch.fd = kd_open(csound, &(p->f), soundiname, "rb", "SFDIR;SSDIR",
+                         dumpf_format_table[p->format]);
     if (UNLIKELY(p->fdch.fd == NULL))
       return csound->InitError(csound, Str("Cannot open %s"), soundiname);
     fdrecord(csound, &p->fdch);
@@ -590,7 +655,8 @@ int32_t krd4set_p(CSOUND *csound, KREAD4 *p)
 }
 
 
-static void nkread(CSOUND *csound, MYFLT *kp, FILE *ifd, int32_t format, int32_t nk)
+static void nkread(CSOUND *csound, MYFLT *kp, FILE *ifd, void *fd,
+                   int32_t format, int32_t nk)
 {
     int32_t   len;
     char  inbuf[256];
@@ -600,7 +666,7 @@ static void nkread(CSOUND *csound, MYFLT *kp, FILE *ifd, int32_t format, int32_t
     case 1: {
       int8_t *bp = (int8_t*)inbuf;
       len = nk;
-      if ((unsigned)len != fread(inbuf, 1, len, ifd)) break;        /* now read the buffer */
+      if (len != kd_read(csound, ifd, fd, inbuf, len)) break;        /* now read the buffer */
       while (nk--)
         *kp++ = (MYFLT)*bp++;
       break;
@@ -608,7 +674,7 @@ static void nkread(CSOUND *csound, MYFLT *kp, FILE *ifd, int32_t format, int32_t
     case 4: {
       int16_t *bp = (int16_t*)inbuf;
       len = nk * 2;
-      if ((unsigned)len != fread(inbuf, 1, len, ifd)) break;        /* now read the buffer */
+      if (len != kd_read(csound, ifd, fd, inbuf, len)) break;        /* now read the buffer */
       while (nk--)
         *kp++ = (MYFLT)*bp++;
       break;
@@ -616,7 +682,7 @@ static void nkread(CSOUND *csound, MYFLT *kp, FILE *ifd, int32_t format, int32_t
     case 5: {
       int32_t *bp = (int32_t*)inbuf;
       len = nk * 4;
-      if ((unsigned)len != fread(inbuf, 1, len, ifd)) break;        /* now read the buffer */
+      if (len != kd_read(csound, ifd, fd, inbuf, len)) break;        /* now read the buffer */
       while (nk--)
         *kp++ = (MYFLT)*bp++;
       break;
@@ -624,7 +690,7 @@ static void nkread(CSOUND *csound, MYFLT *kp, FILE *ifd, int32_t format, int32_t
     case 6: {
       float *bp = (float*)inbuf;
       len = nk * sizeof(float);
-      if ((unsigned)len != fread(inbuf, 1, len, ifd)) break;        /* now read the buffer */
+      if (len != kd_read(csound, ifd, fd, inbuf, len)) break;        /* now read the buffer */
       while (nk--)
         *kp++ = (MYFLT)*bp++;
       break;
@@ -635,7 +701,7 @@ static void nkread(CSOUND *csound, MYFLT *kp, FILE *ifd, int32_t format, int32_t
         int c;
         /* NOTE: could use nextval() in Engine/fgens.c instead */
         do {                    /* Skip whitespace and comments */
-          c = getc(ifd);
+          c = kd_getc(csound, ifd, fd);
           switch (c) {
             case EOF: return;
             case '\n': in_comment = 0; break;
@@ -645,13 +711,13 @@ static void nkread(CSOUND *csound, MYFLT *kp, FILE *ifd, int32_t format, int32_t
           *bp = (char)c;
         } while (isspace(*bp) || in_comment);
         do {                    /* Absorb digits */
-          c = getc(ifd);
+          c = kd_getc(csound, ifd, fd);
           if (c == EOF) return;
           if ((unsigned)(bp - inbuf + 1) >= sizeof(inbuf)) return;
           *(++bp) = (char)c;
         } while (isdigit(*bp) ||
                  *bp=='-' || *bp=='+' || *bp=='.' || *bp=='e' ||*bp=='E');
-        ungetc(*bp, ifd); //fseek(ifd, -1L, SEEK_CUR);
+        kd_ungetc(csound, *bp, ifd, fd);
         *bp = '\0';
 #ifndef USE_DOUBLE
         CS_SSCANF(inbuf,"%f", kp);
@@ -666,7 +732,7 @@ static void nkread(CSOUND *csound, MYFLT *kp, FILE *ifd, int32_t format, int32_t
         char *bp = inbuf;
         int c;
         do {                    /* Skip whitespace and comments */
-          c = getc(ifd);
+          c = kd_getc(csound, ifd, fd);
           switch (c) {
             case EOF: return;
             case '\n': in_comment = 0; break;
@@ -676,12 +742,12 @@ static void nkread(CSOUND *csound, MYFLT *kp, FILE *ifd, int32_t format, int32_t
           *bp = (char)c;
         } while (isspace(*bp) || in_comment);
         do {                    /* Absorb digits and such*/
-          c = getc(ifd);
+          c = kd_getc(csound, ifd, fd);
           if (c == EOF) return;
           if ((unsigned)(bp - inbuf + 1) >= sizeof(inbuf)) return;
           *(++bp) = (char)c;
         } while (!isspace(*bp));
-        (void)ungetc(*bp, ifd); //fseek(ifd, -1L, SEEK_CUR);
+        kd_ungetc(csound, *bp, ifd, fd);
         *bp = '\0';
 #ifndef USE_DOUBLE
         CS_SSCANF(inbuf,"%f", kp);
@@ -701,7 +767,8 @@ int32_t kread(CSOUND *csound, KREAD *p)
 
     if (--p->countdown <= 0) {
       p->countdown = p->timcount;
-      nkread(csound, kval, p->f, p->format, 1);
+      memcpy(kval, p->k, sizeof(kval));   /* kept if nothing is read */
+      nkread(csound, kval, p->f, p->fdch.fd, p->format, 1);
       *p->k1 = p->k[0] = kval[0];
     }
     else *p->k1 = p->k[0];
@@ -714,7 +781,8 @@ int32_t kread2(CSOUND *csound, KREAD2 *p)
 
     if (--p->countdown <= 0) {
       p->countdown = p->timcount;
-      nkread(csound, kval, p->f, p->format, 2);
+      memcpy(kval, p->k, sizeof(kval));
+      nkread(csound, kval, p->f, p->fdch.fd, p->format, 2);
       *p->k1 = p->k[0] = kval[0];
       *p->k2 = p->k[1] = kval[1];
     }
@@ -731,7 +799,8 @@ int32_t kread3(CSOUND *csound, KREAD3 *p)
 
     if (--p->countdown <= 0) {
       p->countdown = p->timcount;
-      nkread(csound, kval, p->f, p->format, 3);
+      memcpy(kval, p->k, sizeof(kval));
+      nkread(csound, kval, p->f, p->fdch.fd, p->format, 3);
       *p->k1 = p->k[0] = kval[0];
       *p->k2 = p->k[1] = kval[1];
       *p->k3 = p->k[2] = kval[2];
@@ -750,7 +819,8 @@ int32_t kread4(CSOUND *csound, KREAD4 *p)
 
     if (--p->countdown <= 0) {
       p->countdown = p->timcount;
-      nkread(csound, kval, p->f, p->format, 4);
+      memcpy(kval, p->k, sizeof(kval));
+      nkread(csound, kval, p->f, p->fdch.fd, p->format, 4);
       *p->k1 = p->k[0] = kval[0];
       *p->k2 = p->k[1] = kval[1];
       *p->k3 = p->k[2] = kval[2];
@@ -774,8 +844,8 @@ int32_t krdsset_S(CSOUND *csound, KREADS *p)
     strNcpy(soundiname, ((STRINGDAT *)p->ifilcod)->data, 1023);
     if (p->fdch.fd != NULL)
       csound_fd_close(csound, &(p->fdch));
-    p->fdch.fd = csound->FileOpen2(csound, &(p->f), CSFILE_STD, soundiname, "rb",
-                                   "SFDIR;SSDIR", 0, 0);
+    p->fdch.fd = kd_open(csound, &(p->f), soundiname, "rb", "SFDIR;SSDIR",
+                         0);
     if (UNLIKELY(p->fdch.fd == NULL))
       return csound->InitError(csound, Str("Cannot open %s"), soundiname);
     fdrecord(csound, &p->fdch);
@@ -801,8 +871,8 @@ int32_t krdsset_p(CSOUND *csound, KREADS *p)
     else csound->strarg2name(csound, soundiname, p->ifilcod, "readk.", 0);
     if (p->fdch.fd != NULL)
       csound_fd_close(csound, &(p->fdch));
-    p->fdch.fd = csound->FileOpen2(csound, &(p->f), CSFILE_STD, soundiname, "rb",
-                                   "SFDIR;SSDIR", 0, 0);
+    p->fdch.fd = kd_open(csound, &(p->f), soundiname, "rb", "SFDIR;SSDIR",
+                         0);
     if (UNLIKELY(p->fdch.fd == NULL))
       return csound->InitError(csound, Str("Cannot open %s"), soundiname);
     fdrecord(csound, &p->fdch);
@@ -823,7 +893,7 @@ int32_t kreads(CSOUND *csound, KREADS *p)
 {
     if (--p->countdown <= 0) {
       p->countdown = p->timcount;
-      if (UNLIKELY(fgets(p->lasts, INITSIZE-1,  p->f)==NULL)) {
+      if (UNLIKELY(kd_gets(csound, p->lasts, INITSIZE-1, p->f, p->fdch.fd)==NULL)) {
         csound->PerfError(csound, &(p->h), Str("Read failure in readks"));
       }
     }
@@ -221,7 +221,10 @@ int32_t turnoff2(CSOUND *csound, TURNOFF2 *p, int32_t isStringArg)
   /*       return csoundPerfError(csound, &(p->h), */
   /*                              Str("turnoff2: invalid instrument number")); */
   /*     }   */
-  while ((ip = ip->nxtact) != NULL && (int32_t) ip->insno != insno);
+  if (mode & 4)                 /* the first instance with this p1 */
+    ip = find_instance_p1(csound->engineState.instrtxtp[insno], p1, 0);
+  else
+    while ((ip = ip->nxtact) != NULL && (int32_t) ip->insno != insno);
   if (ip == NULL)
     return OK;
   do {                        /* This loop does not terminate in mode=0 */
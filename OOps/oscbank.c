@@ -0,0 +1,305 @@
+/*
+    oscbank.c:
+
+    Copyright (C) 2026 The Csound Developers
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+/* Oscillator bank kernels for the additive synthesis opcodes */
+
+#include "csoundCore.h"
+#include "oscbank.h"
+
+/* vector types for the quadrature bank.  Loads and stores are unaligned
+   since AUXCH memory has no alignment guarantee beyond malloc's */
+#if defined(__AVX__) && defined(USE_DOUBLE)
+#include <immintrin.h>
+#define OSCBANK_VLEN    4
+typedef __m256d vreal;
+#define v_load(p)       _mm256_loadu_pd(p)
+#define v_store(p, v)   _mm256_storeu_pd(p, v)
+#define v_set1(x)       _mm256_set1_pd(x)
+#define v_add(a, b)     _mm256_add_pd(a, b)
+#define v_sub(a, b)     _mm256_sub_pd(a, b)
+#define v_mul(a, b)     _mm256_mul_pd(a, b)
+#define v_min(a, b)     _mm256_min_pd(a, b)
+#define v_max(a, b)     _mm256_max_pd(a, b)
+#elif defined(__AVX__)
+#include <immintrin.h>
+#define OSCBANK_VLEN    8
+typedef __m256 vreal;
+#define v_load(p)       _mm256_loadu_ps(p)
+#define v_store(p, v)   _mm256_storeu_ps(p, v)
+#define v_set1(x)       _mm256_set1_ps(x)
+#define v_add(a, b)     _mm256_add_ps(a, b)
+#define v_sub(a, b)     _mm256_sub_ps(a, b)
+#define v_mul(a, b)     _mm256_mul_ps(a, b)
+#define v_min(a, b)     _mm256_min_ps(a, b)
+#define v_max(a, b)     _mm256_max_ps(a, b)
+#elif defined(__SSE2__) && defined(USE_DOUBLE)
+#include <emmintrin.h>
+#define OSCBANK_VLEN    2
+typedef __m128d vreal;
+#define v_load(p)       _mm_loadu_pd(p)
+#define v_store(p, v)   _mm_storeu_pd(p, v)
+#define v_set1(x)       _mm_set1_pd(x)
+#define v_add(a, b)     _mm_add_pd(a, b)
+#define v_sub(a, b)     _mm_sub_pd(a, b)
+#define v_mul(a, b)     _mm_mul_pd(a, b)
+#define v_min(a, b)     _mm_min_pd(a, b)
+#define v_max(a, b)     _mm_max_pd(a, b)
+#elif defined(__SSE__) && !defined(USE_DOUBLE)
+#include <xmmintrin.h>
+#define OSCBANK_VLEN    4
+typedef __m128 vreal;
+#define v_load(p)       _mm_loadu_ps(p)
+#define v_store(p, v)   _mm_storeu_ps(p, v)
+#define v_set1(x)       _mm_set1_ps(x)
+#define v_add(a, b)     _mm_add_ps(a, b)
+#define v_sub(a, b)     _mm_sub_ps(a, b)
+#define v_mul(a, b)     _mm_mul_ps(a, b)
+#define v_min(a, b)     _mm_min_ps(a, b)
+#define v_max(a, b)     _mm_max_ps(a, b)
+#elif defined(__ARM_NEON) && defined(__aarch64__) && defined(USE_DOUBLE)
+#include <arm_neon.h>
+#define OSCBANK_VLEN    2
+typedef float64x2_t vreal;
+#define v_load(p)       vld1q_f64(p)
+#define v_store(p, v)   vst1q_f64(p, v)
+#define v_set1(x)       vdupq_n_f64(x)
+#define v_add(a, b)     vaddq_f64(a, b)
+#define v_sub(a, b)     vsubq_f64(a, b)
+#define v_mul(a, b)     vmulq_f64(a, b)
+#define v_min(a, b)     vminq_f64(a, b)
+#define v_max(a, b)     vmaxq_f64(a, b)
+#elif defined(__ARM_NEON) && !defined(USE_DOUBLE)
+#include <arm_neon.h>
+#define OSCBANK_VLEN    4
+typedef float32x4_t vreal;
+#define v_load(p)       vld1q_f32(p)
+#define v_store(p, v)   vst1q_f32(p, v)
+#define v_set1(x)       vdupq_n_f32(x)
+#define v_add(a, b)     vaddq_f32(a, b)
+#define v_sub(a, b)     vsubq_f32(a, b)
+#define v_mul(a, b)     vmulq_f32(a, b)
+#define v_min(a, b)     vminq_f32(a, b)
+#define v_max(a, b)     vmaxq_f32(a, b)
+#endif
+
+/* number of partials run side by side by oscbank_table() */
+#define OSCBANK_LANES   4
+
+void oscbank_alloc(CSOUND *csound, OSCBANK *b, AUXCH *aux, int32_t count)
+{
+    size_t  size;
+
+    if (count < 1) count = 1;
+    /* phases first, so they stay put if count changes on re-init */
+    size = (size_t) count * (2 * sizeof(uint32) + 2 * sizeof(MYFLT));
+    if (aux->auxp == NULL || aux->size < size)
+      csound->AuxAlloc(csound, size, aux);
+    b->count = count;
+    b->phs = (uint32*) aux->auxp;
+    b->inc = b->phs + count;
+    b->amp = (MYFLT*) (b->inc + count);
+    b->damp = b->amp + count;
+}
+
+/* one sample of partial k: table lookup, scaled by the current amplitude */
+static inline MYFLT oscbank_sample(const OSCBANK_TAB *t, uint32 ph,
+                                   MYFLT amp, const int32_t interp)
+{
+    const MYFLT *ft = t->ftable;
+    uint32  n = ph >> t->lobits;
+    MYFLT   v = ft[n];
+
+    if (interp)
+      v += (ft[n + 1] - v) * (MYFLT) ((int32) (ph & t->fracmask)) * t->pfrac;
+    return v * amp;
+}
+
+/* render the nl < OSCBANK_LANES partials left over at the end in
+   lockstep.  For each sample the
+   partials are added to out[n] in order, as the opcodes always did */
+static inline void oscbank_lanes(const OSCBANK_TAB *t, uint32 *phs,
+                                 const uint32 *inc, MYFLT *amp,
+                                 const MYFLT *damp, const int32_t nl,
+                                 MYFLT *out, int32_t nsmps,
+                                 const int32_t interp)
+{
+    uint32  ph[OSCBANK_LANES], in[OSCBANK_LANES];
+    MYFLT   a[OSCBANK_LANES], da[OSCBANK_LANES];
+    const uint32 phmask = t->phmask;
+    int32_t k, n;
+
+    for (k = 0; k < nl; k++) {
+      ph[k] = phs[k]; in[k] = inc[k];
+      a[k] = amp[k]; da[k] = (damp != NULL ? damp[k] : FL(0.0));
+    }
+    for (n = 0; n < nsmps - 1; n++) {
+      MYFLT s = out[n];
+      for (k = 0; k < nl; k++) {
+        s += oscbank_sample(t, ph[k], a[k], interp);
+        ph[k] = (ph[k] + in[k]) & phmask;
+        a[k] += da[k];
+      }
+      out[n] = s;
+    }
+    /* the last sample does not advance the amplitude ramp */
+    if (nsmps > 0) {
+      MYFLT s = out[n];
+      for (k = 0; k < nl; k++) {
+        s += oscbank_sample(t, ph[k], a[k], interp);
+        ph[k] = (ph[k] + in[k]) & phmask;
+      }
+      out[n] = s;
+    }
+    for (k = 0; k < nl; k++) {
+      phs[k] = ph[k];
+      if (damp != NULL) amp[k] = a[k];
+    }
+}
+
+/* four partials in lockstep, written out so the compiler keeps the
+   whole state in registers; partials are still added in order */
+static inline void oscbank_four(const OSCBANK_TAB *t, uint32 *phs,
+                                const uint32 *inc, MYFLT *amp,
+                                const MYFLT *damp, MYFLT *out,
+                                int32_t nsmps, const int32_t interp)
+{
+    uint32  p0 = phs[0], p1 = phs[1], p2 = phs[2], p3 = phs[3];
+    const uint32 i0 = inc[0], i1 = inc[1], i2 = inc[2], i3 = inc[3];
+    MYFLT   a0 = amp[0], a1 = amp[1], a2 = amp[2], a3 = amp[3];
+    MYFLT   d0 = FL(0.0), d1 = FL(0.0), d2 = FL(0.0), d3 = FL(0.0);
+    MYFLT   l0 = a0, l1 = a1, l2 = a2, l3 = a3;
+    const uint32 phmask = t->phmask;
+    int32_t n;
+
+    if (damp != NULL) {
+      d0 = damp[0]; d1 = damp[1]; d2 = damp[2]; d3 = damp[3];
+    }
+    for (n = 0; n < nsmps; n++) {
+      MYFLT s = out[n];
+      s += oscbank_sample(t, p0, a0, interp);
+      s += oscbank_sample(t, p1, a1, interp);
+      s += oscbank_sample(t, p2, a2, interp);
+      s += oscbank_sample(t, p3, a3, interp);
+      out[n] = s;
+      p0 = (p0 + i0) & phmask; p1 = (p1 + i1) & phmask;
+      p2 = (p2 + i2) & phmask; p3 = (p3 + i3) & phmask;
+      l0 = a0; l1 = a1; l2 = a2; l3 = a3;
+      a0 += d0; a1 += d1; a2 += d2; a3 += d3;
+    }
+    phs[0] = p0; phs[1] = p1; phs[2] = p2; phs[3] = p3;
+    if (damp != NULL) {
+      amp[0] = l0; amp[1] = l1; amp[2] = l2; amp[3] = l3;
+    }
+}
+
+void oscbank_table(const OSCBANK_TAB *t, OSCBANK *b, int32_t count,
+                   MYFLT *out, int32_t nsmps)
+{
+    const int32_t interp = (t->fracmask != 0);
+    int32_t c;
+
+    if (count > b->count) count = b->count;
+    for (c = 0; c < count; c += OSCBANK_LANES) {
+      int32_t nl = count - c;
+      uint32  *phs = b->phs + c;
+      const uint32 *inc = b->inc + c;
+      MYFLT   *amp = b->amp + c;
+      const MYFLT *damp = (b->damp != NULL ? b->damp + c : NULL);
+
+      if (nl >= OSCBANK_LANES) {
+        if (interp)
+          oscbank_four(t, phs, inc, amp, damp, out, nsmps, 1);
+        else
+          oscbank_four(t, phs, inc, amp, damp, out, nsmps, 0);
+      }
+      else if (interp)
+        oscbank_lanes(t, phs, inc, amp, damp, nl, out, nsmps, 1);
+      else
+        oscbank_lanes(t, phs, inc, amp, damp, nl, out, nsmps, 0);
+    }
+}
+
+void oscbank_quad(MYFLT *x, MYFLT *y, const MYFLT *a, const MYFLT *amp,
+                  const MYFLT *damp, int32_t count, MYFLT *out,
+                  int32_t nsmps)
+{
+    int32_t i, j;
+
+    for (j = 0; j < nsmps; j++) {
+      const MYFLT fj = (MYFLT) j;
+      MYFLT   sum = FL(0.0);
+
+      i = 0;
+#ifdef OSCBANK_VLEN
+      {
+        const vreal one = v_set1(FL(1.0)), mone = v_set1(FL(-1.0));
+        const vreal vj = v_set1(fj);
+        vreal   acc0 = v_set1(FL(0.0)), acc1 = v_set1(FL(0.0));
+        MYFLT   lanes[OSCBANK_VLEN];
+        int32_t k;
+
+        for (; i + 2 * OSCBANK_VLEN <= count; i += 2 * OSCBANK_VLEN) {
+          vreal a0 = v_load(a + i), a1 = v_load(a + i + OSCBANK_VLEN);
+          vreal x0 = v_load(x + i), x1 = v_load(x + i + OSCBANK_VLEN);
+          vreal y0 = v_load(y + i), y1 = v_load(y + i + OSCBANK_VLEN);
+          vreal g0 = v_add(v_load(amp + i), v_mul(vj, v_load(damp + i)));
+          vreal g1 = v_add(v_load(amp + i + OSCBANK_VLEN),
+                           v_mul(vj, v_load(damp + i + OSCBANK_VLEN)));
+
+          x0 = v_sub(x0, v_mul(a0, y0));
+          x1 = v_sub(x1, v_mul(a1, y1));
+          y0 = v_min(v_max(v_add(y0, v_mul(a0, x0)), mone), one);
+          y1 = v_min(v_max(v_add(y1, v_mul(a1, x1)), mone), one);
+          v_store(x + i, x0); v_store(x + i + OSCBANK_VLEN, x1);
+          v_store(y + i, y0); v_store(y + i + OSCBANK_VLEN, y1);
+          acc0 = v_add(acc0, v_mul(g0, y0));
+          acc1 = v_add(acc1, v_mul(g1, y1));
+        }
+        for (; i + OSCBANK_VLEN <= count; i += OSCBANK_VLEN) {
+          vreal a0 = v_load(a + i), x0 = v_load(x + i), y0 = v_load(y + i);
+          vreal g0 = v_add(v_load(amp + i), v_mul(vj, v_load(damp + i)));
+
+          x0 = v_sub(x0, v_mul(a0, y0));
+          y0 = v_min(v_max(v_add(y0, v_mul(a0, x0)), mone), one);
+          v_store(x + i, x0); v_store(y + i, y0);
+          acc0 = v_add(acc0, v_mul(g0, y0));
+        }
+        v_store(lanes, v_add(acc0, acc1));
+        for (k = 0; k < OSCBANK_VLEN; k++)
+          sum += lanes[k];
+      }
+#endif
+      for (; i < count; i++) {
+        MYFLT yi;
+
+        x[i] -= a[i] * y[i];
+        yi = y[i] + a[i] * x[i];
+        /* expensive, but worth it for evenness */
+        if (yi < FL(-1.0)) yi = FL(-1.0);
+        if (yi > FL(1.0))  yi = FL(1.0);
+        y[i] = yi;
+        sum += (amp[i] + fj * damp[i]) * yi;
+      }
+      out[j] += sum;
+    }
+}
@@ -418,3 +418,95 @@ int32_t tablexkt(CSOUND *csound, TABLEXKT *p)
     }
     return OK;
 }
+
+/* -------- tablexs set-up -------- */
+
+int32_t tablexs_set(CSOUND *csound, TABLEXS *p)
+{
+    int32_t wsize;
+    MYFLT   warp = *(p->iwarp);
+
+    /* widen the kernel with the cutoff so the transition band keeps */
+    /* its width in output samples */
+    if (warp < FL(1.0)) warp = FL(1.0);
+    wsize = (int32_t)(*(p->iwsize) * warp + FL(0.5));
+    wsize = ((wsize + 2) >> 2) << 2;
+    if (wsize < 8) wsize = 8;
+    else if (wsize > RESAMP_MAXTAPS) wsize = RESAMP_MAXTAPS;
+    p->rsmp = resamp_shared(csound, wsize, FL(1.0) / warp);
+    if (UNLIKELY(p->rsmp == NULL))
+      return csound->InitError(csound, "%s",
+                               Str("tablexs: could not create kernel"));
+    p->ndx_scl = (*(p->ixmode) == FL(0.0) ? 0 : 1);         /* index mode */
+    p->wrap_ndx = (*(p->iwrap) == FL(0.0) ? 0 : 1);         /* wrap index */
+    if ((*(p->ixoff) != FL(0.0)) || p->ndx_scl) p->raw_ndx = 0;
+    else p->raw_ndx = 1;
+    return OK;
+}
+
+/* -------- tablexs opcode -------- */
+
+int32_t tablexs(CSOUND *csound, TABLEXS *p)
+{
+    uint32_t offset = p->h.insdshead->ksmps_offset;
+    uint32_t early  = p->h.insdshead->ksmps_no_end;
+    uint32_t n, nsmps = CS_KSMPS;
+    const RESAMPLER *r = p->rsmp;
+    int32_t i, k, flen, taps, first;
+    double  ndx, ndx_f, flen_d;
+    MYFLT   *ar, *xndx, *ftable, tmp[RESAMP_MAXTAPS];
+    FUNC    *ftp;
+    int32_t asgx = IS_ASIG_ARG(p->xndx);
+
+    if (UNLIKELY(r == NULL))
+      return csound->PerfError(csound, &(p->h),
+                               Str("tablexs: not initialised"));
+    if (UNLIKELY((ftp = csound->FTnp2Finde(csound, p->kfn)) == NULL))
+      return NOTOK;
+    if (UNLIKELY((ftable = ftp->ftable) == NULL)) return NOTOK;
+    flen = ftp->flen;
+    flen_d = (double)flen;
+    taps = r->taps;
+    ar = p->ar;
+    xndx = p->xndx;
+
+    if (UNLIKELY(offset)) memset(ar, '\0', offset*sizeof(MYFLT));
+    if (UNLIKELY(early)) {
+      nsmps -= early;
+      memset(&ar[nsmps], '\0', early*sizeof(MYFLT));
+    }
+    for (n=offset; n<nsmps; n++) {
+      ndx = (double)*xndx;
+      if (asgx) xndx++;
+      if (!(p->raw_ndx)) {
+        ndx += (double)*(p->ixoff);
+        if (p->ndx_scl) ndx *= flen_d;
+      }
+      if (p->wrap_ndx) {
+        ndx = fmod(ndx, flen_d);
+        if (ndx < 0.0) ndx += flen_d;
+      }
+      else if (UNLIKELY(ndx < 0.0)) ndx = 0.0;
+      else if (UNLIKELY(ndx > flen_d)) ndx = flen_d;
+      i = (int32_t)ndx;
+      ndx_f = ndx - (double)i;
+      first = i + 1 - (taps >> 1);
+      if (LIKELY(first >= 0 && first + taps <= flen)) {
+        ar[n] = resamp_point(r, &ftable[first], 1, ndx_f);
+        continue;
+      }
+      /* window crosses an end of the table: wrap or hold the end values */
+      for (k = 0; k < taps; k++) {
+        i = first + k;
+        if (p->wrap_ndx) {
+          while (i < 0) i += flen;
+          while (i >= flen) i -= flen;
+        }
+        else if (i < 0) i = 0;
+        else if (i > flen) i = flen;
+        tmp[k] = ftable[i];
+      }
+      ar[n] = resamp_point(r, tmp, 1, ndx_f);
+    }
+    return OK;
+}
@@ -28,6 +28,7 @@
 
 #include "csoundCore.h"
 #include "pstream.h"
+#include "oscbank.h"
 #include "pvfileio.h"
 
 #ifdef _DEBUG
@@ -180,26 +181,18 @@ int32_t pvadsynset(CSOUND *csound, PVADS *p)
 
     return OK;
 }
-/* c/o John Lazzaro, for SAOL, and many other sources */
-static inline MYFLT fastoscil(MYFLT *a, MYFLT *x, MYFLT *y)
-{
-    *x = *x - *a * *y;
-    *y = *y + *a * *x;
-    /* expensive, but worth it for evenness ? */
-    if (*y < FL(-1.0)) *y = FL(-1.0);
-    if (*y > FL(1.0))  *y = FL(1.0);
-    return *y;
-}
-
+/* Oscillator state is kept compacted: entry k is bin startbin + k*binoffset.
+   The recursive oscillators (c/o John Lazzaro, for SAOL, and many other
+   sources) run on the shared oscillator bank. */
 static void adsyn_frame(CSOUND *csound, PVADS *p)
 {
-    int32_t i,j;
+    int32_t i,k;
     int32_t startbin,lastbin,binoffset;
     MYFLT *outbuf = (MYFLT *) (p->outbuf.auxp);
 
     float *frame;        /* RWD MUST be 32bit */
     MYFLT *a,*x,*y;
-    MYFLT *amps,*freqs,*lastamps;
+    MYFLT *amps,*damps,*lastamps;
     MYFLT ffac    = *p->kfmod;
     MYFLT nyquist = csound->esr * FL(0.5);
     /* we add to outbuf, so clear it first*/
@@ -210,39 +203,30 @@ static void adsyn_frame(CSOUND *csound, PVADS *p)
     x         = (MYFLT *) p->x.auxp;
     y         = (MYFLT *) p->y.auxp;
     amps      = (MYFLT *) p->amps.auxp;
-    freqs     = (MYFLT *) p->freqs.auxp;
+    damps     = (MYFLT *) p->freqs.auxp;    /* freqs are only needed for a */
     lastamps  = (MYFLT *) p->lastamps.auxp;
     startbin  = (int32_t) *p->ibin;
     binoffset = (int32_t) *p->ibinoffset;
     lastbin   = p->maxosc;
 
     /*update amps, freqs*/
-    for (i=startbin;i < lastbin;i+= binoffset) {
-      amps[i] = frame[i*2];
+    for (i=startbin, k=0;i < lastbin;i+= binoffset, k++) {
+      MYFLT freq;
+      amps[k] = frame[i*2];
       /* lazy: force all freqs positive! */
-      freqs[i] = ffac * FABS(frame[(i*2)+1]);
+      freq = ffac * FABS(frame[(i*2)+1]);
       /* kill stuff over Nyquist. Need to worry about vlf values? */
-      if (freqs[i] > nyquist)
-        amps[i] = FL(0.0);
-      a[i] = FL(2.0) * SIN(freqs[i] * csound->pidsr);
+      if (freq > nyquist)
+        amps[k] = FL(0.0);
+      a[k] = FL(2.0) * SIN(freq * csound->pidsr);
+      /* we need to interp amplitude, but seems we can avoid doing freqs too,
+         for pvoc so can use direct calc for speed.
+         But large overlap size is not a good idea. */
+      damps[k] = (amps[k] - lastamps[k]) * p->one_over_overlap;
     }
 
-    /* we need to interp amplitude, but seems we can avoid doing freqs too,
-       for pvoc so can use direct calc for speed.
-       But large overlap size is not a good idea.
-       If compiler cannot inline fastoscil,
-       would be worth doing so by hand here ?
-     */
-    for (i=startbin;i < lastbin;i+=binoffset) {
-      MYFLT thisamp = lastamps[i];
-      MYFLT delta_amp = (amps[i] - thisamp) * p->one_over_overlap;
-
-      for (j=0;j < p->overlap;j++) {
-        outbuf[j] += thisamp *  fastoscil(a+i,x+i,y+i);
-        thisamp += delta_amp;
-      }
-      lastamps[i] = amps[i];
-    }
+    oscbank_quad(x, y, a, lastamps, damps, k, outbuf, p->overlap);
+    memcpy(lastamps, amps, k * sizeof(MYFLT));
 }
 
 static MYFLT adsyn_tick(CSOUND *csound, PVADS *p)
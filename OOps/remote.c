@@ -49,8 +49,6 @@
 /* #endif /\* HAVE_SOCKETS *\/ */
 
 
-#define MAXREMOTES 10
-
 #define ST(x)   (((REMOTE_GLOBALS*) ((CSOUND*)csound)->remoteGlobals)->x)
 
 void remote_Cleanup(CSOUND *csound);
@@ -65,6 +63,7 @@ void remoteRESET(CSOUND *csound)
 #if defined(HAVE_SOCKETS)
 #if !defined(WIN32) || defined(__CYGWIN__)
 #include <netdb.h>
+#include <sys/select.h>
 #endif
 #if 0
 static int32_t foo(char *ipaddr)
@@ -89,6 +88,13 @@ static int32_t foo(char *ipaddr)
  /* get the IPaddress of this machine */
 static int32_t getIpAddress(char *ipaddr)
 {
+    /* CS_REMOTE_ADDR overrides the interface address, so that several
+       Csounds can take part on one machine (127.0.0.1, 127.0.0.2, ...) */
+    char *adr = getenv("CS_REMOTE_ADDR");
+    if (adr != NULL && *adr != '\0') {
+      strNcpy(ipaddr, adr, 16);
+      return 0;
+    }
 #if defined(WIN32) && !defined(__CYGWIN__)
     /* VL 12/10/06: something needs to go here */
     /* gethostbyname is the real answer; code below is unsafe */
@@ -207,7 +213,7 @@ static int32_t callox(CSOUND *csound)
       goto error;
     }
 
-    ST(ipadrs) = (char*) csound->Calloc(csound,(size_t)15 * sizeof(char));
+    ST(ipadrs) = (char*) csound->Calloc(csound,(size_t)16 * sizeof(char));
     if (UNLIKELY(ST(ipadrs) == NULL)) {
       csound->Message(csound, Str("insufficient memory to initialise "
                                   "local ip address."));
@@ -261,6 +267,12 @@ void remote_Cleanup(CSOUND *csound)
       csound->Free(csound, ST(chnrfd)); ST(chnrfd) = NULL; }
     if (ST(ipadrs) != NULL) {
       csound->Free(csound, ST(ipadrs)); ST(ipadrs) = NULL; }
+    if (UNLIKELY(ST(audio_late)))
+      csound->Warning(csound, Str("remote audio: %u blocks arrived too late "
+                                  "and were replaced by silence"),
+                      ST(audio_late));
+    if (ST(audio_delay) != NULL) csound->Free(csound, ST(audio_delay));
+    if (ST(audio_buf) != NULL) csound->Free(csound, ST(audio_buf));
     ST(insrfd_count) = ST(chnrfd_count) = 0;
     csound->Free(csound, csound->remoteGlobals);
     csound->remoteGlobals = NULL;
@@ -326,7 +338,7 @@ static int32_t SVopen(CSOUND *csound)
            /* Server -- open to receive */
 {
     int32_t conn, socklisten,opt;
-    char ipadrs[15];
+    char *ipadrs = ST(ipadrs);
     int32_t *sop = ST(socksin), *sop_end = sop + MAXREMOTES;
 #if defined(WIN32) && !defined(__CYGWIN__)
     int32_t clilen;
@@ -351,11 +363,11 @@ static int32_t SVopen(CSOUND *csound)
         csound->InitError(csound,
                           Str("setting socket option to reuse the address\n"));
 
-    memset(&(ST(to_addr)), 0, sizeof(ST(to_addr)));    /* clear sock mem */
+    memset(&(ST(local_addr)), 0, sizeof(ST(local_addr))); /* clear sock mem */
     ST(local_addr).sin_family = AF_INET;               /* set as INET address */
     /* our adrs, netwrk byt order */
 #if defined(WIN32) && !defined(__CYGWIN__)
-    ST(to_addr).sin_addr.S_un.S_addr = inet_addr((const char *)ipadrs);
+    ST(local_addr).sin_addr.S_un.S_addr = inet_addr((const char *)ipadrs);
 #else
     inet_aton((const char *)ipadrs, &(ST(local_addr).sin_addr));
 #endif
@@ -409,6 +421,55 @@ int32_t SVrecv(CSOUND *csound, int32_t conn, void *data, int32_t length)
     return (int32_t)n;
 }
 
+/* read exactly length bytes, waiting for them; returns 0 if the
+   connection was closed and < 0 on error */
+static int32_t remote_read(int32_t conn, void *data, int32_t length)
+{
+    char    *p = (char*) data;
+    int32_t n, done = 0;
+
+    while (done < length) {
+      n = (int32_t) recv(conn, p + done, length - done, 0);
+      if (n < 0 && errno == EINTR)
+        continue;
+      if (n <= 0)
+        return n;
+      done += n;
+    }
+    return done;
+}
+
+/* wait up to ms milliseconds for data on conn; non-zero if there is some */
+static int32_t remote_wait(int32_t conn, int32_t ms)
+{
+    fd_set  fds;
+    struct timeval tv;
+
+    FD_ZERO(&fds);
+    FD_SET(conn, &fds);
+    tv.tv_sec = ms / 1000;
+    tv.tv_usec = (ms % 1000) * 1000;
+    return (select(conn + 1, &fds, NULL, NULL, &tv) > 0);
+}
+
+int32_t SVrecvmsg(CSOUND *csound, int32_t conn, REMOT_BUF *bp)
+{
+    int32_t n, hdr = (int32_t) (2 * sizeof(int));
+
+    if ((n = remote_read(conn, bp, hdr)) <= 0)
+      return n;
+    if (UNLIKELY(bp->len < hdr || bp->len > (int32_t) sizeof(REMOT_BUF))) {
+      csound->ErrorMsg(csound, Str("remote: invalid message of %d bytes"),
+                       bp->len);
+      return -1;
+    }
+    if (bp->len > hdr && (n = remote_read(conn, bp->data, bp->len - hdr)) <= 0)
+      return n;
+    if (bp->type == AUDIO_TICK)
+      memcpy(&ST(audio_tick), bp->data, sizeof(int));
+    return bp->len;
+}
+
 /* /////////////  INSTR 0 opcodes ///////////////////// */
 
 int32_t remoteport(CSOUND *csound, REMOTEPORT *p)
@@ -429,6 +490,27 @@ int32_t remoteport(CSOUND *csound, REMOTEPORT *p)
     return NOTOK;
 }
 
+int32_t remoteaudio(CSOUND *csound, REMOTEAUDIO *p)
+/* have servers return their audio, latency k-periods late */
+{   /*      INSTR 0 opcode  */
+    if (csound->remoteGlobals==NULL || ST(socksin) == NULL) {
+      if (UNLIKELY(callox(csound) < 0)) {
+        return
+          csound->InitError(csound, Str("failed to initialise remote globals."));
+      }
+    }
+    if (UNLIKELY(ST(socksout)[0].adr != NULL || ST(socksin)[0] != 0)) {
+      return csound->InitError(csound, Str("remoteaudio must come before "
+                                           "insremot and midremot"));
+    }
+    ST(audio_latency) = (int32_t) MYFLT2LRND(*p->latency);
+    if (UNLIKELY(ST(audio_latency) < 1)) {
+      return csound->InitError(csound, Str("remoteaudio: latency must be at "
+                                           "least one k-period"));
+    }
+    return OK;
+}
+
 int32_t insremot(CSOUND *csound, INSREMOT *p)
 /* declare certain instrs for remote Csounds */
 {   /*      INSTR 0 opcode  */
@@ -704,6 +786,129 @@ int32_t* getRemoteSocksIn(CSOUND *csound)
     else return 0;
 }
 
+/* ////////////////       AUDIO RETURN //////////////// */
+
+/* With remoteaudio, a client and its servers run in lock step.  At the
+   end of each k-period the client sends AUDIO_TICK with the number of
+   that k-period to every server; a server renders nothing until the
+   tick has arrived (see sensevents), so it has also seen every event
+   the client sent for that k-period, and then returns its spout in an
+   AUDIO_BLK message.  The client mixes the block of k-period n into its
+   own output of k-period n + latency and delays its local spout by the
+   same amount, so local and remote sound stay aligned.  A block that
+   has not come within REMOTE_AUDIO_WAIT ms of its slot is replaced by
+   silence and dropped when it does arrive. */
+
+#define REMOTE_AUDIO_WAIT (1000)
+
+int32_t getRemoteAudioServer(CSOUND *csound)
+{
+    if (csound->remoteGlobals && ST(audio_latency) > 0 && ST(socksin))
+      return (ST(socksin)[0] != 0);
+    return 0;
+}
+
+/* mix the block of k-period kcnt from server connection *rfd into spout */
+static void remote_audio_mix(CSOUND *csound, int32_t *rfd, int32_t kcnt)
+{
+    int32_t nn, n = csound->nspout, hdr[3];
+    int32_t size = (int32_t) (n * sizeof(MYFLT));
+    MYFLT   *spout = csound->spout, *buf = ST(audio_buf);
+
+    do {
+      if (UNLIKELY(!remote_wait(*rfd, REMOTE_AUDIO_WAIT))) {
+        ST(audio_late)++;
+        return;
+      }
+      if (UNLIKELY(remote_read(*rfd, hdr, sizeof(hdr)) <= 0 ||
+                   hdr[1] != AUDIO_BLK ||
+                   hdr[0] != (int32_t) sizeof(hdr) + size ||
+                   remote_read(*rfd, buf, size) <= 0)) {
+        csound->Warning(csound, Str("remote audio: lost connection to "
+                                    "server, its audio is muted"));
+        *rfd = 0;
+        return;
+      }
+    } while (hdr[2] != kcnt);           /* earlier blocks came too late */
+    for (nn = 0; nn < n; nn++)
+      spout[nn] += buf[nn];
+}
+
+static void remote_audio_client(CSOUND *csound)
+{
+    REMOT_BUF *bp = &ST(CLsendbuf);
+    SOCK    *sop = ST(socksout), *sop_end = sop + MAXREMOTES, *s;
+    int32_t nn, latency = ST(audio_latency), n = csound->nspout;
+    int32_t kcnt = ST(audio_kcnt)++;
+    MYFLT   *spout = csound->spout, *dly;
+
+    if (UNLIKELY(ST(audio_delay) == NULL)) {
+      int32_t cnt = 0;
+      ST(audio_delay) = (MYFLT*) csound->Calloc(csound, (size_t) latency * n
+                                                * sizeof(MYFLT));
+      if (ST(audio_buf) == NULL)
+        ST(audio_buf) = (MYFLT*) csound->Calloc(csound, 3 * sizeof(int)
+                                                + n * sizeof(MYFLT));
+      /* every insremot/midremot line has its own connection, but each
+         server returns its audio on the first one only */
+      for ( ; sop < sop_end && sop->adr != NULL; sop++) {
+        for (s = ST(socksout); s < sop; s++)
+          if (!strcmp(s->adr, sop->adr))
+            break;
+        if (s == sop)
+          ST(audio_rfd)[cnt++] = sop->rfd;
+      }
+      sop = ST(socksout);
+    }
+    /* ask all servers for this k-period */
+    bp->type = AUDIO_TICK;
+    bp->len = (int32_t) (2 * sizeof(int) + sizeof(int));
+    memcpy(bp->data, &kcnt, sizeof(int));
+    for ( ; sop < sop_end && sop->adr != NULL; sop++)
+      CLsend(csound, sop->rfd, (void *)bp, bp->len);
+    /* local output goes through the delay, remote blocks are latency
+       k-periods old when they are mixed in */
+    dly = ST(audio_delay) + (size_t) ST(audio_dpos) * n;
+    for (nn = 0; nn < n; nn++) {
+      MYFLT x = dly[nn];
+      dly[nn] = spout[nn];
+      spout[nn] = x;
+    }
+    if (++ST(audio_dpos) >= latency)
+      ST(audio_dpos) = 0;
+    if (kcnt < latency)
+      return;
+    for (nn = 0; nn < MAXREMOTES; nn++)
+      if (ST(audio_rfd)[nn] > 0)
+        remote_audio_mix(csound, &ST(audio_rfd)[nn], kcnt - latency);
+}
+
+static void remote_audio_server(CSOUND *csound)
+{
+    int32_t n = csound->nspout;
+    int32_t size = (int32_t) (3 * sizeof(int) + n * sizeof(MYFLT));
+    int32_t *hdr;
+
+    if (UNLIKELY(ST(audio_buf) == NULL))
+      ST(audio_buf) = (MYFLT*) csound->Calloc(csound, size);
+    hdr = (int32_t*) ST(audio_buf);
+    hdr[0] = size;
+    hdr[1] = AUDIO_BLK;
+    hdr[2] = ST(audio_tick);
+    memcpy(hdr + 3, csound->spout, n * sizeof(MYFLT));
+    CLsend(csound, ST(socksin)[0], (void *)hdr, size);
+}
+
+void remote_audio(CSOUND *csound)
+{
+    if (csound->remoteGlobals == NULL || ST(audio_latency) <= 0)
+      return;
+    if (ST(socksout) != NULL && ST(socksout)[0].adr != NULL)
+      remote_audio_client(csound);
+    if (ST(socksin) != NULL && ST(socksin)[0] != 0)
+      remote_audio_server(csound);
+}
+
 #else /* HAVE_SOCKETS not defined */
 
 char remoteID(CSOUND *csound)
@@ -723,8 +928,20 @@ int32_t SVrecv(CSOUND *csound, int32_t conn, void *data, int32_t length)
     return 0;
 }
 
+int32_t SVrecvmsg(CSOUND *csound, int32_t conn, REMOT_BUF *bp)
+{
+    return 0;
+}
+
 /*  INSTR 0 opcodes  */
 
+int32_t remoteaudio(CSOUND *csound, REMOTEAUDIO *p)
+{
+    csound->Warning(csound, Str("*** This version of Csound was not "
+            "compiled with remote event support ***\n"));
+    return OK;
+}
+
 int32_t remoteport(CSOUND *csound, REMOTEPORT *p)
 {
     csound->Warning(csound, Str("*** This version of Csound was not "
@@ -808,4 +1025,14 @@ int32_t* getRemoteSocksIn(CSOUND *csound)
     return NULL;
 }
 
+int32_t getRemoteAudioServer(CSOUND *csound)
+{
+    return 0;
+}
+
+void remote_audio(CSOUND *csound)
+{
+    return;
+}
+
 #endif /* HAVE_SOCKETS */
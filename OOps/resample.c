@@ -0,0 +1,214 @@
+/*
+    resample.c:
+
+    Copyright (C) 2026 The Csound Developers
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+/* Polyphase windowed-sinc kernels shared by diskin2, tablexs and the
+   srconv utility.  This file only calls through the CSOUND function
+   table so that utilities can link their own copy of it. */
+
+#include "csdl.h"
+#include "resample.h"
+#include <math.h>
+
+/* total number of weights in one table, spread over the phases */
+#define RESAMP_TABSIZE  (262144)
+#define RESAMP_MINPHS   (256)
+#define RESAMP_MAXPHS   (1024)
+
+/* window used by diskin2 and tablexkt: (1 - d^2 * winfact)^2 */
+
+static double resamp_winfact(int32_t taps)
+{
+    return (1.0 - pow((double) taps * 0.85172, -0.89624))
+           / (double) ((taps * taps) >> 2);
+}
+
+static double resamp_kernel(double d, double cutoff, double winfact)
+{
+    double  w = 1.0 - d * d * winfact;
+
+    if (w <= 0.0)
+      return 0.0;
+    w *= w;
+    if (fabs(d) < 1.0e-9)
+      return cutoff * w;
+    return w * sin(PI * cutoff * d) / (PI * d);
+}
+
+RESAMPLER *resamp_new(CSOUND *csound, int32_t taps, MYFLT cutoff)
+{
+    RESAMPLER *r;
+    double  winfact, d, sum, *row;
+    int32_t phases, i, k;
+
+    taps = (taps + 3) & ~3;
+    if (taps < 4) taps = 4;
+    else if (taps > RESAMP_MAXTAPS) taps = RESAMP_MAXTAPS;
+    if (cutoff <= FL(0.0) || cutoff > FL(1.0))
+      cutoff = FL(1.0);
+    phases = RESAMP_TABSIZE / taps;
+    if (phases < RESAMP_MINPHS) phases = RESAMP_MINPHS;
+    else if (phases > RESAMP_MAXPHS) phases = RESAMP_MAXPHS;
+
+    r = (RESAMPLER*) csound->Calloc(csound, sizeof(RESAMPLER));
+    r->taps = taps;
+    r->phases = phases;
+    r->cutoff = cutoff;
+    r->coef = (MYFLT*) csound->Malloc(csound, sizeof(MYFLT) * 2
+                                      * (size_t) (phases + 1) * taps);
+    r->dcoef = r->coef + (size_t) (phases + 1) * taps;
+    row = (double*) csound->Malloc(csound, sizeof(double) * taps);
+    winfact = resamp_winfact(taps);
+    for (i = 0; i <= phases; i++) {
+      MYFLT *c = r->coef + (size_t) i * taps;
+      d = (double) (1 - (taps >> 1)) - (double) i / (double) phases;
+      sum = 0.0;
+      for (k = 0; k < taps; k++, d += 1.0)
+        sum += (row[k] = resamp_kernel(d, (double) cutoff, winfact));
+      /* unity gain at DC for every phase */
+      sum = (sum > 1.0e-6 ? 1.0 / sum : 1.0);
+      for (k = 0; k < taps; k++)
+        c[k] = (MYFLT) (row[k] * sum);
+    }
+    csound->Free(csound, row);
+    for (i = 0; i < phases; i++) {
+      const MYFLT *c = r->coef + (size_t) i * taps;
+      MYFLT *dc = r->dcoef + (size_t) i * taps;
+      for (k = 0; k < taps; k++)
+        dc[k] = c[k + taps] - c[k];
+    }
+    memset(r->dcoef + (size_t) phases * taps, 0, sizeof(MYFLT) * taps);
+    return r;
+}
+
+void resamp_free(CSOUND *csound, RESAMPLER *r)
+{
+    if (r == NULL)
+      return;
+    csound->Free(csound, r->coef);
+    csound->Free(csound, r);
+}
+
+/* Kernels are kept in a list hanging off a global variable; both the
+   variable and the memory go away on csoundReset, so no callback is
+   needed.  Only called at init time. */
+
+const RESAMPLER *resamp_shared(CSOUND *csound, int32_t taps, MYFLT cutoff)
+{
+    RESAMPLER **head, *r;
+
+    head = (RESAMPLER**) csound->QueryGlobalVariable(csound, "::resamplers");
+    if (head == NULL) {
+      if (UNLIKELY(csound->CreateGlobalVariable(csound, "::resamplers",
+                                                sizeof(RESAMPLER*)) != 0))
+        return NULL;
+      head = (RESAMPLER**) csound->QueryGlobalVariable(csound,
+                                                       "::resamplers");
+    }
+    taps = (taps + 3) & ~3;
+    if (cutoff <= FL(0.0) || cutoff > FL(1.0))
+      cutoff = FL(1.0);
+    for (r = *head; r != NULL; r = r->nxt)
+      if (r->taps == taps && r->cutoff == cutoff)
+        return r;
+    r = resamp_new(csound, taps, cutoff);
+    r->nxt = *head;
+    *head = r;
+    return r;
+}
+
+static inline void resamp_row(const RESAMPLER *r, double frac,
+                              const MYFLT **c, const MYFLT **dc, MYFLT *f)
+{
+    double  x = frac * (double) r->phases;
+    int32_t i = (int32_t) x;
+
+    if (UNLIKELY(i >= r->phases)) {
+      i = r->phases - 1; x = (double) r->phases;
+    }
+    else if (UNLIKELY(i < 0)) {
+      i = 0; x = 0.0;
+    }
+    *f = (MYFLT) (x - (double) i);
+    *c = r->coef + (size_t) i * r->taps;
+    *dc = r->dcoef + (size_t) i * r->taps;
+}
+
+void resamp_coefs(const RESAMPLER *r, double frac, MYFLT *w)
+{
+    const MYFLT *c, *dc;
+    MYFLT   f;
+    int32_t k;
+
+    resamp_row(r, frac, &c, &dc, &f);
+    for (k = 0; k < r->taps; k++)
+      w[k] = c[k] + f * dc[k];
+}
+
+MYFLT resamp_point(const RESAMPLER *r, const MYFLT *x, int32_t stride,
+                   double frac)
+{
+    const MYFLT *c, *dc;
+    MYFLT   f, s0, s1, s2, s3, t0, t1, t2, t3;
+    int32_t k, n = r->taps;
+
+    resamp_row(r, frac, &c, &dc, &f);
+    s0 = s1 = s2 = s3 = t0 = t1 = t2 = t3 = FL(0.0);
+    if (stride == 1) {
+      /* taps is a multiple of 4: four independent sums per row */
+      for (k = 0; k < n; k += 4) {
+        s0 += c[k] * x[k];          t0 += dc[k] * x[k];
+        s1 += c[k + 1] * x[k + 1];  t1 += dc[k + 1] * x[k + 1];
+        s2 += c[k + 2] * x[k + 2];  t2 += dc[k + 2] * x[k + 2];
+        s3 += c[k + 3] * x[k + 3];  t3 += dc[k + 3] * x[k + 3];
+      }
+    }
+    else {
+      for (k = 0; k < n; k++, x += stride) {
+        s0 += c[k] * *x;
+        t0 += dc[k] * *x;
+      }
+    }
+    return (s0 + s1) + (s2 + s3) + f * ((t0 + t1) + (t2 + t3));
+}
+
+void resamp_gather(const RESAMPLER *r, const MYFLT *in, int32_t nin,
+                   int32_t stride, const double *pos, MYFLT *out,
+                   int32_t nout, int32_t ostride)
+{
+    MYFLT   tmp[RESAMP_MAXTAPS];
+    int32_t j, k, first, n = r->taps, half = r->taps >> 1;
+
+    for (j = 0; j < nout; j++, out += ostride) {
+      double  p = pos[j], fl = floor(p);
+      first = (int32_t) fl - half + 1;
+      if (LIKELY(first >= 0 && first + n <= nin)) {
+        *out = resamp_point(r, in + (size_t) first * stride, stride, p - fl);
+        continue;
+      }
+      /* near either end: treat the signal as zero outside the buffer */
+      for (k = 0; k < n; k++)
+        tmp[k] = (first + k >= 0 && first + k < nin ?
+                  in[(size_t) (first + k) * stride] : FL(0.0));
+      *out = resamp_point(r, tmp, 1, p - fl);
+    }
+}
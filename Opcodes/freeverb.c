@@ -56,18 +56,9 @@ static const double offsetRoom  = 0.7;
 
 static const double allPassFeedBack = 0.5;
 
-typedef struct {
-    int32_t     nSamples;
-    int32_t     bufPos;
-    double  filterState;
-    MYFLT   buf[1];
-} freeVerbComb;
-
-typedef struct {
-    int32_t     nSamples;
-    int32_t     bufPos;
-    MYFLT   buf[1];
-} freeVerbAllPass;
+/* Filter state is kept as structure-of-arrays, indexed by channel */
+/* and filter, so that the eight combs of a channel can be run in    */
+/* lockstep one sample at a time.                                    */
 
 typedef struct {
     OPDS            h;
@@ -79,8 +70,13 @@ typedef struct {
     MYFLT           *kDampFactor;
     MYFLT           *iSampleRate;
     MYFLT           *iSkipInit;
-    freeVerbComb    *Comb[NR_COMB][2];
-    freeVerbAllPass *AllPass[NR_ALLPASS][2];
+    int32_t         combSize[2][NR_COMB];
+    int32_t         combPos[2][NR_COMB];
+    double          combState[2][NR_COMB];
+    MYFLT           *combBuf[2][NR_COMB];
+    int32_t         allPassSize[2][NR_ALLPASS];
+    int32_t         allPassPos[2][NR_ALLPASS];
+    MYFLT           *allPassBuf[2][NR_ALLPASS];
     MYFLT           *tmpBuf;
     AUXCH           auxData;
     MYFLT           prvDampFactor;
@@ -97,36 +93,25 @@ static int32_t calc_nsamples(FREEVERB *p, double delTime)
     return (int32_t) (delTime * sampleRate + 0.5);
 }
 
-static int32_t comb_nbytes(FREEVERB *p, double delTime)
-{
-    int32_t nbytes;
-    nbytes = (int32_t) sizeof(freeVerbComb) - (int32_t) sizeof(MYFLT);
-    nbytes += ((int32_t) sizeof(MYFLT) * calc_nsamples(p, delTime));
-    return ((nbytes + 15) & (~15));
-}
-
-static int32_t allpass_nbytes(FREEVERB *p, double delTime)
+static int32_t buf_nbytes(FREEVERB *p, double delTime)
 {
     int32_t nbytes;
-    nbytes = (int32_t) sizeof(freeVerbAllPass) - (int32_t) sizeof(MYFLT);
-    nbytes += ((int32_t) sizeof(MYFLT) * calc_nsamples(p, delTime));
+    nbytes = ((int32_t) sizeof(MYFLT) * calc_nsamples(p, delTime));
     return ((nbytes + 15) & (~15));
 }
 
 static int32_t freeverb_init(CSOUND *csound, FREEVERB *p)
 {
-    int32_t             i, j, k, nbytes;
-    freeVerbComb    *combp;
-    freeVerbAllPass *allpassp;
+    int32_t         i, k, nbytes;
     /* calculate the total number of bytes to allocate */
     nbytes = 0;
     for (i = 0; i < NR_COMB; i++) {
-      nbytes += comb_nbytes(p, comb_delays[i][0]);
-      nbytes += comb_nbytes(p, comb_delays[i][1]);
+      nbytes += buf_nbytes(p, comb_delays[i][0]);
+      nbytes += buf_nbytes(p, comb_delays[i][1]);
     }
     for (i = 0; i < NR_ALLPASS; i++) {
-      nbytes += allpass_nbytes(p, allpass_delays[i][0]);
-      nbytes += allpass_nbytes(p, allpass_delays[i][1]);
+      nbytes += buf_nbytes(p, allpass_delays[i][0]);
+      nbytes += buf_nbytes(p, allpass_delays[i][1]);
     }
     nbytes += (int32_t) sizeof(MYFLT) * (int32_t) CS_KSMPS;
     /* allocate space if size has changed */
@@ -137,27 +122,23 @@ static int32_t freeverb_init(CSOUND *csound, FREEVERB *p)
     /* set up comb and allpass filters */
     nbytes = 0;
     for (i = 0; i < (NR_COMB << 1); i++) {
-      combp = (freeVerbComb*)((unsigned char*)p->auxData.auxp + (int32_t) nbytes);
-      p->Comb[i >> 1][i & 1] = combp;
       k = calc_nsamples(p, comb_delays[i >> 1][i & 1]);
-      combp->nSamples = k;
-      combp->bufPos = 0;
-      combp->filterState = 0.0;
-      for (j = 0; j < k; j++)
-        combp->buf[j] = FL(0.0);
-      nbytes += comb_nbytes(p, comb_delays[i >> 1][i & 1]);
+      p->combBuf[i & 1][i >> 1] =
+        (MYFLT*) ((unsigned char*) p->auxData.auxp + (int32_t) nbytes);
+      p->combSize[i & 1][i >> 1] = k;
+      p->combPos[i & 1][i >> 1] = 0;
+      p->combState[i & 1][i >> 1] = 0.0;
+      memset(p->combBuf[i & 1][i >> 1], '\0', k*sizeof(MYFLT));
+      nbytes += buf_nbytes(p, comb_delays[i >> 1][i & 1]);
     }
     for (i = 0; i < (NR_ALLPASS << 1); i++) {
-      allpassp = (freeVerbAllPass*) ((unsigned char*) p->auxData.auxp
-                                     + (int32_t) nbytes);
-      p->AllPass[i >> 1][i & 1] = allpassp;
       k = calc_nsamples(p, allpass_delays[i >> 1][i & 1]);
-      allpassp->nSamples = k;
-      allpassp->bufPos = 0;
-      //memset(allpassp->buf, '\0', k*sizeof(MYFLT));
-      for (j = 0; j < k; j++)
-        allpassp->buf[j] = FL(0.0);
-      nbytes += allpass_nbytes(p, allpass_delays[i >> 1][i & 1]);
+      p->allPassBuf[i & 1][i >> 1] =
+        (MYFLT*) ((unsigned char*) p->auxData.auxp + (int32_t) nbytes);
+      p->allPassSize[i & 1][i >> 1] = k;
+      p->allPassPos[i & 1][i >> 1] = 0;
+      memset(p->allPassBuf[i & 1][i >> 1], '\0', k*sizeof(MYFLT));
+      nbytes += buf_nbytes(p, allpass_delays[i >> 1][i & 1]);
     }
     p->tmpBuf = (MYFLT*) ((unsigned char*)p->auxData.auxp + (int32_t)nbytes);
     p->prvDampFactor = -FL(1.0);
@@ -168,12 +149,55 @@ static int32_t freeverb_init(CSOUND *csound, FREEVERB *p)
     return OK;
 }
 
+/* run the comb bank and allpass chain of one channel into tmpBuf */
+
+static void freeverb_channel(FREEVERB *p, int32_t c, MYFLT *ain,
+                             uint32_t nsmps, double feedback,
+                             double damp1, double damp2)
+{
+    double  *state = p->combState[c];
+    int32_t *pos = p->combPos[c];
+    MYFLT   x[NR_COMB], sum, *buf;
+    double  y;
+    int32_t i;
+    uint32_t n;
+
+    /* comb filters, all eight in lockstep */
+    for (n = 0; n < nsmps; n++) {
+      sum = FL(0.0);
+      for (i = 0; i < NR_COMB; i++) {
+        x[i] = p->combBuf[c][i][pos[i]];
+        sum += x[i];
+      }
+      p->tmpBuf[n] = sum;
+      for (i = 0; i < NR_COMB; i++)
+        state[i] = (state[i] * damp1) + ((double) x[i] * damp2);
+      for (i = 0; i < NR_COMB; i++) {
+        p->combBuf[c][i][pos[i]] = (MYFLT) (state[i] * feedback
+                                            + (double) ain[n]);
+        if (UNLIKELY(++pos[i] >= p->combSize[c][i]))
+          pos[i] = 0;
+      }
+    }
+    /* allpass filters, in series */
+    for (i = 0; i < NR_ALLPASS; i++) {
+      int32_t bufPos = p->allPassPos[c][i], size = p->allPassSize[c][i];
+      buf = p->allPassBuf[c][i];
+      for (n = 0; n < nsmps; n++) {
+        y = (double) buf[bufPos] - (double) p->tmpBuf[n];
+        buf[bufPos] *= (MYFLT) allPassFeedBack;
+        buf[bufPos] += p->tmpBuf[n];
+        if (UNLIKELY(++bufPos >= size))
+          bufPos = 0;
+        p->tmpBuf[n] = (MYFLT) y;
+      }
+      p->allPassPos[c][i] = bufPos;
+    }
+}
+
 static int32_t freeverb_perf(CSOUND *csound, FREEVERB *p)
 {
-    double          feedback, damp1, damp2, x;
-    freeVerbComb    *combp;
-    freeVerbAllPass *allpassp;
-    int32_t             i;
+    double          feedback, damp1, damp2;
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
     uint32_t n, nsmps = CS_KSMPS;
@@ -193,34 +217,8 @@ static int32_t freeverb_perf(CSOUND *csound, FREEVERB *p)
     else
       damp1 = p->dampValue;
     damp2 = 1.0 - damp1;
-    /* comb filters (left channel) */
-    memset(p->tmpBuf,0, sizeof(MYFLT)*nsmps);
-    for (i = 0; i < NR_COMB; i++) {
-      combp = p->Comb[i][0];
-      for (n = 0; n < nsmps; n++) {
-        p->tmpBuf[n] += combp->buf[combp->bufPos];
-        x = (double) combp->buf[combp->bufPos];
-        combp->filterState = (combp->filterState * damp1) + (x * damp2);
-        x = combp->filterState * feedback + (double) p->aInL[n];
-        combp->buf[combp->bufPos] = (MYFLT) x;
-        if (UNLIKELY(++(combp->bufPos) >= combp->nSamples))
-          combp->bufPos = 0;
-      }
-    }
-    /* allpass filters (left channel) */
-    for (i = 0; i < NR_ALLPASS; i++) {
-      allpassp = p->AllPass[i][0];
-      for (n = 0; n < nsmps; n++) {
-        x = (double) allpassp->buf[allpassp->bufPos] - (double) p->tmpBuf[n];
-        allpassp->buf[allpassp->bufPos] *= (MYFLT) allPassFeedBack;
-        allpassp->buf[allpassp->bufPos] += p->tmpBuf[n];
-        if (UNLIKELY(++(allpassp->bufPos) >= allpassp->nSamples))
-          allpassp->bufPos = 0;
-        p->tmpBuf[n] = (MYFLT) x;
-      }
-    }
-
-    /* write left channel output */
+    /* left channel */
+    freeverb_channel(p, 0, p->aInL, nsmps, feedback, damp1, damp2);
     if (UNLIKELY(offset)) memset(p->aOutL, '\0', offset*sizeof(MYFLT));
     if (UNLIKELY(early)) {
       nsmps -= early;
@@ -228,36 +226,9 @@ static int32_t freeverb_perf(CSOUND *csound, FREEVERB *p)
     }
     for (n = offset; n < nsmps; n++)
       p->aOutL[n] = p->tmpBuf[n] * (MYFLT) fixedGain;
-    /* comb filters (right channel) */
-    memset(p->tmpBuf, 0, sizeof(MYFLT)*nsmps);
-    /* for (n = 0; n < nsmps; n++) */
-    /*   p->tmpBuf[n] = FL(0.0); */
-    for (i = 0; i < NR_COMB; i++) {
-      combp = p->Comb[i][1];
-      for (n = 0; n < nsmps; n++) {
-        p->tmpBuf[n] += combp->buf[combp->bufPos];
-        x = (double) combp->buf[combp->bufPos];
-        combp->filterState = (combp->filterState * damp1) + (x * damp2);
-        x = combp->filterState * feedback + (double) p->aInR[n];
-        combp->buf[combp->bufPos] = (MYFLT) x;
-        if (UNLIKELY(++(combp->bufPos) >= combp->nSamples))
-          combp->bufPos = 0;
-      }
-    }
-    /* allpass filters (right channel) */
-    for (i = 0; i < NR_ALLPASS; i++) {
-      allpassp = p->AllPass[i][1];
-      for (n = 0; n < nsmps; n++) {
-        x = (double) allpassp->buf[allpassp->bufPos] - (double) p->tmpBuf[n];
-        allpassp->buf[allpassp->bufPos] *= (MYFLT) allPassFeedBack;
-        allpassp->buf[allpassp->bufPos] += p->tmpBuf[n];
-        if (UNLIKELY(++(allpassp->bufPos) >= allpassp->nSamples))
-          allpassp->bufPos = 0;
-        p->tmpBuf[n] = (MYFLT) x;
-      }
-    }
+    /* right channel */
     nsmps = CS_KSMPS;
-    /* write right channel output */
+    freeverb_channel(p, 1, p->aInR, nsmps, feedback, damp1, damp2);
     if (UNLIKELY(offset)) memset(p->aOutR, '\0', offset*sizeof(MYFLT));
     if (UNLIKELY(early)) {
       nsmps -= early;
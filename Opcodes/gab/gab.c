@@ -419,7 +419,7 @@ static int32_t adsynt2_set(CSOUND *csound,ADSYNT2 *p)
 {
     FUNC    *ftp;
     uint32_t count;
-    int32   *lphs;
+    uint32  *lphs;
     MYFLT    iphs = *p->iphs;
 
     p->inerr = 0;
@@ -464,10 +464,8 @@ static int32_t adsynt2_set(CSOUND *csound,ADSYNT2 *p)
                                    "than amptable size!"));
     }
 
-    if (p->lphs.auxp==NULL ||
-        p->lphs.size < sizeof(int32)*count)
-      csound->AuxAlloc(csound, sizeof(int32)*count, &p->lphs);
-    lphs = (int32*)p->lphs.auxp;
+    oscbank_alloc(csound, &p->bank, &p->auxch, count);
+    lphs = p->bank.phs;
 
     if (iphs > 1) {
       uint32_t c;
@@ -483,40 +481,35 @@ static int32_t adsynt2_set(CSOUND *csound,ADSYNT2 *p)
         lphs[c] = ((int32)(iphs * FMAXLEN)) & PHMASK;
       }
     }
-    if (p->pamp.auxp==NULL ||
-        p->pamp.size < (uint32_t)(sizeof(MYFLT)*p->count))
-      csound->AuxAlloc(csound, sizeof(MYFLT)*p->count, &p->pamp);
-    else  if (iphs >= 0)        /* AuxAlloc clear anyway */
-      memset(p->pamp.auxp, 0, sizeof(MYFLT)*p->count);
+    if (iphs >= 0)              /* AuxAlloc clears a new bank anyway */
+      memset(p->bank.amp, 0, sizeof(MYFLT)*p->count);
     return OK;
 }
 
 static int32_t adsynt2(CSOUND *csound,ADSYNT2 *p)
 {
-    FUNC    *ftp, *freqtp, *amptp;
-    MYFLT   *ar, *ftbl, *freqtbl, *amptbl, *prevAmp;
-    MYFLT   amp0, amp, cps0, cps, ampIncr, amp2;
-    int32   phs, inc, lobits;
-    int32   *lphs;
+    OSCBANK_TAB tab;
+    MYFLT   *ar, *freqtbl, *amptbl, *prevAmp, *ampIncr;
+    MYFLT   amp0, cps0;
     int32_t     c, count;
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
-    uint32_t n, nsmps = CS_KSMPS;
+    uint32_t nsmps = CS_KSMPS;
 
     /* I believe this can never happen as InitError will remove instance */
     /* The check should be on p->amptp and p->freqtp  -- JPff            */
     if (UNLIKELY(p->inerr || p->amptp==NULL || p->freqtp==NULL)) {
       return csound->InitError(csound, Str("adsynt2: not initialised"));
     }
-    ftp = p->ftp;
-    ftbl = ftp->ftable;
-    lobits = ftp->lobits;
-    freqtp = p->freqtp;
-    freqtbl = freqtp->ftable;
-    amptp = p->amptp;
-    amptbl = amptp->ftable;
-    lphs = (int32*)p->lphs.auxp;
-    prevAmp = (MYFLT*)p->pamp.auxp;
+    tab.ftable = p->ftp->ftable;
+    tab.phmask = PHMASK;
+    tab.lobits = p->ftp->lobits;
+    tab.fracmask = 0;
+    tab.pfrac = FL(0.0);
+    freqtbl = p->freqtp->ftable;
+    amptbl = p->amptp->ftable;
+    prevAmp = p->bank.amp;
+    ampIncr = p->bank.damp;
 
     cps0 = *p->kcps;
     amp0 = *p->kamp;
@@ -529,22 +522,15 @@ static int32_t adsynt2(CSOUND *csound,ADSYNT2 *p)
       memset(&ar[nsmps], '\0', early*sizeof(MYFLT));
     }
 
+    /* amplitudes ramp from the previous k-period's values */
     for (c=0; c<count; c++) {
-      amp2 = prevAmp[c];
-      amp = amptbl[c] * amp0;
-      cps = freqtbl[c] * cps0;
-      inc = (int32) (cps * csound->sicvt);
-      phs = lphs[c];
-      ampIncr = (amp - amp2) * CS_ONEDKSMPS;
-      for (n=offset; n<nsmps; n++) {
-        ar[n] += *(ftbl + (phs >> lobits)) * amp2;
-        phs += inc;
-        phs &= PHMASK;
-        amp2 += ampIncr;
-      }
-      prevAmp[c] = amp;
-      lphs[c] = phs;
+      p->bank.inc[c] = (int32) ((freqtbl[c] * cps0) * csound->sicvt);
+      ampIncr[c] = (amptbl[c] * amp0 - prevAmp[c]) * CS_ONEDKSMPS;
     }
+    if (LIKELY(offset < nsmps))
+      oscbank_table(&tab, &p->bank, count, ar + offset, nsmps - offset);
+    for (c=0; c<count; c++)
+      prevAmp[c] = amptbl[c] * amp0;
     return OK;
 }
 
@@ -24,6 +24,7 @@
 #include "../stdopcod.h"
 #include "H/ugrw1.h"    /* for zread function */
 #include "ugens6.h"     /* for a_k_set function */
+#include "oscbank.h"
 
 typedef struct {
     OPDS    h;
@@ -77,8 +78,8 @@ typedef struct {
     FUNC    *amptp;
     int32_t count;
     int32_t inerr;
-    AUXCH   lphs;
-    AUXCH   pamp;
+    AUXCH   auxch;
+    OSCBANK bank;               /* amp[] holds the previous amplitudes */
 } ADSYNT2;
 
 typedef struct {
@@ -41,6 +41,10 @@ using namespace csound;
  * The mixer send matrix is laid out:
  * matrix[csound][send][bus].
  * std::map<CSOUND *, std::map<size_t, std::map<size_t, MYFLT> > > *matrix = 0;
+ *
+ * Map elements are never erased before the module is destroyed, so
+ * opcodes look up their buss channel and gain once, at init, and keep
+ * pointers to them for performance.
  */
 
 /**
@@ -84,6 +88,7 @@ struct MixerSetLevel : public OpcodeBase<MixerSetLevel> {
   // State.
   size_t send;
   size_t buss;
+  MYFLT *gainpointer;
   std::map<CSOUND *, std::map<size_t, std::map<size_t, MYFLT>>> *matrix;
   int init(CSOUND *csound) {
 #ifdef ENABLE_MIXER_IDEBUG
@@ -93,7 +98,8 @@ struct MixerSetLevel : public OpcodeBase<MixerSetLevel> {
     send = static_cast<size_t>(*isend);
     buss = static_cast<size_t>(*ibuss);
     createBuss(csound, buss);
-    (*matrix)[csound][send][buss] = *kgain;
+    gainpointer = &(*matrix)[csound][send][buss];
+    *gainpointer = *kgain;
 #ifdef ENABLE_MIXER_IDEBUG
     warn(csound, "MixerSetLevel::init: csound %p send %d buss %d gain %f\n",
          csound, send, buss, (*matrix)[csound][send][buss]);
@@ -101,12 +107,14 @@ struct MixerSetLevel : public OpcodeBase<MixerSetLevel> {
     return OK;
   }
   int kontrol(CSOUND *csound) {
-    (*matrix)[csound][send][buss] = *kgain;
 #ifdef ENABLE_MIXER_KDEBUG
     warn(csound, "MixerSetLevel::kontrol: csound %p send %d buss "
                  "%d gain %f\n",
-         csound, send, buss, (*matrix)[csound][send][buss]);
+         csound, send, buss, *kgain);
+#else
+    IGN(csound);
 #endif
+    *gainpointer = *kgain;
     return OK;
   }
 };
@@ -125,6 +133,7 @@ struct MixerGetLevel : public OpcodeBase<MixerGetLevel> {
   // State.
   size_t send;
   size_t buss;
+  MYFLT *gainpointer;
   std::map<CSOUND *, std::map<size_t, std::map<size_t, MYFLT>>> *matrix;
   int init(CSOUND *csound) {
 #ifdef ENABLE_MIXER_IDEBUG
@@ -134,14 +143,17 @@ struct MixerGetLevel : public OpcodeBase<MixerGetLevel> {
     send = static_cast<size_t>(*isend);
     buss = static_cast<size_t>(*ibuss);
     createBuss(csound, buss);
+    gainpointer = &(*matrix)[csound][send][buss];
     return OK;
   }
   int noteoff(CSOUND *) { return OK; }
   int kontrol(CSOUND *csound) {
 #ifdef ENABLE_MIXER_KDEBUG
     warn(csound, "MixerGetLevel::kontrol...\n");
+#else
+    IGN(csound);
 #endif
-    *kgain = (*matrix)[csound][send][buss];
+    *kgain = *gainpointer;
     return OK;
   }
 };
@@ -164,6 +176,7 @@ struct MixerSend : public OpcodeBase<MixerSend> {
   size_t channel;
   size_t frames;
   MYFLT *busspointer;
+  MYFLT *gainpointer;
   std::map<CSOUND *, std::map<size_t, std::vector<std::vector<MYFLT>>>> *busses;
   std::map<CSOUND *, std::map<size_t, std::map<size_t, MYFLT>>> *matrix;
   int init(CSOUND *csound) {
@@ -178,6 +191,7 @@ struct MixerSend : public OpcodeBase<MixerSend> {
     channel = static_cast<size_t>(*ichannel);
     frames = opds.insdshead->ksmps;
     busspointer = &(*busses)[csound][buss][channel].front();
+    gainpointer = &(*matrix)[csound][send][buss];
 #ifdef ENABLE_MIXER_IDEBUG
     warn(csound, "MixerSend::init: instance %p send %d buss "
                  "%d channel %d frames %d busspointer %p\n",
@@ -189,8 +203,10 @@ struct MixerSend : public OpcodeBase<MixerSend> {
   int audio(CSOUND *csound) {
 #ifdef ENABLE_MIXER_KDEBUG
     warn(csound, "MixerSend::audio...\n");
+#else
+    IGN(csound);
 #endif
-    MYFLT gain = (*matrix)[csound][send][buss];
+    MYFLT gain = *gainpointer;
     for (size_t i = 0; i < frames; i++) {
       busspointer[i] += (ainput[i] * gain);
     }
@@ -25,6 +25,673 @@
 /* #include "csdl.h" */
 #include "csoundCore.h"
 #include "mp3dec.h"
+#include <fcntl.h>
+#ifdef WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+/* Shared decoding service.
+
+   Each file read by mp3in or mp3scal is opened once per Csound instance
+   as an MP3STREAM, however many opcodes play it, and stays open until
+   reset.  The byte offset of every MPEG frame is indexed when the stream
+   is opened, so seeks land on an exact frame.  Audio is decoded in blocks
+   of MP3_BLOCK_FRAMES frames by a small pool of worker threads; readers
+   pin the blocks they are about to play and request them ahead of time,
+   and blocks are shared by all readers of a stream.
+
+   A reader never takes the pool lock while it plays.  Pins are atomic
+   counts, a decoded block is published with an atomic state change, and
+   requests for blocks go through a single-producer/single-consumer ring
+   owned by the reader, which the workers empty under the pool lock every
+   MP3_POLL_MS while any reader is open.  If a block is still missing when
+   it is needed, a realtime performance plays silence for the rest of the
+   cycle, and any other one decodes the block itself or waits for it, so
+   offline rendering stays deterministic. */
+
+#define MP3_BLOCK_FRAMES  (16)  /* MPEG frames per decoded block */
+#define MP3_READAHEAD     (3)   /* blocks requested ahead of a reader */
+#define MP3_PREROLL       (4)   /* frames decoded before a seek target to
+                                   refill the layer III bit reservoir */
+#define MP3_WORKERS       (2)
+#define MP3_MAXJOBS       (256)
+#define MP3_SCANBUF       (0x10000)
+#define MP3_REQUESTS      (64)  /* slots in the request ring of a reader */
+#define MP3_POLL_MS       (5)   /* request rings are emptied this often */
+
+enum { MP3_EMPTY = 0, MP3_QUEUED, MP3_BUSY, MP3_READY };
+
+typedef struct {
+  int32_t  state;               /* MP3_*; changed under the pool lock,
+                                   read by readers without it */
+  int32_t  pins;                /* readers that will play this block */
+  uint32_t frames;              /* decoded sample frames */
+  short    *data;               /* interleaved samples */
+} MP3BLOCK;
+
+typedef struct mp3stream_ {
+  struct mp3stream_ *nxt;
+  char     *name;
+  int32_t  mono, refs, busy;
+  mp3dec_t mpa;                 /* used by one thread at a time (busy) */
+  mpadec_info_t info;
+  int32_t  chans;               /* decoded channels */
+  uint32_t frameSamples;        /* sample frames per MPEG frame */
+  uint32_t delay;               /* encoder delay trimmed from the start */
+  int64_t  *index;              /* offset of each frame, NULL if unknown */
+  int32_t  nframes;
+  int32_t  next;                /* frame the decoder produces next */
+  int32_t  nblocks;
+  MP3BLOCK *blocks;
+} MP3STREAM;
+
+typedef struct mp3reader_ {
+  struct mp3reader_ *nxt;       /* open readers of the pool */
+  MP3STREAM *s;
+  int32_t   blk;                /* current block, -1 at the end */
+  uint32_t  pos;                /* sample frame within the block */
+  int32_t   nowait;             /* nonzero: never wait for a worker */
+  int32_t   underruns;          /* reads that found no block ready */
+  void      *req;               /* ring of requested block numbers */
+} MP3READER;
+
+typedef struct {
+  MP3STREAM *s;                 /* block decode, or */
+  int32_t   blk;
+  void      (*func)(void *);    /* any other decoding task */
+  void      *arg;
+} MP3JOB;
+
+typedef struct {
+  void      *lock, *done;
+  void      *wake;              /* thread lock the workers sleep on */
+  void      *openlock;          /* held while a stream is looked up and
+                                   added, so that a file is opened once */
+  void      *thread[MP3_WORKERS];
+  int32_t   nthreads, quit;
+  int32_t   waiting;            /* threads blocked on done */
+  MP3JOB    job[MP3_MAXJOBS];
+  int32_t   njobs;
+  MP3STREAM *streams;
+  MP3READER *readers;
+  CSOUND    *csound;
+} MP3POOL;
+
+/* Length in bytes of the MPEG audio frame whose header is at h, or 0 if
+   h is not a usable header (free format bitstreams are not indexed) */
+static int32_t mp3_frame_size(const uint8_t *h)
+{
+    static const int16_t kbps[2][3][15] = {
+      { { 0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448 },
+        { 0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384 },
+        { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320 } },
+      { { 0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256 },
+        { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 },
+        { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 } } };
+    static const int32_t rates[4][3] = {
+      { 11025, 12000, 8000 }, { 0, 0, 0 },
+      { 22050, 24000, 16000 }, { 44100, 48000, 32000 } };
+    int32_t ver, layer, bri, sri, pad, lsf, br, sr;
+
+    if (h[0] != 0xFF || (h[1] & 0xE0) != 0xE0) return 0;
+    ver = (h[1] >> 3) & 3;
+    layer = 4 - ((h[1] >> 1) & 3);
+    bri = h[2] >> 4;
+    sri = (h[2] >> 2) & 3;
+    pad = (h[2] >> 1) & 1;
+    if (ver == 1 || layer == 4 || bri == 0 || bri == 15 || sri == 3) return 0;
+    lsf = (ver != 3);
+    br = kbps[lsf][layer-1][bri];
+    sr = rates[ver][sri];
+    if (layer == 1) return (12000*br/sr + pad)*4;
+    if (layer == 3 && lsf) return 72000*br/sr + pad;
+    return 144000*br/sr + pad;
+}
+
+/* Build the frame index of s, reading its file through fd.  Offsets are
+   relative to the start of the stream proper, after any ID3v2 tag, as
+   mp3dec_seek() expects; a leading Xing/Info frame carries no audio and
+   is left out, as the decoder skips it too. */
+static void mp3_index(CSOUND *csound, MP3STREAM *s, int32_t fd)
+{
+    uint8_t *buf = (uint8_t *) csound->Malloc(csound, MP3_SCANBUF);
+    int64_t start = 0, pos, bufpos = -1;
+    int32_t have = 0, size, max = 0, hdr = 0;
+
+    if (lseek(fd, 0, SEEK_SET) == 0 && read(fd, buf, 10) == 10 &&
+        buf[0] == 'I' && buf[1] == 'D' && buf[2] == '3')
+      start = buf[6]*2097152 + buf[7]*16384 + buf[8]*128 + buf[9] + 10;
+    s->nframes = 0;
+    for (pos = start; ; ) {
+      uint8_t *h;
+      if (bufpos < 0 || pos + 40 > bufpos + have) {
+        if (lseek(fd, (off_t) pos, SEEK_SET) != pos) break;
+        have = read(fd, buf, MP3_SCANBUF);
+        bufpos = pos;
+        if (have < 4) break;
+      }
+      h = buf + (pos - bufpos);
+      size = mp3_frame_size(h);
+      /* the fixed header bits must not change along the stream */
+      if (size == 0 ||
+          (hdr != 0 && ((h[1] & 0xFE) != (hdr >> 8) ||
+                        (h[2] & 0x0C) != (hdr & 0xFF)))) {
+        if (h[0] == 'T' && h[1] == 'A' && h[2] == 'G') break;  /* ID3v1 */
+        pos++;                                              /* resync */
+        continue;
+      }
+      if (hdr == 0) {
+        hdr = ((h[1] & 0xFE) << 8) | (h[2] & 0x0C);
+        if ((h[1] & 0x06) == 0x02) {            /* layer III: skip tag */
+          int32_t mono = ((h[3] >> 6) == 3);
+          int32_t k = 4 + (((h[1] >> 3) & 3) == 3 ? (mono ? 17 : 32)
+                                                  : (mono ? 9 : 17));
+          if (!memcmp(h + k, "Xing", 4) || !memcmp(h + k, "Info", 4)) {
+            pos += size;
+            continue;
+          }
+        }
+      }
+      if (s->nframes == max) {
+        max = max ? 2*max : 4096;
+        s->index = (int64_t *) csound->ReAlloc(csound, s->index,
+                                               max*sizeof(int64_t));
+      }
+      s->index[s->nframes++] = pos - start;
+      pos += size;
+    }
+    csound->Free(csound, buf);
+    if (s->nframes == 0 && s->index != NULL) {
+      csound->Free(csound, s->index);
+      s->index = NULL;
+    }
+}
+
+/* pool lock held: queue block b of s for the workers */
+static void mp3_request(MP3POOL *g, MP3STREAM *s, int32_t b)
+{
+    if (ATOMIC_GET(s->blocks[b].state) != MP3_EMPTY ||
+        g->nthreads == 0 || g->njobs == MP3_MAXJOBS)
+      return;
+    g->job[g->njobs].s = s;
+    g->job[g->njobs].blk = b;
+    g->job[g->njobs].func = NULL;
+    g->njobs++;
+    ATOMIC_SET(s->blocks[b].state, MP3_QUEUED);
+    csoundNotifyThreadLock(g->wake);
+}
+
+/* pool lock held: queue the blocks that readers asked for in their rings */
+static void mp3_collect(CSOUND *csound, MP3POOL *g)
+{
+    MP3READER *r;
+    int32_t   b;
+    for (r = g->readers; r != NULL; r = r->nxt)
+      while (csound->ReadCircularBuffer(csound, r->req, &b, 1) == 1)
+        if (ATOMIC_GET(r->s->blocks[b].pins) > 0)
+          mp3_request(g, r->s, b);
+}
+
+/* Add d to the pins of the read-ahead window of r that starts at block
+   from; with d > 0, ask for the blocks in it that are not decoded.  No
+   lock is taken: the requests go through the ring of r. */
+static void mp3_window(CSOUND *csound, MP3READER *r, int32_t from, int32_t d)
+{
+    MP3STREAM *s = r->s;
+    int32_t   to = from + MP3_READAHEAD;
+    if (from < 0) return;
+    if (to >= s->nblocks) to = s->nblocks - 1;
+    for (; from <= to; from++) {
+      ATOMIC_ADD(s->blocks[from].pins, d);
+      /* pinned before its state is looked at: see mp3_claim() */
+      if (d > 0 && ATOMIC_GET(s->blocks[from].state) == MP3_EMPTY)
+        csound->WriteCircularBuffer(csound, r->req, &from, 1);
+    }
+}
+
+/* pool lock held: drop queued decodes of block b of s (all if b < 0) */
+static void mp3_unqueue(MP3POOL *g, MP3STREAM *s, int32_t b)
+{
+    int32_t i, j;
+    for (i = j = 0; i < g->njobs; i++) {
+      MP3JOB *jb = &g->job[i];
+      if (jb->s == s && (b < 0 || jb->blk == b)) {
+        ATOMIC_SET(s->blocks[jb->blk].state, MP3_EMPTY);
+      }
+      else g->job[j++] = *jb;
+    }
+    g->njobs = j;
+}
+
+/* pool lock held: free the sample data of every block of s */
+static void mp3_trim(CSOUND *csound, MP3STREAM *s)
+{
+    int32_t b;
+    for (b = 0; b < s->nblocks; b++) {
+      if (s->blocks[b].data != NULL)
+        csound->Free(csound, s->blocks[b].data);
+      s->blocks[b].data = NULL;
+      s->blocks[b].state = MP3_EMPTY;
+    }
+}
+
+/* pool lock held: take block b of s for decoding, reusing the buffer
+   of a decoded block that nobody pins any more */
+static void mp3_claim(MP3STREAM *s, int32_t b)
+{
+    MP3BLOCK *blk = &s->blocks[b];
+    int32_t i;
+    s->busy = 1;
+    ATOMIC_SET(blk->state, MP3_BUSY);
+    for (i = 0; blk->data == NULL && i < s->nblocks; i++) {
+      MP3BLOCK *old = &s->blocks[i];
+      if (old->state != MP3_READY || old->data == NULL ||
+          ATOMIC_GET(old->pins) != 0)
+        continue;
+      /* A reader pins a block before it looks at its state, and the state
+         is changed here before the pins are looked at again, so either
+         the reader finds the block busy or the pin is seen here. */
+      ATOMIC_SET(old->state, MP3_BUSY);
+      if (ATOMIC_GET(old->pins) != 0) {
+        ATOMIC_SET(old->state, MP3_READY);
+        continue;
+      }
+      blk->data = old->data;
+      old->data = NULL;
+      ATOMIC_SET(old->state, MP3_EMPTY);
+    }
+}
+
+/* pool lock held: publish block b of s once decoded */
+static void mp3_finish(CSOUND *csound, MP3POOL *g, MP3STREAM *s, int32_t b)
+{
+    int32_t i;
+    ATOMIC_SET(s->blocks[b].state, MP3_READY);
+    s->busy = 0;
+    for (i = 0; i < g->waiting; i++)
+      csoundCondSignal(g->done);
+    if (s->refs == 0) mp3_trim(csound, s);
+    else if (g->njobs) csoundNotifyThreadLock(g->wake);
+}
+
+/* Decode block b of s; s must have been claimed */
+static void mp3_decode_block(CSOUND *csound, MP3STREAM *s, int32_t b)
+{
+    MP3BLOCK *blk = &s->blocks[b];
+    int32_t  first = b*MP3_BLOCK_FRAMES;
+    uint32_t fbytes = s->frameSamples*s->chans*sizeof(short), used = 0;
+
+    if (blk->data == NULL)
+      blk->data = (short *) csound->Malloc(csound, MP3_BLOCK_FRAMES*fbytes);
+    if (s->next != first) {
+      int32_t from = first > MP3_PREROLL ? first - MP3_PREROLL : 0;
+      if (s->index != NULL)
+        mp3dec_seek(s->mpa, s->index[from], MP3DEC_SEEK_BYTES);
+      else
+        mp3dec_seek(s->mpa, (int64_t) from*s->frameSamples,
+                    MP3DEC_SEEK_SAMPLES);
+      for (; from < first; from++)
+        mp3dec_decode(s->mpa, (uint8_t *) blk->data, fbytes, NULL);
+    }
+    mp3dec_decode(s->mpa, (uint8_t *) blk->data,
+                  MP3_BLOCK_FRAMES*fbytes, &used);
+    blk->frames = used/(s->chans*sizeof(short));
+    s->next = first + MP3_BLOCK_FRAMES;
+}
+
+static uintptr_t mp3_worker(void *arg)
+{
+    MP3POOL *g = (MP3POOL *) arg;
+    CSOUND  *csound = g->csound;
+
+    csoundLockMutex(g->lock);
+    while (!g->quit) {
+      MP3JOB  jb;
+      int32_t i;
+      mp3_collect(csound, g);
+      for (i = 0; i < g->njobs && g->job[i].s != NULL && g->job[i].s->busy;
+           i++);
+      if (i == g->njobs) {
+        /* readers do not wake the workers: poll their rings */
+        int32_t poll = (g->readers != NULL);
+        csoundUnlockMutex(g->lock);
+        if (poll)
+          csoundWaitThreadLock(g->wake, MP3_POLL_MS);
+        else
+          csoundWaitThreadLockNoTimeout(g->wake);
+        csoundLockMutex(g->lock);
+        continue;
+      }
+      jb = g->job[i];
+      g->njobs--;
+      memmove(&g->job[i], &g->job[i+1], (g->njobs - i)*sizeof(MP3JOB));
+      if (jb.s == NULL) {
+        csoundUnlockMutex(g->lock);
+        jb.func(jb.arg);
+        csoundLockMutex(g->lock);
+      }
+      else if (ATOMIC_GET(jb.s->blocks[jb.blk].pins) == 0) {
+        /* nobody wants it now; a reader that pinned it meanwhile may
+           have seen it queued and not asked again */
+        ATOMIC_SET(jb.s->blocks[jb.blk].state, MP3_EMPTY);
+        if (ATOMIC_GET(jb.s->blocks[jb.blk].pins) != 0)
+          mp3_request(g, jb.s, jb.blk);
+      }
+      else {
+        mp3_claim(jb.s, jb.blk);
+        csoundUnlockMutex(g->lock);
+        mp3_decode_block(csound, jb.s, jb.blk);
+        csoundLockMutex(g->lock);
+        mp3_finish(csound, g, jb.s, jb.blk);
+      }
+    }
+    csoundUnlockMutex(g->lock);
+    csoundNotifyThreadLock(g->wake);    /* pass the quit on */
+    return 0;
+}
+
+static int32_t mp3_pool_destroy(CSOUND *csound, void *userData)
+{
+    MP3POOL *g = (MP3POOL *) userData;
+    int32_t i;
+
+    csoundLockMutex(g->lock);
+    g->quit = 1;
+    csoundUnlockMutex(g->lock);
+    csoundNotifyThreadLock(g->wake);
+    for (i = 0; i < g->nthreads; i++)
+      csoundJoinThread(g->thread[i]);
+    while (g->streams != NULL) {
+      MP3STREAM *s = g->streams;
+      g->streams = s->nxt;
+      mp3_trim(csound, s);
+      mp3dec_uninit(s->mpa);
+      csound->Free(csound, s->index);
+      csound->Free(csound, s->blocks);
+      csound->Free(csound, s->name);
+      csound->Free(csound, s);
+    }
+    csoundDestroyThreadLock(g->wake);
+    csoundDestroyCondVar(g->done);
+    csoundDestroyMutex(g->openlock);
+    csoundDestroyMutex(g->lock);
+    return OK;
+}
+
+static MP3POOL *mp3_pool(CSOUND *csound)
+{
+    MP3POOL *g = (MP3POOL *) csound->QueryGlobalVariable(csound, "::mp3pool");
+    int32_t i;
+
+    if (LIKELY(g != NULL))
+      return g;
+    csound->CreateGlobalVariable(csound, "::mp3pool", sizeof(MP3POOL));
+    g = (MP3POOL *) csound->QueryGlobalVariable(csound, "::mp3pool");
+    g->lock = csoundCreateMutex(0);
+    g->openlock = csoundCreateMutex(0);
+    g->wake = csoundCreateThreadLock();
+    g->done = csoundCreateCondVar();
+    g->csound = csound;
+    for (i = 0; i < MP3_WORKERS; i++) {
+      g->thread[g->nthreads] = csoundCreateThread(mp3_worker, (void *) g);
+      if (g->thread[g->nthreads] != NULL)
+        g->nthreads++;
+    }
+    csound->RegisterResetCallback(csound, (void *) g, mp3_pool_destroy);
+    return g;
+}
+
+#ifdef ANDROID
+/* Run func(arg) on a pool thread, or at once if there is none free */
+static void mp3_pool_submit(CSOUND *csound, void (*func)(void *), void *arg)
+{
+    MP3POOL *g = mp3_pool(csound);
+    csoundLockMutex(g->lock);
+    if (g->nthreads > 0 && g->njobs < MP3_MAXJOBS) {
+      g->job[g->njobs].s = NULL;
+      g->job[g->njobs].func = func;
+      g->job[g->njobs].arg = arg;
+      g->njobs++;
+      csoundNotifyThreadLock(g->wake);
+      csoundUnlockMutex(g->lock);
+      return;
+    }
+    csoundUnlockMutex(g->lock);
+    func(arg);
+}
+#endif
+
+/* Open a new stream for the file at path, decoded to mono or stereo.
+   Returns NULL with an mp3dec error code in *err, or with *err < 0 if
+   the file cannot be opened; path is taken over either way. */
+static MP3STREAM *mp3_stream_new(CSOUND *csound, char *path,
+                                 int32_t mono, int32_t *err)
+{
+    MP3STREAM *s;
+    mp3tag_info_t tag;
+    mpadec_config_t config = { MPADEC_CONFIG_FULL_QUALITY, MPADEC_CONFIG_STEREO,
+                               MPADEC_CONFIG_16BIT, MPADEC_CONFIG_LITTLE_ENDIAN,
+                               MPADEC_CONFIG_REPLAYGAIN_NONE, FALSE, TRUE, TRUE,
+                               0.0 };
+    int32_t fd, r;
+
+    /* the decoder does not trim the encoder delay itself (config.skip is
+       off) so that a block decodes the same wherever decoding started */
+    if (mono) config.mode = MPADEC_CONFIG_MONO;
+    s = (MP3STREAM *) csound->Calloc(csound, sizeof(MP3STREAM));
+    s->name = path;
+    s->mono = mono;
+    if (UNLIKELY((s->mpa = mp3dec_init()) == NULL)) {
+      *err = MP3DEC_RETCODE_UNKNOWN;
+      goto fail;
+    }
+    if (UNLIKELY((r = mp3dec_configure(s->mpa, &config)) != MP3DEC_RETCODE_OK)) {
+      *err = r;
+      goto fail;
+    }
+    if (UNLIKELY((fd = open(path, O_RDONLY | O_BINARY)) < 0))
+      goto fail;
+    if (UNLIKELY((r = mp3dec_init_file(s->mpa, fd, 0, FALSE))
+                 != MP3DEC_RETCODE_OK ||
+                 (r = mp3dec_get_info(s->mpa, &s->info, MPADEC_INFO_STREAM))
+                 != MP3DEC_RETCODE_OK)) {
+      *err = r;
+      goto fail;
+    }
+    s->chans = s->info.decoded_channels;
+    s->frameSamples = s->info.decoded_frame_samples;
+    s->delay = (s->info.layer == 3 ? 529 : 241);
+    if (mp3dec_get_info(s->mpa, &tag, MPADEC_INFO_TAG) == MP3DEC_RETCODE_OK)
+      s->delay += tag.enc_delay;
+    mp3_index(csound, s, fd);
+    if (s->index == NULL)       /* unindexable: trust the header estimate */
+      s->nframes = s->info.frames + 1;
+    s->next = -1;
+    s->nblocks = (s->nframes + MP3_BLOCK_FRAMES - 1)/MP3_BLOCK_FRAMES;
+    s->blocks =
+      (MP3BLOCK *) csound->Calloc(csound, (s->nblocks+1)*sizeof(MP3BLOCK));
+    s->refs = 1;
+    return s;
+ fail:
+    if (s->mpa != NULL) mp3dec_uninit(s->mpa);
+    csound->Free(csound, path);
+    csound->Free(csound, s);
+    return NULL;
+}
+
+/* Open (or share) the stream for file name, decoded to mono or stereo.
+   Returns NULL with *err < 0 if the file cannot be found or opened, and
+   an mp3dec error code otherwise. */
+static MP3STREAM *mp3_stream_open(CSOUND *csound, const char *name,
+                                  int32_t mono, int32_t *err)
+{
+    MP3POOL   *g = mp3_pool(csound);
+    MP3STREAM *s;
+    char      *path;
+
+    *err = -1;
+    path = csound->FindInputFile(csound, name, "SFDIR;SSDIR");
+    if (UNLIKELY(path == NULL))
+      return NULL;
+    /* looked up and added under one lock, so that two notes opening the
+       same file at once share one stream; the workers only need the pool
+       lock, which is not held while the file is indexed */
+    csoundLockMutex(g->openlock);
+    for (s = g->streams; s != NULL; s = s->nxt)
+      if (s->mono == mono && !strcmp(s->name, path))
+        break;
+    if (s != NULL) {
+      csoundLockMutex(g->lock);
+      s->refs++;
+      csoundUnlockMutex(g->lock);
+      csound->Free(csound, path);
+    }
+    else if ((s = mp3_stream_new(csound, path, mono, err)) != NULL) {
+      csoundLockMutex(g->lock);
+      s->nxt = g->streams;
+      g->streams = s;
+      csoundUnlockMutex(g->lock);
+    }
+    csoundUnlockMutex(g->openlock);
+    return s;
+}
+
+/* Move r to block b (offset pos), updating the pinned read-ahead window.
+   The new window is pinned before the old one is released, so that the
+   blocks they share are never free to be reused in between. */
+static void mp3_reader_move(CSOUND *csound, MP3READER *r, int32_t b,
+                            uint32_t pos)
+{
+    int32_t old = r->blk;
+    r->blk = (b < r->s->nblocks ? b : -1);
+    r->pos = pos;
+    mp3_window(csound, r, r->blk, 1);
+    mp3_window(csound, r, old, -1);
+}
+
+/* Position r at sample frame frame of its stream */
+static void mp3_reader_seek(CSOUND *csound, MP3READER *r, int64_t frame)
+{
+    int64_t bsize = (int64_t) MP3_BLOCK_FRAMES*r->s->frameSamples;
+    if (frame < 0) frame = 0;
+    frame += r->s->delay;
+    mp3_reader_move(csound, r, (int32_t) (frame/bsize),
+                    (uint32_t) (frame%bsize));
+    /* at init: have the workers start at once */
+    csoundNotifyThreadLock(mp3_pool(csound)->wake);
+}
+
+/* Get pinned block b of s ready, decoding it here if no worker has, or
+   waiting for the worker that is decoding it */
+static void mp3_wait(CSOUND *csound, MP3STREAM *s, int32_t b)
+{
+    MP3POOL  *g = mp3_pool(csound);
+    MP3BLOCK *blk = &s->blocks[b];
+    csoundLockMutex(g->lock);
+    mp3_collect(csound, g);
+    while (blk->state != MP3_READY) {
+      if (!s->busy) {
+        mp3_unqueue(g, s, b);
+        mp3_claim(s, b);
+        csoundUnlockMutex(g->lock);
+        mp3_decode_block(csound, s, b);
+        csoundLockMutex(g->lock);
+        mp3_finish(csound, g, s, b);
+      }
+      else {
+        g->waiting++;
+        csoundCondWait(g->done, g->lock);
+        g->waiting--;
+      }
+    }
+    csoundUnlockMutex(g->lock);
+}
+
+/* Point *samps at the next decoded frames of r and return how many are
+   contiguous there; 0 at the end of the stream (r->blk < 0) or when the
+   next block is not decoded yet and r may not wait (an underrun) */
+static uint32_t mp3_reader_get(CSOUND *csound, MP3READER *r, short **samps)
+{
+    while (r->blk >= 0) {
+      MP3BLOCK *blk = &r->s->blocks[r->blk];
+      if (UNLIKELY(ATOMIC_GET(blk->state) != MP3_READY)) {
+        if (r->nowait) {
+          /* ask again, as a queued decode may have been dropped */
+          csound->WriteCircularBuffer(csound, r->req, &r->blk, 1);
+          r->underruns++;
+          return 0;
+        }
+        mp3_wait(csound, r->s, r->blk);
+      }
+      if (LIKELY(r->pos < blk->frames)) {
+        *samps = blk->data + r->pos*r->s->chans;
+        return blk->frames - r->pos;
+      }
+      mp3_reader_move(csound, r, r->blk + 1, 0);
+    }
+    return 0;
+}
+
+static inline void mp3_reader_advance(MP3READER *r, uint32_t n)
+{
+    r->pos += n;
+}
+
+/* Release r's stream; the stream stays open and indexed for reuse */
+static void mp3_reader_close(CSOUND *csound, MP3READER *r)
+{
+    MP3POOL   *g;
+    MP3READER **pr;
+    MP3STREAM *s = r->s;
+    if (s == NULL) return;
+    if (UNLIKELY(r->underruns))
+      csound->Warning(csound, Str("mp3: %s was not decoded in time "
+                                  "for %d reads\n"), s->name, r->underruns);
+    g = mp3_pool(csound);
+    csoundLockMutex(g->lock);
+    for (pr = &g->readers; *pr != NULL; pr = &(*pr)->nxt)
+      if (*pr == r) {
+        *pr = r->nxt;
+        break;
+      }
+    mp3_window(csound, r, r->blk, -1);
+    if (--s->refs == 0) {
+      mp3_unqueue(g, s, -1);
+      if (!s->busy) mp3_trim(csound, s);
+    }
+    csoundUnlockMutex(g->lock);
+    csound->DestroyCircularBuffer(csound, r->req);
+    r->req = NULL;
+    r->s = NULL;
+    r->blk = -1;
+}
+
+static int32_t mp3_reader_open(CSOUND *csound, MP3READER *r, const char *name,
+                               int32_t mono, int32_t *err)
+{
+    MP3POOL *g = mp3_pool(csound);
+    r->s = mp3_stream_open(csound, name, mono, err);
+    r->blk = -1;
+    r->pos = 0;
+    r->underruns = 0;
+    /* a realtime performance plays silence rather than wait for decoding,
+       if there are workers to decode ahead */
+    r->nowait = (csound->oparms->realtime && g->nthreads > 0);
+    if (r->s == NULL)
+      return NOTOK;
+    r->req = csound->CreateCircularBuffer(csound, MP3_REQUESTS,
+                                          sizeof(int32_t));
+    csoundLockMutex(g->lock);
+    r->nxt = g->readers;
+    g->readers = r;
+    csoundUnlockMutex(g->lock);
+    return OK;
+}
 
 typedef struct {
   OPDS    h;
@@ -35,15 +702,8 @@ typedef struct {
   MYFLT   *iSkipInit;
   MYFLT   *ibufsize;
   /* ------------------------------------- */
-  mp3dec_t mpa;           /* For library */
-  int32_t  r;             /* Result field */
-  int32_t  initDone;
-  int32_t  bufSize;       /* in sample frames, power of two */
-  uint32_t bufused;
-  int64_t  pos;           /* type should be defined in sysdep.h */
-  uint8_t  *buf;
-  AUXCH    auxch;
-  FDCH     fdch;
+  MP3READER rd;           /* shared decoded stream */
+  int32_t initDone;
 } MP3IN;
 
 
@@ -56,10 +716,8 @@ typedef struct {
 
 int32_t mp3in_cleanup(CSOUND *csound, MP3IN *p)
 {
-    IGN(csound);
-    if (LIKELY(p->mpa != NULL))
-      mp3dec_uninit(p->mpa);
-    p->mpa = NULL;
+    mp3_reader_close(csound, &p->rd);
+    p->initDone = 0;
     return OK;
 }
 
@@ -67,40 +725,16 @@ int32_t mp3in_cleanup(CSOUND *csound, MP3IN *p)
 int32_t mp3ininit_(CSOUND *csound, MP3IN *p, int32_t stringname)
 {
     char    name[1024];
-    int32_t fd;
-    mp3dec_t mpa           = NULL;
-    mpadec_config_t config = { MPADEC_CONFIG_FULL_QUALITY, MPADEC_CONFIG_STEREO,
-                               MPADEC_CONFIG_16BIT, MPADEC_CONFIG_LITTLE_ENDIAN,
-                               MPADEC_CONFIG_REPLAYGAIN_NONE, TRUE, TRUE, TRUE,
-                               0.0 };
-    mpadec_info_t mpainfo;
-    int32_t buffersize =
-      (*p->ibufsize<=0.0 ? /*0x1000*/ 8*1152 : (int32_t)*p->ibufsize);
-    /* uint64_t maxsize; */
+    mpadec_info_t *mpainfo;
     int32_t r;
-    int32_t skip;
-    if (p->OUTOCOUNT==1) config.mode = MPADEC_CONFIG_MONO;
-    /* if already open, close old file first */
-    if (p->fdch.fd != NULL) {
-      /* skip initialisation if requested */
+    /* if already open, keep playing it if requested, else close it */
+    if (p->rd.s != NULL) {
       if (*(p->iSkipInit) != FL(0.0))
         return OK;
-      csound->FDClose(csound, &(p->fdch));
+      mp3_reader_close(csound, &p->rd);
     }
-    /* set default format parameters */
-    /* open file */
-
-    p->mpa = mpa = mp3dec_init();
-    if (UNLIKELY(!mpa)) {
-      return csound->InitError(csound, Str("Not enough memory\n"));
-    }
-
-    if (UNLIKELY((r = mp3dec_configure(mpa, &config)) != MP3DEC_RETCODE_OK)) {
-      mp3dec_uninit(mpa);
-      p->mpa = NULL;
-      return csound->InitError(csound, "%s", mp3dec_error(r));
-    }
-
+    /* the buffer size argument is kept for compatibility; decoding is
+       now done in shared blocks */
 
     /* FIXME: name can overflow with very long string -- truncates safely */
     if (stringname==0){
@@ -110,91 +744,40 @@ int32_t mp3ininit_(CSOUND *csound, MP3IN *p, int32_t stringname)
     }
     else strNcpy(name, ((STRINGDAT *)p->iFileCode)->data, 1023);
 
-    if (UNLIKELY(csound->FileOpen2(csound, &fd, CSFILE_FD_R,
-                                   name, "rb", "SFDIR;SSDIR",
-                                   CSFTYPE_OTHER_BINARY, 0) == NULL)) {
-      mp3dec_uninit(mpa);
-      return
-        csound->InitError(csound, Str("mp3in: %s: failed to open file"), name);
-    }
-    /* HOW TO record file handle so that it will be closed at note-off */
-    /* memset(&(p->fdch), 0, sizeof(FDCH)); */
-    /* p->fdch.fd = fd; */
-    /* fdrecord(csound, &(p->fdch)); */
-    if (UNLIKELY((r = mp3dec_init_file(mpa, fd, 0, FALSE)) != MP3DEC_RETCODE_OK)) {
-      mp3dec_uninit(mpa);
+    if (UNLIKELY(mp3_reader_open(csound, &p->rd, name,
+                                 p->OUTOCOUNT == 1, &r) != OK)) {
+      if (r < 0)
+        return csound->InitError(csound,
+                                 Str("mp3in: %s: failed to open file"), name);
       return csound->InitError(csound, "%s", mp3dec_error(r));
     }
-    if (UNLIKELY((r = mp3dec_get_info(mpa, &mpainfo, MPADEC_INFO_STREAM)) !=
-                 MP3DEC_RETCODE_OK)) {
-      mp3dec_uninit(mpa);
-      return csound->InitError(csound, "%s", mp3dec_error(r));
-    }
-    skip = (int32_t)(*p->iSkipTime*CS_ESR);
-
-    /* maxsize = mpainfo.decoded_sample_size */
-    /*          *mpainfo.decoded_frame_samples */
-    /*          *mpainfo.frames; */
-    /* csound->Message(csound, "maxsize = %li\n", maxsize); */
+    mpainfo = &p->rd.s->info;
     /* print file information */
     /* if (UNLIKELY(csound->oparms_.msglevel & WARNMSG)) */ {
       char temp[80];            /* Could be as low as 20 */
-      if (mpainfo.frequency < 16000) strcpy(temp, "MPEG-2.5 ");
-      else if (mpainfo.frequency < 32000) strcpy(temp, "MPEG-2 ");
+      if (mpainfo->frequency < 16000) strcpy(temp, "MPEG-2.5 ");
+      else if (mpainfo->frequency < 32000) strcpy(temp, "MPEG-2 ");
       else strcpy(temp, "MPEG-1 ");
-      if (mpainfo.layer == 1) strcat(temp, "Layer I");
-      else if (mpainfo.layer == 2) strcat(temp, "Layer II");
+      if (mpainfo->layer == 1) strcat(temp, "Layer I");
+      else if (mpainfo->layer == 2) strcat(temp, "Layer II");
       else strcat(temp, "Layer III");
       csound->Warning(csound, "Input:  %s, %s, %d kbps, %d Hz  (%d:%02d)\n",
-                      temp, ((mpainfo.channels > 1) ? "stereo" : "mono"),
-                      mpainfo.bitrate, mpainfo.frequency, mpainfo.duration/60,
-                      mpainfo.duration%60);
-    }
-    /* check number of channels in file (must equal the number of outargs) */
-    /* if (UNLIKELY(sfinfo.channels != p->nChannels && */
-    /*              (csound->oparms_.msglevel & WARNMSG) != 0)) { */
-    /*   mp3dec_uninit(mpa); */
-    /*   return csound->InitError(csound, */
-    /*                      Str("mp3in: number of output args " */
-    /*                          "inconsistent with number of file channels")); */
-    /* } */
-    /* skip initialisation if requested */
-    if (*(p->iSkipInit) != FL(0.0))
-      return OK;
+                      temp, ((mpainfo->channels > 1) ? "stereo" : "mono"),
+                      mpainfo->bitrate, mpainfo->frequency,
+                      mpainfo->duration/60, mpainfo->duration%60);
+    }
     /* set file parameters from header info */
-    if ((int32_t) (CS_ESR + FL(0.5)) != mpainfo.frequency) {
+    if ((int32_t) (CS_ESR + FL(0.5)) != mpainfo->frequency) {
       csound->Warning(csound, Str("mp3in: file sample rate (%d) "
                                   "!= orchestra sr (%d)\n"),
-                      mpainfo.frequency, (int32_t) (CS_ESR + FL(0.5)));
-    }
-    /* initialise buffer */
-    mp3dec_seek(mpa,0, MP3DEC_SEEK_SAMPLES);
-    p->bufSize = buffersize;
-    if (p->auxch.auxp == NULL || p->auxch.size < (uint32_t)buffersize)
-      csound->AuxAlloc(csound, buffersize, &p->auxch);
-    p->buf = (uint8_t *) p->auxch.auxp;
-    p->bufused = -1;
-    buffersize /= (mpainfo.decoded_sample_size);
-    //printf("===%d\n", skip);
-    //skip = skip - 528;
-    while (skip > 0) {
-      int32_t xx= skip;
-      // printf("%d\n", skip);
-      if (xx > buffersize) xx = buffersize;
-      skip -= xx;
-      r = mp3dec_decode(mpa, p->buf, mpainfo.decoded_sample_size*xx, &p->bufused);
-      // printf("u %d\n", p->bufused);
+                      mpainfo->frequency, (int32_t) (CS_ESR + FL(0.5)));
     }
-    //if(!skip)
-    //mp3dec_seek(mpa, skip, MP3DEC_SEEK_SAMPLES);
-    p->r = r;
+    mp3_reader_seek(csound, &p->rd, (int64_t) (*p->iSkipTime*CS_ESR));
     if (p->initDone == 0)
       csound->RegisterDeinitCallback(csound, p,
-                                     (int32_t (*)(CSOUND*, void*)) mp3in_cleanup);
-    /* done initialisation */
+                                     (int32_t (*)(CSOUND*, void*))
+                                     mp3in_cleanup);
     p->initDone = -1;
-    p->pos = 0;
-
     return OK;
 }
 
@@ -209,51 +792,41 @@ int32_t mp3ininit_S(CSOUND *csound, MP3IN *p){
 
 int32_t mp3in(CSOUND *csound, MP3IN *p)
 {
-    int32_t r       = p->r;
-    mp3dec_t mpa    = p->mpa;
-    uint8_t *buffer = p->buf;
     MYFLT *al       = p->ar[0];
-    MYFLT *ar       = p->ar[1];
-    int32_t pos     = p->pos;
+    MYFLT *ar       = (p->OUTOCOUNT > 1 ? p->ar[1] : NULL);
+    MYFLT scal      = csound->e0dbfs/(MYFLT)0x7fff;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
     uint32_t offset = p->h.insdshead->ksmps_offset;
-    uint32_t i, n, nsmps = CS_KSMPS;
+    uint32_t k, n, nsmps = CS_KSMPS;
+    int32_t chans;
 
+    if (UNLIKELY(p->rd.s == NULL))
+      return csound->PerfError(csound, &(p->h),
+                               Str("mp3in: not initialised"));
+    chans = p->rd.s->chans;
     if (UNLIKELY(offset)) {
       memset(al, '\0', offset*sizeof(MYFLT));
-      memset(ar, '\0', offset*sizeof(MYFLT));
+      if (ar != NULL) memset(ar, '\0', offset*sizeof(MYFLT));
     }
     if (UNLIKELY(early)) {
       nsmps -= early;
       memset(&al[nsmps], '\0', early*sizeof(MYFLT));
-      memset(&ar[nsmps], '\0', early*sizeof(MYFLT));
-    }
-    for (n=offset; n<nsmps; n++) {
-      for (i=0; i<p->OUTOCOUNT; i++) {     /* stereo */
-        MYFLT xx;
-        short *bb = (short*)buffer;
-        while (r != MP3DEC_RETCODE_OK || 2*pos >=  (int32_t)p->bufused) {
-          r = mp3dec_decode(mpa, buffer, p->bufSize, &p->bufused);
-          if (UNLIKELY(p->bufused == 0)) {
-            memset(&al[n], 0, (nsmps-n)*sizeof(MYFLT));
-            memset(&ar[n], 0, (nsmps-n)*sizeof(MYFLT));
-            goto ending;
-          }
-          pos = 0;
-        }
-        xx = ((MYFLT)bb[pos]/(MYFLT)0x7fff) * csound->e0dbfs;
-        if (i==0) al[n] = xx;
-        else      ar[n] = xx;
-        pos++;
-      }
+      if (ar != NULL) memset(&ar[nsmps], '\0', early*sizeof(MYFLT));
     }
- ending:
-    p->pos = pos;
-    p->r = r;
-    if (UNLIKELY(r != MP3DEC_RETCODE_OK)) {
-      mp3dec_uninit(mpa);
-      p->mpa = NULL;
-      return NOTOK;
+    for (n=offset; n<nsmps; ) {
+      short *bb;
+      uint32_t avail = mp3_reader_get(csound, &p->rd, &bb);
+      if (UNLIKELY(avail == 0)) {             /* end of file */
+        memset(&al[n], 0, (nsmps-n)*sizeof(MYFLT));
+        if (ar != NULL) memset(&ar[n], 0, (nsmps-n)*sizeof(MYFLT));
+        break;
+      }
+      if (avail > nsmps-n) avail = nsmps-n;
+      for (k=0; k<avail; k++, n++, bb += chans) {
+        al[n] = (MYFLT)bb[0]*scal;
+        if (ar != NULL) ar[n] = (MYFLT)bb[chans-1]*scal;
+      }
+      mp3_reader_advance(&p->rd, avail);
     }
     return OK;
 }
@@ -334,11 +907,11 @@ typedef struct dats{
   double pos;
   MYFLT accum;
   AUXCH outframe[MP3_CHNS], win, bwin[MP3_CHNS], fwin[MP3_CHNS],
-    nwin[MP3_CHNS], prev[MP3_CHNS], framecount[MP3_CHNS], fdata[MP3_CHNS], buffer;
+    nwin[MP3_CHNS], prev[MP3_CHNS], framecount[MP3_CHNS], fdata[MP3_CHNS];
   MYFLT *indataL[2], *indataR[2];
   MYFLT *tab[MP3_CHNS];
   char curbuf;
-  mp3dec_t mpa;
+  MP3READER rd;
   FDCH    fdch;
   MYFLT resamp;
   double tstamp, incr;
@@ -357,9 +930,8 @@ typedef struct dats{
 
 int32_t mp3scale_cleanup(CSOUND *csound, DATASPACE *p)
 {
-    IGN(csound);
-    if (p->mpa != NULL)
-      mp3dec_uninit(p->mpa);
+    mp3_reader_close(csound, &p->rd);
+    p->initDone = 0;
     return OK;
 }
 
@@ -438,48 +1010,21 @@ static int32_t sinit3_(CSOUND *csound, DATASPACE *p)
 {
     uint32_t size;
     char *name;
-    // open file
-    int32_t  fd;
     int32_t  r;
-    mp3dec_t mpa           = NULL;
-    mpadec_config_t config = { MPADEC_CONFIG_FULL_QUALITY, MPADEC_CONFIG_STEREO,
-                               MPADEC_CONFIG_16BIT, MPADEC_CONFIG_LITTLE_ENDIAN,
-                               MPADEC_CONFIG_REPLAYGAIN_NONE, TRUE, TRUE, TRUE,
-                               0.0 };
-    mpadec_info_t mpainfo;
+    mpadec_info_t *mpainfo;
     /*double dtime;
       struct timespec ts;
       clock_gettime(CLOCK_MONOTONIC, &ts);
       dtime = ts.tv_sec + 1e-9*ts.tv_nsec;*/
     name = ((STRINGDAT *)p->knum)->data;
-    p->mpa = mpa = mp3dec_init();
-    if (UNLIKELY(!mpa)) {
-      return csound->InitError(csound, Str("Not enough memory\n"));
-    }
-    if (UNLIKELY((r = mp3dec_configure(mpa, &config)) != MP3DEC_RETCODE_OK)) {
-      mp3dec_uninit(mpa);
-      p->mpa = NULL;
-      return csound->InitError(csound, "%s", mp3dec_error(r));
-    }
-    if (UNLIKELY(csound->FileOpen2(csound, &fd, CSFILE_FD_R,
-                                   name, "rb", "SFDIR;SSDIR",
-                                   CSFTYPE_OTHER_BINARY, 0) == NULL)) {
-      mp3dec_uninit(mpa);
-      return
-        csound->InitError(csound, Str("mp3scale: %s: failed to open file"), name);
-    }// else
-    // csound->Message(csound, Str("mp3scale: open %s\n"), name);
-    if (UNLIKELY((r = mp3dec_init_file(mpa, fd, 0, FALSE)) != MP3DEC_RETCODE_OK)) {
-      mp3dec_uninit(mpa);
-      return csound->InitError(csound, "%s", mp3dec_error(r));
-    } // else
-    // csound->Message(csound, Str("mp3scale: init %s\n"), name);
-
-    if (UNLIKELY((r = mp3dec_get_info(mpa, &mpainfo, MPADEC_INFO_STREAM)) !=
-                 MP3DEC_RETCODE_OK)) {
-      mp3dec_uninit(mpa);
+    mp3_reader_close(csound, &p->rd);
+    if (UNLIKELY(mp3_reader_open(csound, &p->rd, name, 0, &r) != OK)) {
+      if (r < 0)
+        return csound->InitError(csound,
+                                 Str("mp3scale: %s: failed to open file"), name);
       return csound->InitError(csound, "%s", mp3dec_error(r));
     }
+    mpainfo = &p->rd.s->info;
 
     /* {
        char temp[80];
@@ -495,8 +1040,8 @@ static int32_t sinit3_(CSOUND *csound, DATASPACE *p)
        mpainfo.duration%60);
        }*/
 
-    if(mpainfo.frequency != CS_ESR)
-      p->resamp = mpainfo.frequency/CS_ESR;
+    if(mpainfo->frequency != CS_ESR)
+      p->resamp = mpainfo->frequency/CS_ESR;
     else
       p->resamp = 1;
 
@@ -520,8 +1065,6 @@ static int32_t sinit3_(CSOUND *csound, DATASPACE *p)
       ps = (char *) p->fdata[1].auxp;
       p->indataR[0] = (MYFLT*) ps;
       p->indataR[1] = (MYFLT*) (ps + size/2);
-      if (p->buffer.auxp == NULL || p->buffer.size < size)
-        csound->AuxAlloc(csound, size, &p->buffer);
     }
     /*
       memset(&(p->fdch), 0, sizeof(FDCH));
@@ -542,20 +1085,26 @@ static int32_t sinit3_(CSOUND *csound, DATASPACE *p)
       r = mp3dec_decode(mpa, p->buffer.auxp,
       mpainfo.decoded_sample_size*xx, &p->bufused);
       }*/
-    mp3dec_seek(mpa, skip, MP3DEC_SEEK_SAMPLES);
+    mp3_reader_seek(csound, &p->rd, skip);
 
     // fill buffers
     p->curbuf = 0;
-    fillbuf(csound,p,p->N*BUFS/2);
+    {
+      int32_t nowait = p->rd.nowait;
+      p->rd.nowait = 0;         /* the first buffer may wait, at init */
+      fillbuf(csound,p,p->N*BUFS/2);
+      p->rd.nowait = nowait;
+    }
     p->pos = p->hsize;
     p->tscale  = 0;
     p->accum = 0;
     p->tab[0] = (MYFLT *) p->fdata[0].auxp;
     p->tab[1] = (MYFLT *) p->fdata[1].auxp;
     p->tstamp = 0;
-    if(p->initDone == -1)
+    if (p->initDone == 0)
       csound->RegisterDeinitCallback(csound, p,
-                                     (int32_t (*)(CSOUND*, void*))mp3scale_cleanup);
+                                     (int32_t (*)(CSOUND*, void*))
+                                     mp3scale_cleanup);
     p->initDone = -1;
     p->finished = 0;
     p->init = 1;
@@ -596,26 +1145,25 @@ static int32_t sinit3(CSOUND *csound, DATASPACE *p) {
   call to fillbuf
 */
 void fillbuf(CSOUND *csound, DATASPACE *p, int32_t nsmps){
-    IGN(csound);
-    short *buffer= (short *) p->buffer.auxp;
     MYFLT *data[2];
+    int32_t i = 0, chans = p->rd.s->chans;
     data[0] =  p->indataL[(int32_t)p->curbuf];
     data[1] =  p->indataR[(int32_t)p->curbuf];
-    int32_t i,j, end;
     memset(data[0],0,nsmps*sizeof(MYFLT));
     memset(data[1],0,nsmps*sizeof(MYFLT));
-    if(!p->finished){
-      mp3dec_decode(p->mpa,p->buffer.auxp,
-                    MP3_CHNS*nsmps*sizeof(short),
-                    &p->bufused);
-      if(p->bufused == 0) p->finished = 1;
-      else {
-        end = p->bufused/sizeof(short);
-        for(i=j=0; i < end/2; i++, j+=2){
-          data[0][i] = buffer[j]/32768.0;
-          data[1][i] = buffer[j+1]/32768.0;
-        }
+    while (!p->finished && i < nsmps) {
+      short *bb;
+      uint32_t k, avail = mp3_reader_get(csound, &p->rd, &bb);
+      if (avail == 0) {         /* end of file, or an underrun */
+        if (p->rd.blk < 0) p->finished = 1;
+        break;
+      }
+      if (avail > (uint32_t) (nsmps - i)) avail = nsmps - i;
+      for (k = 0; k < avail; k++, i++, bb += chans) {
+        data[0][i] = bb[0]/32768.0;
+        data[1][i] = bb[chans-1]/32768.0;
       }
+      mp3_reader_advance(&p->rd, avail);
     }
     p->curbuf = p->curbuf ? 0 : 1;
 }
@@ -923,19 +1471,17 @@ void *buffiller(void *pp){
     return NULL;
 }
 
+static void buffiller_job(void *pp){
+    (void) buffiller(pp);
+}
+
 void fillbuf2(CSOUND *csound, MP3SCAL2 *p, int32_t nsmps){
     p->nsmps = nsmps;
     if(p->async) {
-      int32_t policy;
-      struct sched_param param;
-      pthread_create(&(p->t1), NULL, buffiller, p);
-      pthread_getschedparam(p->t1, &policy,
-                            &param);
-      param.sched_priority = 1;
-      //policy = SCHED_OTHER;
-      if(pthread_setschedparam(p->t1, policy,
-                               &param) != 0)
-        csound->Message(csound, Str("could not set priority\n"));
+      /* hand the fill to the shared decode pool; lock is held until the
+         job has run so that cleanup waits for it */
+      p->lock = 1;
+      mp3_pool_submit(csound, buffiller_job, p);
     }
     else
       buffiller((void *) p);
@@ -1257,7 +1803,6 @@ int32_t mp3dec_cleanup_player(CSOUND *csound,  PLAYER  *p)
 {
     while(p->p->lock)
       usleep(1000);
-    pthread_join(p->p->t1, NULL);
     if (p->p->mpa != NULL)
       mp3dec_uninit(p->p->mpa);
     p->p->mpa = NULL;
@@ -374,6 +374,8 @@ static int32_t oscbnkset(CSOUND *csound, OSCBNK *p)
     if ((p->auxdata.auxp == NULL) || (p->auxdata.size < i))
       csound->AuxAlloc(csound, i, &(p->auxdata));
     p->osc = (OSCBNK_OSC *) p->auxdata.auxp;
+    if (p->ieqmode < 0)
+      oscbank_alloc(csound, &p->bank, &p->bankdata, p->nr_osc);
 
     memset(p->outft, 0, p->outft_len*sizeof(MYFLT));
 
@@ -473,18 +475,13 @@ static int32_t oscbnk(CSOUND *csound, OSCBNK *p)
         }
         f_i = OSCBNK_PHS2INT(f);
         if (am_enabled) a_d = (o->osc_amp - a)  / (nsmps-offset);
-        /* oscillator */
-        for (nn = offset; nn < nsmps; nn++) {
-          /* read from table */
-          n = ph >> lobits; k = ft[n++];
-          k += (ft[n] - k) * (MYFLT) ((int32) (ph & mask)) * pfrac;
-          /* amplitude modulation */
-          if (am_enabled) k *= (a += a_d);
-          /* mix to output */
-          p->args[0][nn] += k;
-          /* update phase */
-          ph = (ph + f_i) & OSCBNK_PHSMSK;
-        }
+        /* the oscillators are rendered together on the bank below;
+           without AM the amplitude stays at 1 */
+        p->bank.phs[osc_cnt] = ph;
+        p->bank.inc[osc_cnt] = f_i;
+        p->bank.amp[osc_cnt] = (am_enabled ? a + a_d : a);
+        p->bank.damp[osc_cnt] = (am_enabled ? a_d : FL(0.0));
+        continue;
       }
       else {                        /* EQ enabled */
         a1 = o->a1; a2 = o->a2;         /* EQ coeffs    */
@@ -564,6 +561,23 @@ static int32_t oscbnk(CSOUND *csound, OSCBNK *p)
       o->osc_amp = a;
       o->osc_phs = ph;
     }
+    if (p->ieqmode < 0) {             /* EQ disabled */
+      OSCBANK_TAB tab;
+
+      tab.ftable = ft;
+      tab.phmask = OSCBNK_PHSMSK;
+      tab.lobits = lobits;
+      tab.fracmask = mask;
+      tab.pfrac = pfrac;
+      if (LIKELY(offset < nsmps))
+        oscbank_table(&tab, &p->bank, p->nr_osc, p->args[0] + offset,
+                      nsmps - offset);
+      /* save amplitude and phase */
+      for (osc_cnt = 0, o = p->osc; osc_cnt < p->nr_osc; osc_cnt++, o++) {
+        o->osc_amp = p->bank.amp[osc_cnt];
+        o->osc_phs = p->bank.phs[osc_cnt];
+      }
+    }
     p->init_k = 0;
     return OK;
  err1:
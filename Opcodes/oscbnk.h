@@ -25,6 +25,7 @@
 #define CSOUND_OSCBNK_H
 
 #include "stdopcod.h"
+#include "oscbank.h"
 
 /*
 #ifdef  B64BIT
@@ -95,6 +96,8 @@ typedef struct {
         int32    tabl_cnt;               /* current param in table       */
         AUXCH   auxdata;
         OSCBNK_OSC      *osc;           /* oscillator array             */
+        AUXCH   bankdata;
+        OSCBANK bank;                   /* oscillators without EQ       */
 } OSCBNK;
 
 /* grain2 types */
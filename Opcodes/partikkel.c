@@ -40,55 +40,90 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
     if (index > (uint32_t)(to) || index < (uint32_t)(from)) \
         index = (uint32_t)(from);
 
-/* here follows routines for maintaining a linked list of grains */
+/* here follows routines for maintaining the grain store */
 
-/* initialises a linked list of NODEs */
-static void init_pool(GRAINPOOL *s, uint32_t max_grains)
+/* carves the grain store arrays out of mem, which may be NULL to just find
+ * out how much memory is needed. returns the size of the store in bytes */
+static size_t grainstore_layout(GRAINSTORE *s, char *mem, uint32_t max_grains)
 {
-    uint32_t i;
-    NODE **p = &s->grainlist;
-    NODE *grainpool = (NODE *)s->mempool;
-
-    s->free_nodes = max_grains;
-    /* build list of grains in pool */
-    for (i = 0; i < max_grains; ++i) {
-        NODE *node;
-        *p = grainpool + i;
-        node = *p;
-        node->next = NULL;
-        p = &(node->next);
+    size_t used = 0;
+    int32_t i;
+
+#define GS_ARRAY(field, type) \
+    s->field = mem != NULL ? (type *)(mem + used) : NULL; \
+    used += ((size_t)max_grains*sizeof(type) + 15) & ~(size_t)15;
+
+    GS_ARRAY(start, uint32_t);
+    GS_ARRAY(stop, uint32_t);
+    GS_ARRAY(envphase, double);
+    GS_ARRAY(envinc, double);
+    GS_ARRAY(envattacklen, double);
+    GS_ARRAY(envdecaystart, double);
+    GS_ARRAY(env2amount, double);
+    GS_ARRAY(fmamp, MYFLT);
+    GS_ARRAY(fmenvtab, FUNC *);
+    GS_ARRAY(harmonics, uint32_t);
+    GS_ARRAY(falloff, MYFLT);
+    GS_ARRAY(falloff_pow_N, MYFLT);
+    GS_ARRAY(gain1, MYFLT);
+    GS_ARRAY(gain2, MYFLT);
+    GS_ARRAY(chan1, uint32_t);
+    GS_ARRAY(chan2, uint32_t);
+    for (i = 0; i < 5; ++i) {
+        GS_ARRAY(wav[i].table, FUNC *);
+        GS_ARRAY(wav[i].phase, double);
+        GS_ARRAY(wav[i].delta, double);
+        GS_ARRAY(wav[i].sweepoffset, double);
+        GS_ARRAY(wav[i].sweepdecay, double);
+        GS_ARRAY(wav[i].gain, MYFLT);
     }
+#undef GS_ARRAY
+    s->count = 0;
+    s->size = max_grains;
+    return used;
 }
 
-/* returns pointer to new node */
-static NODE *get_grain(GRAINPOOL *s)
+/* copies the grain in slot src to slot dst */
+static void move_grain(GRAINSTORE *s, uint32_t dst, uint32_t src)
 {
-    NODE *ret = s->grainlist;
+    int32_t i;
 
-    if (s->grainlist)
-        s->grainlist = s->grainlist->next;
-    s->free_nodes--;
-    return ret;
+    s->start[dst] = s->start[src];
+    s->stop[dst] = s->stop[src];
+    s->envphase[dst] = s->envphase[src];
+    s->envinc[dst] = s->envinc[src];
+    s->envattacklen[dst] = s->envattacklen[src];
+    s->envdecaystart[dst] = s->envdecaystart[src];
+    s->env2amount[dst] = s->env2amount[src];
+    s->fmamp[dst] = s->fmamp[src];
+    s->fmenvtab[dst] = s->fmenvtab[src];
+    s->harmonics[dst] = s->harmonics[src];
+    s->falloff[dst] = s->falloff[src];
+    s->falloff_pow_N[dst] = s->falloff_pow_N[src];
+    s->gain1[dst] = s->gain1[src];
+    s->gain2[dst] = s->gain2[src];
+    s->chan1[dst] = s->chan1[src];
+    s->chan2[dst] = s->chan2[src];
+    for (i = 0; i < 5; ++i) {
+        WAVESTORE *w = &s->wav[i];
+
+        w->table[dst] = w->table[src];
+        w->phase[dst] = w->phase[src];
+        w->delta[dst] = w->delta[src];
+        w->sweepoffset[dst] = w->sweepoffset[src];
+        w->sweepdecay[dst] = w->sweepdecay[src];
+        w->gain[dst] = w->gain[src];
+    }
 }
 
-/* returns a NODE to the pool. function returns pointer to next node */
-static NODE *return_grain(GRAINPOOL *s, NODE *c)
+/* drop the oldest grain, we use this when we're out of grains */
+static void kill_oldest_grain(GRAINSTORE *s)
 {
-    NODE *oldnext = c->next;
-
-    c->next = s->grainlist;
-    s->grainlist = c;
-    s->free_nodes++;
-    return oldnext;
-}
+    uint32_t g;
 
-/* return oldest grain to the pool, we use this when we're out of grains */
-static void kill_oldest_grain(GRAINPOOL *s, NODE *n)
-{
-    while (n->next->next)
-        n = n->next;
-    return_grain(s, n->next);
-    n->next = NULL;
+    for (g = 1; g < s->count; ++g)
+        move_grain(s, g - 1, g);
+    s->count--;
 }
 
 static int32_t setup_globals(CSOUND *csound, PARTIKKEL *p)
@@ -191,14 +226,13 @@ static inline double intpow_(MYFLT x, uint32_t n)
 }
 
 /* dsf synthesis for trainlets */
-static inline MYFLT dsf(FUNC *tab, GRAIN *grain, double beta, MYFLT zscale,
-                        uint32_t cosineshift)
+static inline MYFLT dsf(FUNC *tab, uint32_t N, MYFLT a, MYFLT a_pow_N,
+                        double beta, MYFLT zscale, uint32_t cosineshift)
 {
     MYFLT numerator, denominator, cos_beta;
     MYFLT lastharmonic, result;
-    uint32_t fbeta, N = grain->harmonics;
-    const MYFLT a = grain->falloff;
-    const MYFLT a_pow_N = grain->falloff_pow_N;
+    uint32_t fbeta;
+
     fbeta = (uint32_t)(beta*(double)UINT_MAX);
 
     cos_beta = lrplookup(tab, fbeta, zscale, cosineshift);
@@ -225,7 +259,6 @@ static int32_t partikkel_init(CSOUND *csound, PARTIKKEL *p)
     if ((ret = setup_globals(csound, p)) != OK)
         return ret;
 
-    p->grainroot = NULL;
     /* set grainphase to 1.0 to make grain scheduler create a grain immediately
      * after starting opcode */
     p->grainphase = 1.0;
@@ -310,15 +343,21 @@ static int32_t partikkel_init(CSOUND *csound, PARTIKKEL *p)
     else
       memset(p->aux.auxp, 0, size);
 
-    /* allocate memory for the grain pool and initialize it*/
+    /* per lane mix and fm envelope buffers for the lockstep renderer */
+    size = 2*PARTIKKEL_LANES*CS_KSMPS*sizeof(MYFLT);
+    if (p->aux3.auxp == NULL || p->aux3.size < size)
+        csound->AuxAlloc(csound, size, &p->aux3);
+    else
+      memset(p->aux3.auxp, 0, size);
+
+    /* allocate memory for the grain store and initialize it */
     if (UNLIKELY(*p->max_grains < FL(1.0)))
         return INITERROR("maximum number of grains needs to be non-zero "
                          "and positive");
-    size = ((uint32_t)*p->max_grains)*sizeof(NODE);
+    size = grainstore_layout(&p->grains, NULL, (uint32_t)*p->max_grains);
     if (p->aux2.auxp == NULL || p->aux2.size < size)
         csound->AuxAlloc(csound, size, &p->aux2);
-    p->gpool.mempool = p->aux2.auxp;
-    init_pool(&p->gpool, (uint32_t)*p->max_grains);
+    grainstore_layout(&p->grains, p->aux2.auxp, (uint32_t)*p->max_grains);
 
     /* find out which of the xrate parameters are arate */
     p->grainfreq_arate = IS_ASIG_ARG(p->grainfreq) ? 1 : 0;
@@ -329,13 +368,15 @@ static int32_t partikkel_init(CSOUND *csound, PARTIKKEL *p)
 
 /* n is sample number for which the grain is to be scheduled
  * offset is time offset for grain in seconds, passed separately for hints */
-static int32_t schedule_grain(CSOUND *csound, PARTIKKEL *p, NODE *node, int32 n,
+static int32_t schedule_grain(CSOUND *csound, PARTIKKEL *p, int32 n,
                           double offset)
 {
-    /* make a new grain */
+    /* make a new grain in the first free slot, it only becomes live if we
+     * get to the end of this function */
     MYFLT startfreqscale, endfreqscale;
     MYFLT maskgain, maskchannel;
-    GRAIN *grain = &node->grain;
+    GRAINSTORE *gs = &p->grains;
+    const uint32_t g = gs->count;
     uint32_t i;
     uint32_t chan;
     MYFLT graingain;
@@ -372,7 +413,7 @@ static int32_t schedule_grain(CSOUND *csound, PARTIKKEL *p, NODE *node, int32 n,
 
     /* get fm modulation index */
     clip_index(p->fmampindex, fmamps[0], fmamps[1]);
-    grain->fmamp = fmamps[p->fmampindex + 2];
+    gs->fmamp[g] = fmamps[p->fmampindex + 2];
     p->fmampindex++;
 
     /* calculate waveform gain table index for later use */
@@ -384,19 +425,17 @@ static int32_t schedule_grain(CSOUND *csound, PARTIKKEL *p, NODE *node, int32 n,
     if ((fabs(graingain) < FL(1e-8)) || (frand() > 1.0 - *p->randommask)) {
         /* grain is either masked out or has a zero amplitude, so we cancel it
          * and proceed with scheduling our next grain */
-        return_grain(&p->gpool, node);
         return OK;
     }
 
-    grain->env2amount = *p->env2_amount;
-    grain->envattacklen = (1.0 - *p->sustain_amount)*(*p->a_d_ratio);
-    grain->envdecaystart = grain->envattacklen + *p->sustain_amount;
-    grain->fmenvtab = p->fmenvtab;
+    gs->env2amount[g] = *p->env2_amount;
+    gs->envattacklen[g] = (1.0 - *p->sustain_amount)*(*p->a_d_ratio);
+    gs->envdecaystart[g] = gs->envattacklen[g] + *p->sustain_amount;
+    gs->fmenvtab[g] = p->fmenvtab;
 
     /* place a grain in between two channels according to channel mask value */
     chan = (uint32_t)maskchannel;
     if (UNLIKELY(chan >= p->num_outputs)) {
-        return_grain(&p->gpool, node);
         return PERFERROR("channel mask specifies non-existing output channel");
     }
     /* use panning law table if specified */
@@ -407,21 +446,20 @@ static int32_t schedule_grain(CSOUND *csound, PARTIKKEL *p, NODE *node, int32 n,
         const uint32_t offset = (uint32_t)((maskchannel - chan)*(tabsize - 1));
         const uint32_t flip_offset = tabsize - 1 - offset;
 
-        grain->gain1 = p->pantab->ftable[tab_offset + flip_offset];
-        grain->gain2 = p->pantab->ftable[tab_offset + offset];
+        gs->gain1[g] = p->pantab->ftable[tab_offset + flip_offset];
+        gs->gain2[g] = p->pantab->ftable[tab_offset + offset];
     } else {
-        grain->gain1 = FL(1.0) - (maskchannel - chan);
-        grain->gain2 = maskchannel - chan;
+        gs->gain1[g] = FL(1.0) - (maskchannel - chan);
+        gs->gain2[g] = maskchannel - chan;
     }
 
-    grain->chan1 = chan;
-    grain->chan2 = p->num_outputs > chan + 1 ? chan + 1 : 0;
+    gs->chan1[g] = chan;
+    gs->chan2[g] = p->num_outputs > chan + 1 ? chan + 1 : 0;
 
     /* duration in samples */
     const double dur_samples = CS_ESR*(*p->duration)/1000.0;
     /* if grainlength is below one sample, we'll just cancel it */
     if (dur_samples < 1.0) {
-        return_grain(&p->gpool, node);
         return OK;
     }
     /* the grain is supposed to start at grainphase = 0, so calculate how far
@@ -434,11 +472,11 @@ static int32_t schedule_grain(CSOUND *csound, PARTIKKEL *p, NODE *node, int32 n,
                             ? p->grainphase/p->graininc
                             : 0.0;
     const double rcp_samples = 1.0/dur_samples;
-    grain->start = (uint32_t)((double)n + offset*CS_ESR + phase_corr);
-    grain->stop = (uint32_t)(grain->start + dur_samples - phase_corr) + 1;
+    gs->start[g] = (uint32_t)((double)n + offset*CS_ESR + phase_corr);
+    gs->stop[g] = (uint32_t)(gs->start[g] + dur_samples - phase_corr) + 1;
     /* set up the four wavetables and dsf to use in the grain */
     for (i = 0; i < 5; ++i) {
-        WAVEDATA *curwav = &grain->wav[i];
+        WAVESTORE *curwav = &gs->wav[i];
         MYFLT freqmult = i != WAV_TRAINLET
                          ? *(*(&p->wavekey1 + i))*(*p->wavfreq)
                          : *p->trainletfreq;
@@ -447,12 +485,12 @@ static int32_t schedule_grain(CSOUND *csound, PARTIKKEL *p, NODE *node, int32 n,
         MYFLT *samplepos = *(&p->samplepos1 + i);
         MYFLT enddelta;
 
-        curwav->table = i != WAV_TRAINLET ? p->wavetabs[i] : p->costab;
-        curwav->gain = wavgains[wavgainsindex + i + 2]*graingain;
+        curwav->table[g] = i != WAV_TRAINLET ? p->wavetabs[i] : p->costab;
+        curwav->gain[g] = wavgains[wavgainsindex + i + 2]*graingain;
 
         /* drop wavetables with close to zero gain */
-        if (fabs(curwav->gain) < FL(1e-8)) {
-            curwav->table = NULL;
+        if (fabs(curwav->gain[g]) < FL(1e-8)) {
+            curwav->table[g] = NULL;
             continue;
         }
 
@@ -467,80 +505,79 @@ static int32_t schedule_grain(CSOUND *csound, PARTIKKEL *p, NODE *node, int32 n,
             nh = 0.5*CS_ESR/fabs(maxfreq);
             if (nh > fabs(*p->harmonics))
                 nh = fabs(*p->harmonics);
-            grain->harmonics = (uint32_t)nh + 1;
-            if (grain->harmonics < 2)
-                grain->harmonics = 2;
-            grain->falloff = *p->falloff;
-            grain->falloff_pow_N = intpow_(grain->falloff, grain->harmonics);
+            gs->harmonics[g] = (uint32_t)nh + 1;
+            if (gs->harmonics[g] < 2)
+                gs->harmonics[g] = 2;
+            gs->falloff[g] = *p->falloff;
+            gs->falloff_pow_N[g] = intpow_(gs->falloff[g], gs->harmonics[g]);
             /* normalize trainlets to uniform peak, using geometric sum */
-            if (FABS(grain->falloff) > FL(0.9999) &&
-                FABS(grain->falloff) < FL(1.0001))
+            if (FABS(gs->falloff[g]) > FL(0.9999) &&
+                FABS(gs->falloff[g]) < FL(1.0001))
                 /* limit case for falloff = 1 */
-                normalize = 1.0/(double)grain->harmonics;
+                normalize = 1.0/(double)gs->harmonics[g];
             else
-                normalize = (1.0 - fabs(grain->falloff))
-                            /(1.0 - fabs(grain->falloff_pow_N));
-            curwav->gain *= normalize;
+                normalize = (1.0 - fabs(gs->falloff[g]))
+                            /(1.0 - fabs(gs->falloff_pow_N[g]));
+            curwav->gain[g] *= normalize;
         }
 
-        curwav->delta = startfreq*csound->onedsr;
+        curwav->delta[g] = startfreq*csound->onedsr;
         enddelta = endfreq*csound->onedsr;
 
         if (i != WAV_TRAINLET) {
             /* set wavphase to samplepos parameter */
-            curwav->phase = samplepos[n];
+            curwav->phase[g] = samplepos[n];
         } else {
             /* set to 0.5 so the dsf pulse doesn't occur at the very start of
              * the grain where it'll probably be enveloped away anyway */
-            curwav->phase = 0.5;
+            curwav->phase[g] = 0.5;
         }
         /* place grain between samples. this is especially important to make
          * high frequency synchronous grain streams sounds right */
-        curwav->phase += phase_corr*startfreq*csound->onedsr;
+        curwav->phase[g] += phase_corr*startfreq*csound->onedsr;
 
         /* clamp phase in case it's out of bounds */
-        curwav->phase = curwav->phase > 1.0 ? 1.0 : curwav->phase;
-        curwav->phase = curwav->phase < 0.0 ? 0.0 : curwav->phase;
+        curwav->phase[g] = curwav->phase[g] > 1.0 ? 1.0 : curwav->phase[g];
+        curwav->phase[g] = curwav->phase[g] < 0.0 ? 0.0 : curwav->phase[g];
         /* phase and delta for wavetable synthesis are scaled by table length */
         if (i != WAV_TRAINLET) {
-            double tablen = (double)curwav->table->flen;
+            double tablen = (double)curwav->table[g]->flen;
 
-            curwav->phase *= tablen;
-            curwav->delta *= tablen;
+            curwav->phase[g] *= tablen;
+            curwav->delta[g] *= tablen;
             enddelta *= tablen;
         }
 
         /* the sweep curve generator is a first order iir filter */
-        if (curwav->delta == enddelta || *p->freqsweepshape == FL(0.5)) {
+        if (curwav->delta[g] == enddelta || *p->freqsweepshape == FL(0.5)) {
             /* special case for linear sweep */
-            curwav->sweepdecay = 1.0;
-            curwav->sweepoffset = (enddelta - curwav->delta)*rcp_samples;
+            curwav->sweepdecay[g] = 1.0;
+            curwav->sweepoffset[g] = (enddelta - curwav->delta[g])*rcp_samples;
         } else {
             /* handle extreme cases the generic code doesn't handle too well */
             if (*p->freqsweepshape < FL(0.001)) {
-                curwav->sweepdecay = 1.0;
-                curwav->sweepoffset = 0.0;
+                curwav->sweepdecay[g] = 1.0;
+                curwav->sweepoffset[g] = 0.0;
             } else if (*p->freqsweepshape > FL(0.999)) {
-                curwav->sweepdecay = 0.0;
-                curwav->sweepoffset = enddelta;
+                curwav->sweepdecay[g] = 0.0;
+                curwav->sweepoffset[g] = enddelta;
             } else {
                 double start_offset, total_decay, t;
 
                 t = fabs((*p->freqsweepshape - 1.0)/(*p->freqsweepshape));
-                curwav->sweepdecay = pow(t, 2.0*rcp_samples);
-                total_decay = t*t; /* pow(curwav->sweepdecay, samples) */
-                start_offset = (enddelta - curwav->delta*total_decay)/
+                curwav->sweepdecay[g] = pow(t, 2.0*rcp_samples);
+                total_decay = t*t; /* pow(curwav->sweepdecay[g], samples) */
+                start_offset = (enddelta - curwav->delta[g]*total_decay)/
                                (1.0 - total_decay);
-                curwav->sweepoffset = start_offset*(1.0 - curwav->sweepdecay);
+                curwav->sweepoffset[g] = start_offset*(1.0 - curwav->sweepdecay[g]);
             }
         }
     }
 
-    grain->envinc = rcp_samples;
-    grain->envphase = phase_corr*grain->envinc;
-    /* link new grain into the list */
-    node->next = p->grainroot;
-    p->grainroot = node;
+    gs->envinc[g] = rcp_samples;
+    gs->envphase[g] = phase_corr*gs->envinc[g];
+    /* grain is live */
+    gs->count++;
     return OK;
 }
 
@@ -550,7 +587,6 @@ static int32_t schedule_grains(CSOUND *csound, PARTIKKEL *p)
     uint32_t koffset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
     uint32_t n, nsmps = CS_KSMPS;
-    NODE *node;
     MYFLT **waveformparams = &p->waveform1;
     MYFLT grainfreq = fabs(*p->grainfreq);
 
@@ -623,20 +659,17 @@ static int32_t schedule_grains(CSOUND *csound, PARTIKKEL *p)
                 offset /= grainfreq;
                 if (offset > 10.0) offset = 10.0;
             }
-            /* check if there are any grains left in the pool */
-            if (!p->gpool.free_nodes) {
+            /* check if there are any free slots left in the store */
+            if (p->grains.count >= p->grains.size) {
                 if (!p->out_of_voices_warning) {
                     WARNING("maximum number of grains reached");
                     p->out_of_voices_warning = 1; /* we only warn once */
                 }
-                kill_oldest_grain(&p->gpool, p->grainroot);
+                kill_oldest_grain(&p->grains);
             }
             /* add a new grain */
-            node = get_grain(&p->gpool);
-            /* check first, in case we'll change the above behaviour of
-             * killing a grain */
-            if (node) {
-                int32_t ret = schedule_grain(csound, p, node, n, offset);
+            {
+                int32_t ret = schedule_grain(csound, p, n, offset);
 
                 if (ret != OK)
                     return ret;
@@ -661,144 +694,271 @@ static int32_t schedule_grains(CSOUND *csound, PARTIKKEL *p)
 /* Main synthesis loops */
 /* NOTE: the main synthesis loop is duplicated for both wavetable and
  * trainlet synthesis for speed */
-static inline void render_wave(PARTIKKEL *p, GRAIN *grain, WAVEDATA *wav,
+static inline void render_wave(PARTIKKEL *p, uint32_t g, WAVESTORE *wav,
                                MYFLT *buf, uint32_t stop)
 {
+    GRAINSTORE *gs = &p->grains;
+    const FUNC *fmenvtab = gs->fmenvtab[g];
+    const double tablen = (double)wav->table[g]->flen;
+    const MYFLT *ftable = wav->table[g]->ftable;
+    double phase = wav->phase[g], delta = wav->delta[g];
     uint32_t n;
-    double fmenvphase = grain->envphase;
+    double fmenvphase = gs->envphase[g];
 
     /* wavetable synthesis */
-    for (n = grain->start; n < stop; ++n) {
-        double tablen = (double)wav->table->flen;
+    for (n = gs->start[g]; n < stop; ++n) {
         uint32_t x0;
         MYFLT frac, fmenv;
 
         /* make sure phase accumulator stays within bounds */
-        while (UNLIKELY(wav->phase >= tablen))
-            wav->phase -= tablen;
-        while (UNLIKELY(wav->phase < 0.0))
-            wav->phase += tablen;
+        while (UNLIKELY(phase >= tablen))
+            phase -= tablen;
+        while (UNLIKELY(phase < 0.0))
+            phase += tablen;
 
         /* sample table lookup with linear interpolation */
-        x0 = (uint32_t)wav->phase;
-        frac = (MYFLT)(wav->phase - x0);
-        buf[n] += lrp(wav->table->ftable[x0], wav->table->ftable[x0 + 1],
-                      frac)*wav->gain;
-
-        fmenv = grain->fmenvtab->ftable[(size_t)(fmenvphase*FMAXLEN)
-                                        >> grain->fmenvtab->lobits];
-        fmenvphase += grain->envinc;
-        wav->phase += wav->delta + wav->delta*p->fm[n]*grain->fmamp*fmenv;
+        x0 = (uint32_t)phase;
+        frac = (MYFLT)(phase - x0);
+        buf[n] += lrp(ftable[x0], ftable[x0 + 1], frac)*wav->gain[g];
+
+        fmenv = fmenvtab->ftable[(size_t)(fmenvphase*FMAXLEN)
+                                 >> fmenvtab->lobits];
+        fmenvphase += gs->envinc[g];
+        phase += delta + delta*p->fm[n]*gs->fmamp[g]*fmenv;
         /* apply sweep */
-        wav->delta = wav->delta*wav->sweepdecay + wav->sweepoffset;
-     }
+        delta = delta*wav->sweepdecay[g] + wav->sweepoffset[g];
+    }
+    wav->phase[g] = phase;
+    wav->delta[g] = delta;
 }
 
-static inline void render_trainlet(PARTIKKEL *p, GRAIN *grain, WAVEDATA *wav,
+static inline void render_trainlet(PARTIKKEL *p, uint32_t g, WAVESTORE *wav,
                                    MYFLT *buf, uint32_t stop)
 {
+    GRAINSTORE *gs = &p->grains;
+    const FUNC *fmenvtab = gs->fmenvtab[g];
+    double phase = wav->phase[g], delta = wav->delta[g];
     uint32_t n;
-    double fmenvphase = grain->envphase;
+    double fmenvphase = gs->envphase[g];
 
     /* trainlet synthesis */
-    for (n = grain->start; n < stop; ++n) {
+    for (n = gs->start[g]; n < stop; ++n) {
         MYFLT fmenv;
 
-        while (UNLIKELY(wav->phase >= 1.0))
-            wav->phase -= 1.0;
-        while (UNLIKELY(wav->phase < 0.0))
-            wav->phase += 1.0;
+        while (UNLIKELY(phase >= 1.0))
+            phase -= 1.0;
+        while (UNLIKELY(phase < 0.0))
+            phase += 1.0;
 
         /* dsf/trainlet synthesis */
-        buf[n] += wav->gain*dsf(p->costab, grain, wav->phase, p->zscale,
-                                p->cosineshift);
-
-        fmenv = grain->fmenvtab->ftable[(size_t)(fmenvphase*FMAXLEN)
-                                        >> grain->fmenvtab->lobits];
-        fmenvphase += grain->envinc;
-        wav->phase += wav->delta + wav->delta*p->fm[n]*grain->fmamp*fmenv;
-        wav->delta = wav->delta*wav->sweepdecay + wav->sweepoffset;
+        buf[n] += wav->gain[g]*dsf(p->costab, gs->harmonics[g],
+                                   gs->falloff[g], gs->falloff_pow_N[g],
+                                   phase, p->zscale, p->cosineshift);
+
+        fmenv = fmenvtab->ftable[(size_t)(fmenvphase*FMAXLEN)
+                                 >> fmenvtab->lobits];
+        fmenvphase += gs->envinc[g];
+        phase += delta + delta*p->fm[n]*gs->fmamp[g]*fmenv;
+        delta = delta*wav->sweepdecay[g] + wav->sweepoffset[g];
     }
+    wav->phase[g] = phase;
+    wav->delta[g] = delta;
 }
 
-/* do the actual waveform synthesis */
-static inline void render_grain(CSOUND *csound, PARTIKKEL *p, GRAIN *grain)
+/* apply the grain envelopes to the mixed waveforms in buf, add the result
+ * to the outputs and clear the part of buf we used */
+static void envelope_grain(PARTIKKEL *p, uint32_t g, MYFLT *buf,
+                           uint32_t stop)
 {
-    IGN(csound);
-    int32_t i;
+    GRAINSTORE *gs = &p->grains;
+    MYFLT *out1 = *(&(p->output1) + gs->chan1[g]);
+    MYFLT *out2 = *(&(p->output1) + gs->chan2[g]);
+    const double envattacklen = gs->envattacklen[g];
+    const double envdecaystart = gs->envdecaystart[g];
+    const double env2amount = gs->env2amount[g];
+    double grainenvphase = gs->envphase[g];
     uint32_t n;
-    MYFLT *out1 = *(&(p->output1) + grain->chan1);
-    MYFLT *out2 = *(&(p->output1) + grain->chan2);
-    uint32_t stop = grain->stop > CS_KSMPS
-                    ? CS_KSMPS : grain->stop;
-    MYFLT *buf = (MYFLT *)p->aux.auxp;
-
-    if (grain->start >= CS_KSMPS)
-        return; /* grain starts at a later kperiod */
-    for (i = 0; i < 5; ++i) {
-        WAVEDATA *curwav = &grain->wav[i];
-
-        /* check if ftable is to be rendered */
-        if (curwav->table == NULL)
-            continue;
-
-        if (i != WAV_TRAINLET)
-            render_wave(p, grain, curwav, buf, stop);
-        else
-            render_trainlet(p, grain, curwav, buf, stop);
-    }
 
-    /* apply envelopes */
-    for (n = grain->start; n < stop; ++n) {
+    for (n = gs->start[g]; n < stop; ++n) {
         MYFLT env, env2, output;
         double envphase;
         FUNC *envtable;
 
         /* apply envelopes */
-        if (grain->envphase < grain->envattacklen) {
+        if (grainenvphase < envattacklen) {
             envtable = p->env_attack_tab;
-            envphase = grain->envphase/grain->envattacklen;
-        } else if (grain->envphase < grain->envdecaystart) {
+            envphase = grainenvphase/envattacklen;
+        } else if (grainenvphase < envdecaystart) {
             /* for sustain, use last sample in attack table */
             envtable = p->env_attack_tab;
             envphase = 1.0;
-        } else if (grain->envphase < 1.0) {
+        } else if (grainenvphase < 1.0) {
             envtable = p->env_decay_tab;
-            envphase = (grain->envphase - grain->envdecaystart)/(1.0 -
-                       grain->envdecaystart);
+            envphase = (grainenvphase - envdecaystart)/(1.0 - envdecaystart);
         } else {
             /* clamp envelope phase because of round-off errors */
-            envtable = grain->envdecaystart < 1.0 ?
+            envtable = envdecaystart < 1.0 ?
                        p->env_decay_tab : p->env_attack_tab;
-            envphase = grain->envphase = 1.0;
+            envphase = grainenvphase = 1.0;
         }
 
         /* fetch envelope values */
         env = envtable->ftable[(size_t)(envphase*FMAXLEN)
                                 >> envtable->lobits];
-        env2 = p->env2_tab->ftable[(size_t)(grain->envphase*FMAXLEN)
+        env2 = p->env2_tab->ftable[(size_t)(grainenvphase*FMAXLEN)
                                    >> p->env2_tab->lobits];
-        env2 = FL(1.0) - grain->env2amount + grain->env2amount*env2;
-        grain->envphase += grain->envinc;
+        env2 = FL(1.0) - env2amount + env2amount*env2;
+        grainenvphase += gs->envinc[g];
         /* generate grain output sample */
         output = buf[n]*env*env2;
         /* now distribute this grain to the output channels it's supposed to
          * end up in, as decided by the channel mask */
-        out1[n] += output*grain->gain1;
-        out2[n] += output*grain->gain2;
+        out1[n] += output*gs->gain1[g];
+        out2[n] += output*gs->gain2[g];
     }
+    gs->envphase[g] = grainenvphase;
     /* now clear the area we just worked in */
-    memset(buf + grain->start, 0, (stop - grain->start)*sizeof(MYFLT));
+    memset(buf + gs->start[g], 0, (stop - gs->start[g])*sizeof(MYFLT));
+}
+
+/* do the actual waveform synthesis for a grain that starts or stops
+ * inside this k-period */
+static void render_grain(PARTIKKEL *p, uint32_t g)
+{
+    GRAINSTORE *gs = &p->grains;
+    int32_t i;
+    uint32_t stop = gs->stop[g] > CS_KSMPS
+                    ? CS_KSMPS : gs->stop[g];
+    MYFLT *buf = (MYFLT *)p->aux.auxp;
+
+    for (i = 0; i < 5; ++i) {
+        WAVESTORE *curwav = &gs->wav[i];
+
+        /* check if ftable is to be rendered */
+        if (curwav->table[g] == NULL)
+            continue;
+
+        if (i != WAV_TRAINLET)
+            render_wave(p, g, curwav, buf, stop);
+        else
+            render_trainlet(p, g, curwav, buf, stop);
+    }
+    envelope_grain(p, g, buf, stop);
+}
+
+/* render a group of up to PARTIKKEL_LANES grains that are active for the
+ * whole k-period, slots[] lists them in the order they are mixed to the
+ * outputs. every (grain, waveform) pair is a voice, and voices are run
+ * PARTIKKEL_LANES at a time in lockstep so their phase and sweep updates,
+ * which each depend on the previous sample, can overlap. results are
+ * identical to render_grain() */
+static void render_grain_group(PARTIKKEL *p, const uint32_t *slots,
+                               uint32_t ngrains)
+{
+    GRAINSTORE *gs = &p->grains;
+    const uint32_t nsmps = CS_KSMPS;
+    MYFLT *bufs = (MYFLT *)p->aux3.auxp;
+    MYFLT *fmenvs = bufs + PARTIKKEL_LANES*nsmps;
+    uint32_t vgrain[PARTIKKEL_LANES*WAV_TRAINLET];
+    uint32_t vwav[PARTIKKEL_LANES*WAV_TRAINLET];
+    uint32_t i, j, k, n, v, nvoices = 0;
+
+    for (j = 0; j < ngrains; ++j) {
+        const uint32_t g = slots[j];
+        const FUNC *fmenvtab = gs->fmenvtab[g];
+        MYFLT *fmenv = fmenvs + j*nsmps;
+        double fmenvphase = gs->envphase[g];
+
+        /* the fm envelope is shared by all waveforms of a grain */
+        for (n = 0; n < nsmps; ++n) {
+            fmenv[n] = fmenvtab->ftable[(size_t)(fmenvphase*FMAXLEN)
+                                        >> fmenvtab->lobits];
+            fmenvphase += gs->envinc[g];
+        }
+        for (i = 0; i < WAV_TRAINLET; ++i) {
+            if (gs->wav[i].table[g] != NULL) {
+                vgrain[nvoices] = j;
+                vwav[nvoices++] = i;
+            }
+        }
+    }
+
+    /* wavetable synthesis */
+    for (v = 0; v < nvoices; v += PARTIKKEL_LANES) {
+        const uint32_t nlanes = nvoices - v < PARTIKKEL_LANES
+                                ? nvoices - v : PARTIKKEL_LANES;
+        double phase[PARTIKKEL_LANES], delta[PARTIKKEL_LANES];
+        double sweepdecay[PARTIKKEL_LANES], sweepoffset[PARTIKKEL_LANES];
+        double tablen[PARTIKKEL_LANES];
+        MYFLT gain[PARTIKKEL_LANES], fmamp[PARTIKKEL_LANES];
+        const MYFLT *ftable[PARTIKKEL_LANES], *fmenv[PARTIKKEL_LANES];
+        MYFLT *buf[PARTIKKEL_LANES];
+
+        for (k = 0; k < nlanes; ++k) {
+            const uint32_t g = slots[vgrain[v + k]];
+            const WAVESTORE *wav = &gs->wav[vwav[v + k]];
+
+            phase[k] = wav->phase[g];
+            delta[k] = wav->delta[g];
+            sweepdecay[k] = wav->sweepdecay[g];
+            sweepoffset[k] = wav->sweepoffset[g];
+            tablen[k] = (double)wav->table[g]->flen;
+            ftable[k] = wav->table[g]->ftable;
+            gain[k] = wav->gain[g];
+            fmamp[k] = gs->fmamp[g];
+            fmenv[k] = fmenvs + vgrain[v + k]*nsmps;
+            buf[k] = bufs + vgrain[v + k]*nsmps;
+        }
+        for (n = 0; n < nsmps; ++n) {
+            const MYFLT fm = p->fm[n];
+
+            for (k = 0; k < nlanes; ++k) {
+                uint32_t x0;
+                MYFLT frac;
+
+                while (UNLIKELY(phase[k] >= tablen[k]))
+                    phase[k] -= tablen[k];
+                while (UNLIKELY(phase[k] < 0.0))
+                    phase[k] += tablen[k];
+
+                x0 = (uint32_t)phase[k];
+                frac = (MYFLT)(phase[k] - x0);
+                buf[k][n] += lrp(ftable[k][x0], ftable[k][x0 + 1],
+                                 frac)*gain[k];
+                phase[k] += delta[k] + delta[k]*fm*fmamp[k]*fmenv[k][n];
+                delta[k] = delta[k]*sweepdecay[k] + sweepoffset[k];
+            }
+        }
+        for (k = 0; k < nlanes; ++k) {
+            const uint32_t g = slots[vgrain[v + k]];
+            WAVESTORE *wav = &gs->wav[vwav[v + k]];
+
+            wav->phase[g] = phase[k];
+            wav->delta[g] = delta[k];
+        }
+    }
+
+    for (j = 0; j < ngrains; ++j) {
+        const uint32_t g = slots[j];
+        MYFLT *buf = bufs + j*nsmps;
+
+        if (gs->wav[WAV_TRAINLET].table[g] != NULL)
+            render_trainlet(p, g, &gs->wav[WAV_TRAINLET], buf, nsmps);
+        envelope_grain(p, g, buf, nsmps);
+    }
 }
 
 static int32_t partikkel(CSOUND *csound, PARTIKKEL *p)
 {
+    GRAINSTORE *gs = &p->grains;
     int32_t ret;
-    uint32_t n;
-    NODE **nodeptr;
+    uint32_t g, n, live, ngroup = 0;
+    uint32_t group[PARTIKKEL_LANES];
+    const uint32_t nsmps = CS_KSMPS;
     MYFLT **outputs = &p->output1;
 
-    if (UNLIKELY(p->aux.auxp == NULL || p->aux2.auxp == NULL))
+    if (UNLIKELY(p->aux.auxp == NULL || p->aux2.auxp == NULL ||
+                 p->aux3.auxp == NULL))
         return PERFERROR("not initialised");
 
     if ((ret = schedule_grains(csound, p)) != OK)
@@ -806,29 +966,46 @@ static int32_t partikkel(CSOUND *csound, PARTIKKEL *p)
 
     /* clear output buffers, we'll be accumulating our outputs */
     for (n = 0; n < p->num_outputs; ++n)
-        memset(outputs[n], 0, sizeof(MYFLT)*CS_KSMPS);
-
-    /* prepare to traverse grain list */
-    nodeptr = &p->grainroot;
-    while (*nodeptr) {
-        GRAIN *grain = &((*nodeptr)->grain);
-
-        /* render current grain to outputs */
-        render_grain(csound, p, grain);
-        /* check if grain is finished */
-        if (grain->stop <= CS_KSMPS) {
-            /* grain is finished, deactivate it */
-            *nodeptr = return_grain(&p->gpool, *nodeptr);
+        memset(outputs[n], 0, sizeof(MYFLT)*nsmps);
+
+    /* render grains newest first. grains that cover the whole k-period are
+     * batched up, any other grain flushes the batch first so the order in
+     * which grains are mixed to the outputs does not change */
+    for (g = gs->count; g-- > 0; ) {
+        if (gs->start[g] >= nsmps)
+            continue; /* grain starts at a later kperiod */
+        if (gs->start[g] == 0 && gs->stop[g] >= nsmps) {
+            group[ngroup++] = g;
+            if (ngroup == PARTIKKEL_LANES) {
+                render_grain_group(p, group, ngroup);
+                ngroup = 0;
+            }
         } else {
-            /* extend grain lifetime with one k-period and find next grain */
-            if (CS_KSMPS > grain->start)
-                grain->start = 0; /* grain is active */
-            else
-                grain->start -= CS_KSMPS; /* grain is not yet active */
-            grain->stop -= CS_KSMPS;
-            nodeptr = &((*nodeptr)->next);
+            if (ngroup) {
+                render_grain_group(p, group, ngroup);
+                ngroup = 0;
+            }
+            render_grain(p, g);
         }
     }
+    if (ngroup)
+        render_grain_group(p, group, ngroup);
+
+    /* drop finished grains, keeping the rest in order of age */
+    for (g = live = 0; g < gs->count; ++g) {
+        if (gs->stop[g] <= nsmps)
+            continue; /* grain is finished, deactivate it */
+        /* extend grain lifetime with one k-period */
+        if (nsmps > gs->start[g])
+            gs->start[g] = 0; /* grain is active */
+        else
+            gs->start[g] -= nsmps; /* grain is not yet active */
+        gs->stop[g] -= nsmps;
+        if (live != g)
+            move_grain(gs, live, g);
+        live++;
+    }
+    gs->count = live;
     return OK;
 }
 
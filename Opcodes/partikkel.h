@@ -21,41 +21,38 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include "csoundCore.h"
 #include "interlocks.h"
 
+/* Grains are kept in a structure-of-arrays store: every field below is
+ * an array with one entry per grain slot.  Slots 0..count-1 are live and
+ * ordered from oldest to newest. */
+
+/* per waveform grain state */
 typedef struct {
-    FUNC *table;
-    double phase, delta;
-    double sweepoffset, sweepdecay;
-    MYFLT gain;
-} WAVEDATA;
+    FUNC **table;               /* NULL when the waveform is silent */
+    double *phase, *delta;
+    double *sweepoffset, *sweepdecay;
+    MYFLT *gain;
+} WAVESTORE;
 
 typedef struct {
-    uint32_t start, stop;
-    double envphase, envinc;
-    double envattacklen, envdecaystart;
-    double env2amount;
-    MYFLT fmamp;
-    FUNC *fmenvtab;
-    uint32_t harmonics;
-    MYFLT falloff, falloff_pow_N;
-    MYFLT gain1, gain2;
-    uint32_t chan1, chan2;
-    WAVEDATA wav[5];
-} GRAIN;
+    uint32_t *start, *stop;
+    double *envphase, *envinc;
+    double *envattacklen, *envdecaystart;
+    double *env2amount;
+    MYFLT *fmamp;
+    FUNC **fmenvtab;
+    uint32_t *harmonics;
+    MYFLT *falloff, *falloff_pow_N;
+    MYFLT *gain1, *gain2;
+    uint32_t *chan1, *chan2;
+    WAVESTORE wav[5];
+    uint32_t count, size;
+} GRAINSTORE;
 
 /* which of the wav[] entries above correspond to the trainlet generator */
 #define WAV_TRAINLET 4
 
-/* support structs for the grain pool routines */
-typedef struct NODE {
-    GRAIN grain;
-    struct NODE *next;
-} NODE;
-
-typedef struct {
-    NODE *grainlist;
-    char *mempool;
-    uint32_t free_nodes;
-} GRAINPOOL;
+/* number of grains rendered side by side by the lockstep renderer */
+#define PARTIKKEL_LANES 8
 
 struct PARTIKKEL;
 
@@ -121,13 +118,12 @@ typedef struct PARTIKKEL {
     /* internal variables */
     PARTIKKEL_GLOBALS *globals;
     PARTIKKEL_GLOBALS_ENTRY *globals_entry;
-    GRAINPOOL gpool;
-    NODE *grainroot;
+    GRAINSTORE grains;
     int32_t out_of_voices_warning;
     uint32_t num_outputs;
     int32_t grainfreq_arate;
     int32_t synced;
-    AUXCH aux, aux2;
+    AUXCH aux, aux2, aux3;
     CsoundRandMTState randstate;
     FUNC *wavetabs[4];
     FUNC *costab;
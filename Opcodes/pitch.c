@@ -617,7 +617,7 @@ int32_t adsyntset(CSOUND *csound, ADSYNT *p)
 {
     FUNC    *ftp;
     uint32_t     count;
-    int32   *lphs;
+    uint32  *lphs;
 
     p->inerr = 0;
 
@@ -660,10 +660,10 @@ int32_t adsyntset(CSOUND *csound, ADSYNT *p)
                     "adsynt: partial count is greater than amptable size!"));
     }
 
-    if (p->lphs.auxp==NULL || p->lphs.size < (size_t)sizeof(int32)*count)
-      csound->AuxAlloc(csound, sizeof(int32)*count, &p->lphs);
+    oscbank_alloc(csound, &p->bank, &p->auxch, count);
+    p->bank.damp = NULL;                /* amplitudes are held over a period */
 
-    lphs = (int32*)p->lphs.auxp;
+    lphs = p->bank.phs;
     if (*p->iphs > 1) {
       do {
         *lphs++ = ((int32) ((MYFLT) ((double) rand_31(csound) / 2147483645.0)
@@ -681,28 +681,25 @@ int32_t adsyntset(CSOUND *csound, ADSYNT *p)
 
 int32_t adsynt(CSOUND *csound, ADSYNT *p)
 {
-    FUNC    *ftp, *freqtp, *amptp;
-    MYFLT   *ar, *ftbl, *freqtbl, *amptbl;
-    MYFLT    amp0, amp, cps0, cps;
-    int32    phs, inc, lobits;
-    int32   *lphs;
+    OSCBANK_TAB tab;
+    MYFLT   *ar, *freqtbl, *amptbl;
+    MYFLT    amp0, cps0;
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
-    uint32_t n, nsmps = CS_KSMPS;
+    uint32_t nsmps = CS_KSMPS;
     int32_t      c, count;
 
     if (UNLIKELY(p->inerr)) {
       return csound->PerfError(csound, &(p->h),
                                Str("adsynt: not initialised"));
     }
-    ftp = p->ftp;
-    ftbl = ftp->ftable;
-    lobits = ftp->lobits;
-    freqtp = p->freqtp;
-    freqtbl = freqtp->ftable;
-    amptp = p->amptp;
-    amptbl = amptp->ftable;
-    lphs = (int32*)p->lphs.auxp;
+    tab.ftable = p->ftp->ftable;
+    tab.phmask = PHMASK;
+    tab.lobits = p->ftp->lobits;
+    tab.fracmask = 0;
+    tab.pfrac = FL(0.0);
+    freqtbl = p->freqtp->ftable;
+    amptbl = p->amptp->ftable;
 
     cps0 = *p->kcps;
     amp0 = *p->kamp;
@@ -711,19 +708,13 @@ int32_t adsynt(CSOUND *csound, ADSYNT *p)
     ar = p->sr;
     memset(ar, 0, nsmps*sizeof(MYFLT));
     if (UNLIKELY(early)) nsmps -= early;
+    if (UNLIKELY(offset >= nsmps)) return OK;
 
     for (c=0; c<count; c++) {
-      amp = amptbl[c] * amp0;
-      cps = freqtbl[c] * cps0;
-      inc = (int32) (cps * csound->sicvt);
-      phs = lphs[c];
-      for (n=offset; n<nsmps; n++) {
-        ar[n] += *(ftbl + (phs >> lobits)) * amp;
-        phs += inc;
-        phs &= PHMASK;
-      }
-      lphs[c] = phs;
+      p->bank.amp[c] = amptbl[c] * amp0;
+      p->bank.inc[c] = (int32) ((freqtbl[c] * cps0) * csound->sicvt);
     }
+    oscbank_table(&tab, &p->bank, count, ar + offset, nsmps - offset);
     return OK;
 }
 
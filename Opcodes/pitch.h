@@ -27,6 +27,7 @@
                         /*                                      PITCH.H */
 #include "spectra.h"
 #include "uggab.h"
+#include "oscbank.h"
 
 typedef struct {
         OPDS    h;
@@ -98,7 +99,8 @@ typedef struct {
     FUNC    *amptp;
     uint32_t     count;
     int32_t     inerr;
-    AUXCH   lphs;
+    AUXCH   auxch;
+    OSCBANK bank;
 } ADSYNT;
 
 typedef struct {
@@ -297,6 +299,10 @@ int32_t macset(CSOUND *, SUM *p);
 int32_t maxalloc(CSOUND *, CPU_PERC *p);
 int32_t mute_inst(CSOUND *, MUTE *p);
 int32_t maxalloc_S(CSOUND *, CPU_PERC *p);
+int32_t pipestage(CSOUND *, CPU_PERC *p);
+int32_t pipestage_S(CSOUND *, CPU_PERC *p);
+int32_t cpuprio(CSOUND *, CPU_PERC *p);
+int32_t cpuprio_S(CSOUND *, CPU_PERC *p);
 int32_t mute_inst_S(CSOUND *, MUTE *p);
 int32_t pfun(CSOUND *, PFUN *p);
 int32_t pfunk_init(CSOUND *, PFUNK *p);
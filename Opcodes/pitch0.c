@@ -183,6 +183,70 @@ int32_t maxalloc_S(CSOUND *csound, CPU_PERC *p)
     return OK;
 }
 
+/* pipeline stage of an instrument under --pipeline (cs_new_dispatch.c) */
+
+static void set_pipestage(CSOUND *csound, int32_t n, MYFLT stage)
+{
+    if (n > 0 && n <= csound->engineState.maxinsno &&
+        csound->engineState.instrtxtp[n] != NULL) {
+      /* If instrument exists */
+      csound->engineState.instrtxtp[n]->pipestage =
+        (stage < FL(0.0) ? 0 : (int32_t) stage + 1);
+      csound->dag_stages_changed = 1;
+      csound->dag_changed++;
+    }
+}
+
+int32_t pipestage(CSOUND *csound, CPU_PERC *p)
+{
+    int32_t n;
+
+    if (csound->ISSTRCOD(*p->instrnum)) {
+      char *ss = get_arg_string(csound,*p->instrnum);
+      n = csound->strarg2insno(csound,ss,1);
+    }
+    else n = *p->instrnum;
+    set_pipestage(csound, n, *p->ipercent);
+    return OK;
+}
+
+int32_t pipestage_S(CSOUND *csound, CPU_PERC *p)
+{
+    int32_t n = csound->strarg2insno(csound, ((STRINGDAT *)p->instrnum)->data, 1);
+    set_pipestage(csound, n, *p->ipercent);
+    return OK;
+}
+
+/* priority of an instrument under --cpu-budget (Engine/cpubudget.c) */
+
+static void set_cpuprio(CSOUND *csound, int32_t n, MYFLT prio)
+{
+    if (n > 0 && n <= csound->engineState.maxinsno &&
+        csound->engineState.instrtxtp[n] != NULL)
+      /* If instrument exists */
+      csound->engineState.instrtxtp[n]->cpuprio = (int32_t) prio;
+}
+
+int32_t cpuprio(CSOUND *csound, CPU_PERC *p)
+{
+    int32_t n;
+
+    if (csound->ISSTRCOD(*p->instrnum)) {
+      char *ss = get_arg_string(csound,*p->instrnum);
+      n = csound->strarg2insno(csound,ss,1);
+    }
+    else n = *p->instrnum;
+    set_cpuprio(csound, n, *p->ipercent);
+    return OK;
+}
+
+int32_t cpuprio_S(CSOUND *csound, CPU_PERC *p)
+{
+    int32_t n = csound->strarg2insno(csound, ((STRINGDAT *)p->instrnum)->data, 1);
+    set_cpuprio(csound, n, *p->ipercent);
+    return OK;
+}
+
 int32_t pfun(CSOUND *csound, PFUN *p)
 {
     int32_t n = (int32_t)MYFLT2LONG(*p->pnum);
@@ -28,6 +28,7 @@
 #include "pvs_ops.h"
 #include "pvsbasic.h"
 #include "pvfileio.h"
+#include "cstrace.h"
 #include <math.h>
 #define MAXOUTS 16
 
@@ -283,11 +284,14 @@ uintptr_t pvs_io_thread(void *pp){
   int32_t  *on = &p->async;
   int32_t lc,n, N2=p->N+2;
   _MM_SET_DENORMALS_ZERO_MODE(_MM_DENORMALS_ZERO_ON);
+  cstrace_thread(TRACE_PVSIO);
   while (*on) {
     lc = csound->ReadCircularBuffer(csound, p->cb, buf, N2);
     if (lc) {
+      TRACE_BEGIN(csound, "pvs_write", -1);
       for (n=0; n < N2; n++) frame[n] = (float) buf[n];
       csound->PVOC_PutFrames(csound, p->pvfile, frame, 1);
+      TRACE_END(csound, "pvs_write", -1);
     }
   }
   return (uintptr_t)0;
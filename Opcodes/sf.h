@@ -125,6 +125,8 @@ struct _SFBANK {
         instrType *instr;
         SHORT *sampleData;
         CHUNKS chunk;
+        void *mapBase;          /* file mapping, or NULL if read in */
+        size_t mapSize;
 } PACKED;
 typedef struct _SFBANK SFBANK;
 
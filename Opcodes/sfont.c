@@ -41,12 +41,23 @@
 #endif
 #include "sfenum.h"
 #include "sfont.h"
+/* On little-endian POSIX hosts the SoundFont is mapped rather than read,
+   so sample pages are only brought in when a note actually uses them */
+#if !defined(WIN32) && !defined(__wasi__) && !defined(WORDS_BIGENDIAN)
+#  define SF_USE_MMAP
+#  include <sys/types.h>
+#  include <sys/stat.h>
+#  include <sys/mman.h>
+#  include <unistd.h>
+#endif
 
 #define s2d(x)  *((DWORD *) (x))
 
 
 
 static int32_t chunk_read(CSOUND *, FILE *f, CHUNK *chunk);
+static int32_t chunk_map(CSOUND *, FILE *f, SFBANK *sf);
+static void bank_prefetch(const SFBANK *sf);
 static void fill_SfPointers(CSOUND *);
 static int32_t  fill_SfStruct(CSOUND *);
 static void layerDefaults(layerType *layer);
@@ -55,6 +66,7 @@ static void splitDefaults(splitType *split);
 #define MAX_SFONT               (10)
 #define MAX_SFPRESET            (16384)
 #define GLOBAL_ATTENUATION      (FL(0.3))
+#define SF_ATTACK_FRAMES        (16384) /* frames prefetched per zone */
 
 #define ONETWELTH               (0.08333333333333333333333333333)
 #define TWOTOTWELTH             (1.05946309435929526456182529495)
@@ -90,6 +102,11 @@ int32_t sfont_ModuleDestroy(CSOUND *csound)
         csound->Free(csound, sfArray[j].instr[l].split);
       }
       csound->Free(csound, sfArray[j].instr);
+#ifdef SF_USE_MMAP
+      if (sfArray[j].mapBase != NULL)
+        munmap(sfArray[j].mapBase, sfArray[j].mapSize);
+      else
+#endif
       csound->Free(csound, sfArray[j].chunk.main_chunk.ckDATA);
     }
     csound->Free(csound, sfArray);
@@ -137,12 +154,16 @@ static int SoundFontLoad(CSOUND *csound, char *fname)
     /* } */
     strNcpy(soundFont->name, csound->GetFileName(fd), 256);
     //soundFont->name[255]='\0';
-    if (UNLIKELY(chunk_read(csound, fil, &soundFont->chunk.main_chunk)<0))
+    soundFont->mapBase = NULL;
+    soundFont->mapSize = 0;
+    if (!chunk_map(csound, fil, soundFont) &&
+        UNLIKELY(chunk_read(csound, fil, &soundFont->chunk.main_chunk)<0))
       csound->Message(csound, Str("sfont: failed to read file\n"));
     csound->FileClose(csound, fd);
     globals->soundFont = soundFont;
     fill_SfPointers(csound);
     fill_SfStruct(csound);
+    bank_prefetch(soundFont);
     return -1;
 }
 
@@ -2095,6 +2116,76 @@ static int32_t chunk_read(CSOUND *csound, FILE *fil, CHUNK *chunk)
     return fread(chunk->ckDATA,1,chunk->ckSize,fil);
 }
 
+/* Map the whole RIFF file instead of copying it into memory.  The
+   metadata chunks are parsed from the mapping as before, while the
+   sample chunk is paged in by the OS on demand (and evicted by it under
+   memory pressure), so banks far larger than RAM can be used.  The
+   mapping is private and writable so that in-place fixups made while
+   parsing never reach the file.  Returns 0 if the caller should fall
+   back to chunk_read(). */
+static int32_t chunk_map(CSOUND *csound, FILE *fil, SFBANK *sf)
+{
+#ifdef SF_USE_MMAP
+    CHUNK *chunk = &sf->chunk.main_chunk;
+    struct stat st;
+    BYTE *map;
+    DWORD size;
+    IGN(csound);
+    if (UNLIKELY(fstat(fileno(fil), &st) != 0 || st.st_size < 12))
+      return 0;
+    map = (BYTE *) mmap(NULL, (size_t) st.st_size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE, fileno(fil), 0);
+    if (UNLIKELY(map == (BYTE *) MAP_FAILED))
+      return 0;
+    memcpy(chunk->ckID, map, 4);
+    memcpy(&size, map + 4, 4);
+    if (size > (DWORD) (st.st_size - 8))   /* truncated file */
+      size = (DWORD) (st.st_size - 8);
+    chunk->ckSize = size;
+    chunk->ckDATA = map + 8;
+    sf->mapBase = map;
+    sf->mapSize = (size_t) st.st_size;
+    return 1;
+#else
+    IGN(csound); IGN(fil); IGN(sf);
+    return 0;
+#endif
+}
+
+/* Ask the OS to start reading the attack portion of every zone of a
+   mapped bank, so that note onsets do not wait on disk reads.  This is
+   done once when the bank is loaded, never from a note's init pass, and
+   is advisory only. */
+static void bank_prefetch(const SFBANK *sf)
+{
+#ifdef SF_USE_MMAP
+    uintptr_t beg, end, pg = (uintptr_t) sysconf(_SC_PAGESIZE);
+    const SHORT *sBase = sf->sampleData;
+    int32_t j, l, k;
+    if (sf->mapBase == NULL || sBase == NULL)
+      return;
+    for (j = 0; j < sf->presets_num; j++) {
+      const presetType *preset = &sf->preset[j];
+      for (l = 0; l < preset->layers_num; l++) {
+        const layerType *layer = &preset->layer[l];
+        for (k = 0; k < layer->splits_num; k++) {
+          const sfSample *sample = layer->split[k].sample;
+          if (sample == NULL || sample->dwEnd <= sample->dwStart)
+            continue;
+          beg = (uintptr_t) (sBase + sample->dwStart);
+          end = (uintptr_t) (sBase + sample->dwEnd);
+          if (end - beg > SF_ATTACK_FRAMES * sizeof(SHORT))
+            end = beg + SF_ATTACK_FRAMES * sizeof(SHORT);
+          beg &= ~(pg - 1);
+          posix_madvise((void *) beg, end - beg, POSIX_MADV_WILLNEED);
+        }
+      }
+    }
+#else
+    IGN(sf);
+#endif
+}
+
 static DWORD dword(char *p)
 {
     union cheat {
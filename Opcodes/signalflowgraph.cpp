@@ -211,6 +211,28 @@ bool operator<(const EventBlock &a, const EventBlock &b) {
 // Identifiers are always "sourcename:outletname" and "sinkname:inletname",
 // or "sourcename:idname:outletname" and "sinkname:inletname."
 
+/**
+ * The sources of one inlet instance. The outlet lists for the outlet ids
+ * connected to the inlet are found once, at init; the outlet instances
+ * in them are resolved into a flat array only when the set of outlet
+ * instances has changed, so performance neither walks the lists nor
+ * takes the ports lock.
+ */
+template <typename T> struct InletSources {
+  std::vector<std::vector<T *> *> outlets;
+  std::vector<T *> instances;
+  long generation;
+  InletSources() : generation(-1) {}
+  void resolve(long generation_) {
+    instances.clear();
+    for (size_t i = 0, n = outlets.size(); i < n; i++) {
+      instances.insert(instances.end(), outlets[i]->begin(),
+                       outlets[i]->end());
+    }
+    generation = generation_;
+  }
+};
+
 struct SignalFlowGraphState {
   CSOUND *csound;
   void *signal_flow_ports_lock;
@@ -227,47 +249,63 @@ struct SignalFlowGraphState {
   std::map<std::string, std::vector<Inletkid *>> kidinletsForSinkInletIds;
   std::map<std::string, std::vector<std::string>> connections;
   std::map<EventBlock, int> functionTablesForEvtblks;
-  std::vector<std::vector<std::vector<Outleta *> *> *> aoutletVectors;
-  std::vector<std::vector<std::vector<Outletk *> *> *> koutletVectors;
-  std::vector<std::vector<std::vector<Outletf *> *> *> foutletVectors;
-  std::vector<std::vector<std::vector<Outletv *> *> *> voutletVectors;
-  std::vector<std::vector<std::vector<Outletkid *> *> *> kidoutletVectors;
+  std::vector<InletSources<Outleta> *> ainletSources;
+  std::vector<InletSources<Outletk> *> kinletSources;
+  std::vector<InletSources<Outletf> *> finletSources;
+  std::vector<InletSources<Outletv> *> vinletSources;
+  std::vector<InletSources<Outletkid> *> kidinletSources;
+  /**
+   * Incremented, under the ports lock, whenever an outlet instance is
+   * created or removed.
+   */
+  volatile long ports_generation;
   SignalFlowGraphState(CSOUND *csound_) {
     csound = csound_;
     signal_flow_ports_lock = csound->Create_Mutex(0);
     signal_flow_ftables_lock = csound->Create_Mutex(0);
+    ports_generation = 0;
   }
   ~SignalFlowGraphState() {}
+  /**
+   * Brings the flat sources of an inlet up to date, taking the ports lock
+   * only if outlet instances have come or gone since they were resolved.
+   * Returns true if they were resolved again.
+   */
+  template <typename T> bool update(InletSources<T> *sources) {
+    if (LIKELY(ATOMIC_GET(ports_generation) == sources->generation)) {
+      return false;
+    }
+    LockGuard guard(csound, signal_flow_ports_lock);
+    sources->resolve(ports_generation);
+    return true;
+  }
+  template <typename T> static void free_sources(std::vector<T *> &sources) {
+    for (size_t i = 0, n = sources.size(); i < n; i++) {
+      delete sources[i];
+    }
+    sources.clear();
+  }
   void clear() {
     LockGuard guard(csound, signal_flow_ports_lock);
 
-    for (std::vector<std::vector<std::vector<Outleta *> *> *>::iterator it = aoutletVectors.begin(), end = aoutletVectors.end(); it != end; it++)
-      delete *it;
-    for (std::vector<std::vector<std::vector<Outletk *> *> *>::iterator it = koutletVectors.begin(), end = koutletVectors.end(); it != end; it++)
-      delete *it;
-    for (std::vector<std::vector<std::vector<Outletf *> *> *>::iterator it = foutletVectors.begin(), end = foutletVectors.end(); it != end; it++)
-      delete *it;
-    for (std::vector<std::vector<std::vector<Outletv *> *> *>::iterator it = voutletVectors.begin(), end = voutletVectors.end(); it != end; it++)
-      delete *it;
-    for (std::vector<std::vector<std::vector<Outletkid *> *> *>::iterator it = kidoutletVectors.begin(), end = kidoutletVectors.end(); it != end; it++)
-      delete *it;
+    free_sources(ainletSources);
+    free_sources(kinletSources);
+    free_sources(finletSources);
+    free_sources(vinletSources);
+    free_sources(kidinletSources);
 
     aoutletsForSourceOutletIds.clear();
     ainletsForSinkInletIds.clear();
-    aoutletVectors.clear();
     koutletsForSourceOutletIds.clear();
     kinletsForSinkInletIds.clear();
-    koutletVectors.clear();
     foutletsForSourceOutletIds.clear();
     voutletsForSourceOutletIds.clear();
     kidoutletsForSourceOutletIds.clear();
     vinletsForSinkInletIds.clear();
     kidinletsForSinkInletIds.clear();
     finletsForSinkInletIds.clear();
-    foutletVectors.clear();
-    voutletVectors.clear();
-    kidoutletVectors.clear();
     connections.clear();
+    ATOMIC_INCR(ports_generation);
   }
 };
 
@@ -303,6 +341,7 @@ struct Outleta : public OpcodeNoteoffBase<Outleta> {
         sfg_globals->aoutletsForSourceOutletIds[sourceOutletId];
     if (std::find(aoutlets.begin(), aoutlets.end(), this) == aoutlets.end()) {
       aoutlets.push_back(this);
+      ATOMIC_INCR(sfg_globals->ports_generation);
       warn(csound, Str("Created instance 0x%x of %d instances of outlet %s\n"),
            this, aoutlets.size(), sourceOutletId);
     }
@@ -316,6 +355,7 @@ struct Outleta : public OpcodeNoteoffBase<Outleta> {
     std::vector<Outleta *>::iterator thisoutlet =
         std::find(aoutlets.begin(), aoutlets.end(), this);
     aoutlets.erase(thisoutlet);
+    ATOMIC_INCR(sfg_globals->ports_generation);
     warn(csound, Str("Removed instance 0x%x of %d instances of outleta %s\n"),
          this, aoutlets.size(), sourceOutletId);
     return OK;
@@ -335,7 +375,7 @@ struct Inleta : public OpcodeBase<Inleta> {
    * State.
    */
   char sinkInletId[0x100];
-  std::vector<std::vector<Outleta *> *> *sourceOutlets;
+  InletSources<Outleta> *sources;
   int sampleN;
   SignalFlowGraphState *sfg_globals;
   int init(CSOUND *csound) {
@@ -343,18 +383,19 @@ struct Inleta : public OpcodeBase<Inleta> {
     LockGuard guard(csound, sfg_globals->signal_flow_ports_lock);
     warn(csound, "BEGAN Inleta::init()...\n");
     sampleN = opds.insdshead->ksmps;
-    warn(csound, "sourceOutlets: 0x%x\n", sourceOutlets);
+    warn(csound, "sources: 0x%x\n", sources);
     // think problem is here
     // should always create
-    if (std::find(sfg_globals->aoutletVectors.begin(),
-                  sfg_globals->aoutletVectors.end(),
-                  sourceOutlets) == sfg_globals->aoutletVectors.end()) {
-      sourceOutlets = new std::vector<std::vector<Outleta *> *>;
-      sfg_globals->aoutletVectors.push_back(sourceOutlets);
+    if (std::find(sfg_globals->ainletSources.begin(),
+                  sfg_globals->ainletSources.end(),
+                  sources) == sfg_globals->ainletSources.end()) {
+      sources = new InletSources<Outleta>;
+      sfg_globals->ainletSources.push_back(sources);
     } else {
-      sourceOutlets->clear();
+      sources->outlets.clear();
     }
-    warn(csound, "sourceOutlets: 0x%x\n", sourceOutlets);
+    sources->generation = -1;
+    warn(csound, "sources: 0x%x\n", sources);
     sinkInletId[0] = 0;
     const char *insname =
         csound->GetInstrumentList(csound)[opds.insdshead->insno]->insname;
@@ -379,9 +420,9 @@ struct Inleta : public OpcodeBase<Inleta> {
       const std::string &sourceOutletId = sourceOutletIds[i];
       std::vector<Outleta *> &aoutlets =
           sfg_globals->aoutletsForSourceOutletIds[sourceOutletId];
-      if (std::find(sourceOutlets->begin(), sourceOutlets->end(), &aoutlets) ==
-          sourceOutlets->end()) {
-        sourceOutlets->push_back(&aoutlets);
+      if (std::find(sources->outlets.begin(), sources->outlets.end(),
+                    &aoutlets) == sources->outlets.end()) {
+        sources->outlets.push_back(&aoutlets);
         warn(csound, Str("Connected instances of outlet %s to instance 0x%x of "
                          "inlet %s.\n"),
              sourceOutletId.c_str(), this, sinkInletId);
@@ -394,30 +435,25 @@ struct Inleta : public OpcodeBase<Inleta> {
    * Sum arate values from active outlets feeding this inlet.
    */
   int audio(CSOUND *csound) {
-    LockGuard guard(csound, sfg_globals->signal_flow_ports_lock);
-    // warn(csound, "BEGAN Inleta::audio()...\n");
+    IGN(csound);
+    sfg_globals->update(sources);
     // Zero the inlet buffer.
     for (int sampleI = 0; sampleI < sampleN; sampleI++) {
       asignal[sampleI] = FL(0.0);
     }
-    // Loop over the source connections...
-    for (size_t sourceI = 0, sourceN = sourceOutlets->size(); sourceI < sourceN;
-         sourceI++) {
-      // Loop over the source connection instances...
-      std::vector<Outleta *> *instances = sourceOutlets->at(sourceI);
-      for (size_t instanceI = 0, instanceN = instances->size();
-           instanceI < instanceN; instanceI++) {
-        Outleta *sourceOutlet = instances->at(instanceI);
-        // Skip inactive instances.
-        if (sourceOutlet->opds.insdshead->actflg) {
-          for (int sampleI = 0, sampleN = ksmps(); sampleI < sampleN;
-               ++sampleI) {
-            asignal[sampleI] += sourceOutlet->asignal[sampleI];
-          }
+    // Loop over the source outlet instances...
+    Outleta *const *instances = sources->instances.data();
+    for (size_t instanceI = 0, instanceN = sources->instances.size();
+         instanceI < instanceN; instanceI++) {
+      const Outleta *sourceOutlet = instances[instanceI];
+      // Skip inactive instances.
+      if (sourceOutlet->opds.insdshead->actflg) {
+        const MYFLT *source = sourceOutlet->asignal;
+        for (int sampleI = 0; sampleI < sampleN; ++sampleI) {
+          asignal[sampleI] += source[sampleI];
         }
       }
     }
-    // warn(csound, "ENDED Inleta::audio().\n");
     return OK;
   }
 };
@@ -448,6 +484,7 @@ struct Outletk : public OpcodeNoteoffBase<Outletk> {
         sfg_globals->koutletsForSourceOutletIds[sourceOutletId];
     if (std::find(koutlets.begin(), koutlets.end(), this) == koutlets.end()) {
       koutlets.push_back(this);
+      ATOMIC_INCR(sfg_globals->ports_generation);
       warn(csound, Str("Created instance 0x%x of %d instances of outlet %s\n"),
            this, koutlets.size(), sourceOutletId);
     }
@@ -460,6 +497,7 @@ struct Outletk : public OpcodeNoteoffBase<Outletk> {
     std::vector<Outletk *>::iterator thisoutlet =
         std::find(koutlets.begin(), koutlets.end(), this);
     koutlets.erase(thisoutlet);
+    ATOMIC_INCR(sfg_globals->ports_generation);
     warn(csound, Str("Removed 0x%x of %d instances of outletk %s\n"), this,
          koutlets.size(), sourceOutletId);
     return OK;
@@ -479,21 +517,22 @@ struct Inletk : public OpcodeBase<Inletk> {
    * State.
    */
   char sinkInletId[0x100];
-  std::vector<std::vector<Outletk *> *> *sourceOutlets;
+  InletSources<Outletk> *sources;
   int ksmps;
   SignalFlowGraphState *sfg_globals;
   int init(CSOUND *csound) {
     QueryGlobalPointer(csound, "sfg_globals", sfg_globals);
     LockGuard guard(csound, sfg_globals->signal_flow_ports_lock);
     ksmps = opds.insdshead->ksmps;
-    if (std::find(sfg_globals->koutletVectors.begin(),
-                  sfg_globals->koutletVectors.end(),
-                  sourceOutlets) == sfg_globals->koutletVectors.end()) {
-      sourceOutlets = new std::vector<std::vector<Outletk *> *>;
-      sfg_globals->koutletVectors.push_back(sourceOutlets);
+    if (std::find(sfg_globals->kinletSources.begin(),
+                  sfg_globals->kinletSources.end(),
+                  sources) == sfg_globals->kinletSources.end()) {
+      sources = new InletSources<Outletk>;
+      sfg_globals->kinletSources.push_back(sources);
     } else {
-      sourceOutlets->clear();
+      sources->outlets.clear();
     }
+    sources->generation = -1;
     sinkInletId[0] = 0;
     const char *insname =
         csound->GetInstrumentList(csound)[opds.insdshead->insno]->insname;
@@ -518,9 +557,9 @@ struct Inletk : public OpcodeBase<Inletk> {
       const std::string &sourceOutletId = sourceOutletIds[i];
       std::vector<Outletk *> &koutlets =
           sfg_globals->koutletsForSourceOutletIds[sourceOutletId];
-      if (std::find(sourceOutlets->begin(), sourceOutlets->end(), &koutlets) ==
-          sourceOutlets->end()) {
-        sourceOutlets->push_back(&koutlets);
+      if (std::find(sources->outlets.begin(), sources->outlets.end(),
+                    &koutlets) == sources->outlets.end()) {
+        sources->outlets.push_back(&koutlets);
         warn(csound, Str("Connected instances of outlet %s to instance 0x%x"
                          "of inlet %s.\n"),
              sourceOutletId.c_str(), this, sinkInletId);
@@ -532,21 +571,18 @@ struct Inletk : public OpcodeBase<Inletk> {
    * Sum krate values from active outlets feeding this inlet.
    */
   int kontrol(CSOUND *csound) {
-    LockGuard guard(csound, sfg_globals->signal_flow_ports_lock);
+    IGN(csound);
+    sfg_globals->update(sources);
     // Zero the inlet buffer.
     *ksignal = FL(0.0);
-    // Loop over the source connections...
-    for (size_t sourceI = 0, sourceN = sourceOutlets->size(); sourceI < sourceN;
-         sourceI++) {
-      // Loop over the source connection instances...
-      const std::vector<Outletk *> *instances = sourceOutlets->at(sourceI);
-      for (size_t instanceI = 0, instanceN = instances->size();
-           instanceI < instanceN; instanceI++) {
-        const Outletk *sourceOutlet = instances->at(instanceI);
-        // Skip inactive instances.
-        if (sourceOutlet->opds.insdshead->actflg) {
-          *ksignal += *sourceOutlet->ksignal;
-        }
+    // Loop over the source outlet instances...
+    Outletk *const *instances = sources->instances.data();
+    for (size_t instanceI = 0, instanceN = sources->instances.size();
+         instanceI < instanceN; instanceI++) {
+      const Outletk *sourceOutlet = instances[instanceI];
+      // Skip inactive instances.
+      if (sourceOutlet->opds.insdshead->actflg) {
+        *ksignal += *sourceOutlet->ksignal;
       }
     }
     return OK;
@@ -579,17 +615,20 @@ struct Outletf : public OpcodeNoteoffBase<Outletf> {
         sfg_globals->foutletsForSourceOutletIds[sourceOutletId];
     if (std::find(foutlets.begin(), foutlets.end(), this) == foutlets.end()) {
       foutlets.push_back(this);
+      ATOMIC_INCR(sfg_globals->ports_generation);
       warn(csound, Str("Created instance 0x%x of outlet %s\n"), this,
            sourceOutletId);
     }
     return OK;
   }
   int noteoff(CSOUND *csound) {
+    LockGuard guard(csound, sfg_globals->signal_flow_ports_lock);
     std::vector<Outletf *> &foutlets =
         sfg_globals->foutletsForSourceOutletIds[sourceOutletId];
     std::vector<Outletf *>::iterator thisoutlet =
         std::find(foutlets.begin(), foutlets.end(), this);
     foutlets.erase(thisoutlet);
+    ATOMIC_INCR(sfg_globals->ports_generation);
     warn(csound, Str("Removed 0x%x of %d instances of outletf %s\n"), this,
          foutlets.size(), sourceOutletId);
     return OK;
@@ -609,7 +648,7 @@ struct Inletf : public OpcodeBase<Inletf> {
    * State.
    */
   char sinkInletId[0x100];
-  std::vector<std::vector<Outletf *> *> *sourceOutlets;
+  InletSources<Outletf> *sources;
   int ksmps;
   int lastframe;
   bool fsignalInitialized;
@@ -620,14 +659,15 @@ struct Inletf : public OpcodeBase<Inletf> {
     ksmps = opds.insdshead->ksmps;
     lastframe = 0;
     fsignalInitialized = false;
-    if (std::find(sfg_globals->foutletVectors.begin(),
-                  sfg_globals->foutletVectors.end(),
-                  sourceOutlets) == sfg_globals->foutletVectors.end()) {
-      sourceOutlets = new std::vector<std::vector<Outletf *> *>;
-      sfg_globals->foutletVectors.push_back(sourceOutlets);
+    if (std::find(sfg_globals->finletSources.begin(),
+                  sfg_globals->finletSources.end(),
+                  sources) == sfg_globals->finletSources.end()) {
+      sources = new InletSources<Outletf>;
+      sfg_globals->finletSources.push_back(sources);
     } else {
-      sourceOutlets->clear();
+      sources->outlets.clear();
     }
+    sources->generation = -1;
     sinkInletId[0] = 0;
     const char *insname =
         csound->GetInstrumentList(csound)[opds.insdshead->insno]->insname;
@@ -652,9 +692,9 @@ struct Inletf : public OpcodeBase<Inletf> {
       const std::string &sourceOutletId = sourceOutletIds[i];
       std::vector<Outletf *> &foutlets =
           sfg_globals->foutletsForSourceOutletIds[sourceOutletId];
-      if (std::find(sourceOutlets->begin(), sourceOutlets->end(), &foutlets) ==
-          sourceOutlets->end()) {
-        sourceOutlets->push_back(&foutlets);
+      if (std::find(sources->outlets.begin(), sources->outlets.end(),
+                    &foutlets) == sources->outlets.end()) {
+        sources->outlets.push_back(&foutlets);
         warn(csound, Str("Connected instances of outlet %s to instance 0x%x of "
                          "inlet %s.\n"),
              sourceOutletId.c_str(), this, sinkInletId);
@@ -666,82 +706,78 @@ struct Inletf : public OpcodeBase<Inletf> {
    * Mix fsig values from active outlets feeding this inlet.
    */
   int audio(CSOUND *csound) {
-    LockGuard guard(csound, sfg_globals->signal_flow_ports_lock);
+    sfg_globals->update(sources);
     int result = OK;
     float *sink = 0;
     float *source = 0;
     CMPLX *sinkFrame = 0;
     CMPLX *sourceFrame = 0;
-    // Loop over the source connections...
-    for (size_t sourceI = 0, sourceN = sourceOutlets->size(); sourceI < sourceN;
-         sourceI++) {
-      // Loop over the source connection instances...
-      const std::vector<Outletf *> *instances = sourceOutlets->at(sourceI);
-      for (size_t instanceI = 0, instanceN = instances->size();
-           instanceI < instanceN; instanceI++) {
-        const Outletf *sourceOutlet = instances->at(instanceI);
-        // Skip inactive instances.
-        if (sourceOutlet->opds.insdshead->actflg) {
-          if (!fsignalInitialized) {
-            int32 N = sourceOutlet->fsignal->N;
-            if (UNLIKELY(sourceOutlet->fsignal == fsignal)) {
-              csound->Warning(csound,
-                              "%s", Str("Unsafe to have same fsig as in and out"));
-            }
-            fsignal->sliding = 0;
-            if (sourceOutlet->fsignal->sliding) {
-              if (fsignal->frame.auxp == 0 ||
-                  fsignal->frame.size <
-                      sizeof(MYFLT) * opds.insdshead->ksmps * (N + 2))
-                csound->AuxAlloc(
-                    csound, (N + 2) * sizeof(MYFLT) * opds.insdshead->ksmps,
-                    &fsignal->frame);
-              fsignal->NB = sourceOutlet->fsignal->NB;
-              fsignal->sliding = 1;
-            } else if (fsignal->frame.auxp == 0 ||
-                       fsignal->frame.size < sizeof(float) * (N + 2)) {
-              csound->AuxAlloc(csound, (N + 2) * sizeof(float),
-                               &fsignal->frame);
-            }
-            fsignal->N = N;
-            fsignal->overlap = sourceOutlet->fsignal->overlap;
-            fsignal->winsize = sourceOutlet->fsignal->winsize;
-            fsignal->wintype = sourceOutlet->fsignal->wintype;
-            fsignal->format = sourceOutlet->fsignal->format;
-            fsignal->framecount = 1;
-            lastframe = 0;
-            if (UNLIKELY(!((fsignal->format == PVS_AMP_FREQ) ||
-                           (fsignal->format == PVS_AMP_PHASE))))
-              result = csound->InitError(csound,
-                                         "%s", Str("inletf: signal format "
-                                             "must be amp-phase or amp-freq."));
-            fsignalInitialized = true;
+    // Loop over the source outlet instances...
+    Outletf *const *instances = sources->instances.data();
+    for (size_t instanceI = 0, instanceN = sources->instances.size();
+         instanceI < instanceN; instanceI++) {
+      const Outletf *sourceOutlet = instances[instanceI];
+      // Skip inactive instances.
+      if (sourceOutlet->opds.insdshead->actflg) {
+        if (!fsignalInitialized) {
+          int32 N = sourceOutlet->fsignal->N;
+          if (UNLIKELY(sourceOutlet->fsignal == fsignal)) {
+            csound->Warning(csound,
+                            "%s", Str("Unsafe to have same fsig as in and out"));
+          }
+          fsignal->sliding = 0;
+          if (sourceOutlet->fsignal->sliding) {
+            if (fsignal->frame.auxp == 0 ||
+                fsignal->frame.size <
+                    sizeof(MYFLT) * opds.insdshead->ksmps * (N + 2))
+              csound->AuxAlloc(
+                  csound, (N + 2) * sizeof(MYFLT) * opds.insdshead->ksmps,
+                  &fsignal->frame);
+            fsignal->NB = sourceOutlet->fsignal->NB;
+            fsignal->sliding = 1;
+          } else if (fsignal->frame.auxp == 0 ||
+                     fsignal->frame.size < sizeof(float) * (N + 2)) {
+            csound->AuxAlloc(csound, (N + 2) * sizeof(float),
+                             &fsignal->frame);
           }
-          if (fsignal->sliding) {
-            for (int frameI = 0; frameI < ksmps; frameI++) {
-              sinkFrame = (CMPLX *)fsignal->frame.auxp + (fsignal->NB * frameI);
-              sourceFrame = (CMPLX *)sourceOutlet->fsignal->frame.auxp +
-                            (fsignal->NB * frameI);
-              for (size_t binI = 0, binN = fsignal->NB; binI < binN; binI++) {
-                if (sourceFrame[binI].re > sinkFrame[binI].re) {
-                  sinkFrame[binI] = sourceFrame[binI];
-                }
+          fsignal->N = N;
+          fsignal->overlap = sourceOutlet->fsignal->overlap;
+          fsignal->winsize = sourceOutlet->fsignal->winsize;
+          fsignal->wintype = sourceOutlet->fsignal->wintype;
+          fsignal->format = sourceOutlet->fsignal->format;
+          fsignal->framecount = 1;
+          lastframe = 0;
+          if (UNLIKELY(!((fsignal->format == PVS_AMP_FREQ) ||
+                         (fsignal->format == PVS_AMP_PHASE))))
+            result = csound->InitError(csound,
+                                       "%s", Str("inletf: signal format "
+                                           "must be amp-phase or amp-freq."));
+          fsignalInitialized = true;
+        }
+        if (fsignal->sliding) {
+          for (int frameI = 0; frameI < ksmps; frameI++) {
+            sinkFrame = (CMPLX *)fsignal->frame.auxp + (fsignal->NB * frameI);
+            sourceFrame = (CMPLX *)sourceOutlet->fsignal->frame.auxp +
+                          (fsignal->NB * frameI);
+            for (size_t binI = 0, binN = fsignal->NB; binI < binN; binI++) {
+              if (sourceFrame[binI].re > sinkFrame[binI].re) {
+                sinkFrame[binI] = sourceFrame[binI];
               }
             }
           }
-        } else {
-          sink = (float *)fsignal->frame.auxp;
-          source = (float *)sourceOutlet->fsignal->frame.auxp;
-          if (lastframe < int(fsignal->framecount)) {
-            for (size_t binI = 0, binN = fsignal->N + 2; binI < binN;
-                 binI += 2) {
-              if (source[binI] > sink[binI]) {
-                source[binI] = sink[binI];
-                source[binI + 1] = sink[binI + 1];
-              }
+        }
+      } else {
+        sink = (float *)fsignal->frame.auxp;
+        source = (float *)sourceOutlet->fsignal->frame.auxp;
+        if (lastframe < int(fsignal->framecount)) {
+          for (size_t binI = 0, binN = fsignal->N + 2; binI < binN;
+               binI += 2) {
+            if (source[binI] > sink[binI]) {
+              source[binI] = sink[binI];
+              source[binI + 1] = sink[binI + 1];
             }
-            fsignal->framecount = lastframe = sourceOutlet->fsignal->framecount;
           }
+          fsignal->framecount = lastframe = sourceOutlet->fsignal->framecount;
         }
       }
     }
@@ -777,6 +813,7 @@ struct Outletv : public OpcodeNoteoffBase<Outletv> {
         sfg_globals->voutletsForSourceOutletIds[sourceOutletId];
     if (std::find(voutlets.begin(), voutlets.end(), this) == voutlets.end()) {
       voutlets.push_back(this);
+      ATOMIC_INCR(sfg_globals->ports_generation);
       warn(csound,
            Str("Created instance 0x%x of %d instances of outlet %s (out "
                "arraydat: 0x%x dims: %2d size: %4d [%4d] data: 0x%x (0x%x))\n"),
@@ -794,6 +831,7 @@ struct Outletv : public OpcodeNoteoffBase<Outletv> {
     std::vector<Outletv *>::iterator thisoutlet =
         std::find(voutlets.begin(), voutlets.end(), this);
     voutlets.erase(thisoutlet);
+    ATOMIC_INCR(sfg_globals->ports_generation);
     warn(csound, Str("Removed 0x%x of %d instances of outletv %s\n"), this,
          voutlets.size(), sourceOutletId);
     return OK;
@@ -813,7 +851,7 @@ struct Inletv : public OpcodeBase<Inletv> {
    * State.
    */
   char sinkInletId[0x100];
-  std::vector<std::vector<Outletv *> *> *sourceOutlets;
+  InletSources<Outletv> *sources;
   size_t arraySize;
   size_t myFltsPerArrayElement;
   int sampleN;
@@ -832,16 +870,17 @@ struct Inletv : public OpcodeBase<Inletv> {
       arraySize *= vsignal->sizes[dimension];
     }
     warn(csound, "arraySize: %d\n", arraySize);
-    warn(csound, "sourceOutlets: 0x%x\n", sourceOutlets);
-    if (std::find(sfg_globals->voutletVectors.begin(),
-                  sfg_globals->voutletVectors.end(),
-                  sourceOutlets) == sfg_globals->voutletVectors.end()) {
-      sourceOutlets = new std::vector<std::vector<Outletv *> *>;
-      sfg_globals->voutletVectors.push_back(sourceOutlets);
+    warn(csound, "sources: 0x%x\n", sources);
+    if (std::find(sfg_globals->vinletSources.begin(),
+                  sfg_globals->vinletSources.end(),
+                  sources) == sfg_globals->vinletSources.end()) {
+      sources = new InletSources<Outletv>;
+      sfg_globals->vinletSources.push_back(sources);
     } else {
-      sourceOutlets->clear();
+      sources->outlets.clear();
     }
-    warn(csound, "sourceOutlets: 0x%x\n", sourceOutlets);
+    sources->generation = -1;
+    warn(csound, "sources: 0x%x\n", sources);
     sinkInletId[0] = 0;
     const char *insname =
         csound->GetInstrumentList(csound)[opds.insdshead->insno]->insname;
@@ -868,9 +907,9 @@ struct Inletv : public OpcodeBase<Inletv> {
       const std::string &sourceOutletId = sourceOutletIds[i];
       std::vector<Outletv *> &voutlets =
           sfg_globals->voutletsForSourceOutletIds[sourceOutletId];
-      if (std::find(sourceOutlets->begin(), sourceOutlets->end(), &voutlets) ==
-          sourceOutlets->end()) {
-        sourceOutlets->push_back(&voutlets);
+      if (std::find(sources->outlets.begin(), sources->outlets.end(),
+                    &voutlets) == sources->outlets.end()) {
+        sources->outlets.push_back(&voutlets);
         warn(csound, Str("Connected instances of outlet %s to instance 0x%x of "
                          "inlet %s\n"),
              sourceOutletId.c_str(), this, sinkInletId);
@@ -883,33 +922,25 @@ struct Inletv : public OpcodeBase<Inletv> {
    * Sum values from active outlets feeding this inlet.
    */
   int audio(CSOUND *csound) {
-    // warn(csound, "BEGAN Inletv::audio()...\n");
-    LockGuard guard(csound, sfg_globals->signal_flow_ports_lock);
+    IGN(csound);
+    sfg_globals->update(sources);
     for (uint32_t signalI = 0; signalI < arraySize; ++signalI) {
       vsignal->data[signalI] = FL(0.0);
     }
-    // Loop over the source connections...
-    for (size_t sourceI = 0, sourceN = sourceOutlets->size(); sourceI < sourceN;
-         sourceI++) {
-      // Loop over the source connection instances...
-      std::vector<Outletv *> *instances = sourceOutlets->at(sourceI);
-      for (size_t instanceI = 0, instanceN = instances->size();
-           instanceI < instanceN; instanceI++) {
-        Outletv *sourceOutlet = instances->at(instanceI);
-        // Skip inactive instances.
-        if (sourceOutlet->opds.insdshead->actflg) {
-          for (uint32_t signalI = 0; signalI < arraySize; ++signalI) {
-            ARRAYDAT *insignal = sourceOutlet->vsignal;
-            MYFLT *indata = insignal->data;
-            // warn(csound, "Inletv::audio: sourceOutlet: 0%x in arraydat: 0x%x
-            // data: 0x%x (0x%x)\n", sourceOutlet, insignal, indata,
-            // &insignal->data);
-            vsignal->data[signalI] += indata[signalI];
-          }
+    // Loop over the source outlet instances...
+    Outletv *const *instances = sources->instances.data();
+    for (size_t instanceI = 0, instanceN = sources->instances.size();
+         instanceI < instanceN; instanceI++) {
+      const Outletv *sourceOutlet = instances[instanceI];
+      // Skip inactive instances.
+      if (sourceOutlet->opds.insdshead->actflg) {
+        MYFLT *outdata = vsignal->data;
+        const MYFLT *indata = sourceOutlet->vsignal->data;
+        for (uint32_t signalI = 0; signalI < arraySize; ++signalI) {
+          outdata[signalI] += indata[signalI];
         }
       }
     }
-    // warn(csound, "ENDED Inletv::audio().\n");
     return OK;
   }
 };
@@ -932,6 +963,7 @@ struct Outletkid : public OpcodeNoteoffBase<Outletkid> {
     LockGuard guard(csound, sfg_globals->signal_flow_ports_lock);
     const char *insname =
         csound->GetInstrumentList(csound)[opds.insdshead->insno]->insname;
+    const char *previousId = instanceId;
     instanceId = csound->strarg2name(csound, (char *)0, SinstanceId->data,
                                      (char *)"", 1);
     if (insname && instanceId) {
@@ -950,8 +982,14 @@ struct Outletkid : public OpcodeNoteoffBase<Outletkid> {
         sfg_globals->kidoutletsForSourceOutletIds[sourceOutletId];
     if (std::find(koutlets.begin(), koutlets.end(), this) == koutlets.end()) {
       koutlets.push_back(this);
+      ATOMIC_INCR(sfg_globals->ports_generation);
       warn(csound, Str("Created instance 0x%x of %d instances of outlet %s\n"),
            this, koutlets.size(), sourceOutletId);
+    } else if (previousId == nullptr ||
+               std::strcmp(previousId, instanceId) != 0) {
+      // Reinitialised with another instance id: the inlets that select
+      // outlet instances by id must select again.
+      ATOMIC_INCR(sfg_globals->ports_generation);
     }
     return OK;
   }
@@ -962,6 +1000,7 @@ struct Outletkid : public OpcodeNoteoffBase<Outletkid> {
     std::vector<Outletkid *>::iterator thisoutlet =
         std::find(koutlets.begin(), koutlets.end(), this);
     koutlets.erase(thisoutlet);
+    ATOMIC_INCR(sfg_globals->ports_generation);
     warn(csound, Str("Removed 0x%x of %d instances of outletkid %s\n"), this,
          koutlets.size(), sourceOutletId);
     return OK;
@@ -983,21 +1022,22 @@ struct Inletkid : public OpcodeBase<Inletkid> {
    */
   char sinkInletId[0x100];
   char *instanceId;
-  std::vector<std::vector<Outletkid *> *> *sourceOutlets;
+  InletSources<Outletkid> *sources;
   int ksmps;
   SignalFlowGraphState *sfg_globals;
   int init(CSOUND *csound) {
     QueryGlobalPointer(csound, "sfg_globals", sfg_globals);
     LockGuard guard(csound, sfg_globals->signal_flow_ports_lock);
     ksmps = opds.insdshead->ksmps;
-    if (std::find(sfg_globals->kidoutletVectors.begin(),
-                  sfg_globals->kidoutletVectors.end(),
-                  sourceOutlets) == sfg_globals->kidoutletVectors.end()) {
-      sourceOutlets = new std::vector<std::vector<Outletkid *> *>;
-      sfg_globals->kidoutletVectors.push_back(sourceOutlets);
+    if (std::find(sfg_globals->kidinletSources.begin(),
+                  sfg_globals->kidinletSources.end(),
+                  sources) == sfg_globals->kidinletSources.end()) {
+      sources = new InletSources<Outletkid>;
+      sfg_globals->kidinletSources.push_back(sources);
     } else {
-      sourceOutlets->clear();
+      sources->outlets.clear();
     }
+    sources->generation = -1;
     sinkInletId[0] = 0;
     instanceId = csound->strarg2name(csound, (char *)0, SinstanceId->data,
                                      (char *)"", 1);
@@ -1024,9 +1064,9 @@ struct Inletkid : public OpcodeBase<Inletkid> {
       const std::string &sourceOutletId = sourceOutletIds[i];
       std::vector<Outletkid *> &koutlets =
           sfg_globals->kidoutletsForSourceOutletIds[sourceOutletId];
-      if (std::find(sourceOutlets->begin(), sourceOutlets->end(), &koutlets) ==
-          sourceOutlets->end()) {
-        sourceOutlets->push_back(&koutlets);
+      if (std::find(sources->outlets.begin(), sources->outlets.end(),
+                    &koutlets) == sources->outlets.end()) {
+        sources->outlets.push_back(&koutlets);
         warn(csound, Str("Connected instances of outlet %s to instance 0x%x of "
                          "inlet %s.\n"),
              sourceOutletId.c_str(), this, sinkInletId);
@@ -1038,24 +1078,30 @@ struct Inletkid : public OpcodeBase<Inletkid> {
    * Replay instance signal.
    */
   int kontrol(CSOUND *csound) {
-    LockGuard guard(csound, sfg_globals->signal_flow_ports_lock);
-    // Zero the / buffer.
-    *ksignal = FL(0.0);
-    // Loop over the source connections...
-    for (size_t sourceI = 0, sourceN = sourceOutlets->size(); sourceI < sourceN;
-         sourceI++) {
-      // Loop over the source connection instances...
-      const std::vector<Outletkid *> *instances = sourceOutlets->at(sourceI);
-      for (size_t instanceI = 0, instanceN = instances->size();
+    IGN(csound);
+    if (sfg_globals->update(sources)) {
+      // Keep only the instances with this instance id.
+      std::vector<Outletkid *> &instances = sources->instances;
+      size_t kept = 0;
+      for (size_t instanceI = 0, instanceN = instances.size();
            instanceI < instanceN; instanceI++) {
-        const Outletkid *sourceOutlet = instances->at(instanceI);
-        // Skip inactive instances and also all non-matching instances.
-        if (sourceOutlet->opds.insdshead->actflg) {
-          if (std::strcmp(sourceOutlet->instanceId, instanceId) == 0) {
-            *ksignal += *sourceOutlet->ksignal;
-          }
+        if (std::strcmp(instances[instanceI]->instanceId, instanceId) == 0) {
+          instances[kept++] = instances[instanceI];
         }
       }
+      instances.resize(kept);
+    }
+    // Zero the / buffer.
+    *ksignal = FL(0.0);
+    // Loop over the matching source outlet instances...
+    Outletkid *const *instances = sources->instances.data();
+    for (size_t instanceI = 0, instanceN = sources->instances.size();
+         instanceI < instanceN; instanceI++) {
+      const Outletkid *sourceOutlet = instances[instanceI];
+      // Skip inactive instances.
+      if (sourceOutlet->opds.insdshead->actflg) {
+        *ksignal += *sourceOutlet->ksignal;
+      }
     }
     return OK;
   }
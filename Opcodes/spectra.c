@@ -1256,7 +1256,7 @@ static OENTRY spectra_localops[] = {
                                 (SUBR)phsbnkset, (SUBR)phsorbnk },
 { "phasorbnk.k", S(PHSORBNK),0,3,"k", "xkio",
                                 (SUBR)phsbnkset, (SUBR)kphsorbnk, NULL},
-{ "adsynt",S(HSBOSC), TR, 3,  "a", "kkiiiio", (SUBR)adsyntset, (SUBR)adsynt },
+{ "adsynt",S(ADSYNT), TR, 3,  "a", "kkiiiio", (SUBR)adsyntset, (SUBR)adsynt },
 { "mpulse", S(IMPULSE), 0, 3,  "a", "kko",
                                     (SUBR)impulse_set, (SUBR)impulse },
 { "lpf18", S(LPF18), 0, 3,  "a", "axxxo",  (SUBR)lpf18set, (SUBR)lpf18db },
@@ -1280,6 +1280,10 @@ static OENTRY spectra_localops[] = {
 { "maxalloc", S(CPU_PERC),0, 1,   "",     "Si",   (SUBR)maxalloc_S, NULL, NULL  },
 { "cpuprc", S(CPU_PERC),0, 1,     "",     "ii",   (SUBR)cpuperc, NULL, NULL   },
 { "maxalloc", S(CPU_PERC),0, 1,   "",     "ii",   (SUBR)maxalloc, NULL, NULL  },
+{ "pipestage", S(CPU_PERC),0, 1,  "",     "Si",   (SUBR)pipestage_S, NULL, NULL },
+{ "pipestage", S(CPU_PERC),0, 1,  "",     "ii",   (SUBR)pipestage, NULL, NULL },
+{ "cpuprio", S(CPU_PERC),0, 1,    "",     "Si",   (SUBR)cpuprio_S, NULL, NULL },
+{ "cpuprio", S(CPU_PERC),0, 1,    "",     "ii",   (SUBR)cpuprio, NULL, NULL },
 { "active", 0xffff                                                          },
 { "active.iS", S(INSTCNT),0,1,    "i",    "Soo",   (SUBR)instcount_S, NULL, NULL },
 { "active.kS", S(INSTCNT),0,2,    "k",    "Soo",   NULL, (SUBR)instcount_S, NULL },
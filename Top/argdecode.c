@@ -25,6 +25,8 @@
 #include "new_opts.h"
 #include "csmodule.h"
 #include "corfile.h"
+#include "cstrace.h"
+#include "cpubudget.h"
 #include <ctype.h>
 
 static void list_audio_devices(CSOUND *csound, int output);
@@ -294,7 +296,26 @@ static const char *longUsageList[] = {
   Str_noop("                          velocity number to pfield N as amplitude"),
   Str_noop("--no-default-paths      turn off relative paths from CSD/ORC/SCO"),
   Str_noop("--sample-accurate       use sample-accurate timing of score events"),
+  Str_noop("--trace=FNAM            record a timeline of the performance and"),
+  Str_noop("                          write it to FNAM as Chrome trace JSON"),
+  Str_noop("--thread-pool[=N]       with -j, take threads from a pool of N"),
+  Str_noop("                          (default one per core) shared by all"),
+  Str_noop("                          instances in the process"),
+  Str_noop("--thread-pool-priority=N  priority of this instance in the pool"),
+  Str_noop("--thread-pool-pin       pin pool threads to cores"),
+  Str_noop("--pipeline=N            with -j, run instruments in up to N+1"),
+  Str_noop("                          pipeline stages, adding up to N blocks"),
+  Str_noop("                          of latency between them (see pipestage)"),
   Str_noop("--realtime              realtime priority mode"),
+  Str_noop("--init-ahead=N          with --realtime, run the init pass of"),
+  Str_noop("                          scheduled events up to N ms before they"),
+  Str_noop("                          start"),
+  Str_noop("--cpu-budget=N          measure the DSP load and keep it under N%"),
+  Str_noop("                          of the k-period, see --cpu-budget-policy"),
+  Str_noop("--cpu-budget-policy=P   when a new voice would go over budget:"),
+  Str_noop("                          refuse (default) it, turn off the oldest"),
+  Str_noop("                          or quietest voices of no higher cpuprio,"),
+  Str_noop("                          or skip the lowest cpuprio instruments"),
   Str_noop("--nchnls=N              override number of audio channels"),
   Str_noop("--nchnls_i=N            override number of input audio channels"),
   Str_noop("--0dbfs=N               override 0dbfs (max positive signal amplitude)"),
@@ -1054,6 +1075,66 @@ static int decode_long(CSOUND *csound, char *s, int argc, char **argv)
       O->noDefaultPaths = 1;
       return 1;
     }
+    else if (!(strncmp(s, "trace=", 6))) {
+      s += 6;
+      if (UNLIKELY(*s == '\0')) dieu(csound, Str("no trace file name"));
+      cstrace_start(csound, s);
+      return 1;
+    }
+    else if (!(strcmp(s, "thread-pool"))) {
+      O->threadPool = -1;
+      return 1;
+    }
+    else if (!(strncmp(s, "thread-pool=", 12))) {
+      s += 12;
+      O->threadPool = atoi(s);
+      if (O->threadPool < 1)
+        O->threadPool = -1;
+      return 1;
+    }
+    else if (!(strncmp(s, "thread-pool-priority=", 21))) {
+      s += 21;
+      O->threadPoolPriority = atoi(s);
+      return 1;
+    }
+    else if (!(strcmp(s, "thread-pool-pin"))) {
+      O->threadPoolPin = 1;
+      return 1;
+    }
+    else if (!(strncmp(s, "pipeline=", 9))) {
+      s += 9;
+      O->pipeline = atoi(s);
+      if (O->pipeline < 0)
+        O->pipeline = 0;
+      return 1;
+    }
+    else if (!(strncmp(s, "init-ahead=", 11))) {
+      s += 11;
+      O->initAhead = atoi(s);
+      if (O->initAhead < 0)
+        O->initAhead = 0;
+      return 1;
+    }
+    else if (!(strncmp(s, "cpu-budget=", 11))) {
+      s += 11;
+      O->cpuBudget = atoi(s);
+      if (O->cpuBudget < 0)
+        O->cpuBudget = 0;
+      return 1;
+    }
+    else if (!(strncmp(s, "cpu-budget-policy=", 18))) {
+      s += 18;
+      if (!strcmp(s, "refuse"))
+        O->cpuBudgetPolicy = CPU_BUDGET_REFUSE;
+      else if (!strcmp(s, "oldest"))
+        O->cpuBudgetPolicy = CPU_BUDGET_OLDEST;
+      else if (!strcmp(s, "quietest"))
+        O->cpuBudgetPolicy = CPU_BUDGET_QUIETEST;
+      else if (!strcmp(s, "skip"))
+        O->cpuBudgetPolicy = CPU_BUDGET_SKIP;
+      else dieu(csound, Str("unknown --cpu-budget-policy %s"), s);
+      return 1;
+    }
     else if (!(strncmp (s, "num-threads=", 12))) {
       s += 12 ;
       O->numThreads = atoi(s);
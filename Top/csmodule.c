@@ -99,6 +99,16 @@
 #endif
 #endif
 
+#if defined(WIN32)
+#include <process.h>
+#define manifest_pid()  ((long) _getpid())
+#elif defined(HAVE_UNISTD_H)
+#include <unistd.h>
+#define manifest_pid()  ((long) getpid())
+#else
+#define manifest_pid()  0L
+#endif
+
 
 #if defined(HAVE_DIRENT_H)
 #  include <dirent.h>
@@ -195,6 +205,7 @@ typedef struct csoundModule_s {
       pluginLibFunc_t   p;                  /* generic plugin interface      */
       opcodeLibFunc_t   o;                  /* opcode library interface      */
     } fn;
+    void        *mfst;                      /* plugin manifest entry         */
     char        name[1];                    /* name of the module            */
 } csoundModule_t;
 
@@ -373,6 +384,20 @@ int csoundLoadAndInitModules(CSOUND *csound, const char *opdir) {
     return 0;
 }
 
+void csoundManifestAddOpcode(CSOUND *csound, const char *name, int existed) {
+}
+
+int csoundLoadDeferredOpcode(CSOUND *csound, const char *opname) {
+    return 0;
+}
+
+void csoundLoadAllDeferredModules(CSOUND *csound) {
+}
+
+uint64_t csoundDeferredOpcodesKey(CSOUND *csound) {
+    return 0;
+}
+
 #else /* __wasi__ */
 
 
@@ -554,6 +579,499 @@ static int _dir_exists(char *path) {
 }
 
 
+/* ------------------------------------------------------------------------ */
+/* Plugin opcode manifest                                                   */
+/*                                                                          */
+/* If the environment variable CS_PLUGIN_MANIFEST names a file, the first   */
+/* run loads every plugin as usual and records which opcodes each library   */
+/* adds. Later runs read the file back and only register the opcode names;  */
+/* a library is opened and initialised when the orchestra first refers to   */
+/* one of its opcodes. Libraries that do anything besides adding opcodes    */
+/* (audio/MIDI modules, utilities, named GENs, configuration or global      */
+/* variables), or that share an opcode name with other code, are always     */
+/* loaded at startup. Entries are checked against the size and time stamp   */
+/* of each library, and the file is rewritten when anything has changed.    */
+/* ------------------------------------------------------------------------ */
+
+static  const   char    *pluginmanifest_envvar = "CS_PLUGIN_MANIFEST";
+static  const   char    *pluginmanifest_magic =  "csound-plugin-manifest";
+#define PLUGINMANIFEST_VERSION  1
+
+typedef struct pluginManifestLib_s {
+    struct pluginManifestLib_s *nxt;
+    int64_t     size;                       /* file size and modification    */
+    int64_t     mtime;                      /*   time when it was recorded   */
+    int         eager;                      /* must be loaded at startup     */
+    int         seen;                       /* found in the plugin path      */
+    int         loaded;                     /* opened in this instance       */
+    int         record;                     /* opcodes are being recorded    */
+    int         nops, maxops;
+    char        **ops;                      /* names of opcodes it adds      */
+    char        path[1];                    /* full path of the library      */
+} pluginManifestLib_t;
+
+typedef struct pluginManifest_s {
+    char                *fname;             /* manifest file name            */
+    pluginManifestLib_t *libs;
+    CS_HASH_TABLE       *owners;            /* opcode name -> libraries      */
+    pluginManifestLib_t *recording;         /* library being recorded        */
+    pluginManifestLib_t *loading;           /* library being replayed        */
+    int                 dirty;              /* file needs to be rewritten    */
+} pluginManifest_t;
+
+typedef struct pluginSideEffects_s {
+    int         globals, cfgvars, utilities, modules;
+    void        *namedgen;
+} pluginSideEffects_t;
+
+extern void add_to_symbtab(CSOUND *csound, OENTRY *ep);
+
+static int manifest_stat(const char *path, int64_t *size, int64_t *mtime)
+{
+    struct stat s;
+    if (stat(path, &s) != 0)
+      return -1;
+    *size = (int64_t) s.st_size;
+    *mtime = (int64_t) s.st_mtime;
+    return 0;
+}
+
+static pluginManifestLib_t *manifest_find_lib(pluginManifest_t *mf,
+                                              const char *path)
+{
+    pluginManifestLib_t *lib;
+    for (lib = mf->libs; lib != NULL; lib = lib->nxt)
+      if (strcmp(lib->path, path) == 0)
+        return lib;
+    return NULL;
+}
+
+static pluginManifestLib_t *manifest_new_lib(CSOUND *csound,
+                                             pluginManifest_t *mf,
+                                             const char *path)
+{
+    pluginManifestLib_t *lib, *p;
+    lib = (pluginManifestLib_t*)
+      csound->Calloc(csound, sizeof(pluginManifestLib_t) + strlen(path));
+    strcpy(&(lib->path[0]), path);
+    /* keep the file in plugin directory order */
+    if (mf->libs == NULL)
+      mf->libs = lib;
+    else {
+      for (p = mf->libs; p->nxt != NULL; p = p->nxt)
+        ;
+      p->nxt = lib;
+    }
+    return lib;
+}
+
+static int manifest_lib_has_op(pluginManifestLib_t *lib, const char *name)
+{
+    int i;
+    for (i = 0; i < lib->nops; i++)
+      if (strcmp(lib->ops[i], name) == 0)
+        return 1;
+    return 0;
+}
+
+static void manifest_lib_add_op(CSOUND *csound, pluginManifestLib_t *lib,
+                                const char *name)
+{
+    if (lib->nops >= lib->maxops) {
+      lib->maxops = (lib->maxops ? lib->maxops * 2 : 32);
+      lib->ops = (char**) csound->ReAlloc(csound, lib->ops,
+                                          sizeof(char*) * lib->maxops);
+    }
+    lib->ops[lib->nops++] = cs_strdup(csound, (char*) name);
+}
+
+static void manifest_set_eager(pluginManifest_t *mf, pluginManifestLib_t *lib)
+{
+    if (!lib->eager) {
+      lib->eager = 1;
+      mf->dirty = 1;
+    }
+}
+
+/* make the opcodes of a library known for lookup by name */
+static void manifest_register_ops(CSOUND *csound, pluginManifest_t *mf,
+                                  pluginManifestLib_t *lib)
+{
+    CONS_CELL *head;
+    int       i;
+    for (i = 0; i < lib->nops; i++) {
+      head = cs_hash_table_get(csound, mf->owners, lib->ops[i]);
+      cs_hash_table_put(csound, mf->owners, lib->ops[i],
+                        cs_cons(csound, lib, head));
+    }
+}
+
+static void manifest_read(CSOUND *csound, pluginManifest_t *mf)
+{
+    FILE                *f;
+    char                line[1200], magic[64];
+    pluginManifestLib_t *lib = NULL;
+    int                 version, myfltSize, apiVersion, apiSubVer;
+    size_t              len;
+
+    if ((f = fopen(mf->fname, "r")) == NULL)
+      return;
+    if (fgets(line, (int) sizeof(line), f) == NULL ||
+        sscanf(line, "%63s %d %d %d.%d", magic, &version, &myfltSize,
+               &apiVersion, &apiSubVer) != 5 ||
+        strcmp(magic, pluginmanifest_magic) != 0 ||
+        version != PLUGINMANIFEST_VERSION ||
+        myfltSize != (int) sizeof(MYFLT) ||
+        apiVersion != CS_APIVERSION || apiSubVer != CS_APISUBVER) {
+      /* unknown or foreign file: rebuild it from scratch */
+      fclose(f);
+      return;
+    }
+    while (fgets(line, (int) sizeof(line), f) != NULL) {
+      len = strlen(line);
+      while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r'))
+        line[--len] = '\0';
+      if (strncmp(line, "library ", 8) == 0) {
+        long long size, mtime;
+        int       eager, n = 0;
+        if (sscanf(line + 8, "%d %lld %lld %n", &eager, &size, &mtime, &n) < 3
+            || n == 0 || line[8 + n] == '\0') {
+          lib = NULL;
+          continue;
+        }
+        lib = manifest_new_lib(csound, mf, line + 8 + n);
+        lib->eager = eager;
+        lib->size = (int64_t) size;
+        lib->mtime = (int64_t) mtime;
+      }
+      else if (strncmp(line, "opcode ", 7) == 0 && lib != NULL &&
+               line[7] != '\0')
+        manifest_lib_add_op(csound, lib, line + 7);
+    }
+    fclose(f);
+}
+
+/* replace the file at 'path' by the one at 'tmp' in one step */
+static int manifest_replace(const char *tmp, const char *path)
+{
+#if defined(WIN32)
+    return (MoveFileExA(tmp, path, MOVEFILE_REPLACE_EXISTING) ? 0 : -1);
+#else
+    return rename(tmp, path);
+#endif
+}
+
+static void manifest_write(CSOUND *csound, pluginManifest_t *mf)
+{
+    FILE                *f;
+    pluginManifestLib_t *lib;
+    char                *tmp;
+    size_t              n;
+    int                 i, err;
+
+    /* written under another name first, so that a Csound starting at the
+       same time never reads half a manifest */
+    n = strlen(mf->fname) + 48;
+    tmp = (char*) csound->Malloc(csound, n);
+    snprintf(tmp, n, "%s.%ld.%p", mf->fname, manifest_pid(), (void*) csound);
+    if ((f = fopen(tmp, "w")) == NULL) {
+      csound->Warning(csound, Str("could not write plugin manifest '%s': %s"),
+                      tmp, strerror(errno));
+      csound->Free(csound, tmp);
+      return;
+    }
+    fprintf(f, "%s %d %d %d.%d\n", pluginmanifest_magic,
+            PLUGINMANIFEST_VERSION, (int) sizeof(MYFLT),
+            CS_APIVERSION, CS_APISUBVER);
+    for (lib = mf->libs; lib != NULL; lib = lib->nxt) {
+      if (!lib->seen)
+        continue;               /* library was removed */
+      fprintf(f, "library %d %lld %lld %s\n", lib->eager,
+              (long long) lib->size, (long long) lib->mtime, lib->path);
+      for (i = 0; i < lib->nops; i++)
+        fprintf(f, "opcode %s\n", lib->ops[i]);
+    }
+    err = (ferror(f) != 0);
+    if (fclose(f) != 0)
+      err = 1;
+    if (err || manifest_replace(tmp, mf->fname) != 0) {
+      csound->Warning(csound, Str("could not write plugin manifest '%s': %s"),
+                      mf->fname, strerror(errno));
+      remove(tmp);
+      csound->Free(csound, tmp);
+      return;
+    }
+    csound->Free(csound, tmp);
+    if (UNLIKELY(csound->oparms->odebug))
+      csound->Message(csound, Str("Plugin manifest written to '%s'\n"),
+                      mf->fname);
+}
+
+static void manifest_snapshot(CSOUND *csound, pluginSideEffects_t *fx)
+{
+    MODULE_INFO **modules =
+      (MODULE_INFO **) csoundQueryGlobalVariable(csound, "_MODULES");
+    char        **utils = csoundListUtilities(csound);
+
+    fx->globals = (csound->namedGlobals ? csound->namedGlobals->count : 0);
+    fx->cfgvars = (csound->cfgVariableDB ? csound->cfgVariableDB->count : 0);
+    fx->utilities = 0;
+    if (utils != NULL) {
+      while (utils[fx->utilities] != NULL)
+        fx->utilities++;
+      csoundDeleteUtilityList(csound, utils);
+    }
+    fx->modules = 0;
+    if (modules != NULL)
+      while (fx->modules < MAX_MODULES && modules[fx->modules] != NULL)
+        fx->modules++;
+    fx->namedgen = csound->namedgen;
+}
+
+/* look up or create the record of the library in 'path' before it is */
+/* loaded; its opcodes are recorded if the library is new or changed    */
+static pluginManifestLib_t *manifest_begin_load(CSOUND *csound,
+                                                const char *path)
+{
+    pluginManifest_t    *mf = (pluginManifest_t*) csound->pluginManifest;
+    pluginManifestLib_t *lib;
+    int64_t             size, mtime;
+
+    if (mf == NULL || manifest_stat(path, &size, &mtime) != 0)
+      return NULL;
+    lib = manifest_find_lib(mf, path);
+    if (lib != NULL && lib->size == size && lib->mtime == mtime) {
+      /* unchanged library that has to be loaded at startup */
+      manifest_register_ops(csound, mf, lib);
+    }
+    else {
+      if (lib == NULL)
+        lib = manifest_new_lib(csound, mf, path);
+      lib->nops = 0;
+      lib->eager = 0;
+      lib->size = size;
+      lib->mtime = mtime;
+      lib->record = 1;
+      mf->dirty = 1;
+    }
+    lib->seen = lib->loaded = 1;
+    return lib;
+}
+
+/* bracket a call into a library so that the opcodes it adds and any */
+/* other registrations can be attributed to it                       */
+static void manifest_enter(CSOUND *csound, pluginManifestLib_t *lib,
+                           pluginSideEffects_t *fx)
+{
+    pluginManifest_t    *mf = (pluginManifest_t*) csound->pluginManifest;
+
+    if (mf == NULL || lib == NULL)
+      return;
+    if (lib->record) {
+      mf->recording = lib;
+      manifest_snapshot(csound, fx);
+    }
+    else
+      mf->loading = lib;
+}
+
+static void manifest_leave(CSOUND *csound, pluginManifestLib_t *lib,
+                           const pluginSideEffects_t *fx)
+{
+    pluginManifest_t    *mf = (pluginManifest_t*) csound->pluginManifest;
+    pluginSideEffects_t fx2;
+
+    if (mf == NULL || lib == NULL)
+      return;
+    if (mf->recording == lib) {
+      manifest_snapshot(csound, &fx2);
+      if (memcmp(fx, &fx2, sizeof(pluginSideEffects_t)) != 0)
+        manifest_set_eager(mf, lib);
+    }
+    mf->recording = mf->loading = NULL;
+}
+
+/* returns non-zero if 'path' can be left unloaded until it is needed */
+static int manifest_defer(CSOUND *csound, const char *path)
+{
+    pluginManifest_t    *mf = (pluginManifest_t*) csound->pluginManifest;
+    pluginManifestLib_t *lib;
+    int64_t             size, mtime;
+
+    if (mf == NULL || (lib = manifest_find_lib(mf, path)) == NULL ||
+        lib->eager || lib->nops == 0 ||
+        manifest_stat(path, &size, &mtime) != 0 ||
+        lib->size != size || lib->mtime != mtime)
+      return 0;
+    lib->seen = 1;
+    manifest_register_ops(csound, mf, lib);
+    return 1;
+}
+
+/* load and initialise a library that was deferred */
+static int manifest_load_lib(CSOUND *csound, pluginManifest_t *mf,
+                             pluginManifestLib_t *lib)
+{
+    CONS_CELL   *head;
+    int         i, err;
+
+    lib->loaded = 1;
+    if (UNLIKELY(csound->oparms->odebug))
+      csoundMessage(csound, Str("Loading '%s' on demand\n"), lib->path);
+    mf->loading = lib;
+    err = csoundLoadAndInitModule(csound, lib->path);
+    mf->loading = NULL;
+    if (UNLIKELY(err != CSOUND_SUCCESS)) {
+      csound->Warning(csound, Str("could not load plugin '%s' listed in "
+                                  "manifest '%s'"), lib->path, mf->fname);
+      return err;
+    }
+    /* csoundLoadAndInitModule() leaves the new module at the list head */
+    ((csoundModule_t*) csound->csmodule_db)->mfst = (void*) lib;
+    /* the parser may already be running: make the new names visible */
+    for (i = 0; i < lib->nops; i++) {
+      head = cs_hash_table_get(csound, csound->opcodes, lib->ops[i]);
+      for ( ; head != NULL; head = head->next)
+        add_to_symbtab(csound, (OENTRY*) head->value);
+    }
+    return CSOUND_SUCCESS;
+}
+
+static void manifest_init(CSOUND *csound)
+{
+    pluginManifest_t    *mf;
+    const char          *fname = getenv(pluginmanifest_envvar);
+
+    if (fname == NULL || fname[0] == '\0')
+      return;
+    mf = (pluginManifest_t*) csound->Calloc(csound, sizeof(pluginManifest_t));
+    mf->fname = cs_strdup(csound, (char*) fname);
+    mf->owners = cs_hash_table_create(csound);
+    manifest_read(csound, mf);
+    csound->pluginManifest = (void*) mf;
+}
+
+/* called after the first csoundInitModules() of this instance */
+static void manifest_finish(CSOUND *csound)
+{
+    pluginManifest_t    *mf = (pluginManifest_t*) csound->pluginManifest;
+    pluginManifestLib_t *lib;
+
+    if (mf == NULL)
+      return;
+    /* libraries found to clash with others while recording */
+    for (lib = mf->libs; lib != NULL; lib = lib->nxt)
+      if (lib->seen && lib->eager && !lib->loaded)
+        manifest_load_lib(csound, mf, lib);
+    for (lib = mf->libs; lib != NULL; lib = lib->nxt)
+      if (!lib->seen)
+        mf->dirty = 1;
+    if (mf->dirty) {
+      manifest_write(csound, mf);
+      mf->dirty = 0;
+    }
+}
+
+/**
+ * Called for every opcode entry appended while a manifest is in use.
+ * Records the opcodes of libraries that are being loaded, and forces
+ * libraries to be loaded at startup when an opcode name is provided by
+ * more than one source (so that no polymorphic variant can be missed).
+ */
+void csoundManifestAddOpcode(CSOUND *csound, const char *name, int existed)
+{
+    pluginManifest_t    *mf = (pluginManifest_t*) csound->pluginManifest;
+    pluginManifestLib_t *self, *lib;
+    CONS_CELL           *head, *p;
+    int                 own;
+
+    self = (mf->recording != NULL ? mf->recording : mf->loading);
+    own = (self != NULL && manifest_lib_has_op(self, name));
+    head = cs_hash_table_get(csound, mf->owners, (char*) name);
+    for (p = head; p != NULL; p = p->next) {
+      lib = (pluginManifestLib_t*) p->value;
+      if (lib == self)
+        continue;
+      manifest_set_eager(mf, lib);
+      if (mf->recording != NULL)
+        manifest_set_eager(mf, mf->recording);
+    }
+    if (mf->recording != NULL && !own) {
+      if (existed)              /* clashes with a built-in opcode */
+        manifest_set_eager(mf, mf->recording);
+      manifest_lib_add_op(csound, mf->recording, name);
+      cs_hash_table_put(csound, mf->owners, (char*) name,
+                        cs_cons(csound, mf->recording, head));
+    }
+}
+
+/**
+ * Load the deferred plugin libraries that provide 'opname', if any.
+ * Returns non-zero if a library was loaded.
+ */
+int csoundLoadDeferredOpcode(CSOUND *csound, const char *opname)
+{
+    pluginManifest_t    *mf = (pluginManifest_t*) csound->pluginManifest;
+    pluginManifestLib_t *lib;
+    CONS_CELL           *head;
+    int                 n = 0;
+
+    if (LIKELY(mf == NULL) || opname == NULL)
+      return 0;
+    head = cs_hash_table_get(csound, mf->owners, (char*) opname);
+    for ( ; head != NULL; head = head->next) {
+      lib = (pluginManifestLib_t*) head->value;
+      if (lib->seen && !lib->loaded &&
+          manifest_load_lib(csound, mf, lib) == CSOUND_SUCCESS)
+        n++;
+    }
+    return n;
+}
+
+/**
+ * Load all plugin libraries that are still deferred, e.g. before
+ * listing the available opcodes.
+ */
+void csoundLoadAllDeferredModules(CSOUND *csound)
+{
+    pluginManifest_t    *mf = (pluginManifest_t*) csound->pluginManifest;
+    pluginManifestLib_t *lib;
+
+    if (LIKELY(mf == NULL))
+      return;
+    for (lib = mf->libs; lib != NULL; lib = lib->nxt)
+      if (lib->seen && !lib->loaded)
+        manifest_load_lib(csound, mf, lib);
+}
+
+/**
+ * Returns a hash of the plugin libraries that are still deferred (their
+ * paths, sizes and modification times), or zero if there are none.
+ * Their opcodes are not in the symbol table yet, but the parser will
+ * find them.
+ */
+uint64_t csoundDeferredOpcodesKey(CSOUND *csound)
+{
+    pluginManifest_t    *mf = (pluginManifest_t*) csound->pluginManifest;
+    pluginManifestLib_t *lib;
+    uint64_t            h = 0, x;
+    const char          *s;
+
+    if (LIKELY(mf == NULL))
+      return 0;
+    for (lib = mf->libs; lib != NULL; lib = lib->nxt) {
+      if (!lib->seen || lib->loaded)
+        continue;
+      x = 14695981039346656037ULL;          /* FNV-1a */
+      for (s = lib->path; *s != '\0'; s++)
+        x = (x ^ (unsigned char) *s) * 1099511628211ULL;
+      x = (x ^ (uint64_t) lib->size) * 1099511628211ULL;
+      x = (x ^ (uint64_t) lib->mtime) * 1099511628211ULL;
+      h += x;
+    }
+    return h;
+}
+
 /**
  * Load plugin libraries for Csound instance 'csound', and call
  * pre-initialisation functions.
@@ -585,6 +1103,8 @@ int csoundLoadModules(CSOUND *csound)
 
     if (UNLIKELY(csound->csmodule_db != NULL))
       return CSOUND_ERROR;
+    /* read the opcode manifest for deferred loading, if there is one */
+    manifest_init(csound);
 
     /* open plugin directory */
     dname = csoundGetEnv(csound, (sizeof(MYFLT) == sizeof(float) ?
@@ -729,10 +1249,24 @@ int csoundLoadModules(CSOUND *csound)
 
       snprintf(buf, 1024, "%s%c%s", dname1, DIRSEP, fname);
 
+      if (manifest_defer(csound, buf)) {
+        if (UNLIKELY(csound->oparms->odebug))
+          csoundMessage(csound, Str("Deferring '%s'\n"), buf);
+        continue;
+      }
       if (UNLIKELY(csound->oparms->odebug)) {
         csoundMessage(csound, Str("Loading '%s'\n"), buf);
        }
-      n = csoundLoadExternal(csound, buf);
+      {
+        pluginSideEffects_t fx;
+        pluginManifestLib_t *lib = manifest_begin_load(csound, buf);
+        void                *prv = csound->csmodule_db;
+        manifest_enter(csound, lib, &fx);
+        n = csoundLoadExternal(csound, buf);
+        manifest_leave(csound, lib, &fx);
+        if (lib != NULL && csound->csmodule_db != prv)
+          ((csoundModule_t*) csound->csmodule_db)->mfst = (void*) lib;
+      }
       if (UNLIKELY(UNLIKELY(n == CSOUND_ERROR)))
         continue;               /* ignore non-plugin files */
       if (UNLIKELY(n < err))
@@ -818,10 +1352,18 @@ int csoundInitModules(CSOUND *csound)
 #endif
     /* call init functions */
     for (m = (csoundModule_t*) csound->csmodule_db; m != NULL; m = m->nxt) {
+      pluginManifestLib_t *lib = (pluginManifestLib_t*) m->mfst;
+      pluginSideEffects_t fx;
+      manifest_enter(csound, lib, &fx);
       i = csoundInitModule(csound, m);
+      manifest_leave(csound, lib, &fx);
+      if (lib != NULL)
+        lib->record = 0;
       if (UNLIKELY(i != CSOUND_SUCCESS && i < retval))
         retval = i;
     }
+    /* write the opcode manifest if it has changed */
+    manifest_finish(csound);
     /* return with error code */
     return retval;
 }
@@ -60,6 +60,8 @@
 #include "lpred.h"
 #include "cs_par_base.h"
 #include "cs_par_orc_semantics.h"
+#include "cstrace.h"
+#include "cpubudget.h"
 #include "namedins.h"
 //#include "cs_par_dispatch.h"
 #include "find_opcode.h"
@@ -195,8 +197,6 @@ static void create_opcode_table(CSOUND *csound)
 
 }
 
-#define MAX_MODULES 64
-
 static void module_list_add(CSOUND *csound, char *drv, char *type){
     MODULE_INFO **modules =
       (MODULE_INFO **) csoundQueryGlobalVariable(csound, "_MODULES");
@@ -536,10 +536,11 @@ static const CSOUND cenviron_ = {
     csoundCepsLP,
     csoundLPrms,
     csoundCreateThread2,
+    csoundSetExternalMidiReadTimedCallback,
     {
       NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
       NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
-      NULL, NULL
+      NULL
     },
     /* ------- private data (not to be used by hosts or externals) ------- */
     /* callback function pointers */
@@ -944,7 +945,11 @@ static const CSOUND cenviron_ = {
       0,             /*    fft_lib */
       0,             /* echo */
       0.0,           /* limiter */
-      DFLT_SR, DFLT_KR  /* defaults */
+      DFLT_SR, DFLT_KR,  /* defaults */
+      0, 0, 0,       /* thread pool */
+      0,             /* pipeline */
+      0,             /* init ahead */
+      0, 0           /* cpu budget, policy */
     },
     {0, 0, {0}}, /* REMOT_BUF */
     NULL,           /* remoteGlobals        */
@@ -1019,7 +1024,33 @@ static const CSOUND cenviron_ = {
     NULL,           /* op */
     0,              /* mode */
     NULL,           /* opcodedir */
-    NULL           /* score_srt */
+    NULL,           /* score_srt */
+    NULL,           /* pluginManifest */
+    NULL,           /* orcCacheRec */
+    NULL,           /* lastExpandedOrc */
+    NULL,           /* orcHistory */
+    0,              /* keepOrcHistory */
+    NULL,           /* threadPoolJob */
+    0,              /* memalloc_count */
+    NULL,           /* trace */
+    NULL,           /* reduce */
+    0,              /* reducing */
+    NULL,           /* dag_task_first */
+    NULL,           /* dag_inst_cost */
+    0,              /* dag_kcount */
+    0,              /* dag_costing */
+    NULL,           /* dag_piped */
+    0,              /* dag_piped_gen */
+    1,              /* dag_stages_changed */
+    NULL,           /* host_out */
+    NULL,           /* host_in */
+    0, 0,           /* host_nout, host_nin */
+    0,              /* host_frames */
+    0,              /* host_pos */
+    NULL,           /* init_ahead */
+    0,              /* actcount */
+    NULL,           /* cpubudget */
+    0               /* ftables_made */
 };
 
 void csound_aops_init_tables(CSOUND *cs);
@@ -1368,6 +1399,69 @@ PUBLIC CSOUND *csoundCreate(void *hostdata)
     return csound;
 }
 
+extern int csoundCompileExpandedOrc(CSOUND *csound, const char *str);
+
+PUBLIC void csoundKeepOrcHistory(CSOUND *csound, int keep)
+{
+    CONS_CELL *orc, *nxt;
+
+    csound->keepOrcHistory = (keep != 0);
+    if (keep)
+      return;
+    for (orc = csound->orcHistory; orc != NULL; orc = nxt) {
+      nxt = orc->next;
+      csound->Free(csound, orc->value);
+      csound->Free(csound, orc);
+    }
+    csound->orcHistory = NULL;
+}
+
+PUBLIC CSOUND *csoundCreateRecompiled(CSOUND *templ, void *hostData)
+{
+    CSOUND        *csound;
+    CSOUND_PARAMS params;
+    CONS_CELL     *orc;
+    FUNC          *src, *dst;
+    MYFLT         *ftable;
+    int           i;
+
+    if (UNLIKELY(templ == NULL || templ->orcHistory == NULL))
+      return NULL;
+    csound = csoundCreate(hostData);
+    if (UNLIKELY(csound == NULL))
+      return NULL;
+    csoundGetParams(templ, &params);
+    csoundSetParams(csound, &params);
+    csound->keepOrcHistory = templ->keepOrcHistory;
+    /* file names referred to by #source lines of the preprocessed code */
+    for (i = 0; i < 255 && templ->filedir[i] != NULL; i++)
+      csound->filedir[i] = cs_strdup(csound, templ->filedir[i]);
+    csound->filedir[i] = NULL;
+    for (orc = templ->orcHistory; orc != NULL; orc = orc->next) {
+      if (UNLIKELY(csoundCompileExpandedOrc(csound, (char*) orc->value)
+                   != CSOUND_SUCCESS)) {
+        csoundDestroy(csound);
+        return NULL;
+      }
+    }
+    /* copy the function tables instead of running the GENs again */
+    for (i = 1; i <= templ->maxfnum; i++) {
+      src = templ->flist[i];
+      if (src == NULL || src->ftable == NULL || src->flen == 0)
+        continue;
+      if (UNLIKELY(csoundFTAlloc(csound, i, (int) src->flen) != 0)) {
+        csoundDestroy(csound);
+        return NULL;
+      }
+      dst = csound->flist[i];
+      ftable = dst->ftable;
+      memcpy(dst, src, sizeof(FUNC));
+      dst->ftable = ftable;
+      memcpy(ftable, src->ftable, sizeof(MYFLT) * (src->flen + 1));
+    }
+    return csound;
+}
+
   /* dummy real time MIDI functions */
 int DummyMidiInOpen(CSOUND *csound, void **userData,
                            const char *devName);
@@ -1534,6 +1628,7 @@ int dag_get_task(CSOUND *csound, int index, int numThreads, int next_task);
 int dag_end_task(CSOUND *csound, int task);
 void dag_build(CSOUND *csound, INSDS *chain);
 void dag_reinit(CSOUND *csound);
+void dag_cost_end(CSOUND *csound);
 
 #ifdef PARCS
 inline static int nodePerf(CSOUND *csound, int index, int numThreads)
@@ -1546,8 +1641,9 @@ inline static int nodePerf(CSOUND *csound, int index, int numThreads)
     double time_end;
 #define INVALID (-1)
 #define WAIT    (-2)
-    int next_task = INVALID;
-    IGN(index);
+    int next_task = INVALID, k;
+    /* this thread mixes into a spout of its own (cs_par_reduce.c) */
+    MYFLT *spout = csp_reduce_thread(csound, index);
 
     while (1) {
       int done;
@@ -1555,9 +1651,13 @@ inline static int nodePerf(CSOUND *csound, int index, int numThreads)
       //printf("******** Select task %d\n", which_task);
       if (which_task==WAIT) continue;
       if (which_task==INVALID) return played_count;
-         /* VL: the validity of icurTime needs to be checked */
+      /* a task is a run of instances (see dag_build) */
+      for (k = csound->dag_task_first[which_task];
+           k < csound->dag_task_first[which_task+1]; k++) {
+        double t0 = 0.0;
+        /* VL: the validity of icurTime needs to be checked */
         time_end = (csound->ksmps+csound->icurTime)/csound->esr;
-        insds = task_map[which_task];
+        insds = task_map[k];
         if (insds->offtim > 0 && time_end > insds->offtim){
             /* this is the last cycle of performance */
             insds->ksmps_no_end = insds->no_end;
@@ -1569,11 +1669,18 @@ inline static int nodePerf(CSOUND *csound, int index, int numThreads)
 #else
         done = insds->init_done;
 #endif
-        if (done) {
-          opstart = (OPDS*)task_map[which_task];
+        if (done && !CPUBUDGET_SKIP(csound, insds)) {
+          TRACE_BEGIN(csound, cstrace_instr, insds->insno);
+          csp_reduce_task(csound, insds->insno);
+          if (UNLIKELY(csound->dag_costing)) {
+            if (csound->cpubudget != NULL)
+              cpubudget_level_begin(csound, index, spout);
+            t0 = csoundGetRealTime(csound->csRtClock);
+          }
+          opstart = (OPDS*)insds;
           if (insds->ksmps == csound->ksmps) {
             insds->spin = csound->spin;
-            insds->spout = csound->spraw;
+            insds->spout = spout;
             insds->kcounter =  csound->kcounter;
             csound->mode = 2;
             while ((opstart = opstart->nxtp) != NULL) {
@@ -1592,7 +1699,7 @@ inline static int nodePerf(CSOUND *csound, int index, int numThreads)
             int early = insds->ksmps_no_end;
             OPDS  *opstart;
             insds->spin = csound->spin;
-            insds->spout = csound->spraw;
+            insds->spout = spout;
             insds->kcounter =  csound->kcounter*csound->ksmps;
 
             /* we have to deal with sample-accurate code
@@ -1624,9 +1731,17 @@ inline static int nodePerf(CSOUND *csound, int index, int numThreads)
           }
           insds->ksmps_offset = 0; /* reset sample-accuracy offset */
           insds->ksmps_no_end = 0;  /* reset end of loop samples */
+          if (UNLIKELY(csound->dag_costing)) {
+            csound->dag_inst_cost[k] =
+              csoundGetRealTime(csound->csRtClock) - t0;
+            if (csound->cpubudget != NULL)
+              cpubudget_level_end(csound, insds, index, spout);
+          }
           played_count++;
+          TRACE_END(csound, cstrace_instr, insds->insno);
         }
-        //printf("******** finished task %d\n", which_task);
+      }
+      //printf("******** finished task %d\n", which_task);
         next_task = dag_end_task(csound, which_task);
     }
     return played_count;
@@ -1665,6 +1780,69 @@ inline static void make_interleave(CSOUND *csound, uint32_t lksmps)
     }
 }
 
+/* copy the k-period's output from spraw to the host's planar buffers */
+
+inline static void make_planar(CSOUND *csound, uint32_t lksmps)
+{
+    uint32_t nsmps = csound->ksmps, nchan = csound->nchnls, i, n;
+    MYFLT    *out;
+
+    for (i = 0; i < nchan; i++) {
+      if ((out = csound->host_out[i]) == NULL)
+        continue;
+      out += csound->host_pos;
+      if (!csound->spoutactive)
+        memset(out, '\0', nsmps*sizeof(MYFLT));
+      else if (lksmps == nsmps || nchan == 1)
+        memcpy(out, &csound->spraw[i*nsmps], nsmps*sizeof(MYFLT));
+      else
+        for (n = 0; n < nsmps/lksmps; n++)
+          memcpy(out + n*lksmps, &csound->spraw[(n*nchan + i)*lksmps],
+                 lksmps*sizeof(MYFLT));
+    }
+}
+
+/* interleave the k-period's input from the host's planar buffers */
+
+inline static void read_planar(CSOUND *csound)
+{
+    uint32_t nsmps = csound->ksmps, nchan = csound->inchnls, i, j;
+    const MYFLT *in;
+    MYFLT    *spin = csound->spin;
+
+    for (i = 0; i < nchan; i++) {
+      if ((in = csound->host_in[i]) == NULL) {
+        for (j = 0; j < nsmps; j++)
+          spin[j*nchan + i] = FL(0.0);
+        continue;
+      }
+      in += csound->host_pos;
+      for (j = 0; j < nsmps; j++)
+        spin[j*nchan + i] = in[j];
+    }
+}
+
+/* Does this k-period's output go to the host's planar buffers only?
+   spout is then neither filled nor sent to spoutran.  Remote audio
+   still needs it. */
+
+inline static int host_planar_out(CSOUND *csound)
+{
+    return (csound->host_frames > 0 && csound->host_nout > 0 &&
+            csound->remoteGlobals == NULL);
+}
+
+/* the k-period is done: on to the next ksmps frames of the host buffers,
+   which are released at the end of the block */
+
+inline static void host_planar_end(CSOUND *csound, uint32_t lksmps)
+{
+    if (csound->host_nout > 0)
+      make_planar(csound, lksmps);
+    if ((csound->host_pos += csound->ksmps) >= csound->host_frames)
+      csound->host_frames = csound->host_pos = 0;
+}
+
 #ifdef PARCS
 unsigned long kperfThread(void * cs)
 {
@@ -1692,6 +1870,7 @@ unsigned long kperfThread(void * cs)
       return ULONG_MAX;
     }
     index++;
+    cstrace_thread(TRACE_WORKER + index - 1);
 
     while (1) {
 
@@ -1713,12 +1892,19 @@ unsigned long kperfThread(void * cs)
       csound->WaitBarrier(csound->barrier2);
     }
 }
+
+/* run by the performance thread and shared pool threads (--thread-pool) */
+int kperfPoolTask(CSOUND *csound, int index, int numThreads)
+{
+    return nodePerf(csound, index, numThreads);
+}
 #endif
 
 int kperf_nodebug(CSOUND *csound)
 {
     INSDS *ip;
-    int lksmps = csound->ksmps;
+    int lksmps = csound->ksmps, planar, costing = 0;
+    double kstart = 0.0;
     /* update orchestra time */
     csound->kcounter = ++(csound->global_kcounter);
     csound->icurTime += csound->ksmps;
@@ -1736,37 +1922,54 @@ int kperf_nodebug(CSOUND *csound)
     /* if i-time only, return now */
     if (UNLIKELY(csound->initonly))
       return 1;
+    TRACE_BEGIN(csound, "kperf", -1);
     /* PC GUI needs attention, but avoid excessively frequent */
     /* calls of csoundYield() */
     if (UNLIKELY(--(csound->evt_poll_cnt) < 0)) {
       csound->evt_poll_cnt = csound->evt_poll_maxcnt;
       if (UNLIKELY(!csoundYield(csound))) csound->LongJmp(csound, 1);
     }
+    if (UNLIKELY(csound->cpubudget != NULL)) {
+      kstart = cpubudget_settle(csound);  /* --cpu-budget */
+      costing = cpubudget_costing(csound);
+    }
 
     /* for one kcnt: */
-    if (csound->oparms_.sfread)         /*   if audio_infile open  */
+    planar = host_planar_out(csound);
+    if (csound->host_frames > 0 && csound->host_nin > 0)
+      read_planar(csound);              /*   host's planar input   */
+    else if (csound->oparms_.sfread)    /*   if audio_infile open  */
       csound->spinrecv(csound);         /*      fill the spin buf  */
     csound->spoutactive = 0;            /*   make spout inactive   */
     /* clear spout */
-    memset(csound->spout, 0, csound->nspout*sizeof(MYFLT));
+    if (!planar)
+      memset(csound->spout, 0, csound->nspout*sizeof(MYFLT));
     memset(csound->spraw, 0, csound->nspout*sizeof(MYFLT));
     ip = csound->actanchor.nxtact;
 
     if (ip != NULL) {
       /* There are 2 partitions of work: 1st by inso,
          2nd by inso count / thread count. */
-      if (csound->multiThreadedThreadInfo != NULL) {
+      if (csound->multiThreadedThreadInfo != NULL ||
+          csound->threadPoolJob != NULL) {
 #ifdef PARCS
         if (csound->dag_changed) dag_build(csound, ip);
         else dag_reinit(csound);     /* set to initial state */
 
-        /* process this partition */
-        csound->WaitBarrier(csound->barrier1);
+        csp_reduce_begin(csound);
+        if (csound->threadPoolJob != NULL)
+          csp_pool_perform(csound);
+        else {
+          /* process this partition */
+          csound->WaitBarrier(csound->barrier1);
 
-        (void) nodePerf(csound, 0, 1);
+          (void) nodePerf(csound, 0, 1);
 
-        /* wait until partition is complete */
-        csound->WaitBarrier(csound->barrier2);
+          /* wait until partition is complete */
+          csound->WaitBarrier(csound->barrier2);
+        }
+        csp_reduce_end(csound);
+        dag_cost_end(csound);
 #endif
         csound->multiThreadedDag = NULL;
       }
@@ -1786,9 +1989,14 @@ int kperf_nodebug(CSOUND *csound)
             ip->ksmps_no_end = ip->no_end;
           }
           done = ATOMIC_GET(ip->init_done);
-          if (done == 1) {/* if init-pass has been done */
+          if (done == 1 && /* if init-pass has been done */
+              !CPUBUDGET_SKIP(csound, ip)) {
             int error = 0;
+            double t0 = 0.0;
             OPDS  *opstart = (OPDS*) ip;
+            TRACE_BEGIN(csound, cstrace_instr, ip->insno);
+            if (UNLIKELY(costing))
+              t0 = cpubudget_inst_begin(csound);
             ip->spin = csound->spin;
             ip->spout = csound->spraw;
             ip->kcounter =  csound->kcounter;
@@ -1846,6 +2054,9 @@ int kperf_nodebug(CSOUND *csound)
 
                 }
             }
+            if (UNLIKELY(costing))
+              cpubudget_inst_end(csound, ip, t0);
+            TRACE_END(csound, cstrace_instr, ip->insno);
           }
           /*else csound->Message(csound, "time %f\n",
                                  csound->kcounter/csound->ekr);*/
@@ -1865,12 +2076,23 @@ int kperf_nodebug(CSOUND *csound)
         }
       }
     }
+    if (UNLIKELY(csound->cpubudget != NULL))
+      cpubudget_kcycle(csound, kstart);
 
+    if (planar) {               /* straight to the host's buffers */
+      host_planar_end(csound, lksmps);
+      TRACE_END(csound, "kperf", -1);
+      return 0;
+    }
     if (!csound->spoutactive) { /* results now in spout? */
       memset(csound->spout, 0, csound->nspout * sizeof(MYFLT));
       memset(csound->spraw, 0, csound->nspout * sizeof(MYFLT));
     }
     make_interleave(csound, lksmps);
+    if (csound->host_frames > 0)
+      host_planar_end(csound, lksmps);
+    if (UNLIKELY(csound->remoteGlobals != NULL))
+      remote_audio(csound);   /* RM: exchange audio with remote Csounds */
     csound->spoutran(csound); /* send to audio_out */
     //#ifdef ANDROID
     //struct timespec ts;
@@ -1878,6 +2100,7 @@ int kperf_nodebug(CSOUND *csound)
     //csound->Message(csound, "kperf kcount, %d,%d.%06d\n",
     //                csound->kcounter, ts.tv_sec, ts.tv_nsec/1000);
     //#endif
+    TRACE_END(csound, "kperf", -1);
     return 0;
 }
 
@@ -2000,11 +2223,14 @@ int kperf_debug(CSOUND *csound)
     if (!data || data->status == CSDEBUG_STATUS_RUNNING)
     {
       /* for one kcnt: */
-      if (csound->oparms_.sfread)         /*   if audio_infile open  */
+      if (csound->host_frames > 0 && csound->host_nin > 0)
+        read_planar(csound);              /*   host's planar input   */
+      else if (csound->oparms_.sfread)    /*   if audio_infile open  */
         csound->spinrecv(csound);         /*      fill the spin buf  */
       csound->spoutactive = 0;            /*   make spout inactive   */
       /* clear spout */
-      memset(csound->spout, 0, csound->nspout*sizeof(MYFLT));
+      if (!host_planar_out(csound))
+        memset(csound->spout, 0, csound->nspout*sizeof(MYFLT));
       memset(csound->spraw, 0, csound->nspout*sizeof(MYFLT));
     }
 
@@ -2035,18 +2261,26 @@ int kperf_debug(CSOUND *csound)
     if (ip != NULL && data != NULL && (data->status != CSDEBUG_STATUS_STOPPED) ) {
       /* There are 2 partitions of work: 1st by inso,
          2nd by inso count / thread count. */
-      if (csound->multiThreadedThreadInfo != NULL) {
+      if (csound->multiThreadedThreadInfo != NULL ||
+          csound->threadPoolJob != NULL) {
 #ifdef PARCS
         if (csound->dag_changed) dag_build(csound, ip);
         else dag_reinit(csound);     /* set to initial state */
 
-        /* process this partition */
-        csound->WaitBarrier(csound->barrier1);
+        csp_reduce_begin(csound);
+        if (csound->threadPoolJob != NULL)
+          csp_pool_perform(csound);
+        else {
+          /* process this partition */
+          csound->WaitBarrier(csound->barrier1);
 
-        (void) nodePerf(csound, 0, 1);
+          (void) nodePerf(csound, 0, 1);
 
-        /* wait until partition is complete */
-        csound->WaitBarrier(csound->barrier2);
+          /* wait until partition is complete */
+          csound->WaitBarrier(csound->barrier2);
+        }
+        csp_reduce_end(csound);
+        dag_cost_end(csound);
 #endif
         csound->multiThreadedDag = NULL;
       }
@@ -2154,12 +2388,20 @@ int kperf_debug(CSOUND *csound)
 
     if (!data || data->status != CSDEBUG_STATUS_STOPPED)
     {
+    if (host_planar_out(csound)) {          /* straight to the host */
+      host_planar_end(csound, lksmps);
+      return 0;
+    }
     if (!csound->spoutactive) {             /*   results now in spout? */
       memset(csound->spout, 0, csound->nspout * sizeof(MYFLT));
       memset(csound->spraw, 0, csound->nspout * sizeof(MYFLT));
     }
     else
       make_interleave(csound, lksmps);
+    if (csound->host_frames > 0)
+      host_planar_end(csound, lksmps);
+    if (UNLIKELY(csound->remoteGlobals != NULL))
+      remote_audio(csound);
     csound->spoutran(csound);               /*      send to audio_out  */
     }
     return 0;
@@ -2283,7 +2525,11 @@ PUBLIC int csoundPerformBuffer(CSOUND *csound)
 #endif
       return ((returnValue - CSOUND_EXITJMP_SUCCESS) | CSOUND_EXITJMP_SUCCESS);
     }
-    csound->sampsNeeded += csound->oparms_.outbufsamps;
+    if (csound->host_frames > 0)        /* fill the host's planar block */
+      csound->sampsNeeded = (csound->host_frames - csound->host_pos)
+                            * csound->nchnls;
+    else
+      csound->sampsNeeded += csound->oparms_.outbufsamps;
     while (csound->sampsNeeded > 0) {
      if(!csound->oparms->realtime) {// no API lock in realtime mode
       csoundLockMutex(csound->API_lock);
@@ -2334,7 +2580,8 @@ PUBLIC int csoundPerform(CSOUND *csound)
            csoundMessage(csound, Str("Score finished in csoundPerform().\n"));
           if(!csound->oparms->realtime)
             csoundUnlockMutex(csound->API_lock);
-          if (csound->oparms->numThreads > 1) {
+          if (csound->oparms->numThreads > 1 &&
+              csound->threadPoolJob == NULL) {
             csound->multiThreadedComplete = 1;
             csound->WaitBarrier(csound->barrier1);
           }
@@ -2447,6 +2694,38 @@ PUBLIC MYFLT csoundGetSpoutSample(CSOUND *csound, int frame, int channel)
     return csound->spout[index];
 }
 
+PUBLIC int csoundSetHostBuffers(CSOUND *csound, MYFLT *const *out,
+                                const MYFLT *const *in, int nframes)
+{
+    int     i;
+
+    csound->host_frames = csound->host_pos = 0;
+    if (nframes == 0)
+      return CSOUND_SUCCESS;
+    if (UNLIKELY(!(csound->engineStatus & CS_STATE_COMP)))
+      return CSOUND_ERROR;
+    if (UNLIKELY(nframes < 0 || nframes % csound->ksmps != 0)) {
+      csound->Warning(csound, Str("csoundSetHostBuffers(): %d frames is not "
+                                  "a multiple of ksmps\n"), nframes);
+      return CSOUND_ERROR;
+    }
+    if (csound->host_out == NULL) {
+      csound->host_out = (MYFLT**) csound->Calloc(csound, csound->nchnls
+                                                  * sizeof(MYFLT*));
+      csound->host_in = (const MYFLT**) csound->Calloc(csound, csound->inchnls
+                                                       * sizeof(MYFLT*));
+    }
+    csound->host_nout = csound->host_nin = 0;
+    for (i = 0; i < (int) csound->nchnls; i++)
+      if ((csound->host_out[i] = (out != NULL ? out[i] : NULL)) != NULL)
+        csound->host_nout++;
+    for (i = 0; i < (int) csound->inchnls; i++)
+      if ((csound->host_in[i] = (in != NULL ? in[i] : NULL)) != NULL)
+        csound->host_nin++;
+    csound->host_frames = nframes;
+    return CSOUND_SUCCESS;
+}
+
 PUBLIC const char *csoundGetOutputName(CSOUND *csound)
 {
     return (const char*) csound->oparms_.outfilename;
@@ -2827,6 +3106,19 @@ int csoundScoreEventAbsoluteInternal(CSOUND *csound, char type,
 
 /* dummy functions for the case when no real-time audio module is available */
 
+/* The "virtual" module is the dummy module driven by a simulated device
+   clock: buffers are taken as soon as they are written, so performance
+   runs as fast as it can while the device time still advances by the
+   amount of audio passed.  Used for benchmarking (tests/bench).
+   dummy_rtaudio_name() tells whether an -+rtaudio module name selects
+   the dummy functions; csoundStart() asks it too. */
+
+int dummy_rtaudio_name(const char *s)
+{
+    return (strcmp(s, "null") == 0 || strcmp(s, "Null") == 0 ||
+            strcmp(s, "NULL") == 0 || strcmp(s, "virtual") == 0);
+}
+
 static double *get_dummy_rtaudio_globals(CSOUND *csound)
 {
     double  *p;
@@ -2834,7 +3126,7 @@ static double *get_dummy_rtaudio_globals(CSOUND *csound)
     p = (double*) csound->QueryGlobalVariable(csound, "__rtaudio_null_state");
     if (p == NULL) {
       if (UNLIKELY(csound->CreateGlobalVariable(csound, "__rtaudio_null_state",
-                                                sizeof(double) * 4) != 0))
+                                                sizeof(double) * 6) != 0))
         csound->Die(csound, Str("rtdummy: failed to allocate globals"));
       csound->Message(csound, Str("rtaudio: dummy module enabled\n"));
       p = (double*) csound->QueryGlobalVariable(csound, "__rtaudio_null_state");
@@ -2847,6 +3139,8 @@ static void dummy_rtaudio_timer(CSOUND *csound, double *p)
     double  timeWait;
     int     i;
 
+    if (p[2] != 0.0)            /* virtual device clock */
+      return;
     timeWait = p[0] - csoundGetRealTime(csound->csRtClock);
     i = (int) (timeWait * 1000.0 + 0.5);
     if (i > 0)
@@ -2861,8 +3155,7 @@ int playopen_dummy(CSOUND *csound, const csRtAudioParams *parm)
     /* find out if the use of dummy real-time audio functions was requested, */
     /* or an unknown plugin name was specified; the latter case is an error  */
     s = (char*) csoundQueryGlobalVariable(csound, "_RTAUDIO");
-    if (s != NULL && !(strcmp(s, "null") == 0 || strcmp(s, "Null") == 0 ||
-                       strcmp(s, "NULL") == 0)) {
+    if (s != NULL && !dummy_rtaudio_name(s)) {
       if (s[0] == '\0')
         csoundErrorMsg(csound,
                        Str(" *** error: rtaudio module set to empty string"));
@@ -2879,6 +3172,7 @@ int playopen_dummy(CSOUND *csound, const csRtAudioParams *parm)
     p[0] = csound->GetRealTime(csound->csRtClock);
     p[1] = 1.0 / ((double) ((int) sizeof(MYFLT) * parm->nChannels)
                   * (double) parm->sampleRate);
+    p[2] = (s != NULL && strcmp(s, "virtual") == 0);
     return CSOUND_SUCCESS;
 }
 
@@ -2898,8 +3192,7 @@ int recopen_dummy(CSOUND *csound, const csRtAudioParams *parm)
     /* find out if the use of dummy real-time audio functions was requested, */
     /* or an unknown plugin name was specified; the latter case is an error  */
     s = (char*) csoundQueryGlobalVariable(csound, "_RTAUDIO");
-    if (s != NULL && !(strcmp(s, "null") == 0 || strcmp(s, "Null") == 0 ||
-                       strcmp(s, "NULL") == 0)) {
+    if (s != NULL && !dummy_rtaudio_name(s)) {
       if (s[0] == '\0')
         csoundErrorMsg(csound,
                        Str(" *** error: rtaudio module set to empty string"));
@@ -2911,11 +3204,12 @@ int recopen_dummy(CSOUND *csound, const csRtAudioParams *parm)
       }
       // return CSOUND_ERROR;
     }
-    p = (double*) get_dummy_rtaudio_globals(csound) + 2;
+    p = (double*) get_dummy_rtaudio_globals(csound) + 3;
     csound->rtRecord_userdata = (void*) p;
     p[0] = csound->GetRealTime(csound->csRtClock);
     p[1] = 1.0 / ((double) ((int) sizeof(MYFLT) * parm->nChannels)
                   * (double) parm->sampleRate);
+    p[2] = (s != NULL && strcmp(s, "virtual") == 0);
     return CSOUND_SUCCESS;
 }
 
@@ -3108,6 +3402,16 @@ PUBLIC void csoundSetExternalMidiReadCallback(CSOUND *csound,
                                                           unsigned char *, int))
 {
     csound->midiGlobals->MidiReadCallback = func;
+    csound->midiGlobals->MidiReadTimedCallback = NULL;
+}
+
+PUBLIC void csoundSetExternalMidiReadTimedCallback(CSOUND *csound,
+                                                   int (*func)(CSOUND *,
+                                                               void *,
+                                                               unsigned char *,
+                                                               int, double *))
+{
+    csound->midiGlobals->MidiReadTimedCallback = func;
 }
 
 PUBLIC void csoundSetExternalMidiInCloseCallback(CSOUND *csound,
@@ -3207,6 +3511,8 @@ static CS_NOINLINE int opcode_list_new_oentry(CSOUND *csound,
     //printf("%p\n", entryCopy);
     memcpy(entryCopy, ep, sizeof(OENTRY));
     entryCopy->useropinfo = NULL;
+    if (UNLIKELY(csound->pluginManifest != NULL))
+      csoundManifestAddOpcode(csound, shortName, head != NULL);
 
     if (head != NULL) {
         cs_cons_append(head, cs_cons(csound, entryCopy, NULL));
@@ -3395,6 +3701,7 @@ static void reset(CSOUND *csound)
     csound->spinlock1= saved_env->spinlock1;
 #endif
     csound->enableHostImplementedMIDIIO = saved_env->enableHostImplementedMIDIIO;
+    csound->keepOrcHistory = saved_env->keepOrcHistory;
     memcpy(&(csound->exitjmp), &(saved_env->exitjmp), sizeof(jmp_buf));
     csound->memalloc_db = saved_env->memalloc_db;
     csound->message_buffer = saved_env->message_buffer; /*VL 19.06.21 keep msg buffer */
@@ -3409,8 +3716,7 @@ PUBLIC void csoundSetRTAudioModule(CSOUND *csound, const char *module){
     if ((s = csoundQueryGlobalVariable(csound, "_RTAUDIO")) != NULL)
       strNcpy(s, module, 20);
     if (UNLIKELY(s==NULL)) return;        /* Should not happen */
-    if (strcmp(s, "null") == 0 || strcmp(s, "Null") == 0 ||
-        strcmp(s, "NULL") == 0) {
+    if (dummy_rtaudio_name(s)) {
       csound->Message(csound, Str("setting dummy interface\n"));
       csound->SetPlayopenCallback(csound, playopen_dummy);
       csound->SetRecopenCallback(csound, recopen_dummy);
@@ -21,6 +21,7 @@
 #include "soundio.h"
 #include "csmodule.h"
 #include "corfile.h"
+#include "cpubudget.h"
 
 #include "csound_orc.h"
 
@@ -399,6 +400,7 @@ extern int  recopen_dummy(CSOUND *, const csRtAudioParams *parm);
 extern int  rtrecord_dummy(CSOUND *, MYFLT *inBuf, int nbytes);
 extern void rtclose_dummy(CSOUND *);
 extern int  audio_dev_list_dummy(CSOUND *, CS_AUDIODEVICE *, int);
+extern int  dummy_rtaudio_name(const char *s);
 extern int  midi_dev_list_dummy(CSOUND *csound, CS_MIDIDEVICE *list, int isOutput);
 extern int DummyMidiInOpen(CSOUND *csound, void **userData,
                            const char *devName);
@@ -428,8 +430,7 @@ PUBLIC int csoundStart(CSOUND *csound) // DEBUG
     { /* test for dummy module request */
       char *s;
       if ((s = csoundQueryGlobalVariable(csound, "_RTAUDIO")) != NULL)
-        if (strcmp(s, "null") == 0 || strcmp(s, "Null") == 0 ||
-            strcmp(s, "NULL") == 0) {
+        if (dummy_rtaudio_name(s)) {
           csound->Message(csound, Str("setting dummy interface\n"));
           csound->SetPlayopenCallback(csound, playopen_dummy);
           csound->SetRecopenCallback(csound, recopen_dummy);
@@ -525,8 +526,22 @@ PUBLIC int csoundStart(CSOUND *csound) // DEBUG
     O->sfsampsize = sfsampsize(FORMAT2SF(O->outformat));
     O->informat = O->outformat;             /* informat default */
 
+    if (O->initAhead > 0 && !O->realtime)
+      csound->Warning(csound, Str("--init-ahead has no effect without "
+                                  "--realtime"));
+    if (O->cpuBudget > 0 && csound->cpubudget == NULL)
+      cpubudget_start(csound);
 #ifdef PARCS
-    if (O->numThreads > 1) {
+    if (O->numThreads > 1)
+      csp_reduce_alloc(csound, O->numThreads);
+    else if (O->pipeline > 0)
+      csound->Warning(csound, Str("--pipeline has no effect without -j"));
+    if (O->numThreads > 1 && O->threadPool) {
+      int kperfPoolTask(CSOUND *, int, int);
+      if (UNLIKELY(csp_pool_attach(csound, kperfPoolTask) != OK))
+        csound->Die(csound, Str("could not start the shared thread pool"));
+    }
+    else if (O->numThreads > 1) {
       void csp_barrier_alloc(CSOUND *, void **, int);
       int i;
       THREADINFO *current = NULL;
@@ -32,6 +32,7 @@
 #include "csoundCore.h"
 #include <ctype.h>
 #include "interlocks.h"
+#include "csmodule.h"
 
 static int opcode_cmp_func(const void *a, const void *b)
 {
@@ -72,6 +73,8 @@ PUBLIC int csoundNewOpcodeList(CSOUND *csound, opcodeListEntry **lstp)
     (*lstp) = NULL;
     if (UNLIKELY(csound->opcodes == NULL))
       return -1;
+    /* list the opcodes of deferred plugin libraries as well */
+    csoundLoadAllDeferredModules(csound);
 
     head = items = cs_hash_table_values(csound, csound->opcodes);
 
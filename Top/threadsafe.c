@@ -21,7 +21,10 @@
 
 #include "csoundCore.h"
 #include "csound_orc.h"
+#include "cstrace.h"
+#include "namedins.h"
 #include <stdlib.h>
+#include <limits.h>
 
 #ifdef USE_DOUBLE
 #  define MYFLT_INT_TYPE int64_t
@@ -53,12 +56,15 @@ void set_channel_data_ptr(CSOUND *csound, const char *name,
 void named_instr_assign_numbers(CSOUND *csound, ENGINE_STATE *engineState);
 
 enum {INPUT_MESSAGE=1, READ_SCORE, SCORE_EVENT, SCORE_EVENT_ABS,
-      TABLE_COPY_OUT, TABLE_COPY_IN, TABLE_SET, MERGE_STATE, KILL_INSTANCE};
+      TABLE_COPY_OUT, TABLE_COPY_IN, TABLE_SET, MERGE_STATE, KILL_INSTANCE,
+      SCHEDULE_EVENTS};
 
 /* MAX QUEUE SIZE */
 #define API_MAX_QUEUE 1024
 /* ARG LIST ALIGNMENT */
 #define ARG_ALIGN 8
+/* size rounded up to the alignment */
+#define ARG_SIZE(n) (((n) + ARG_ALIGN - 1) & ~(ARG_ALIGN - 1))
 
 /* Message queue structure */
 typedef struct _message_queue {
@@ -96,31 +102,41 @@ void allocate_message_queue(CSOUND *csound) {
 }
 
 
+/* take a free message with room for argsiz bytes of args, to be filled
+   in by the caller and passed to message_post() */
+static message_queue_t *message_reserve(CSOUND *csound, int32_t message,
+                                        int argsiz) {
+  volatile long items;
+  message_queue_t *msg;
+
+  /* block if queue is full */
+  do {
+    items = ATOMIC_GET(csound->msg_queue_items);
+  } while(items >= API_MAX_QUEUE);
+
+  msg = csound->msg_queue[atomicGet_Incr_Mod(&csound->msg_queue_wget,
+                                             API_MAX_QUEUE)];
+  msg->message = message;
+  if(msg->args != NULL)
+    csound->Free(csound, msg->args);
+  msg->args = (char *)csound->Malloc(csound, argsiz);
+  return msg;
+}
+
+static int64_t *message_post(CSOUND *csound, message_queue_t *msg) {
+  csound->msg_queue[atomicGet_Incr_Mod(&csound->msg_queue_wput,
+                                       API_MAX_QUEUE)] = msg;
+  ATOMIC_INCR(csound->msg_queue_items);
+  return &msg->rtn;
+}
+
 /* enqueue should be called by the relevant API function */
 void *message_enqueue(CSOUND *csound, int32_t message, char *args,
                       int argsiz) {
   if(csound->msg_queue != NULL) {
-    int64_t *rtn;
-    volatile long items;
-
-    /* block if queue is full */
-    do {
-      items = ATOMIC_GET(csound->msg_queue_items);
-    } while(items >= API_MAX_QUEUE);
-
-    message_queue_t* msg =
-      csound->msg_queue[atomicGet_Incr_Mod(&csound->msg_queue_wget,
-                                           API_MAX_QUEUE)];
-    msg->message = message;
-    if(msg->args != NULL)
-      csound->Free(csound, msg->args);
-    msg->args = (char *)csound->Calloc(csound, argsiz);
+    message_queue_t* msg = message_reserve(csound, message, argsiz);
     memcpy(msg->args, args, argsiz);
-    rtn = &msg->rtn;
-    csound->msg_queue[atomicGet_Incr_Mod(&csound->msg_queue_wput,
-                                         API_MAX_QUEUE)] = msg;
-    ATOMIC_INCR(csound->msg_queue_items);
-    return (void *) rtn;
+    return (void *) message_post(csound, msg);
   }
   else return NULL;
 }
@@ -134,6 +150,8 @@ void message_dequeue(CSOUND *csound) {
     long items = csound->msg_queue_items;
     long rend = rp + items;
 
+    if (items > 0)
+      TRACE_BEGIN(csound, "message_dequeue", (int32_t) items);
     while(rp < rend) {
       message_queue_t* msg = csound->msg_queue[rp % API_MAX_QUEUE];
       switch(msg->message) {
@@ -245,12 +263,31 @@ void message_dequeue(CSOUND *csound) {
           killInstance(csound, instr, insno, ip, mode, rls);
         }
         break;
+      case SCHEDULE_EVENTS:
+        {
+          int n, nfields;
+          char *a = msg->args + 2*ARG_ALIGN;
+          const MYFLT *instr, *pfields;
+          const int64_t *start;
+          memcpy(&n, msg->args, sizeof(int));
+          memcpy(&nfields, msg->args + ARG_ALIGN, sizeof(int));
+          instr = (const MYFLT *) a;
+          a += ARG_SIZE(n*sizeof(MYFLT));
+          start = (const int64_t *) a;
+          a += ARG_SIZE(n*sizeof(int64_t));
+          pfields = (const MYFLT *) a;
+          msg->rtn = insert_score_events(csound, instr, start, pfields,
+                                         nfields, n);
+        }
+        break;
       }
       msg->message = 0;
       rp += 1;
     }
     ATOMIC_SUB(csound->msg_queue_items, items);
     csound->msg_queue_rstart = rp % API_MAX_QUEUE;
+    if (items > 0)
+      TRACE_END(csound, "message_dequeue", -1);
   }
 }
 
@@ -321,6 +358,37 @@ static inline int64_t *csoundScoreEventAbsolute_enqueue(CSOUND *csound, char typ
   return message_enqueue(csound,SCORE_EVENT_ABS, args, argsize);
 }
 
+/* a whole batch goes in one message, written in place: n, nfields,
+   then the arrays; NULL if it would not fit in an int of args */
+static inline int64_t *csoundScheduleEvents_enqueue(CSOUND *csound,
+                                                    const MYFLT *instr,
+                                                    const int64_t *start,
+                                                    const MYFLT *pfields,
+                                                    int nfields, int n)
+{
+  size_t sinstr = ARG_SIZE((size_t) n*sizeof(MYFLT)),
+         sstart = ARG_SIZE((size_t) n*sizeof(int64_t)),
+         spf = ARG_SIZE((size_t) n*nfields*sizeof(MYFLT));
+  message_queue_t *msg;
+  char *a;
+  if (UNLIKELY(csound->msg_queue == NULL ||
+               (size_t) n > (INT_MAX - 5*ARG_ALIGN) /
+                            ((nfields + 1)*sizeof(MYFLT) + sizeof(int64_t))))
+    return NULL;
+  msg = message_reserve(csound, SCHEDULE_EVENTS,
+                        (int) (2*ARG_ALIGN + sinstr + sstart + spf));
+  a = msg->args;
+  memcpy(a, &n, sizeof(int));
+  memcpy(a+ARG_ALIGN, &nfields, sizeof(int));
+  a += 2*ARG_ALIGN;
+  memcpy(a, instr, n*sizeof(MYFLT));
+  a += sinstr;
+  memcpy(a, start, n*sizeof(int64_t));
+  a += sstart;
+  memcpy(a, pfields, (size_t) n*nfields*sizeof(MYFLT));
+  return message_post(csound, msg);
+}
+
 /* this is to be called from
    csoundKillInstanceInternal() in insert.c
 */
@@ -482,6 +550,29 @@ void csoundScoreEventAbsoluteAsync(CSOUND *csound, char type,
   csoundScoreEventAbsolute_enqueue(csound, type, pfields, numFields, time_ofs);
 }
 
+MYFLT csoundGetInstrumentHandle(CSOUND *csound, const char *name)
+{
+  MYFLT insno;
+  csoundLockMutex(csound->API_lock);
+  insno = named_instr_find(csound, (char *) name);
+  csoundUnlockMutex(csound->API_lock);
+  return insno;
+}
+
+int csoundScheduleEvents(CSOUND *csound, const MYFLT *instr,
+                         const int64_t *start, const MYFLT *pfields,
+                         int nfields, int n)
+{
+  if (UNLIKELY(n < 0 || nfields < 1 || nfields > PMAX - 2))
+    return CSOUND_ERROR;
+  if (n == 0)
+    return CSOUND_SUCCESS;
+  if (UNLIKELY(csoundScheduleEvents_enqueue(csound, instr, start, pfields,
+                                            nfields, n) == NULL))
+    return CSOUND_ERROR;
+  return CSOUND_SUCCESS;
+}
+
 int csoundCompileTreeAsync(CSOUND *csound, TREE *root) {
   int async = 1;
   return csoundCompileTreeInternal(csound, root, async);
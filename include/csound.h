@@ -565,6 +565,20 @@ extern "C" {
     int_least64_t   starttime_CPU;
   } RTCLOCK;
 
+  /**
+   * Voice management under --cpu-budget (see csoundGetVoiceStats())
+   */
+  typedef struct {
+    /** rolling DSP load, as a fraction of the k-period */
+    double  load;
+    /** voices turned off by the 'oldest' and 'quietest' policies */
+    long    stolenOldest, stolenQuietest;
+    /** new voices not started by the 'refuse' policy */
+    long    refused;
+    /** instance k-cycles not performed by the 'skip' policy */
+    long    skipped;
+  } CS_VOICE_STATS;
+
   typedef struct {
     char        *opname;
     char        *outypes;
@@ -698,6 +712,35 @@ extern "C" {
    */
   PUBLIC CSOUND *csoundCreate(void *hostData);
 
+  /**
+   * If 'keep' is non-zero, every later successful compilation of
+   * orchestra code on 'csound' keeps the preprocessed code, so that the
+   * instance can be passed to csoundCreateRecompiled(). This is off by
+   * default, as the kept code grows with every compilation; turning it
+   * off frees the code kept so far. The setting survives csoundReset().
+   */
+  PUBLIC void csoundKeepOrcHistory(CSOUND *csound, int keep);
+
+  /**
+   * Creates a new instance of Csound and compiles on it the orchestra
+   * code compiled on 'templ' while csoundKeepOrcHistory() was on. The
+   * new instance gets the options of the template (see
+   * csoundGetParams()), that orchestra code, and a copy of every
+   * function table the template holds at the time of the call. It does
+   * not share any state with the template, and can be given its own
+   * score, output and channel values before csoundStart() is called.
+   * It keeps its own history if the template does. Returns NULL if
+   * 'templ' has no kept orchestra code or on failure.
+   *
+   * This is not a cheap clone. It costs as much as csoundCreate()
+   * followed by csoundCompileOrc() on the same code, plugin loading
+   * included, less the preprocessor (the code is kept preprocessed, so
+   * no files are read and no macros expanded) and the GEN routines of
+   * the copied tables. Copying the tables takes time and memory in
+   * proportion to their total size.
+   */
+  PUBLIC CSOUND *csoundCreateRecompiled(CSOUND *templ, void *hostData);
+
   /**
    *  Loads all plugins from a given directory
    */
@@ -1270,6 +1313,24 @@ extern "C" {
    */
   PUBLIC MYFLT csoundGetSpoutSample(CSOUND *csound, int frame, int channel);
 
+  /**
+   * Registers planar buffers for the host's next block of nframes frames,
+   * which must be a multiple of ksmps: out[0 .. nchnls-1] receive the
+   * output channels and in[0 .. nchnls_i-1] supply the input channels
+   * (either array, or any channel in it, may be NULL).  Each following
+   * k-period writes and reads ksmps frames of them straight from the
+   * engine's channel buffers, without interleaving through spout and
+   * spin; csoundPerformBuffer() performs the whole block.  The buffers
+   * are released when the block is done, so register them again for
+   * every block; nframes = 0 releases them at once.  While output
+   * buffers are registered spout is not filled and no audio goes to the
+   * -o device or file, nor to the amplitude statistics.
+   * Returns CSOUND_SUCCESS, or CSOUND_ERROR if nframes is not valid or
+   * csoundStart() has not been called.
+   */
+  PUBLIC int csoundSetHostBuffers(CSOUND *csound, MYFLT *const *out,
+                                  const MYFLT *const *in, int nframes);
+
   /**
    * Return pointer to user data pointer for real time audio input.
    */
@@ -1420,6 +1481,23 @@ extern "C" {
                                                             unsigned char *buf,
                                                             int nBytes));
 
+  /**
+   * Sets callback for reading time-stamped real time MIDI input.
+   * The callback works like the one set with
+   * csoundSetExternalMidiReadCallback(), and in addition stores in
+   * times[i] how long before the call, in seconds, byte i of buf was
+   * received.  When set, it is used instead of the plain read callback.
+   * With --sample-accurate, note-ons then start at the matching sample
+   * of the k-period, one k-period after they were received, instead of
+   * at its start.
+   */
+  PUBLIC void csoundSetExternalMidiReadTimedCallback(CSOUND *,
+                                                     int (*func)(CSOUND *,
+                                                                 void *userData,
+                                                                 unsigned char *buf,
+                                                                 int nBytes,
+                                                                 double *times));
+
   /**
    * Sets callback for closing real time MIDI input.
    */
@@ -1872,6 +1950,30 @@ extern "C" {
    */
   PUBLIC void csoundScoreEventAbsoluteAsync(CSOUND *,
                  char type, const MYFLT *pfields, long numFields, double time_ofs);
+
+  /**
+   * Returns the number of the named instrument, which may be followed by
+   * a fraction as in "name.1", for use with csoundScheduleEvents(); or
+   * 0 if there is no such instrument.  Resolve names once, ahead of time:
+   * the number holds until the instrument is redefined.
+   */
+  PUBLIC MYFLT csoundGetInstrumentHandle(CSOUND *, const char *name);
+
+  /**
+   * Schedules n note events in one go, asynchronously.  Event k starts
+   * instrument instr[k] (a number, or a handle from
+   * csoundGetInstrumentHandle(); negative to turn off a held note)
+   * start[k] samples from the start of the next k-period, with the
+   * nfields p-fields from p3 on taken from pfields[k*nfields].  The batch
+   * is copied, and goes to the event scheduler through a single message,
+   * so no string is looked up and only one message is queued however
+   * large it is.  Starts are rounded to k-periods unless
+   * --sample-accurate is used.  Returns CSOUND_SUCCESS, or CSOUND_ERROR
+   * if the arguments are not valid or the message cannot be queued.
+   */
+  PUBLIC int csoundScheduleEvents(CSOUND *, const MYFLT *instr,
+                                  const int64_t *start, const MYFLT *pfields,
+                                  int nfields, int n);
   /**
    * Input a NULL-terminated string (as if from a console),
    * used for line events.
@@ -2367,6 +2469,31 @@ extern "C" {
    */
   PUBLIC double csoundGetCPUTime(RTCLOCK *);
 
+  /**
+   * Start recording a timeline of engine activity (k-cycles, init passes,
+   * table generation, DAG builds, instrument performance and the work of
+   * the helper and I/O threads) into a ring of at least 'nevents' events,
+   * discarding any earlier recording.  When the ring is full the oldest
+   * events are overwritten.  A value of zero or less stops recording.
+   * The --trace=FILE option does the same and writes FILE on cleanup.
+   */
+  PUBLIC int csoundSetTrace(CSOUND *, int nevents);
+
+  /**
+   * Write the events recorded since csoundSetTrace() to 'filename' in
+   * Chrome trace JSON format, for chrome://tracing or Perfetto.
+   * Recording goes on.  Returns CSOUND_ERROR if tracing is off or the
+   * file cannot be written.
+   */
+  PUBLIC int csoundWriteTrace(CSOUND *, const char *filename);
+
+  /**
+   * Fill 'stats' with the DSP load measured under --cpu-budget=N and
+   * counts of what the budget policy has done so far.  Returns
+   * CSOUND_ERROR if --cpu-budget is not set.
+   */
+  PUBLIC int csoundGetVoiceStats(CSOUND *, CS_VOICE_STATS *stats);
+
   /**
    * Return a 32-bit unsigned integer to be used as seed from current time.
    */
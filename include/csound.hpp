@@ -934,6 +934,20 @@ public:
   virtual MYFLT SystemSr(MYFLT value) {
     return csoundSystemSr(csound, value);
   }
+  virtual int SetHostBuffers(MYFLT *const *out, const MYFLT *const *in,
+                             int nframes)
+  {
+    return csoundSetHostBuffers(csound, out, in, nframes);
+  }
+  virtual MYFLT GetInstrumentHandle(const char *name)
+  {
+    return csoundGetInstrumentHandle(csound, name);
+  }
+  virtual int ScheduleEvents(const MYFLT *instr, const int64_t *start,
+                             const MYFLT *pfields, int nfields, int n)
+  {
+    return csoundScheduleEvents(csound, instr, start, pfields, nfields, n);
+  }
 };
 
 class CsoundThreadLock {
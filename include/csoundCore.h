@@ -270,6 +270,13 @@ typedef struct CORFIL {
     int     echo;
     MYFLT   limiter;
     float   sr_default, kr_default;
+    int     threadPool;     /* share worker threads: 0 off, -1 one per core */
+    int     threadPoolPriority;
+    int     threadPoolPin;
+    int     pipeline;       /* highest pipeline stage, 0 off */
+    int     initAhead;      /* --init-ahead: ms, 0 off */
+    int     cpuBudget;      /* --cpu-budget: % of the k-period, 0 off */
+    int     cpuBudgetPolicy;  /* CPU_BUDGET_REFUSE etc. (cpubudget.h) */
   } OPARMS;
 
   typedef struct arglst {
@@ -353,6 +360,17 @@ typedef struct CORFIL {
     int     instcnt;                /* Count number of instances ever */
     int     isNew;                  /* is this a new definition */
     int     nocheckpcnt;            /* Control checks on pcnt */
+    double  perfcost;               /* running mean perf time, seconds per
+                                       k-cycle, measured under -j or
+                                       --cpu-budget */
+    int     pipestage;              /* stage+1 set by pipestage, 0 auto */
+    int     stage;                  /* --pipeline stage, from dag_stages */
+    int     preinit;                /* --init-ahead: 1 allowed, 2 while
+                                       no table is made, -1 not, 0 not
+                                       known yet */
+    struct insds **p1hash;          /* active instances by p1 */
+    int     p1size, p1count;        /* buckets (power of 2), entries */
+    int     cpuprio;                /* set by cpuprio, for --cpu-budget */
   } INSTRTXT;
 
   typedef struct namedInstr {
@@ -597,6 +615,25 @@ typedef struct CORFIL {
 #define CS_PDS       (p->h.insdshead->pds)
 #define CS_SPIN      (p->h.insdshead->spin)
 #define CS_SPOUT     (p->h.insdshead->spout)
+
+#ifdef __BUILDING_LIBCSOUND
+  /**
+   * Engine data of an instance that plugins do not see.  It is allocated
+   * with the INSDS by instance(), in front of it, so that the layout of
+   * INSDS and of the p-fields that follow it does not change.
+   */
+  typedef struct insds_ext {
+    /* Chain in the p1 index of instr (prvp1 NULL if not in it) */
+    struct insds *nxtp1, **prvp1;
+    int      actno;        /* csound->actcount when activated */
+    /* --cpu-budget */
+    double   perfcost;     /* running mean perf time, seconds per k-cycle */
+    MYFLT    level;        /* running mean output power, < 0 not known */
+  } INSDS_EXT;
+
+#define INSDS_EXT_SIZE ((sizeof(INSDS_EXT) + 15) & ~((size_t) 15))
+#define INSEXT(ip)     ((INSDS_EXT*) ((char*) (ip) - INSDS_EXT_SIZE))
+#endif
   typedef int (*SUBR)(CSOUND *, void *);
 
   /**
@@ -719,6 +756,7 @@ typedef struct CORFIL {
     int16   chan;
     int16   dat1;
     int16   dat2;
+    int32   ofs;        /* sample offset in the k-period (timed input) */
   } MEVENT;
 
   typedef struct SNDMEMFILE_ {
@@ -828,12 +866,17 @@ typedef struct CORFIL {
     unsigned char mbuf[MBUFSIZ];
     unsigned char *bufp, *endatp;
     int16   datreq, datcnt;
+    int     (*MidiReadTimedCallback)(CSOUND *, void *, unsigned char *, int,
+                                     double *);
+    double  mtime[MBUFSIZ];     /* age of each byte of mbuf, -1: untimed */
   } MGLOBAL;
 
   typedef struct eventnode {
     struct eventnode  *nxt;
     uint32     start_kcnt;
     EVTBLK            evt;
+    void              *preinit;   /* initialised ahead (--init-ahead) */
+    int               preinit_tried;  /* insert_ahead() has been asked */
   } EVTNODE;
 
   typedef struct {
@@ -982,6 +1025,8 @@ typedef struct NAME__ {
     char type[12];
   } MODULE_INFO;
 
+#define MAX_MODULES 64
+
 
 #define MAX_ALLOC_QUEUE 1024
 
@@ -993,6 +1038,7 @@ typedef struct _alloc_data_ {
   MEVENT mep;
   INSDS *ip;
   OPDS *ids;
+  void *preinit;
 } ALLOC_DATA;
 
 #define MAX_MESSAGE_STR 1024
@@ -1410,11 +1456,13 @@ typedef struct _message_queue_t_ {
     MYFLT* (*CepsLP)(CSOUND *, MYFLT *, MYFLT *, int, int);
     MYFLT (*LPrms)(CSOUND *, void *);
     void *(*CreateThread2)(uintptr_t (*threadRoutine)(void *), unsigned int, void *userdata);
+    void (*SetExternalMidiReadTimedCallback)(CSOUND *,
+                int (*func)(CSOUND *, void *, unsigned char *, int, double *));
     /**@}*/
     /** @name Placeholders
         To allow the API to grow while maintining backward binary compatibility. */
     /**@{ */
-    SUBR dummyfn_2[22];
+    SUBR dummyfn_2[21];
     /**@}*/
 #ifdef __BUILDING_LIBCSOUND
     /* ------- private data (not to be used by hosts or externals) ------- */
@@ -1838,6 +1886,47 @@ typedef struct _message_queue_t_ {
     int  mode;
     char *opcodedir;
     char *score_srt;
+    /* database for deferred loading of opcode plugin libraries */
+    void *pluginManifest;
+    /* what parsing an orchestra for CS_ORC_CACHE did besides building
+       its tree (orc_cache.c), NULL when not recording */
+    void *orcCacheRec;
+    /* preprocessed orchestra code, kept for csoundCreateRecompiled()
+       when keepOrcHistory is set by csoundKeepOrcHistory() */
+    char *lastExpandedOrc;
+    CONS_CELL *orcHistory;
+    int keepOrcHistory;
+    /* this instance's job in the shared worker pool (--thread-pool) */
+    void *threadPoolJob;
+    /* number of blocks obtained by csound->Malloc, Calloc and ReAlloc */
+    uint64_t memalloc_count;
+    /* timeline trace ring (cstrace.c), NULL when not tracing */
+    void *trace;
+    /* per-thread reduction buffers (cs_par_reduce.c), NULL without -j */
+    void *reduce;
+    /* set while the DAG is performed: spout is private to each thread */
+    int reducing;
+    /* task coarsening (cs_new_dispatch.c): task t performs instances
+       dag_task_first[t] .. dag_task_first[t+1]-1 of dag_task_map */
+    int *dag_task_first;
+    double *dag_inst_cost;      /* seconds, in a costing k-cycle */
+    int dag_kcount;
+    int dag_costing;            /* time each instance this k-cycle */
+    /* --pipeline: set of the globals read a block late, and its version */
+    void *dag_piped;
+    int dag_piped_gen;
+    int dag_stages_changed;
+    /* planar host buffers (csoundSetHostBuffers()), by channel */
+    MYFLT **host_out;
+    const MYFLT **host_in;
+    int host_nout, host_nin;    /* of these, not NULL */
+    int host_frames;            /* 0: none registered */
+    int host_pos;               /* frames done */
+    /* --init-ahead: voices initialised and waiting for their start */
+    void *init_ahead;
+    int actcount;               /* activations, numbering INSDS.actno */
+    void *cpubudget;            /* --cpu-budget state (cpubudget.c) */
+    int ftables_made;           /* tables made or deleted (fgens.c) */
     /*struct CSOUND_ **self;*/
     /**@}*/
 #endif  /* __BUILDING_LIBCSOUND */
@@ -0,0 +1,227 @@
+/*
+    csound_bench.c:
+
+    Copyright (C) 2026 The Csound Developers
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+/* csound-bench: engine benchmark
+ *
+ *   csound-bench [-k cycles] [-w warmup] [-o out.json] [-- csound options]
+ *                file.csd ...
+ *
+ * Each CSD is run through the "virtual" real-time audio module, a null
+ * device whose clock advances with the audio written to it instead of
+ * with real time, so results do not depend on a sound card and the
+ * engine runs flat out.  Every k-cycle is timed on its own and the
+ * number of blocks allocated by the engine during it is counted.  The
+ * results are written as JSON: mean time per k-cycle, percentiles, and
+ * the number of cycles that took longer than their own duration of
+ * audio (those that would have dropped out on a real device).
+ */
+
+#include "csoundCore.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_CYCLES  (20000)
+#define BENCH_WARMUP  (200)
+
+typedef struct {
+    const char *name;
+    int     cycles;             /* cycles measured */
+    double  sr;
+    int     ksmps;
+    double  mean, p50, p99, p999, max;  /* nanoseconds */
+    double  allocs;             /* per cycle */
+    int     overruns;
+} BENCH_RESULT;
+
+static void quiet(CSOUND *csound, int attr, const char *format, va_list args)
+{
+    (void) csound; (void) attr; (void) format; (void) args;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double*) a, y = *(const double*) b;
+    return (x < y ? -1 : (x > y ? 1 : 0));
+}
+
+static double percentile(const double *sorted, int n, double q)
+{
+    int i = (int) (q * (double) (n - 1) + 0.5);
+    return sorted[i < n ? i : n - 1];
+}
+
+static const char *base_name(const char *path)
+{
+    const char *s = strrchr(path, '/');
+#ifdef WIN32
+    const char *t = strrchr(path, '\\');
+    if (t != NULL && (s == NULL || t > s)) s = t;
+#endif
+    return (s != NULL ? s + 1 : path);
+}
+
+static int bench_run(const char *csd, int argc, char **argv,
+                     int cycles, int warmup, BENCH_RESULT *r)
+{
+    CSOUND  *csound;
+    RTCLOCK clock;
+    double  *t, period, t0;
+    uint64_t allocs = 0, a0;
+    int     i, n = 0, err = 0;
+
+    csound = csoundCreate(NULL);
+    csoundSetMessageCallback(csound, quiet);
+    csoundSetOption(csound, "-odac");
+    csoundSetOption(csound, "-+rtaudio=virtual");
+    csoundSetOption(csound, "-+rtmidi=null");
+    csoundSetOption(csound, "-d");
+    csoundSetOption(csound, "-m0");
+    for (i = 0; i < argc; i++)
+      csoundSetOption(csound, argv[i]);
+    if (csoundCompileCsd(csound, csd) != CSOUND_SUCCESS ||
+        csoundStart(csound) != CSOUND_SUCCESS) {
+      fprintf(stderr, "csound-bench: %s: could not start\n", csd);
+      csoundDestroy(csound);
+      return -1;
+    }
+    r->name = base_name(csd);
+    r->sr = (double) csoundGetSr(csound);
+    r->ksmps = (int) csoundGetKsmps(csound);
+    period = 1.0e9 * (double) r->ksmps / r->sr;
+
+    for (i = 0; i < warmup && !err; i++)
+      err = csoundPerformKsmps(csound);
+    t = (double*) malloc(sizeof(double) * cycles);
+    csoundInitTimerStruct(&clock);
+    while (n < cycles && !err) {
+      a0 = csound->memalloc_count;
+      t0 = csoundGetRealTime(&clock);
+      err = csoundPerformKsmps(csound);
+      t[n] = 1.0e9 * (csoundGetRealTime(&clock) - t0);
+      allocs += csound->memalloc_count - a0;
+      n++;
+    }
+    csoundStop(csound);
+    csoundCleanup(csound);
+    csoundDestroy(csound);
+
+    r->cycles = n;
+    r->mean = r->p50 = r->p99 = r->p999 = r->max = r->allocs = 0.0;
+    r->overruns = 0;
+    if (n > 0) {
+      for (i = 0; i < n; i++) {
+        r->mean += t[i];
+        if (t[i] > period) r->overruns++;
+      }
+      r->mean /= (double) n;
+      qsort(t, n, sizeof(double), cmp_double);
+      r->p50 = percentile(t, n, 0.5);
+      r->p99 = percentile(t, n, 0.99);
+      r->p999 = percentile(t, n, 0.999);
+      r->max = t[n - 1];
+      r->allocs = (double) allocs / (double) n;
+    }
+    free(t);
+    return 0;
+}
+
+static void bench_json(FILE *f, const BENCH_RESULT *r, int nr,
+                       int cycles, int warmup)
+{
+    int     i;
+
+    fprintf(f, "{\n  \"version\": %d,\n  \"cycles\": %d,\n"
+               "  \"warmup\": %d,\n  \"benchmarks\": [\n",
+            csoundGetVersion(), cycles, warmup);
+    for (i = 0; i < nr; i++) {
+      double rt = (r[i].mean > 0.0 ?
+                   1.0e9 * r[i].ksmps / r[i].sr / r[i].mean : 0.0);
+      fprintf(f, "    {\"name\": \"%s\", \"sr\": %g, \"ksmps\": %d, "
+                 "\"cycles\": %d,\n"
+                 "     \"ns_per_cycle\": %.0f, \"p50_ns\": %.0f, "
+                 "\"p99_ns\": %.0f, \"p999_ns\": %.0f, \"max_ns\": %.0f,\n"
+                 "     \"allocs_per_cycle\": %.3f, \"overruns\": %d, "
+                 "\"realtime_factor\": %.2f}%s\n",
+              r[i].name, r[i].sr, r[i].ksmps, r[i].cycles,
+              r[i].mean, r[i].p50, r[i].p99, r[i].p999, r[i].max,
+              r[i].allocs, r[i].overruns, rt, i < nr - 1 ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+            "usage: csound-bench [-k cycles] [-w warmup] [-o out.json]\n"
+            "                    [-- csound options --] file.csd ...\n");
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+    BENCH_RESULT *r;
+    const char *out = NULL;
+    char    **opts = NULL;
+    int     i, nopts = 0, nr = 0, cycles = BENCH_CYCLES, warmup = BENCH_WARMUP;
+    FILE    *f = stdout;
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+      if (!strcmp(argv[i], "-k") && i + 1 < argc)
+        cycles = atoi(argv[++i]);
+      else if (!strcmp(argv[i], "-w") && i + 1 < argc)
+        warmup = atoi(argv[++i]);
+      else if (!strcmp(argv[i], "-o") && i + 1 < argc)
+        out = argv[++i];
+      else if (!strcmp(argv[i], "--")) {
+        opts = &argv[++i];
+        while (i < argc && strcmp(argv[i], "--") != 0) {
+          i++; nopts++;
+        }
+      }
+      else
+        usage();
+    }
+    if (i >= argc || cycles < 1 || warmup < 0)
+      usage();
+
+    csoundInitialize(CSOUNDINIT_NO_SIGNAL_HANDLER | CSOUNDINIT_NO_ATEXIT);
+    r = (BENCH_RESULT*) calloc(argc - i, sizeof(BENCH_RESULT));
+    for ( ; i < argc; i++) {
+      if (bench_run(argv[i], nopts, opts, cycles, warmup, &r[nr]) == 0) {
+        fprintf(stderr, "%-24s %10.0f ns/cycle  p99 %10.0f  p999 %10.0f  "
+                "%.3f allocs/cycle\n", r[nr].name, r[nr].mean, r[nr].p99,
+                r[nr].p999, r[nr].allocs);
+        nr++;
+      }
+    }
+    if (out != NULL && (f = fopen(out, "w")) == NULL) {
+      fprintf(stderr, "csound-bench: cannot write %s\n", out);
+      return 1;
+    }
+    bench_json(f, r, nr, cycles, warmup);
+    if (f != stdout)
+      fclose(f);
+    free(r);
+    return (nr > 0 ? 0 : 1);
+}
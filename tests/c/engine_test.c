@@ -1,6 +1,11 @@
 #include "csound.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <CUnit/Basic.h>
+#if defined(__linux__)
+#include <dirent.h>
+#endif
 
 #include "time.h"
 
@@ -54,6 +59,647 @@ void test_compile_async(void)
     csoundDestroy(csound);
 }
 
+void test_create_recompiled(void)
+{
+    CSOUND  *templ, *clone;
+    MYFLT   *tab;
+    templ = csoundCreate(NULL);
+    csoundSetOption(templ, "-n");
+    /* no code is kept unless the host asks for it */
+    CU_ASSERT_EQUAL(csoundCompileOrc(templ, "instr 2\nendin\n"), 0);
+    CU_ASSERT_PTR_NULL(csoundCreateRecompiled(templ, NULL));
+    csoundKeepOrcHistory(templ, 1);
+    CU_ASSERT_EQUAL(csoundCompileOrc(templ,
+                                     "giTab ftgen 1, 0, 8, -2, 1, 2, 3, 4, "
+                                     "5, 6, 7, 8\n"
+                                     "instr 1\n"
+                                     "endin\n"), 0);
+    csoundStart(templ);
+    clone = csoundCreateRecompiled(templ, NULL);
+    CU_ASSERT_PTR_NOT_NULL(clone);
+    CU_ASSERT_EQUAL(csoundGetTable(clone, &tab, 1), 8);
+    CU_ASSERT_DOUBLE_EQUAL(tab[7], 8.0, 0.0);
+    CU_ASSERT_EQUAL(csoundStart(clone), 0);
+    csoundDestroy(clone);
+    /* turning it off drops what was kept */
+    csoundKeepOrcHistory(templ, 0);
+    CU_ASSERT_PTR_NULL(csoundCreateRecompiled(templ, NULL));
+    csoundDestroy(templ);
+}
+
+/* Perform orc and sco offline with the options in opt, separated by
+   spaces, and keep the first channel of up to n sample frames of output
+   in buf; returns the number of frames kept */
+static int render(const char *orc, const char *sco, const char *opt,
+                  MYFLT *buf, int n)
+{
+    CSOUND  *csound = csoundCreate(NULL);
+    MYFLT   *spout;
+    int     i, cnt = 0, ksmps, nchnls;
+
+    csoundCreateMessageBuffer(csound, 0);
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, "-d");
+    while (opt != NULL && *opt != '\0') {
+      const char *e = strchr(opt, ' ');
+      char    o[64];
+      snprintf(o, sizeof(o), "%.*s",
+               (int) (e != NULL ? e - opt : (int) strlen(opt)), opt);
+      csoundSetOption(csound, o);
+      opt = (e != NULL ? e + 1 : NULL);
+    }
+    CU_ASSERT_EQUAL(csoundCompileOrc(csound, orc), 0);
+    CU_ASSERT_EQUAL(csoundReadScore(csound, sco), 0);
+    CU_ASSERT_EQUAL(csoundStart(csound), CSOUND_SUCCESS);
+    ksmps = csoundGetKsmps(csound);
+    nchnls = csoundGetNchnls(csound);
+    spout = csoundGetSpout(csound);
+    while (cnt < n && csoundPerformKsmps(csound) == 0)
+      for (i = 0; i < ksmps && cnt < n; i++)
+        buf[cnt++] = spout[i*nchnls];
+    csoundCleanup(csound);
+    csoundDestroyMessageBuffer(csound);
+    csoundDestroy(csound);
+    return cnt;
+}
+
+/* number of frames in which a and b differ by more than tol */
+static int count_diffs(const MYFLT *a, const MYFLT *b, int n, double tol)
+{
+    int i, cnt = 0;
+    for (i = 0; i < n; i++)
+      if (a[i] - b[i] > tol || b[i] - a[i] > tol)
+        cnt++;
+    return cnt;
+}
+
+#define RENDER_FRAMES (44100)
+
+static const char reduction_orc[] =
+  "sr = 44100\n"
+  "ksmps = 32\n"
+  "nchnls = 1\n"
+  "0dbfs = 1\n"
+  "giSine ftgen 1, 0, 4096, 10, 1\n"
+  "ga init 0\n"
+  "gk init 0\n"
+  "instr 1\n"
+  "  asig oscili 0.01, 100 + p4*7, 1\n"
+  "  ga += asig\n"
+  "  gk += p4\n"
+  "  out asig\n"
+  "endin\n"
+  "instr 2\n"
+  "  out ga + a(gk - 2080)\n"
+  "  ga = 0\n"
+  "  gk = 0\n"
+  "endin\n";
+
+/* voices on several threads mix into out and into globals as they do
+   on one */
+void test_parallel_reductions(void)
+{
+    static MYFLT    ref[RENDER_FRAMES], out[RENDER_FRAMES];
+    char    sco[4096];
+    int     i, len = 0, n;
+
+    for (i = 1; i <= 64; i++)
+      len += snprintf(sco + len, sizeof(sco) - len, "i1 0 1 %d\n", i);
+    snprintf(sco + len, sizeof(sco) - len, "i2 0 1\ne 1\n");
+    n = render(reduction_orc, sco, NULL, ref, RENDER_FRAMES);
+    CU_ASSERT(n > 40000);
+    CU_ASSERT_EQUAL(render(reduction_orc, sco, "-j4", out, RENDER_FRAMES), n);
+    /* gk misses a voice's p4 (1..64, 2080 in all) by at least 1 */
+    CU_ASSERT_EQUAL(count_diffs(ref, out, n, 1e-9), 0);
+}
+
+static const char packing_orc[] =
+  "sr = 44100\n"
+  "ksmps = 64\n"
+  "nchnls = 1\n"
+  "0dbfs = 1\n"
+  "giSine ftgen 1, 0, 4096, 10, 1\n"
+  "ga init 0\n"
+  "instr 1\n"
+  "  asig oscili 0.002, 50 + p4*3, 1\n"
+  "  ga = ga + asig\n"
+  "  out asig\n"
+  "endin\n"
+  "instr 2\n"
+  "  asig oscili 0.1, 220*p4, 1\n"
+  "  aL, aR reverbsc asig, asig, 0.9, 8000\n"
+  "  aL, aR reverbsc aL, aR, 0.9, 8000\n"
+  "  aL, aR reverbsc aL, aR, 0.9, 8000\n"
+  "  out aL\n"
+  "endin\n"
+  "instr 3\n"
+  "  out ga\n"
+  "  ga = 0\n"
+  "endin\n";
+
+/* Light voices packed into runs keep their order on the global they
+   share with each other and with its reader. Two seconds cover several
+   re-packings, which happen every 256 k-periods. */
+void test_task_packing(void)
+{
+    static MYFLT    ref[2*RENDER_FRAMES], out[2*RENDER_FRAMES];
+    char    sco[8192];
+    int     i, len = 0, n;
+
+    for (i = 1; i <= 200; i++)
+      len += snprintf(sco + len, sizeof(sco) - len, "i1 0 2 %d\n", i);
+    len += snprintf(sco + len, sizeof(sco) - len, "i2 0 2 1\ni2 0 2 2\n");
+    snprintf(sco + len, sizeof(sco) - len, "i3 0 2\ne 2\n");
+    n = render(packing_orc, sco, NULL, ref, 2*RENDER_FRAMES);
+    CU_ASSERT(n > 80000);
+    CU_ASSERT_EQUAL(render(packing_orc, sco, "-j4", out, 2*RENDER_FRAMES), n);
+    CU_ASSERT_EQUAL(count_diffs(ref, out, n, 1e-9), 0);
+}
+
+static const char pipeline_orc[] =
+  "sr = 44100\n"
+  "ksmps = 32\n"
+  "nchnls = 1\n"
+  "0dbfs = 1\n"
+  "giSine ftgen 1, 0, 4096, 10, 1\n"
+  "ga init 0\n"
+  "instr 1\n"
+  "  asig oscili 0.05, 100 + p4*37, 1\n"
+  "  ga += asig\n"
+  "endin\n"
+  "instr 2\n"
+  "  out ga\n"
+  "  ga = 0\n"
+  "endin\n"
+  "instr 3\n"
+  "  pipestage 2, 0\n"
+  "endin\n";
+
+/* Under --pipeline=1 the reader of a summed global is put a stage after
+   the voices and hears them one k-period late; when pipestage moves it
+   into their stage half way through, the stages are worked out again
+   and it hears them at once, as it does without -j */
+void test_pipeline_stages(void)
+{
+    static MYFLT    ref[RENDER_FRAMES], out[RENDER_FRAMES];
+    char    sco[1024];
+    int     i, len = 0, n, ksmps = 32;
+
+    for (i = 1; i <= 8; i++)
+      len += snprintf(sco + len, sizeof(sco) - len, "i1 0 1 %d\n", i);
+    snprintf(sco + len, sizeof(sco) - len, "i2 0 1\ni3 0.5 0.1\ne 1\n");
+    n = render(pipeline_orc, sco, NULL, ref, RENDER_FRAMES);
+    CU_ASSERT(n > 40000);
+    CU_ASSERT_EQUAL(render(pipeline_orc, sco, "-j2 --pipeline=1",
+                           out, RENDER_FRAMES), n);
+    CU_ASSERT_EQUAL(count_diffs(ref, out + ksmps, 19000, 1e-9), 0);
+    CU_ASSERT(count_diffs(ref, out, 19000, 1e-9) > 18000);
+    CU_ASSERT_EQUAL(count_diffs(ref + 24000, out + 24000, n - 24000, 1e-9), 0);
+}
+
+static const char planar_orc[] =
+  "sr = 44100\n"
+  "ksmps = 16\n"
+  "nchnls = 2\n"
+  "nchnls_i = 2\n"
+  "0dbfs = 1\n"
+  "giSine ftgen 1, 0, 4096, 10, 1\n"
+  "instr 1\n"
+  "  aL, aR ins\n"
+  "  a1 oscili 0.3, 441, 1\n"
+  "  a2 oscili 0.2, 882, 1\n"
+  "  outs a1 + aL*0.5, a2 - aR\n"
+  "endin\n";
+
+#define PLANAR_BLOCK (256)
+#define PLANAR_FRAMES (100*PLANAR_BLOCK)
+
+static MYFLT planar_input(int chn, int frame)
+{
+    return (MYFLT) ((frame*7 + chn*31) % 101) / FL(101.0) - FL(0.5);
+}
+
+static CSOUND *planar_start(void)
+{
+    CSOUND  *csound = csoundCreate(NULL);
+
+    csoundCreateMessageBuffer(csound, 0);
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, "-d");
+    CU_ASSERT_EQUAL(csoundCompileOrc(csound, planar_orc), 0);
+    CU_ASSERT_EQUAL(csoundReadScore(csound, "i1 0 2\ne 2\n"), 0);
+    return csound;
+}
+
+/* csoundSetHostBuffers blocks match the interleaved spin and spout of
+   csoundPerformKsmps, channel by channel, and leave spout alone */
+void test_host_buffers(void)
+{
+    static MYFLT    ref[2][PLANAR_FRAMES], out[2][PLANAR_FRAMES];
+    static MYFLT    in[2][PLANAR_FRAMES];
+    CSOUND  *csound;
+    MYFLT   *spin, *spout, *op[2];
+    const MYFLT *ipp[2];
+    int     i, c, t, ksmps, bad = 0;
+
+    for (c = 0; c < 2; c++)
+      for (t = 0; t < PLANAR_FRAMES; t++)
+        in[c][t] = planar_input(c, t);
+
+    csound = planar_start();
+    CU_ASSERT_EQUAL(csoundSetHostBuffers(csound, NULL, NULL, PLANAR_BLOCK),
+                    CSOUND_ERROR);
+    CU_ASSERT_EQUAL(csoundStart(csound), CSOUND_SUCCESS);
+    ksmps = csoundGetKsmps(csound);
+    spin = csoundGetSpin(csound);
+    spout = csoundGetSpout(csound);
+    for (t = 0; t < PLANAR_FRAMES; t += ksmps) {
+      for (i = 0; i < ksmps; i++)
+        for (c = 0; c < 2; c++)
+          spin[i*2 + c] = in[c][t + i];
+      CU_ASSERT_EQUAL(csoundPerformKsmps(csound), 0);
+      for (i = 0; i < ksmps; i++)
+        for (c = 0; c < 2; c++)
+          ref[c][t + i] = spout[i*2 + c];
+    }
+    csoundCleanup(csound);
+    csoundDestroyMessageBuffer(csound);
+    csoundDestroy(csound);
+
+    csound = planar_start();
+    CU_ASSERT_EQUAL(csoundStart(csound), CSOUND_SUCCESS);
+    CU_ASSERT_EQUAL(csoundSetHostBuffers(csound, NULL, NULL, ksmps + 1),
+                    CSOUND_ERROR);
+    spout = csoundGetSpout(csound);
+    for (t = 0; t < PLANAR_FRAMES; t += PLANAR_BLOCK) {
+      for (c = 0; c < 2; c++) {
+        op[c] = &out[c][t];
+        ipp[c] = &in[c][t];
+      }
+      CU_ASSERT_EQUAL(csoundSetHostBuffers(csound, op, ipp, PLANAR_BLOCK),
+                      CSOUND_SUCCESS);
+      CU_ASSERT_EQUAL(csoundPerformBuffer(csound), 0);
+    }
+    for (i = 0; i < 2*ksmps; i++)
+      if (spout[i] != FL(0.0))
+        bad++;
+    CU_ASSERT_EQUAL(bad, 0);
+    csoundCleanup(csound);
+    csoundDestroyMessageBuffer(csound);
+    csoundDestroy(csound);
+
+    CU_ASSERT(count_diffs(ref[0], ref[1], PLANAR_FRAMES, 1e-3) > 0);
+    CU_ASSERT_EQUAL(count_diffs(ref[0], out[0], PLANAR_FRAMES, 0.0), 0);
+    CU_ASSERT_EQUAL(count_diffs(ref[1], out[1], PLANAR_FRAMES, 0.0), 0);
+}
+
+static const char schedule_orc[] =
+  "sr = 32768\n"
+  "ksmps = 32\n"
+  "nchnls = 1\n"
+  "0dbfs = 1\n"
+  "giOrder ftgen 1, 0, 16, -2, 0\n"
+  "gicnt init 0\n"
+  "instr Tick\n"
+  "  tabw_i p4, gicnt, 1\n"
+  "  gicnt = gicnt + 1\n"
+  "endin\n"
+  "instr Click\n"
+  "  out a(1)\n"
+  "endin\n";
+
+static CSOUND *schedule_start(void)
+{
+    CSOUND  *csound = csoundCreate(NULL);
+
+    csoundCreateMessageBuffer(csound, 0);
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, "-d");
+    csoundSetOption(csound, "--sample-accurate");
+    CU_ASSERT_EQUAL(csoundCompileOrc(csound, schedule_orc), 0);
+    CU_ASSERT_EQUAL(csoundReadScore(csound, "f 0 2\n"), 0);
+    CU_ASSERT_EQUAL(csoundStart(csound), CSOUND_SUCCESS);
+    return csound;
+}
+
+/* A batch starts in time order, events at the same time in the order
+   given and after those already queued for it; an event for an unknown
+   instrument is dropped without the others; starts keep their sample
+   offset into the k-period */
+void test_schedule_events(void)
+{
+    CSOUND  *csound = schedule_start();
+    MYFLT   tick = csoundGetInstrumentHandle(csound, "Tick");
+    MYFLT   instr[6], pf[12], *spout;
+    int64_t start[6];
+    static const int order[] = { 2, 6, 7, 4, 1, 3, 0 };
+    static const int64_t when[] = { 64, 0, 64, 32, 0, 0 };
+    int     i, k, ksmps = csoundGetKsmps(csound), first = -1, t0 = 0;
+
+    CU_ASSERT(tick > FL(0.0));
+    CU_ASSERT_EQUAL(csoundGetInstrumentHandle(csound, "NoSuch"), FL(0.0));
+    for (i = 0; i < 6; i++) {
+      instr[i] = (i == 4 ? FL(99.0) : tick);
+      start[i] = when[i];
+      pf[2*i] = FL(0.01);
+      pf[2*i + 1] = (MYFLT) (i + 1);
+    }
+    CU_ASSERT_EQUAL(csoundScheduleEvents(csound, instr, start, pf, 2, 6),
+                    CSOUND_SUCCESS);
+    pf[1] = FL(7.0);
+    CU_ASSERT_EQUAL(csoundScheduleEvents(csound, instr, start + 1, pf, 2, 1),
+                    CSOUND_SUCCESS);
+    CU_ASSERT_EQUAL(csoundScheduleEvents(csound, instr, start, pf, 0, 1),
+                    CSOUND_ERROR);
+    CU_ASSERT_EQUAL(csoundScheduleEvents(csound, instr, start, pf, 2, -1),
+                    CSOUND_ERROR);
+    CU_ASSERT_EQUAL(csoundScheduleEvents(csound, instr, start, pf, 2, 0),
+                    CSOUND_SUCCESS);
+    for (i = 0; i < 8; i++)
+      CU_ASSERT_EQUAL(csoundPerformKsmps(csound), 0);
+    for (i = 0; i < 7; i++)
+      CU_ASSERT_EQUAL(csoundTableGet(csound, 1, i), (MYFLT) order[i]);
+    csoundCleanup(csound);
+    csoundDestroyMessageBuffer(csound);
+    csoundDestroy(csound);
+
+    csound = schedule_start();
+    for (i = 0; i < 3; i++, t0 += ksmps)
+      CU_ASSERT_EQUAL(csoundPerformKsmps(csound), 0);
+    instr[0] = csoundGetInstrumentHandle(csound, "Click");
+    start[0] = 2*ksmps + 13;
+    pf[0] = FL(0.5);
+    CU_ASSERT_EQUAL(csoundScheduleEvents(csound, instr, start, pf, 1, 1),
+                    CSOUND_SUCCESS);
+    spout = csoundGetSpout(csound);
+    for (i = 0; i < 8 && first < 0; i++) {
+      CU_ASSERT_EQUAL(csoundPerformKsmps(csound), 0);
+      for (k = 0; k < ksmps && first < 0; k++)
+        if (spout[k] != FL(0.0))
+          first = t0 + i*ksmps + k;
+    }
+    CU_ASSERT(first >= t0 + 2*ksmps + 13);
+    CU_ASSERT_EQUAL(first % ksmps, 13);
+    csoundCleanup(csound);
+    csoundDestroyMessageBuffer(csound);
+    csoundDestroy(csound);
+}
+
+static CSOUND *pool_instance(const char *pool, const char *sco)
+{
+    CSOUND  *csound = csoundCreate(NULL);
+
+    csoundCreateMessageBuffer(csound, 0);
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, "-d");
+    csoundSetOption(csound, "-j3");
+    csoundSetOption(csound, pool);
+    CU_ASSERT_EQUAL(csoundCompileOrc(csound, reduction_orc), 0);
+    CU_ASSERT_EQUAL(csoundReadScore(csound, sco), 0);
+    CU_ASSERT_EQUAL(csoundStart(csound), CSOUND_SUCCESS);
+    return csound;
+}
+
+static int pool_messages(CSOUND *csound, const char *s)
+{
+    int     n = 0;
+
+    while (csoundGetMessageCnt(csound) > 0) {
+      if (strstr(csoundGetFirstMessage(csound), s) != NULL)
+        n++;
+      csoundPopFirstMessage(csound);
+    }
+    return n;
+}
+
+static void pool_done(CSOUND *csound)
+{
+    csoundCleanup(csound);
+    csoundDestroyMessageBuffer(csound);
+    csoundDestroy(csound);
+}
+
+/* threads in this process, or -1 where that cannot be seen */
+static int thread_count(void)
+{
+#if defined(__linux__)
+    DIR     *d = opendir("/proc/self/task");
+    struct dirent *e;
+    int     n = 0;
+
+    if (d == NULL)
+      return -1;
+    while ((e = readdir(d)) != NULL)
+      if (e->d_name[0] != '.')
+        n++;
+    closedir(d);
+    return n;
+#else
+    return -1;
+#endif
+}
+
+/* two instances under --thread-pool share one set of worker threads,
+   sized by the first, and render as they do alone; the pool goes away
+   with the last of them and the next one starts it afresh */
+void test_thread_pool(void)
+{
+    static MYFLT    ref[RENDER_FRAMES], out[2][RENDER_FRAMES];
+    CSOUND  *cs[2];
+    MYFLT   *spout[2];
+    char    sco[4096];
+    int     i, c, len = 0, n, cnt = 0, ksmps, before, running = 2;
+
+    for (i = 1; i <= 64; i++)
+      len += snprintf(sco + len, sizeof(sco) - len, "i1 0 1 %d\n", i);
+    snprintf(sco + len, sizeof(sco) - len, "i2 0 1\ne 1\n");
+    n = render(reduction_orc, sco, NULL, ref, RENDER_FRAMES);
+    CU_ASSERT(n > 40000);
+
+    before = thread_count();
+    cs[0] = pool_instance("--thread-pool=2", sco);
+    cs[1] = pool_instance("--thread-pool=5", sco);
+    CU_ASSERT_EQUAL(pool_messages(cs[0], "from the shared pool of 2"), 1);
+    CU_ASSERT_EQUAL(pool_messages(cs[1], "from the shared pool of 2"), 1);
+    if (before > 0)
+      CU_ASSERT_EQUAL(thread_count(), before + 2);
+    ksmps = csoundGetKsmps(cs[0]);
+    for (c = 0; c < 2; c++)
+      spout[c] = csoundGetSpout(cs[c]);
+    /* interleaved k-periods, as two hosts in one process would run them */
+    while (running == 2 && cnt < n) {
+      for (c = 0; c < 2; c++)
+        if (csoundPerformKsmps(cs[c]) != 0)
+          running--;
+      if (running < 2)
+        break;
+      for (i = 0; i < ksmps && cnt < n; i++, cnt++)
+        for (c = 0; c < 2; c++)
+          out[c][cnt] = spout[c][i];
+    }
+    CU_ASSERT_EQUAL(running == 1, 0);
+    CU_ASSERT_EQUAL(cnt, n);
+    CU_ASSERT_EQUAL(count_diffs(ref, out[0], n, 1e-9), 0);
+    CU_ASSERT_EQUAL(count_diffs(ref, out[1], n, 1e-9), 0);
+    pool_done(cs[0]);
+    if (before > 0)
+      CU_ASSERT_EQUAL(thread_count(), before + 2);
+    pool_done(cs[1]);
+    if (before > 0)
+      CU_ASSERT_EQUAL(thread_count(), before);
+
+    cs[0] = pool_instance("--thread-pool=3", sco);
+    CU_ASSERT_EQUAL(pool_messages(cs[0], "from the shared pool of 3"), 1);
+    if (before > 0)
+      CU_ASSERT_EQUAL(thread_count(), before + 3);
+    pool_done(cs[0]);
+}
+
+static const char trace_orc[] =
+  "sr = 44100\n"
+  "ksmps = 32\n"
+  "nchnls = 1\n"
+  "0dbfs = 1\n"
+  "giSine ftgen 7, 0, 1024, 10, 1\n"
+  "instr Voice\n"
+  "  out oscili(0.1, 440, 7)\n"
+  "endin\n";
+
+#define TRACE_FILE "engine_test_trace.json"
+
+/* the contents of a file as a string, to be freed by the caller */
+static char *read_text(const char *path)
+{
+    FILE    *f = fopen(path, "rb");
+    char    *s;
+    long    n;
+
+    if (f == NULL)
+      return NULL;
+    fseek(f, 0L, SEEK_END);
+    n = ftell(f);
+    fseek(f, 0L, SEEK_SET);
+    s = (char*) malloc(n + 1);
+    n = (long) fread(s, 1, n, f);
+    s[n] = '\0';
+    fclose(f);
+    return s;
+}
+
+static int count_str(const char *s, const char *sub)
+{
+    int     n = 0;
+
+    while ((s = strstr(s, sub)) != NULL) {
+      n++;
+      s += strlen(sub);
+    }
+    return n;
+}
+
+/* 1 if no event on track tid ends more than have begun */
+static int trace_nested(const char *s, int tid)
+{
+    int     depth = 0, t;
+    char    ph;
+
+    while ((s = strstr(s, "{\"ph\":\"")) != NULL) {
+      s += 7;
+      if (sscanf(s, "%c\",\"pid\":1,\"tid\":%d", &ph, &t) != 2 || t != tid)
+        continue;
+      if (ph == 'B')
+        depth++;
+      else if (ph == 'E' && --depth < 0)
+        return 0;
+    }
+    return 1;
+}
+
+/* opt holds options, each ended by a NUL, then an empty one */
+static CSOUND *trace_instance(const char *opt, int voices)
+{
+    int     i;
+
+    CSOUND  *csound = csoundCreate(NULL);
+
+    csoundCreateMessageBuffer(csound, 0);
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, "-d");
+    while (opt != NULL && *opt != '\0') {
+      csoundSetOption(csound, (char*) opt);
+      opt += strlen(opt) + 1;
+    }
+    CU_ASSERT_EQUAL(csoundCompileOrc(csound, trace_orc), 0);
+    for (i = 0; i < voices; i++)
+      CU_ASSERT_EQUAL(csoundReadScore(csound, "i \"Voice\" 0 10\n"), 0);
+    return csound;
+}
+
+/* csoundWriteTrace pairs every k-cycle and instrument pass with its end,
+   names instruments and tables, and drops ends whose begins the ring has
+   overwritten; --trace writes the file on cleanup */
+void test_trace(void)
+{
+    CSOUND  *csound;
+    char    *s;
+    int     i;
+
+    csound = trace_instance(NULL, 1);
+    CU_ASSERT_EQUAL(csoundWriteTrace(csound, TRACE_FILE), CSOUND_ERROR);
+    CU_ASSERT_EQUAL(csoundSetTrace(csound, 4096), CSOUND_SUCCESS);
+    CU_ASSERT_EQUAL(csoundStart(csound), CSOUND_SUCCESS);
+    for (i = 0; i < 100; i++)
+      CU_ASSERT_EQUAL(csoundPerformKsmps(csound), 0);
+    CU_ASSERT_EQUAL(csoundWriteTrace(csound, TRACE_FILE), CSOUND_SUCCESS);
+    s = read_text(TRACE_FILE);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(s);
+    CU_ASSERT(strncmp(s, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[",
+                      38) == 0);
+    CU_ASSERT(strstr(s, "\n]}\n") != NULL);
+    CU_ASSERT_EQUAL(count_str(s, "\"name\":\"kperf\""), 200);
+    CU_ASSERT_EQUAL(count_str(s, "\"name\":\"instr Voice\""), 200);
+    CU_ASSERT_EQUAL(count_str(s, "\"name\":\"hfgens\",\"args\":{\"n\":7}"), 2);
+    CU_ASSERT_EQUAL(count_str(s, "\"ph\":\"B\""), count_str(s, "\"ph\":\"E\""));
+    CU_ASSERT(strstr(s, "\"args\":{\"name\":\"performance\"}") != NULL);
+    free(s);
+
+    /* a ring of 1024 events holds only the last few hundred k-cycles */
+    CU_ASSERT_EQUAL(csoundSetTrace(csound, 1000), CSOUND_SUCCESS);
+    for (i = 0; i < 1000; i++)
+      CU_ASSERT_EQUAL(csoundPerformKsmps(csound), 0);
+    CU_ASSERT_EQUAL(csoundWriteTrace(csound, TRACE_FILE), CSOUND_SUCCESS);
+    s = read_text(TRACE_FILE);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(s);
+    CU_ASSERT(count_str(s, "\"ph\":\"B\"") <= 1024);
+    CU_ASSERT(count_str(s, "\"name\":\"kperf\"") > 400);
+    CU_ASSERT(trace_nested(s, 0));
+    free(s);
+    CU_ASSERT_EQUAL(csoundSetTrace(csound, 0), CSOUND_SUCCESS);
+    CU_ASSERT_EQUAL(csoundWriteTrace(csound, TRACE_FILE), CSOUND_ERROR);
+    csoundCleanup(csound);
+    csoundDestroyMessageBuffer(csound);
+    csoundDestroy(csound);
+    remove(TRACE_FILE);
+
+    /* under -j2 either thread may play a voice, each on its own track */
+    csound = trace_instance("--trace=" TRACE_FILE "\0-j2\0", 8);
+    CU_ASSERT_EQUAL(csoundStart(csound), CSOUND_SUCCESS);
+    for (i = 0; i < 100; i++)
+      CU_ASSERT_EQUAL(csoundPerformKsmps(csound), 0);
+    CU_ASSERT_PTR_NULL(read_text(TRACE_FILE));
+    csoundCleanup(csound);
+    csoundDestroyMessageBuffer(csound);
+    csoundDestroy(csound);
+    s = read_text(TRACE_FILE);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(s);
+    CU_ASSERT_EQUAL(count_str(s, "\"name\":\"kperf\""), 200);
+    CU_ASSERT_EQUAL(count_str(s, "\"name\":\"instr Voice\""), 1600);
+    CU_ASSERT(count_str(s, "\"name\":\"dag_build\"") > 0);
+    CU_ASSERT(trace_nested(s, 0) && trace_nested(s, 1));
+    free(s);
+    remove(TRACE_FILE);
+}
+
 int main()
 {
     CU_pSuite pSuite = NULL;
@@ -72,7 +718,15 @@ int main()
     /* add the tests to the suite */
     if ((NULL == CU_add_test(pSuite, "Test daemon mode", test_daemon))
         || (NULL == CU_add_test(pSuite, "Test evalcode", test_eval_code))
-	|| (NULL == CU_add_test(pSuite, "Test compileAsync", test_compile_async)) 
+	|| (NULL == CU_add_test(pSuite, "Test compileAsync", test_compile_async))
+	|| (NULL == CU_add_test(pSuite, "Test createRecompiled", test_create_recompiled))
+        || (NULL == CU_add_test(pSuite, "Test out and g += under -j", test_parallel_reductions))
+        || (NULL == CU_add_test(pSuite, "Test cost-balanced DAG tasks", test_task_packing))
+        || (NULL == CU_add_test(pSuite, "Test --pipeline stages and pipestage", test_pipeline_stages))
+        || (NULL == CU_add_test(pSuite, "Test planar host buffers", test_host_buffers))
+        || (NULL == CU_add_test(pSuite, "Test csoundScheduleEvents", test_schedule_events))
+        || (NULL == CU_add_test(pSuite, "Test --thread-pool shared by two instances", test_thread_pool))
+        || (NULL == CU_add_test(pSuite, "Test timeline tracing", test_trace))
 	)
     {
         CU_cleanup_registry();
@@ -0,0 +1,1097 @@
+#include "csound.h"
+#include <stdio.h>
+#include <string.h>
+#include <CUnit/Basic.h>
+#if defined(__linux__)
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#endif
+
+/* directory of the test sources, from the command line */
+static const char *srcdir = "";
+
+int init_suite1(void)
+{
+    return 0;
+}
+
+int clean_suite1(void)
+{
+    return 0;
+}
+
+/* Compile orc with the extra options in opt, separated by spaces (or
+   NULL), and start sco offline */
+static CSOUND *start_orc(const char *orc, const char *sco, const char *opt)
+{
+    CSOUND *csound = csoundCreate(NULL);
+    csoundCreateMessageBuffer(csound, 0);
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, "-d");
+    while (opt != NULL && *opt != '\0') {
+      const char *e = strchr(opt, ' ');
+      char    o[64];
+      snprintf(o, sizeof(o), "%.*s",
+               (int) (e != NULL ? e - opt : (int) strlen(opt)), opt);
+      csoundSetOption(csound, o);
+      opt = (e != NULL ? e + 1 : NULL);
+    }
+    CU_ASSERT_EQUAL(csoundCompileOrc(csound, orc), 0);
+    CU_ASSERT_EQUAL(csoundReadScore(csound, sco), 0);
+    CU_ASSERT_EQUAL(csoundStart(csound), CSOUND_SUCCESS);
+    return csound;
+}
+
+/* the same, performing sco to its end */
+static CSOUND *run_orc(const char *orc, const char *sco, const char *opt)
+{
+    CSOUND *csound = start_orc(orc, sco, opt);
+    while (csoundPerformKsmps(csound) == 0)
+      ;
+    return csound;
+}
+
+static MYFLT channel(CSOUND *csound, const char *name)
+{
+    return csoundGetControlChannel(csound, name, NULL);
+}
+
+static void done(CSOUND *csound)
+{
+    csoundCleanup(csound);
+    csoundDestroyMessageBuffer(csound);
+    csoundDestroy(csound);
+}
+
+/* the number of messages containing s; the buffer is emptied */
+static int messages_with(CSOUND *csound, const char *s)
+{
+    int     n = 0;
+
+    while (csoundGetMessageCnt(csound) > 0) {
+      if (strstr(csoundGetFirstMessage(csound), s) != NULL)
+        n++;
+      csoundPopFirstMessage(csound);
+    }
+    return n;
+}
+
+static const char mp3_orc[] =
+  "sr = 44100\n"
+  "ksmps = 64\n"
+  "nchnls = 2\n"
+  "0dbfs = 1\n"
+  "instr 1\n"
+  "  aL, aR mp3in \"%s\"\n"
+  "  ksum init 0\n"
+  "  ksum += rms(aL) + rms(aR)\n"
+  "  Sch sprintf \"sum%%d\", p4\n"
+  "  chnset ksum, Sch\n"
+  "endin\n";
+
+/* every block of the file is played, the same way each time */
+void test_mp3in(void)
+{
+    char    orc[1024], path[512];
+    CSOUND  *csound;
+    MYFLT   first, second, again;
+
+    snprintf(path, sizeof(path), "%s../soak/beats.mp3", srcdir);
+    snprintf(orc, sizeof(orc), mp3_orc, path);
+    /* the instance of the first note is reused by the second */
+    csound = run_orc(orc, "i1 0 1 1\n"
+                          "i1 1.5 1 2\n"
+                          "e 3\n", NULL);
+    first = channel(csound, "sum1");
+    second = channel(csound, "sum2");
+    done(csound);
+    CU_ASSERT(first > 0.0);
+    CU_ASSERT_DOUBLE_EQUAL(first, second, 1e-9);
+    csound = run_orc(orc, "i1 0 1 1\ne 1\n", NULL);
+    again = channel(csound, "sum1");
+    done(csound);
+    CU_ASSERT_DOUBLE_EQUAL(first, again, 1e-9);
+}
+
+static const char tablexs_orc[] =
+  "sr = 44100\n"
+  "ksmps = 32\n"
+  "0dbfs = 1\n"
+  "giSine ftgen 1, 0, 4096, 10, 1\n"
+  "instr 1\n"
+  "  aph phasor 441*0.731\n"
+  "  aref = sin(2*$M_PI*aph)\n"
+  "  as tablexs aph*4096, 1, 32, 1, 0, 0, 1\n"
+  "  akt tablexkt aph*4096, 1, 1, 32, 0, 0, 1\n"
+  "  kerr peak as - aref\n"
+  "  kdif peak as - akt\n"
+  "  kamp peak as\n"
+  "  chnset kamp, \"amp\"\n"
+  "  chnset kerr, \"err\"\n"
+  "  chnset kdif, \"dif\"\n"
+  "endin\n";
+
+/* a sine table read at fractional positions through the sinc kernel */
+void test_tablexs(void)
+{
+    CSOUND *csound = run_orc(tablexs_orc, "i1 0 0.5\ne 0.5\n", NULL);
+    CU_ASSERT(channel(csound, "amp") > 0.99);
+    CU_ASSERT(channel(csound, "err") < 1e-3);
+    CU_ASSERT(channel(csound, "dif") < 1e-3);
+    done(csound);
+}
+
+static const char reverb_orc[] =
+  "sr = 44100\n"
+  "ksmps = 32\n"
+  "nchnls = 2\n"
+  "0dbfs = 1\n"
+  "instr 1\n"
+  "  kc init 0\n"
+  "  ain upsamp (kc == 0 ? 1 : 0)\n"
+  "  kc += 1\n"
+  "  aL, aR reverbsc ain, ain, 0.85, 12000\n"
+  "  outs aL, aR\n"
+  "endin\n"
+  "instr 2\n"
+  "  kc init 0\n"
+  "  ain upsamp (kc == 0 ? 1 : 0)\n"
+  "  kc += 1\n"
+  "  aL, aR freeverb ain, ain, 0.8, 0.4\n"
+  "  outs aL, aR\n"
+  "endin\n";
+
+/* Output of the scalar reverbsc and freeverb that preceded the
+   structure-of-arrays versions, for a 32 sample pulse at 44.1 kHz:
+   every 2205th sample frame of the first second, and the energy */
+static const double reverbsc_ref[20][2] = {
+    { 0, 0 },
+    { 0, 8.4789609385676415e-140 },
+    { 2.5738298937138396e-136, 4.8163716308484378e-135 },
+    { 0.061638389557768437, 0.061528279136626576 },
+    { 0.10149667894668588, 0.07753410387681188 },
+    { -0.015946874970361128, -0.0089797844803754922 },
+    { -0.026054509684930151, -0.044363890009597493 },
+    { 0.030420715894395104, -0.02916201330740802 },
+    { 0.0049375869374978908, -0.010557287606412552 },
+    { 0.011841396987231559, 0.011898678754725594 },
+    { 0.022209447702046015, 0.028868509401453486 },
+    { 0.056148323393731082, 0.044866533583126617 },
+    { -0.0048053278496777777, -0.0028491826188958734 },
+    { 0.018143668140580101, 0.012874384886264311 },
+    { 0.01430364436987005, -0.0017043453939805109 },
+    { 0.0074645167552756849, 0.003642808720655429 },
+    { -0.0088982411972255981, -0.015189934511549869 },
+    { -0.0036773524202755488, 0.011679138131159488 },
+    { 0.0078580926716957916, 0.001707479811604142 },
+    { -0.006006258005220538, -0.00092332182575801443 }
+};
+static const double reverbsc_energy = 93.644864511202016;
+
+static const double freeverb_ref[20][2] = {
+    { 0, 0 },
+    { 0.076874999999999999, 0.031875000000000001 },
+    { -0.016346015450870218, 0.0080119105938320657 },
+    { 0.0035413107376939929, -0.031916530766496365 },
+    { -0.041296855671770563, 0.032953612004837235 },
+    { 0.0064388531114381925, 0.00911835414067012 },
+    { -0.027606973273263911, 0.013424348056880891 },
+    { 0.014314718318026142, 0.0066556190360938855 },
+    { 0.0071375847102939658, 0.0029414803690397673 },
+    { -0.010765718429556898, 0.020642398074469593 },
+    { -0.016070686593418843, -0.0050036535232030428 },
+    { 0.010755763607905755, 0.0082248037827444657 },
+    { 0.012189572456179285, -0.0024416126963914537 },
+    { -0.0017975626407415281, -0.010566997341965562 },
+    { 0.001324526548260033, 0.0063349538909873819 },
+    { -0.0023419766299160416, -0.007554590365567832 },
+    { 0.0099487235063435361, 0.0036756606028577363 },
+    { -0.010108727647776684, -0.0035514675471895584 },
+    { -0.00088197830067629273, 0.0020253374313418389 },
+    { 0.0011548787701925632, -0.00050909398648733796 }
+};
+static const double freeverb_energy = 21.005525685322439;
+
+static void check_reverb(const char *sco, const double ref[20][2],
+                         double energy)
+{
+    CSOUND  *csound = start_orc(reverb_orc, sco, NULL);
+    MYFLT   *spout = csoundGetSpout(csound);
+    double  e = 0.0;
+    int     n = 0, i, ksmps = csoundGetKsmps(csound);
+
+    while (n < 44100 && csoundPerformKsmps(csound) == 0) {
+      for (i = 0; i < ksmps && n < 44100; i++, n++) {
+        e += spout[2*i]*spout[2*i] + spout[2*i+1]*spout[2*i+1];
+        if (n % 2205 == 0) {
+          CU_ASSERT_DOUBLE_EQUAL(spout[2*i], ref[n/2205][0], 1e-12);
+          CU_ASSERT_DOUBLE_EQUAL(spout[2*i+1], ref[n/2205][1], 1e-12);
+        }
+      }
+    }
+    CU_ASSERT_EQUAL(n, 44100);
+    CU_ASSERT_DOUBLE_EQUAL(e, energy, 1e-9);
+    done(csound);
+}
+
+/* the delay networks produce what they did before they were vectorised */
+void test_reverbs(void)
+{
+    check_reverb("i1 0 2\ne 2\n", reverbsc_ref, reverbsc_energy);
+    check_reverb("i2 0 2\ne 2\n", freeverb_ref, freeverb_energy);
+}
+
+static const char partikkel_orc[] =
+  "sr = 48000\n"
+  "ksmps = 64\n"
+  "nchnls = 2\n"
+  "0dbfs = 1\n"
+  "giSine ftgen 1, 0, 4096, 10, 1\n"
+  "giCos  ftgen 2, 0, 8192, 9, 1, 1, 90\n"
+  "giHalf ftgen 3, 0, 4096, 9, 0.5, 1, 0\n"
+  "giSaw  ftgen 4, 0, 1024, 7, -1, 1024, 1\n"
+  "giRamp ftgen 5, 0, 256, 7, 0, 256, 1\n"
+  "giGain ftgen 6, 0, 8, -2, 0, 0, 0.3, 0.4, 0.5, 0.6, 0.7\n"
+  "giChan ftgen 7, 0, 8, -2, 0, 2, 0, 0.5, 1\n"
+  "instr 1\n"
+  "  a0 = 0\n"
+  "  asp = 0.1\n"
+  "  a1, a2 partikkel 150, 0, 5, a0, 0.3, -1, 3, 3, 0.4, 0.5, 60, 0.5, -1,\n"
+  "        220, 0.3, -1, -1, a0, -1, -1, 2, 100, 10, 0.7, 7, 0, 1, 3, 4, 1,\n"
+  "        6, asp, asp, asp, asp, 1, 1.5, 2, 0.5, 100\n"
+  "  outs a1, a2\n"
+  "endin\n";
+
+/* Output of the linked-list partikkel that preceded the grain store, for
+   the instrument above: every 2401st sample frame of the first second,
+   and the energy */
+static const double partikkel_ref[20][2] = {
+    { 0, 0 },
+    { 0.41725020514949951, -0.048281110122363968 },
+    { 0.12101783519989918, 0.22938944936095557 },
+    { 0.43736791293796623, -0.015539724530588366 },
+    { -0.045310641472740193, 0.074083646116024096 },
+    { 0.45589589242700362, -0.012983521066600591 },
+    { -0.030460738841541112, 0.099542889591843667 },
+    { 0.47322381460286567, -0.0099750671003905368 },
+    { -0.015344023142700326, 0.12462344211880469 },
+    { 0.48901922681991283, -0.0065938115990771427 },
+    { 0.00028320397864365493, 0.14970313406726238 },
+    { 0.50366136188277855, -0.0028470901734324238 },
+    { 0.01597172522334071, 0.17415770060069813 },
+    { 0.51685866988123563, 0.0011955389583929244 },
+    { 0.032063559491958091, 0.19837321916049827 },
+    { 0.52897029959512454, 0.0054977430984946354 },
+    { 0.048052671610633549, 0.22174565746573549 },
+    { 0.53973870222907316, 0.010016474790007467 },
+    { 0.064347482189934441, 0.24466196491079845 },
+    { 0.54949564839566145, 0.014705424705201347 }
+};
+static const double partikkel_energy = 10127.110088949383;
+
+/* overlapping grains of four waveforms mix as they did before */
+void test_partikkel(void)
+{
+    CSOUND  *csound = start_orc(partikkel_orc, "i1 0 2\ne 2\n", NULL);
+    MYFLT   *spout = csoundGetSpout(csound);
+    double  e = 0.0;
+    int     n = 0, i, ksmps = csoundGetKsmps(csound);
+
+    while (n < 48000 && csoundPerformKsmps(csound) == 0) {
+      for (i = 0; i < ksmps; i++, n++) {
+        e += spout[2*i]*spout[2*i] + spout[2*i+1]*spout[2*i+1];
+        if (n % 2401 == 0) {
+          CU_ASSERT_DOUBLE_EQUAL(spout[2*i], partikkel_ref[n/2401][0], 1e-9);
+          CU_ASSERT_DOUBLE_EQUAL(spout[2*i+1], partikkel_ref[n/2401][1], 1e-9);
+        }
+      }
+    }
+    CU_ASSERT_EQUAL(n, 48000);
+    CU_ASSERT_DOUBLE_EQUAL(e, partikkel_energy, 1e-6);
+    done(csound);
+}
+
+/* sr is a power of two so that every increment is exact and both sides
+   step their phases identically */
+static const char adsynt_orc[] =
+  "sr = 32768\n"
+  "ksmps = 64\n"
+  "0dbfs = 1\n"
+  "giSine ftgen 1, 0, 4096, 10, 1\n"
+  "giFreq ftgen 2, 0, 4, -2, 1, 2.5, 3\n"
+  "giAmp  ftgen 3, 0, 4, -2, 1, 0.5, 0.25\n"
+  "instr 1\n"
+  "  abank adsynt 0.5, 220, 1, 2, 3, 3\n"
+  "  a1 oscil 0.5, 220, 1\n"
+  "  a2 oscil 0.25, 550, 1\n"
+  "  a3 oscil 0.125, 660, 1\n"
+  "  kdif peak abank - (a1 + a2 + a3)\n"
+  "  kamp peak abank\n"
+  "  chnset kdif, \"dif\"\n"
+  "  chnset kamp, \"amp\"\n"
+  "endin\n";
+
+/* the bank sums its partials as separate oscillators would */
+void test_adsynt(void)
+{
+    CSOUND *csound = run_orc(adsynt_orc, "i1 0 1\ne 1\n", NULL);
+    CU_ASSERT(channel(csound, "amp") > 0.5);
+    CU_ASSERT(channel(csound, "dif") < 1e-12);
+    done(csound);
+}
+
+static const char dumpk_orc[] =
+  "sr = 44100\n"
+  "ksmps = 64\n"
+  "instr 1\n"
+  "  kc init 0\n"
+  "  kc += 1\n"
+  "  dumpk kc, \"opcode_test_dumpk.dat\", 6, 0\n"
+  "endin\n"
+  "instr 2\n"
+  "  kc init 0\n"
+  "  kbad init 0\n"
+  "  kc += 1\n"
+  "  kr readk \"opcode_test_dumpk.dat\", 6, 0\n"
+  "  kbad += (kr == kc ? 0 : 1)\n"
+  "  chnset kc, \"count\"\n"
+  "  chnset kbad, \"bad\"\n"
+  "endin\n";
+
+/* records written through the I/O thread are all there, in order, for
+   a reader that also goes through it */
+void test_dumpk_readk(void)
+{
+    CSOUND *csound = run_orc(dumpk_orc, "i1 0 0.5\ne 0.5\n", "--realtime");
+    done(csound);
+    csound = run_orc(dumpk_orc, "i2 0 0.5\ne 0.5\n", "--realtime");
+    CU_ASSERT(channel(csound, "count") > 300);
+    CU_ASSERT_EQUAL(channel(csound, "bad"), 0);
+    done(csound);
+    remove("opcode_test_dumpk.dat");
+}
+
+static int run_utility(const char *name, const char *opt, const char *in,
+                       const char *out)
+{
+    CSOUND  *csound = csoundCreate(NULL);
+    char    *argv[4];
+    int     ret;
+
+    csoundCreateMessageBuffer(csound, 0);
+    argv[0] = (char *) name;
+    argv[1] = (char *) opt;
+    argv[2] = (char *) in;
+    argv[3] = (char *) out;
+    ret = csoundRunUtility(csound, name, 4, argv);
+    csoundDestroyMessageBuffer(csound);
+    csoundDestroy(csound);
+    return ret;
+}
+
+static int same_file(const char *a, const char *b)
+{
+    FILE    *fa = fopen(a, "rb"), *fb = fopen(b, "rb");
+    int     ca, cb, n = 0;
+
+    if (fa == NULL || fb == NULL) {
+      if (fa != NULL) fclose(fa);
+      if (fb != NULL) fclose(fb);
+      return 0;
+    }
+    do {
+      ca = getc(fa);
+      cb = getc(fb);
+      n++;
+    } while (ca == cb && ca != EOF);
+    fclose(fa);
+    fclose(fb);
+    return (ca == cb && n > 1);
+}
+
+/* analysis on four threads writes the same file as the serial path */
+void test_analysis_threads(void)
+{
+    static const char *util[3][3] = {
+      { "pvanal", "opcode_test_1.pvx", "opcode_test_4.pvx" },
+      { "hetro",  "opcode_test_1.het", "opcode_test_4.het" },
+      { "lpanal", "opcode_test_1.lpc", "opcode_test_4.lpc" }
+    };
+    char    in[512];
+    int     i;
+
+    snprintf(in, sizeof(in), "%s../commandline/fox.wav", srcdir);
+    for (i = 0; i < 3; i++) {
+      CU_ASSERT_EQUAL(run_utility(util[i][0], "-j1", in, util[i][1]), 0);
+      CU_ASSERT_EQUAL(run_utility(util[i][0], "-j4", in, util[i][2]), 0);
+      CU_ASSERT(same_file(util[i][1], util[i][2]));
+      remove(util[i][1]);
+      remove(util[i][2]);
+    }
+}
+
+#if defined(__linux__)
+/* client and server take part on one machine through CS_REMOTE_ADDR */
+static const char remote_orc[] =
+  "sr = 44100\n"
+  "ksmps = 64\n"
+  "nchnls = 1\n"
+  "0dbfs = 1\n"
+  "remoteport 40102\n"
+  "remoteaudio 2\n"
+  "insremot \"127.0.0.1\", \"127.0.0.2\", 1\n"
+  "instr 1\n"
+  "  aout = 0.25\n"
+  "  out aout\n"
+  "endin\n"
+  "instr 2\n"
+  "  aout = 0.5\n"
+  "  out aout\n"
+  "endin\n";
+#endif
+
+/* a remote instrument is heard in step with a local one */
+void test_remote_audio(void)
+{
+#if defined(__linux__)
+    CSOUND  *csound;
+    MYFLT   *spout;
+    pid_t   pid;
+    int     status, both = 0, one = 0;
+
+    pid = fork();
+    CU_ASSERT(pid >= 0);
+    if (pid == 0) {
+      setenv("CS_REMOTE_ADDR", "127.0.0.2", 1);
+      run_orc(remote_orc, "f0 60\n", NULL);
+      _exit(0);
+    }
+    csoundSleep(1000);          /* let the server listen */
+    setenv("CS_REMOTE_ADDR", "127.0.0.1", 1);
+    csound = start_orc(remote_orc, "i1 0 1\ni2 0 1\ne 1.2\n", NULL);
+    spout = csoundGetSpout(csound);
+    while (csoundPerformKsmps(csound) == 0) {
+      if (spout[0] == 0.75) both++;
+      else if (spout[0] != 0.0) one++;
+    }
+    done(csound);
+    unsetenv("CS_REMOTE_ADDR");
+    waitpid(pid, &status, 0);
+    CU_ASSERT(both > 600);
+    CU_ASSERT_EQUAL(one, 0);
+#endif
+}
+
+static const char midi_orc[] =
+  "sr = 44100\n"
+  "ksmps = 64\n"
+  "nchnls = 1\n"
+  "0dbfs = 1\n"
+  "instr 1\n"
+  "  aout upsamp 1\n"
+  "  out aout\n"
+  "endin\n";
+
+static int midi_reads;
+
+static int midi_open(CSOUND *csound, void **userData, const char *dev)
+{
+    (void) csound; (void) dev;
+    *userData = NULL;
+    midi_reads = 0;
+    return 0;
+}
+
+/* a note-on that arrived 16 samples before the fifth read */
+static int midi_read(CSOUND *csound, void *userData, unsigned char *buf,
+                     int nbytes, double *times)
+{
+    int i;
+    (void) userData;
+    if (++midi_reads != 5 || nbytes < 3)
+      return 0;
+    buf[0] = 0x90;
+    buf[1] = 60;
+    buf[2] = 100;
+    for (i = 0; i < 3; i++)
+      times[i] = 16.0 / csoundGetSr(csound);
+    return 3;
+}
+
+/* the note starts at its time stamp, one k-period late */
+void test_midi_timestamps(void)
+{
+    CSOUND  *csound = csoundCreate(NULL);
+    MYFLT   *spout;
+    int     k = 0, i, start = -1, ksmps;
+
+    csoundCreateMessageBuffer(csound, 0);
+    csoundSetHostImplementedMIDIIO(csound, 1);
+    csoundSetExternalMidiInOpenCallback(csound, midi_open);
+    csoundSetExternalMidiReadTimedCallback(csound, midi_read);
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, "-d");
+    csoundSetOption(csound, "-M0");
+    csoundSetOption(csound, "--sample-accurate");
+    CU_ASSERT_EQUAL(csoundCompileOrc(csound, midi_orc), 0);
+    CU_ASSERT_EQUAL(csoundReadScore(csound, "f0 0.1\n"), 0);
+    CU_ASSERT_EQUAL(csoundStart(csound), CSOUND_SUCCESS);
+    ksmps = csoundGetKsmps(csound);
+    spout = csoundGetSpout(csound);
+    while (start < 0 && csoundPerformKsmps(csound) == 0) {
+      for (i = 0; i < ksmps; i++)
+        if (spout[i] != 0.0) {
+          start = k*ksmps + i;
+          break;
+        }
+      k++;
+    }
+    done(csound);
+    /* started 16 samples before the end of the k-period it was read in */
+    CU_ASSERT(start >= 64);
+    CU_ASSERT_EQUAL(start % 64, 64 - 16);
+}
+
+static const char cache_orc[] =
+  "sr = 44100\n"
+  "ksmps = 32\n"
+  "nchnls = 1\n"
+  "0dbfs = 1\n"
+  "gaBus init 0\n"
+  "opcode Twice, a, a\n"
+  "  ain xin\n"
+  "  xout ain*2\n"
+  "endop\n"
+  "instr Voice\n"
+  "  asig oscili 0.1, 110*p4\n"
+  "  gaBus += Twice(asig)\n"
+  "endin\n"
+  "instr Sum\n"
+  "  ksum init 0\n"
+  "  ksum += rms(gaBus)\n"
+  "  chnset ksum, \"sum\"\n"
+  "  gaBus = 0\n"
+  "endin\n";
+
+static const char cache_sco[] =
+  "i \"Voice\" 0 1 1\n"
+  "i \"Voice\" 0 1 2\n"
+  "i \"Voice\" 0 1 3\n"
+  "i \"Sum\" 0 1\n"
+  "e 1\n";
+
+#if defined(__linux__)
+/* the number of trees in the cache directory; the path of the last */
+static int cache_files(const char *dir, char *path, size_t n)
+{
+    DIR     *d = opendir(dir);
+    struct dirent *ent;
+    int     cnt = 0;
+
+    if (d == NULL)
+      return 0;
+    while ((ent = readdir(d)) != NULL)
+      if (strstr(ent->d_name, ".orctree") != NULL) {
+        snprintf(path, n, "%s/%s", dir, ent->d_name);
+        cnt++;
+      }
+    closedir(d);
+    return cnt;
+}
+
+static MYFLT cache_run(const char *opt)
+{
+    CSOUND  *csound = run_orc(cache_orc, cache_sco, opt);
+    MYFLT   sum = channel(csound, "sum");
+    done(csound);
+    return sum;
+}
+#endif
+
+/* An orchestra compiled again is read from the cache, UDO and globals
+   included, and plays as it did; a damaged tree is parsed again and
+   replaced */
+void test_orc_cache(void)
+{
+#if defined(__linux__)
+    char    dir[] = "/tmp/csorcXXXXXX", path[512];
+    struct stat st;
+    ino_t   ino;
+    off_t   size;
+    MYFLT   ref, sum;
+    FILE    *f;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(mkdtemp(dir));
+    setenv("CS_ORC_CACHE", dir, 1);
+    ref = cache_run(NULL);
+    CU_ASSERT(ref > 1.0);
+    CU_ASSERT_EQUAL_FATAL(cache_files(dir, path, sizeof(path)), 1);
+    CU_ASSERT_EQUAL(stat(path, &st), 0);
+    ino = st.st_ino;
+    size = st.st_size;
+
+    /* read back, not written again */
+    CU_ASSERT_EQUAL(cache_run(NULL), ref);
+    CU_ASSERT_EQUAL(stat(path, &st), 0);
+    CU_ASSERT_EQUAL(st.st_ino, ino);
+    sum = cache_run("-j2");
+    CU_ASSERT(sum > ref - 1e-9 && sum < ref + 1e-9);
+    CU_ASSERT_EQUAL(cache_files(dir, path, sizeof(path)), 1);
+
+    f = fopen(path, "wb");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(f);
+    fputs("CSORCT\n damaged", f);
+    fclose(f);
+    CU_ASSERT_EQUAL(cache_run(NULL), ref);
+    CU_ASSERT_EQUAL(stat(path, &st), 0);
+    CU_ASSERT_NOT_EQUAL(st.st_ino, ino);
+    CU_ASSERT_EQUAL(st.st_size, size);
+
+    unsetenv("CS_ORC_CACHE");
+    remove(path);
+    rmdir(dir);
+#endif
+}
+
+static const char ahead_orc[] =
+  "sr = 44100\n"
+  "ksmps = 64\n"
+  "nchnls = 1\n"
+  "0dbfs = 1\n"
+  "gkX init 0\n"
+  "giX init -1\n"
+  "instr 1\n"
+  "  gkX linseg 0, 2, 2\n"
+  "  chnset k(giX), \"x\"\n"
+  "endin\n"
+  "instr 2\n"
+  "  giX = i(gkX)\n"
+  "endin\n"
+  "schedule 1, 0, 2\n"
+  "schedule 2, 1, 0.1\n";
+
+/* A scheduled instrument reading at init a global that another one
+   sets is not initialised ahead, half a second early, but at its start,
+   and sees the value of that time */
+void test_init_ahead_fallback(void)
+{
+    CSOUND  *csound = run_orc(ahead_orc, "e 1.5\n",
+                              "--realtime --init-ahead=500");
+    MYFLT   x = channel(csound, "x");
+
+    CU_ASSERT(x > 0.99 && x < 1.01);
+    done(csound);
+}
+
+static const char ahead_table_orc[] =
+  "sr = 44100\n"
+  "ksmps = 64\n"
+  "nchnls = 1\n"
+  "0dbfs = 1\n"
+  "giT ftgen 1, 0, 4, -2, 0\n"
+  "giX init -1\n"
+  "instr 1\n"
+  "  tablew linseg(0, 2, 2), 0, 1\n"
+  "  chnset k(giX), \"x\"\n"
+  "endin\n"
+  "instr 2\n"
+  "  giX table 0, 1\n"
+  "endin\n"
+  "schedule 1, 0, 2\n"
+  "schedule 2, 1, 0.1\n";
+
+/* the same for a table read at init that another instrument writes */
+void test_init_ahead_table(void)
+{
+    CSOUND  *csound = run_orc(ahead_table_orc, "e 1.5\n",
+                              "--realtime --init-ahead=500");
+    MYFLT   x = channel(csound, "x");
+
+    CU_ASSERT(x > 0.99 && x < 1.01);
+    done(csound);
+}
+
+static const char p1_orc[] =
+  "sr = 44100\n"
+  "ksmps = 64\n"
+  "nchnls = 1\n"
+  "0dbfs = 1\n"
+  "gitied init 0\n"
+  "instr 1\n"
+  "  itie tival\n"
+  "  gitied = gitied + itie\n"
+  "endin\n"
+  "instr 2\n"
+  "  Sch sprintf \"active%d\", p4\n"
+  "  iact active 1\n"
+  "  chnset iact, Sch\n"
+  "  chnset gitied, \"tied\"\n"
+  "endin\n"
+  "instr 3\n"
+  "  turnoff2 p4, 4, 0\n"
+  "endin\n";
+
+/* held notes of one instrument, found by p1 however many there are */
+void test_p1_index(void)
+{
+    char    sco[8192];
+    CSOUND  *csound;
+    int     i, len = 0;
+
+    for (i = 1; i <= 100; i++)
+      len += snprintf(sco + len, sizeof(sco) - len, "i1.%03d 0 -1\n", i);
+    for (i = 1; i <= 100; i += 3)       /* 34 ties */
+      len += snprintf(sco + len, sizeof(sco) - len, "i1.%03d 0.5 -1\n", i);
+    len += snprintf(sco + len, sizeof(sco) - len, "i2 0.7 0.1 1\n");
+    for (i = 2; i <= 100; i += 2)       /* 50 turned off */
+      len += snprintf(sco + len, sizeof(sco) - len, "i-1.%03d 1 0\n", i);
+    len += snprintf(sco + len, sizeof(sco) - len, "i2 1.2 0.1 2\n");
+    len += snprintf(sco + len, sizeof(sco) - len,
+                    "i3 1.5 0.1 1.001\ni3 1.5 0.1 1.099\ni3 1.5 0.1 1.098\n");
+    snprintf(sco + len, sizeof(sco) - len, "i2 2 0.1 3\ne 2.5\n");
+    csound = run_orc(p1_orc, sco, NULL);
+    CU_ASSERT_EQUAL(channel(csound, "active1"), 100.0);
+    CU_ASSERT_EQUAL(channel(csound, "tied"), 34.0);
+    CU_ASSERT_EQUAL(channel(csound, "active2"), 50.0);
+    /* 1.098 is already off */
+    CU_ASSERT_EQUAL(channel(csound, "active3"), 48.0);
+    done(csound);
+}
+
+static const char budget_orc[] =
+  "sr = 44100\n"
+  "ksmps = 64\n"
+  "nchnls = 1\n"
+  "0dbfs = 1\n"
+  "instr 1\n"
+  "  asig oscili 0.01*p4, 220\n"
+  "  aL, aR reverbsc asig, asig, 0.9, 8000\n"
+  "  aL, aR reverbsc aL, aR, 0.9, 8000\n"
+  "  out aL\n"
+  "endin\n";
+
+static CSOUND *budget_run(const char *policy, int *warnings)
+{
+    CSOUND  *csound;
+    char    sco[4096], opt[128];
+    int     i, len = 0;
+
+    for (i = 0; i < 40; i++)
+      len += snprintf(sco + len, sizeof(sco) - len, "i1 %.3f 2 %d\n",
+                      i * 0.075, 1 + i % 4);
+    snprintf(sco + len, sizeof(sco) - len, "e 5\n");
+    snprintf(opt, sizeof(opt), "-j2 --cpu-budget=1 %s", policy);
+    csound = run_orc(budget_orc, sco, opt);
+    *warnings = messages_with(csound, "cpu budget");
+    return csound;
+}
+
+/* under -j voices are measured and managed, and refusals are not
+   warned about one by one */
+void test_cpu_budget_threads(void)
+{
+    CS_VOICE_STATS st;
+    CSOUND  *csound;
+    int     warnings;
+
+    csound = budget_run("--cpu-budget-policy=refuse", &warnings);
+    CU_ASSERT_EQUAL(csoundGetVoiceStats(csound, &st), CSOUND_SUCCESS);
+    CU_ASSERT(st.load > 0.0);
+    CU_ASSERT(st.refused > 10);
+    CU_ASSERT(warnings >= 1 && warnings <= 4);
+    done(csound);
+
+    csound = budget_run("--cpu-budget-policy=quietest", &warnings);
+    CU_ASSERT_EQUAL(csoundGetVoiceStats(csound, &st), CSOUND_SUCCESS);
+    CU_ASSERT(st.stolenQuietest > 0);
+    CU_ASSERT_EQUAL(st.refused, 0);
+    done(csound);
+}
+
+static const char outletkid_orc[] =
+  "sr = 44100\n"
+  "ksmps = 64\n"
+  "nchnls = 1\n"
+  "0dbfs = 1\n"
+  "connect \"Src\", \"out\", \"Sink\", \"in\"\n"
+  "alwayson \"Sink\"\n"
+  "instr Src\n"
+  "  kcnt init 0\n"
+  "  kcnt += 1\n"
+  "  if kcnt == 100 then\n"
+  "    reinit change\n"
+  "  endif\n"
+  "change:\n"
+  "  Sid sprintf \"id%d\", i(kcnt) >= 100 ? 1 : 0\n"
+  "  outletkid \"out\", Sid, 1\n"
+  "  rireturn\n"
+  "endin\n"
+  "instr Sink\n"
+  "  k0 inletkid \"in\", \"id0\"\n"
+  "  k1 inletkid \"in\", \"id1\"\n"
+  "  chnset k0, \"id0\"\n"
+  "  chnset k1, \"id1\"\n"
+  "endin\n";
+
+/* an inlet follows a source instance whose id changes on reinit */
+void test_outletkid_reinit(void)
+{
+    CSOUND  *csound = run_orc(outletkid_orc, "i \"Src\" 0 2\ne 1\n", NULL);
+
+    CU_ASSERT_EQUAL(channel(csound, "id0"), 0.0);
+    CU_ASSERT_EQUAL(channel(csound, "id1"), 1.0);
+    done(csound);
+}
+
+static const char lfsr_orc[] =
+  "sr = 44100\n"
+  "ksmps = 64\n"
+  "nchnls = 1\n"
+  "0dbfs = 1\n"
+  "instr 1\n"
+  "  kn lfsr 8, 1, 7\n"
+  "  ksum init 0\n"
+  "  ksum += kn\n"
+  "  chnset ksum, \"sum\"\n"
+  "endin\n";
+
+#if defined(__linux__)
+/* the eager flag of the library recorded as adding opname, or -1 */
+static int manifest_eager(const char *path, const char *opname)
+{
+    FILE    *f = fopen(path, "r");
+    char    line[1200];
+    int     eager = -1, lib = -1;
+
+    if (f == NULL)
+      return -1;
+    while (fgets(line, (int) sizeof(line), f) != NULL) {
+      line[strcspn(line, "\n")] = '\0';
+      if (sscanf(line, "library %d", &lib) == 1)
+        continue;
+      if (strncmp(line, "opcode ", 7) == 0 && strcmp(line + 7, opname) == 0)
+        eager = lib;
+    }
+    fclose(f);
+    return eager;
+}
+#endif
+
+/* the first run records which opcodes each plugin adds; later runs only
+   load a plugin when the orchestra uses one of its opcodes */
+void test_plugin_manifest(void)
+{
+#if defined(__linux__)
+    char    dir[] = "/tmp/csmfstXXXXXX", path[512];
+    struct stat st;
+    ino_t   ino;
+    CSOUND  *csound;
+    MYFLT   ref;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(mkdtemp(dir));
+    snprintf(path, sizeof(path), "%s/plugins.manifest", dir);
+    csoundSetGlobalEnv("OPCODE6DIR64", "../../");
+    setenv("CS_PLUGIN_MANIFEST", path, 1);
+
+    csound = run_orc(lfsr_orc, "i1 0 0.5\ne 0.5\n", "-v");
+    ref = channel(csound, "sum");
+    CU_ASSERT_EQUAL(messages_with(csound, "on demand"), 0);
+    done(csound);
+    CU_ASSERT(ref > 0.0);
+    CU_ASSERT_EQUAL_FATAL(stat(path, &st), 0);
+    ino = st.st_ino;
+    CU_ASSERT_EQUAL(manifest_eager(path, "lfsr"), 0);
+
+    /* deferred, then loaded by the parser and playing as before */
+    csound = run_orc(lfsr_orc, "i1 0 0.5\ne 0.5\n", "-v");
+    CU_ASSERT_EQUAL(channel(csound, "sum"), ref);
+    CU_ASSERT_EQUAL(messages_with(csound, "on demand"), 1);
+    done(csound);
+
+    /* not needed, not loaded */
+    csound = run_orc("instr 1\nendin\n", "i1 0 0.1\ne 0.1\n", "-v");
+    CU_ASSERT_EQUAL(messages_with(csound, "on demand"), 0);
+    done(csound);
+
+    /* nothing changed, so the manifest was never written again */
+    CU_ASSERT_EQUAL(stat(path, &st), 0);
+    CU_ASSERT_EQUAL(st.st_ino, ino);
+
+    unsetenv("CS_PLUGIN_MANIFEST");
+    remove(path);
+    rmdir(dir);
+#endif
+}
+
+static const char sfont_orc[] =
+  "sr = 44100\n"
+  "ksmps = 64\n"
+  "nchnls = 1\n"
+  "0dbfs = 1\n"
+  "gisf sfload \"%s\"\n"
+  "gipre sfpreset 0, 0, gisf, 0\n"
+  "instr 1\n"
+  "  asig sfplaym 100, 60, 1, 1, gipre\n"
+  "  ksum init 0\n"
+  "  ksum += rms(asig)\n"
+  "  Sch sprintf \"sum%%d\", p4\n"
+  "  chnset ksum, Sch\n"
+  "endin\n";
+
+/* notes read the same sample data from the mapped bank each time,
+   in one instance and in another */
+void test_sfplay(void)
+{
+    char    orc[1024], path[512];
+    CSOUND  *csound;
+    MYFLT   first, second;
+
+    snprintf(path, sizeof(path), "%s../../samples/sf_GMbank.sf2", srcdir);
+    snprintf(orc, sizeof(orc), sfont_orc, path);
+    csound = run_orc(orc, "i1 0 0.5 1\ni1 1 0.5 2\ne 1.5\n", NULL);
+    first = channel(csound, "sum1");
+    second = channel(csound, "sum2");
+    done(csound);
+    CU_ASSERT(first > 0.0);
+    CU_ASSERT_DOUBLE_EQUAL(first, second, 1e-9);
+    csound = run_orc(orc, "i1 0 0.5 1\ne 0.5\n", NULL);
+    CU_ASSERT_DOUBLE_EQUAL(channel(csound, "sum1"), first, 1e-9);
+    done(csound);
+}
+
+static const char chnfn_orc[] =
+  "sr = 44100\n"
+  "ksmps = 32\n"
+  "nchnls = 1\n"
+  "0dbfs = 1\n"
+  "giT ftgen 1, 0, 8, 10, 1\n"
+  "instr Set\n"
+  "  chnset k(p4), \"x\"\n"
+  "endin\n"
+  "instr Get\n"
+  "  kv init 0\n"
+  "  if chnget:k(\"x\") > ptable:k(1, 1) then\n"
+  "    kv = chnget:k(\"x\")\n"
+  "  endif\n"
+  "  chnset kv, \"got\"\n"
+  "endin\n";
+
+#if defined(__linux__)
+/* the instruments' sets printed under -v, without their addresses, and
+   the number of deprecation messages */
+static int orc_sets(char *buf, size_t n)
+{
+    CSOUND  *csound = run_orc(chnfn_orc, "i \"Set\" 0 0.1 1\n"
+                              "i \"Get\" 0 0.1\n", "-v");
+    const char *m;
+    size_t  len = 0;
+    int     in = 0, dep = 0;
+
+    while (csoundGetMessageCnt(csound) > 0) {
+      m = csoundGetFirstMessage(csound);
+      if (strstr(m, "deprecated") != NULL)
+        dep++;
+      if (strcmp(m, "Semantic Analysis\n") == 0)
+        in = 1;
+      else if (strcmp(m, "Semantic Analysis Ends\n") == 0)
+        in = 0;
+      else if (in)
+        for ( ; *m != '\0' && len + 1 < n; m++) {
+          if (*m == '(' && strchr(m, ')') != NULL)
+            m = strchr(m, ')');
+          else
+            buf[len++] = *m;
+        }
+      csoundPopFirstMessage(csound);
+    }
+    buf[len] = '\0';
+    CU_ASSERT_DOUBLE_EQUAL(channel(csound, "got"), 1.0, 0.0);
+    done(csound);
+    return dep;
+}
+#endif
+
+/* Calls in function syntax, in conditions as well, add to the globals
+   and interlocks of their instrument for -j when the orchestra comes from
+   the cache, as they do when it is parsed */
+void test_orc_cache_sets(void)
+{
+#if defined(__linux__)
+    char    dir[] = "/tmp/csorcXXXXXX", path[512];
+    char    ref[2048], sets[2048];
+    int     dep;
+
+    dep = orc_sets(ref, sizeof(ref));
+    CU_ASSERT(dep > 0);
+    CU_ASSERT(strstr(ref, "Instr: Get\n  read: { ##chn, ##tab }\n"
+                     "  write: { ##chn }\n") != NULL);
+    CU_ASSERT(strstr(ref, "Instr: Set\n  read: {  }\n"
+                     "  write: { ##chn }\n") != NULL);
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(mkdtemp(dir));
+    setenv("CS_ORC_CACHE", dir, 1);
+    CU_ASSERT_EQUAL(orc_sets(sets, sizeof(sets)), dep);
+    CU_ASSERT_STRING_EQUAL(sets, ref);
+    CU_ASSERT_EQUAL_FATAL(cache_files(dir, path, sizeof(path)), 1);
+    /* read back */
+    CU_ASSERT_EQUAL(orc_sets(sets, sizeof(sets)), dep);
+    CU_ASSERT_STRING_EQUAL(sets, ref);
+    CU_ASSERT_EQUAL(cache_files(dir, path, sizeof(path)), 1);
+    unsetenv("CS_ORC_CACHE");
+    remove(path);
+    rmdir(dir);
+#endif
+}
+
+int main(int argc, char **argv)
+{
+    CU_pSuite pSuite = NULL;
+
+    if (argc > 1)
+      srcdir = argv[1];
+
+    /* initialize the CUnit test registry */
+    if (CUE_SUCCESS != CU_initialize_registry())
+        return CU_get_error();
+
+    /* add a suite to the registry */
+    pSuite = CU_add_suite("opcode behaviour tests", init_suite1, clean_suite1);
+    if (NULL == pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    /* add the tests to the suite */
+    if ((NULL == CU_add_test(pSuite, "Test mp3in", test_mp3in))
+        || (NULL == CU_add_test(pSuite, "Test tablexs", test_tablexs))
+        || (NULL == CU_add_test(pSuite, "Test reverbsc and freeverb output", test_reverbs))
+        || (NULL == CU_add_test(pSuite, "Test partikkel grain mixing", test_partikkel))
+        || (NULL == CU_add_test(pSuite, "Test adsynt oscillator bank", test_adsynt))
+        || (NULL == CU_add_test(pSuite, "Test dumpk and readk in real-time mode", test_dumpk_readk))
+        || (NULL == CU_add_test(pSuite, "Test analysis utilities with -j", test_analysis_threads))
+        || (NULL == CU_add_test(pSuite, "Test audio returned by insremot servers", test_remote_audio))
+        || (NULL == CU_add_test(pSuite, "Test time-stamped MIDI input", test_midi_timestamps))
+        || (NULL == CU_add_test(pSuite, "Test the CS_ORC_CACHE parse cache", test_orc_cache))
+        || (NULL == CU_add_test(pSuite, "Test --init-ahead falls back on globals", test_init_ahead_fallback))
+        || (NULL == CU_add_test(pSuite, "Test --init-ahead falls back on table reads", test_init_ahead_table))
+        || (NULL == CU_add_test(pSuite, "Test ties and turnoffs by fractional p1", test_p1_index))
+        || (NULL == CU_add_test(pSuite, "Test --cpu-budget under -j", test_cpu_budget_threads))
+        || (NULL == CU_add_test(pSuite, "Test outletkid reinitialised with another id", test_outletkid_reinit))
+        || (NULL == CU_add_test(pSuite, "Test plugins deferred by CS_PLUGIN_MANIFEST", test_plugin_manifest))
+        || (NULL == CU_add_test(pSuite, "Test sfplaym from a mapped SoundFont", test_sfplay))
+        || (NULL == CU_add_test(pSuite, "Test CS_ORC_CACHE keeps the -j read/write sets", test_orc_cache_sets))
+        )
+    {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    /* Run all tests using the CUnit Basic interface */
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    return CU_get_error();
+}
@@ -27,6 +27,7 @@
 #define _FILE_OFFSET_BITS 64
 
 #include "std_util.h"
+#include "parallel.h"
 
 #include <math.h>
 #include <stdio.h>
@@ -158,6 +159,7 @@ typedef struct {
     int     highest_bin;
     int     frames;
     int     type;
+    int     nthreads;           /* -j: threads for peak detection */
 } ANARGS;
 
 /* ATS_FFT
@@ -599,7 +601,9 @@ static CS_NOINLINE CS_NORETURN void usage(CSOUND *csound)
     csound->Message(csound, "%s", Str("\t\t(Options: 1=amp.and freq. only, "
                                 "2=amp.,freq. and phase, "
                                 "3=amp.,freq. and residual, "
-                                "4=amp.,freq.,phase, and residual)\n\n"));
+                                "4=amp.,freq.,phase, and residual)\n"));
+    csound->Message(csound, "%s",
+                    Str("\t -j number of analysis threads (1)\n\n"));
     csound->LongJmp(csound, 1);
 }
 
@@ -631,6 +635,7 @@ static int atsa_main(CSOUND *csound, int argc, char **argv)
     anargs->last_peak_cont = ATSA_LPKCONT;
     anargs->SMR_cont = ATSA_SMRCONT;
     anargs->type = ATSA_TYPE;
+    anargs->nthreads = 1;
 
     for (i = 1; i < argc; ++i) {
       if (cur_opt == '\0') {
@@ -712,6 +717,9 @@ static int atsa_main(CSOUND *csound, int argc, char **argv)
       case 'F':
         anargs->type = (int) atoi(s);
         break;
+      case 'j':
+        anargs->nthreads = util_nthreads((int) atoi(s));
+        break;
       default:
         usage(csound);
       }
@@ -1991,6 +1999,64 @@ static void ats_save(CSOUND *csound, ATS_SOUND *sound, FILE *outfile,
 /* private function prototypes */
 static int compute_frames(ANARGS *anargs);
 
+/* ATS_DETECT
+ * ==========
+ * shared state of the peak detection stage of tracker()
+ */
+typedef struct {
+    ANARGS  *anargs;
+    const float *window;
+    const mus_sample_t *snd;
+    int     sflen, M_2, first_point;
+    float   norm;
+    MYFLT   **data;             /* fft buffer of each thread */
+    ATS_FRAME *found;           /* peaks detected in each frame */
+} ATS_DETECT;
+
+/* detect_frame
+ * ============
+ * windows and transforms one analysis frame and finds its peaks.
+ * Frames do not depend on each other, so tracker() runs this for all
+ * of them first, on several threads with -j, and then tracks the
+ * peaks frame by frame as before.
+ */
+static void detect_frame(CSOUND *csound, void *data, int frame_n,
+                         int thread)
+{
+    ATS_DETECT *d = (ATS_DETECT *) data;
+    ANARGS  *anargs = d->anargs;
+    ATS_FFT fft;
+    ATS_PEAK *peaks;
+    int     k, peaks_size = 0;
+    /* half a window from first sample */
+    int     filptr = anargs->first_smp - d->M_2 + frame_n * anargs->hop_smp;
+
+    fft.size = anargs->fft_size;
+    fft.rate = anargs->srate;
+    fft.data = d->data[thread];
+    /* clear fft arrays */
+    for (k = 0; k < (fft.size + 2); k++)
+      fft.data[k] = (MYFLT) 0;
+    /* multiply by window */
+    for (k = 0; k < anargs->win_size; k++) {
+      if ((filptr >= 0) && (filptr < d->sflen))
+        fft.data[(k + d->first_point) % anargs->fft_size] =
+            (MYFLT) d->window[k] * (MYFLT) d->snd[filptr];
+      filptr++;
+    }
+    /* take the fft */
+    csound->RealFFTnp2(csound, fft.data, fft.size);
+    /* peak detection */
+    peaks =
+        peak_detection(csound, &fft, anargs->lowest_bin, anargs->highest_bin,
+                       anargs->lowest_mag, d->norm, &peaks_size);
+    /* evaluate peaks SMR (masking curves) */
+    if (peaks != NULL)
+      evaluate_smr(peaks, peaks_size);
+    d->found[frame_n].peaks = peaks;
+    d->found[frame_n].n_peaks = peaks_size;
+}
+
 /* ATS_SOUND *tracker (ANARGS *anargs, char *soundfile)
  * partial tracking function
  * anargs: pointer to analysis parameters
@@ -2010,7 +2076,7 @@ static ATS_SOUND *tracker(CSOUND *csound, ANARGS *anargs, char *soundfile,
     ATS_PEAK *peaks, *tracks = NULL, cpy_peak;
     ATS_FRAME *ana_frames = NULL, *unmatched_peaks = NULL;
     mus_sample_t **bufs;
-    ATS_FFT fft;
+    ATS_DETECT detect;
     SF_INFO sfinfo;
     SNDFILE *sf;
     void    *fd;
@@ -2241,40 +2307,35 @@ static ATS_SOUND *tracker(CSOUND *csound, ANARGS *anargs, char *soundfile,
     /* read sound into memory */
     atsa_sound_read_noninterleaved(sf, bufs, 1, sflen);
 
-    /* make our fft-struct */
-    fft.size = anargs->fft_size;
-    fft.rate = anargs->srate;
-    fft.data =
-        (MYFLT *) csound->Malloc(csound,
-                                 (anargs->fft_size + 2) * sizeof(MYFLT));
+    /* detect the peaks of every frame; one fft buffer per thread */
+    detect.anargs = anargs;
+    detect.window = window;
+    detect.snd = bufs[0];
+    detect.sflen = sflen;
+    detect.M_2 = M_2;
+    detect.first_point = first_point;
+    detect.norm = norm;
+    detect.data =
+        (MYFLT **) csound->Malloc(csound, anargs->nthreads * sizeof(MYFLT *));
+    for (k = 0; k < anargs->nthreads; k++)
+      detect.data[k] =
+          (MYFLT *) csound->Malloc(csound,
+                                   (anargs->fft_size + 2) * sizeof(MYFLT));
+    detect.found =
+        (ATS_FRAME *) csound->Malloc(csound,
+                                     anargs->frames * sizeof(ATS_FRAME));
+    util_parallel(csound, anargs->nthreads, anargs->frames, detect_frame,
+                  &detect);
 
     /* main loop */
     for (frame_n = 0; frame_n < anargs->frames; frame_n++) {
-      /* clear fft arrays */
-      for (k = 0; k < (fft.size + 2); k++)
-        fft.data[k] = (MYFLT) 0;
-      /* multiply by window */
-      for (k = 0; k < anargs->win_size; k++) {
-        if ((filptr >= 0) && (filptr < sflen))
-          fft.data[(k + first_point) % anargs->fft_size] =
-              (MYFLT) window[k] * (MYFLT) bufs[0][filptr];
-        filptr++;
-      }
       /* we keep sample numbers of window midpoints in win_samps array */
-      win_samps[frame_n] = filptr - M_2 - 1;
-      /* move file pointer back */
-      filptr = filptr - anargs->win_size + anargs->hop_smp;
-      /* take the fft */
-      csound->RealFFTnp2(csound, fft.data, fft.size);
-      /* peak detection */
-      peaks_size = 0;
-      peaks =
-          peak_detection(csound, &fft, anargs->lowest_bin, anargs->highest_bin,
-                         anargs->lowest_mag, norm, &peaks_size);
+      win_samps[frame_n] = filptr + anargs->win_size - M_2 - 1;
+      filptr += anargs->hop_smp;
+      peaks = detect.found[frame_n].peaks;
+      peaks_size = detect.found[frame_n].n_peaks;
       /* peak tracking */
       if (peaks != NULL) {
-        /* evaluate peaks SMR (masking curves) */
-        evaluate_smr(peaks, peaks_size);
         if (frame_n) {
           /* initialise or update tracks */
           if ((tracks =
@@ -2345,7 +2406,10 @@ static ATS_SOUND *tracker(CSOUND *csound, ANARGS *anargs, char *soundfile,
     /* free up some memory */
     csound->Free(csound, window);
     csound->Free(csound, tracks);
-    csound->Free(csound, fft.data);
+    for (k = 0; k < anargs->nthreads; k++)
+      csound->Free(csound, detect.data[k]);
+    csound->Free(csound, detect.data);
+    csound->Free(csound, detect.found);
     /* init sound */
     csound->Message(csound, "%s", Str("Initializing ATS data..."));
     sound = (ATS_SOUND *) csound->Malloc(csound, sizeof(ATS_SOUND));
@@ -23,6 +23,7 @@
 
 #include "std_util.h"                                   /*  HETRO.C   */
 #include "soundio.h"
+#include "parallel.h"
 #include <math.h>
 #include <inttypes.h>
 
@@ -77,6 +78,7 @@ typedef struct {
          *a_avg,                /* output dev. freq. buffer*/
          new_ph,                /* new phase value*/
          old_ph,                /* previous phase value*/
+         first_ph,              /* new_ph of the first sample */
          jmp_ph,                /* for phase unwrap*/
          *ph_av1, *ph_av2, *ph_av3,      /*tempor. buffers*/
          *amp_av1, *amp_av2, *amp_av3,   /* same for ampl.*/
@@ -96,8 +98,23 @@ typedef struct {
   MYFLT  *adp;                  /* pointer to front of sample file */
   double *c_p,*s_p;             /* pointers to space for sine and cos terms */
   int32_t newformat;             /* flag for m/c independent format */
+  int32_t events;                /* call CheckEvents() while analysing */
 } HET;
 
+/* Harmonics are analysed one after the other, and each only depends
+   on the previous one through the phase it starts from (old_ph), which
+   decides whether the first sample counts as a phase jump.  With -j
+   all harmonics are first run at once from phase 0; those for which
+   the real starting phase gives a different decision are then run
+   again, so the result is the same as analysing them in turn. */
+
+typedef struct {
+    HET     *het;               /* one copy per thread, own buffers */
+    int32_t *items;             /* harmonics to analyse */
+    MYFLT   *cur_est, *max_frq, *max_amp;
+    double  *old_ph, *first_ph, *last_ph;
+} HETJOBS;
+
 #if INCSDIF
 static int32_t writesdif(CSOUND*, HET*);
 #endif
@@ -105,6 +122,9 @@ static  double  GETVAL(HET *, double *, int32);
 //static  double  sq(double);
 static  void    PUTVAL(HET *,double *, int32, double);
 static  int32_t hetdyn(CSOUND *csound, HET *, int32_t);
+static  char    *het_buffers(CSOUND *, HET *);
+static  void    het_harmonic(CSOUND *, void *, int, int);
+static  int32_t het_parallel(CSOUND *, HET *, int32_t);
 static  void    lpinit(HET*);
 static  void    lowpass(HET *,double *, double *, int32);
 static  void    average(HET *,int32, double *, double *, int32);
@@ -137,15 +157,15 @@ static void init_het(HET *t)
     t->bufsiz    = 1;             /* circular buffer size */
     t->skip      = 0;             /* JPff: this was missing */
     t->newformat = 1;
+    t->events    = 1;
 }
 
 static int32_t hetro(CSOUND *csound, int32_t argc, char **argv)
 {
     SNDFILE *infd;
-    int32_t i, hno, channel = 1, retval = 0;
-    int32   nsamps, smpspc, bufspc, mgfrspc;
+    int32_t i, hno, channel = 1, retval = 0, nthreads = 1;
+    int32   nsamps, mgfrspc;
     char    *dsp, *dspace;
-    double  *begbufs, *endbufs;
     HET     het;
     HET     *t = &het;
     SOUNDIN *p;         /* space allocated by SAsndgetset() */
@@ -234,6 +254,10 @@ static int32_t hetro(CSOUND *csound, int32_t argc, char **argv)
         case 'x':
           het.newformat = 0;
           break;
+        case 'j':
+          FIND(Str("no number of threads"))
+          sscanf(s,"%d",&nthreads);
+          break;
         case '-':
           FIND(Str("no log file"));
           while (*s++) {}; s--;
@@ -301,28 +325,6 @@ static int32_t hetro(CSOUND *csound, int32_t argc, char **argv)
     t->midbuf = t->bufsiz/2;
     t->bufmask = t->bufsiz - 1;
 
-    smpspc = t->smpsin * sizeof(double);
-    bufspc = t->bufsiz * sizeof(double);
-//printf("sizes2: smpspc - %d  bufspc - %d\n", smpspc, bufspc);
-    dsp = dspace = csound->Calloc(csound, smpspc * 2 + bufspc * 13);
-    t->c_p = (double *) dsp;      dsp += smpspc;  /* space for the    */
-    t->s_p = (double *) dsp;      dsp += smpspc;  /* quadrature terms */
-    begbufs = (double *) dsp;
-    t->cos_mul = (double *) dsp;  dsp += bufspc;  /* bufs that will be */
-    t->sin_mul = (double *) dsp;  dsp += bufspc;  /* refilled each hno */
-    t->a_term = (double *) dsp;   dsp += bufspc;
-    t->b_term = (double *) dsp;   dsp += bufspc;
-    t->r_ampl = (double *) dsp;   dsp += bufspc;
-    t->ph_av1 = (double *) dsp;   dsp += bufspc;
-    t->ph_av2 = (double *) dsp;   dsp += bufspc;
-    t->ph_av3 = (double *) dsp;   dsp += bufspc;
-    t->r_phase = (double *) dsp;  dsp += bufspc;
-    t->amp_av1 = (double *) dsp;  dsp += bufspc;
-    t->amp_av2 = (double *) dsp;  dsp += bufspc;
-    t->amp_av3 = (double *) dsp;  dsp += bufspc;
-    t->a_avg = (double *) dsp;    dsp += bufspc;
-    endbufs = (double *) dsp;
-
     mgfrspc = t->num_pts * sizeof(MYFLT);
     dsp = csound->Malloc(csound, mgfrspc * t->hmax * 2);
     t->MAGS = (MYFLT **) csound->Malloc(csound,
@@ -335,15 +337,18 @@ static int32_t hetro(CSOUND *csound, int32_t argc, char **argv)
     }
     lpinit(t);                        /* calculate LPF coeffs.  */
     t->adp = t->auxp;           /* point to beg sample data block */
+    if (util_nthreads(nthreads) > 1 && t->hmax > 1) {
+      retval = het_parallel(csound, t, util_nthreads(nthreads));
+      if (retval != 0)
+        return retval;
+      goto dump;
+    }
+    dspace = het_buffers(csound, t);
     for (hno = 0; hno < t->hmax; hno++) { /* for requested harmonics */
-      double *dblp;
       t->freq_est += t->fund_est; /*   do analysis */
       t->cur_est = t->freq_est;
-      dblp = begbufs;
-      // TODO? memset(begbufs, '\0', (endbufs-begbufs)*sizeof(double));
-      do {
-        *dblp++ = FL(0.0);                    /* clear all refilling buffers */
-      } while (dblp < endbufs);
+      /* clear all refilling buffers */
+      memset(t->cos_mul, 0, 13 * t->bufsiz * sizeof(double));
       t->max_frq = FL(0.0);
       t->max_amp = -FL(1.0);
 
@@ -357,6 +362,7 @@ static int32_t hetro(CSOUND *csound, int32_t argc, char **argv)
                               t->max_frq, t->max_amp);
     }
     csound->Free(csound, dspace);
+ dump:
 #if INCSDIF
     /* RWD if extension is .sdif, write as 1TRC frames */
     if (is_sdiffile(t->outfilnam)) {
@@ -372,6 +378,119 @@ static int32_t hetro(CSOUND *csound, int32_t argc, char **argv)
     return retval;
 }
 
+/* space for the quadrature terms and the buffers refilled for each
+   harmonic; returns the block to free */
+
+static char *het_buffers(CSOUND *csound, HET *t)
+{
+    int32   smpspc, bufspc;
+    char    *dsp, *dspace;
+
+    smpspc = t->smpsin * sizeof(double);
+    bufspc = t->bufsiz * sizeof(double);
+//printf("sizes2: smpspc - %d  bufspc - %d\n", smpspc, bufspc);
+    dsp = dspace = csound->Calloc(csound, smpspc * 2 + bufspc * 13);
+    t->c_p = (double *) dsp;      dsp += smpspc;  /* space for the    */
+    t->s_p = (double *) dsp;      dsp += smpspc;  /* quadrature terms */
+    t->cos_mul = (double *) dsp;  dsp += bufspc;  /* bufs that will be */
+    t->sin_mul = (double *) dsp;  dsp += bufspc;  /* refilled each hno */
+    t->a_term = (double *) dsp;   dsp += bufspc;  /* (13 of them, from */
+    t->b_term = (double *) dsp;   dsp += bufspc;  /* cos_mul onwards)  */
+    t->r_ampl = (double *) dsp;   dsp += bufspc;
+    t->ph_av1 = (double *) dsp;   dsp += bufspc;
+    t->ph_av2 = (double *) dsp;   dsp += bufspc;
+    t->ph_av3 = (double *) dsp;   dsp += bufspc;
+    t->r_phase = (double *) dsp;  dsp += bufspc;
+    t->amp_av1 = (double *) dsp;  dsp += bufspc;
+    t->amp_av2 = (double *) dsp;  dsp += bufspc;
+    t->amp_av3 = (double *) dsp;  dsp += bufspc;
+    t->a_avg = (double *) dsp;
+    return dspace;
+}
+
+/* analyse harmonic items[item] from the starting phase old_ph[] */
+
+static void het_harmonic(CSOUND *csound, void *data, int item, int thread)
+{
+    HETJOBS *j = (HETJOBS *) data;
+    HET     *t = &j->het[thread];
+    int32_t hno = j->items[item];
+
+    memset(t->cos_mul, 0, 13 * t->bufsiz * sizeof(double));
+    t->cur_est = j->cur_est[hno];
+    t->max_frq = FL(0.0);
+    t->max_amp = -FL(1.0);
+    t->old_ph = j->old_ph[hno];
+    t->first_ph = t->old_ph;
+    hetdyn(csound, t, hno);
+    j->max_frq[hno] = t->max_frq;
+    j->max_amp[hno] = t->max_amp;
+    j->first_ph[hno] = t->first_ph;
+    j->last_ph[hno] = t->old_ph;
+}
+
+/* all harmonics on several threads, see HETJOBS */
+
+static int32_t het_parallel(CSOUND *csound, HET *t, int32_t nthreads)
+{
+    HETJOBS jobs;
+    char    *dspace[UTIL_MAXTHREADS];
+    double  old_ph;
+    int32_t i, hno, nredo;
+
+    jobs.het = (HET *) csound->Malloc(csound, nthreads * sizeof(HET));
+    for (i = 0; i < nthreads; i++) {
+      jobs.het[i] = *t;
+      jobs.het[i].events = 0;
+      dspace[i] = het_buffers(csound, &jobs.het[i]);
+    }
+    jobs.items = (int32_t *) csound->Malloc(csound, t->hmax * sizeof(int32_t));
+    jobs.cur_est = (MYFLT *) csound->Malloc(csound,
+                                            3 * t->hmax * sizeof(MYFLT));
+    jobs.max_frq = jobs.cur_est + t->hmax;
+    jobs.max_amp = jobs.max_frq + t->hmax;
+    jobs.old_ph = (double *) csound->Malloc(csound,
+                                            3 * t->hmax * sizeof(double));
+    jobs.first_ph = jobs.old_ph + t->hmax;
+    jobs.last_ph = jobs.first_ph + t->hmax;
+    for (hno = 0; hno < t->hmax; hno++) {
+      t->freq_est += t->fund_est;
+      jobs.cur_est[hno] = t->freq_est;
+      jobs.old_ph[hno] = t->old_ph;
+      jobs.items[hno] = hno;
+    }
+    util_parallel(csound, nthreads, t->hmax, het_harmonic, &jobs);
+    if (!csound->CheckEvents(csound))
+      return -1;
+    /* the phase each harmonic really starts from, and whether that
+       changes the jump test on its first sample */
+    old_ph = t->old_ph;
+    for (nredo = 0, hno = 0; hno < t->hmax; hno++) {
+      double first = jobs.first_ph[hno];
+      if ((fabs(first - old_ph) > PI) !=
+          (fabs(first - jobs.old_ph[hno]) > PI)) {
+        jobs.old_ph[hno] = old_ph;
+        jobs.items[nredo++] = hno;
+      }
+      old_ph = jobs.last_ph[hno];
+    }
+    util_parallel(csound, nthreads, nredo, het_harmonic, &jobs);
+    t->old_ph = old_ph;
+    for (hno = 0; hno < t->hmax; hno++) {
+      csound->Message(csound,Str("analyzing harmonic #%d\n"),hno);
+      csound->Message(csound,Str("freq estimate %6.1f,"), jobs.cur_est[hno]);
+      csound->Message(csound, Str(" max found %6.1f, rel amp %6.1f\n"),
+                              jobs.max_frq[hno], jobs.max_amp[hno]);
+    }
+    for (i = 0; i < nthreads; i++)
+      csound->Free(csound, dspace[i]);
+    csound->Free(csound, jobs.het);
+    csound->Free(csound, jobs.items);
+    csound->Free(csound, jobs.cur_est);
+    csound->Free(csound, jobs.old_ph);
+    return 0;
+}
+
 static double GETVAL(HET* t, double *inb, int32 smpl)
 {                               /* get value at position smpl in array inb */
     if (smpl<0) return 0.0;
@@ -450,11 +569,13 @@ static int32_t hetdyn(CSOUND *csound,
         //       GETVAL(t,t->cos_mul, smplno));
       }
       output_ph(t, smplno);       /* calculate mag. & phase for sample */
+      if (smplno == 0)
+        t->first_ph = t->new_ph;
       if ((outpnt = (int32_t)(smplno * t->outdelta_t)) > lastout) {
         /* if next out-time */
         output(t, smplno, hno, outpnt);  /*     place in     */
         lastout = outpnt;                      /*     output array */
-        if (!csound->CheckEvents(csound))
+        if (t->events && !csound->CheckEvents(csound))
           return -1;
       }
       if (t->skip) {
@@ -27,6 +27,7 @@
 #include "soundio.h"
 #include "lpc.h"
 #include "cwindow.h"
+#include "parallel.h"
 #ifndef WIN32
 #include <unistd.h>
 #endif
@@ -89,6 +90,7 @@ static  void    quit(CSOUND *, char *), lpdieu(CSOUND *, char *);
 static  void    usage(CSOUND *);
 static  void    ptable(CSOUND *, MYFLT, MYFLT, MYFLT, int32_t, LPANAL_GLOBALS*);
 static  MYFLT   getpch(CSOUND *, MYFLT *, LPANAL_GLOBALS*);
+static  MYFLT   noise(MYFLT);
 
 /* Search for an argument and report of not found */
 #define FIND(MSG)   if (*s == '\0')  \
@@ -346,14 +348,203 @@ static void DumpPoles(CSOUND *csound,
  *
  */
 
+/* Frames waiting to be analysed and written.  Input and pitch tracking
+   carry state from frame to frame and are done in order; the linear
+   prediction of a full batch is then run in parallel (-j) and the
+   frames are written in order, so the file does not depend on -j. */
+
+typedef struct {
+    LPC     *lpc;               /* per thread copy, with its own a, setup */
+    int32_t size, count, first; /* slots, slots in use, frame of slot 0 */
+    int32_t nvals;              /* values in an output frame */
+    MYFLT   *sig;               /* WINDIN input samples per slot */
+    double  *x;                 /* the same, as seen by alpol() */
+    MYFLT   *coef;              /* output frame of each slot */
+    int32_t *found;             /* poles found in each slot */
+    double  dPI;
+    int32_t new_format, ofd;
+    FILE    *oFd;
+    uint32_t osiz;
+} LPBATCH;
+
+/* take in the frame at sig: the serial part of alpol() */
+
+static void lp_input(LPC *thislp, MYFLT *sig, MYFLT *slot, double *x)
+{
+    double *xp;
+
+    memcpy(slot, sig, thislp->WINDIN * sizeof(MYFLT));
+    if (thislp->newmethod)
+      return;
+   /* Transfer signal in x array */
+    for (xp=x; xp-x < thislp->WINDIN;++xp,++sig) {
+      /* VL 24.06.21 - adding a little noise to allow pole analysis
+         to be carried out with silences */
+      *xp = (double) *sig + (thislp->storePoles ? noise(0.0001) : 0.);
+    }
+}
+
+/* analyse batch slot 'item' into its output frame */
+
+static void lp_frame(CSOUND *csound, void *data, int item, int thread)
+{
+    LPBATCH *b = (LPBATCH *) data;
+    LPC     *lpc = &b->lpc[thread];
+    MYFLT   *coef = b->coef + item * b->nvals, *fp1;
+    double  errn, rms1, rms2, filterCoef[MAXPOLES+1], *dfp;
+    int32_t i, j, n, indic, poleFound;
+    double  pr, pi, pm, pp;
+    double  polePart1[MAXPOLES], polePart2[MAXPOLES];
+    double  z1, workArray1[MAXPOLES];
+#ifdef _DEBUG
+    double  polyReal[MAXPOLES], polyImag[MAXPOLES];
+#endif
+
+    lpc->x = b->x + item * lpc->WINDIN;
+    alpol(csound, lpc, b->sig + item * lpc->WINDIN,
+          &errn, &rms1, &rms2, filterCoef);
+    /* Transfer results */
+    coef[0] = (MYFLT)rms2;
+    coef[1] = (MYFLT)rms1;
+    coef[2] = (MYFLT)errn;
+    b->found[item] = lpc->poleCount;
+
+    /* Prepare buffer for output */
+
+    if (lpc->storePoles) {
+      /* Treat (swap) filter coefs for resolution */
+
+      filterCoef[lpc->poleCount] = 1.0;
+      for (i=0; i<(lpc->poleCount+1)/2; i++) {
+        j = lpc->poleCount-1-i;
+        z1 = filterCoef[i];
+        filterCoef[i] = filterCoef[j];
+        filterCoef[j] = z1;
+      }
+
+      /* Get the Filter Poles */
+
+      polyzero(lpc->poleCount,filterCoef,polePart1,polePart2,
+               &poleFound,2000,&indic,workArray1);
+
+      if (UNLIKELY(poleFound<lpc->poleCount)) {
+        b->found[item] = poleFound;     /* reported by lp_flush() */
+        return;
+      }
+      InvertPoles(lpc->poleCount,polePart1,polePart2);
+
+#ifdef TRACE_POLES
+      DumpPoles(csound,
+                lpc->poleCount, polePart1, polePart2, 0, "Extracted Poles");
+#endif
+
+#ifdef _DEBUG
+      /* Resynthetize the filter for check */
+      InvertPoles(lpc->poleCount,polePart1,polePart2);
+
+      synthetize(lpc->poleCount,polePart1,polePart2,polyReal,polyImag);
+      for (i=0; i<lpc->poleCount; i++) {
+#ifdef TRACE_FILTER
+        csound->Message(csound, "filterCoef: %f\n", filterCoef[i]);
+#endif
+        if (UNLIKELY(filterCoef[i]-polyReal[lpc->poleCount-i]>1e-10))
+          csound->Message(csound, Str("Error in coef %d : %f <> %f\n"),
+                                  i, filterCoef[i], polyReal[lpc->poleCount-i]);
+      }
+      csound->Message(csound,".");
+      InvertPoles(lpc->poleCount,polePart1,polePart2);
+#endif
+      /* Switch to pole magnitude and phase */
+
+      for (i=0; i<lpc->poleCount;i++) {
+        /* Store magnitude and phase (PI,-PI) */
+        pr = polePart1[i];
+        pi = polePart2[i];
+        pm = hypot(pr, pi);
+        if (pm!=0) {
+          pp = atan2(pi,pr);
+          if (pp>b->dPI)
+            pp = 2*b->dPI-pp;
+        }
+        else
+          pp = 0;
+        polePart1[i] = pm;
+        polePart2[i] = pp;
+      }
+
+/*    DumpPoles(csound, poleCount,polePart1,polePart2,1,"About to store"); */
+
+      /* Store in output buffer */
+      fp1 = coef+NDATA;
+      for (i=0; i<lpc->poleCount;i++) {
+        *fp1++ = (MYFLT)polePart1[i];
+        *fp1++ = (MYFLT)polePart2[i];
+      }
+    }
+    else {
+      /* Move filter data into output buffer */
+      dfp = filterCoef+lpc->poleCount;
+      fp1 = coef+NDATA;
+      for (n=0;n<lpc->poleCount; n++)
+        *fp1++ = - (MYFLT) *--dfp;
+    }
+}
+
+/* analyse the frames of a batch and write them out in order; returns
+   non-zero if a frame could not be converted to poles */
+
+static int32_t lp_flush(CSOUND *csound, LPBATCH *b, int32_t nthreads)
+{
+    LPC     *lpc = &b->lpc[0];
+    MYFLT   *coef;
+    int32_t i, counter;
+    uint32_t nb;
+
+    util_parallel(csound, nthreads, b->count, lp_frame, b);
+    for (i = 0; i < b->count; i++) {
+      coef = b->coef + i * b->nvals;
+      counter = b->first + i;
+      if (lpc->debug) csound->Message(csound,"%d\t%9.4f\t%9.4f\t%9.4f\t%9.4f\n",
+                                      counter, coef[0], coef[1], coef[2],
+                                      coef[3]);
+#ifdef TRACE
+      if (lpc->debug) fprintf(trace,"%d\t%9.4f\t%9.4f\t%9.4f\t%9.4f\n",
+                              counter, coef[0], coef[1], coef[2], coef[3]);
+#endif
+#if 0
+      CS_SPRINTF(lpc->pwindow.caption, "pitch: %8.2f", coef[3]);
+      display(csound, &lpc->pwindow);
+#endif
+      if (UNLIKELY(b->found[i] < lpc->poleCount)) {
+        csound->Message(csound,
+                        Str("Found only %d poles...sorry\n"), b->found[i]);
+        csound->Message(csound,
+                        Str("wanted %d poles\n"), lpc->poleCount);
+        return -1;
+      }
+
+      /* Write frame to disk */
+      if (b->new_format) {
+        uint32_t k, j;
+        for (k=0, j=0; k<b->osiz; k+=sizeof(MYFLT), j++)
+          fprintf(b->oFd, "%a\n", (double)coef[j]);
+      }
+      else
+        if (UNLIKELY((nb = write(b->ofd, (char *)coef, b->osiz)) != b->osiz))
+          quit(csound, Str("write error"));
+    }
+    b->first += b->count;
+    b->count = 0;
+    return 0;
+}
+
 static int32_t lpanal(CSOUND *csound, int32_t argc, char **argv)
 {
     SNDFILE *infd;
     int32_t     slice, analframes, counter, channel;
-    MYFLT   *coef, beg_time, input_dur, sr = FL(0.0);
+    MYFLT   beg_time, input_dur, sr = FL(0.0);
     char    *infilnam, *outfilnam;
     int32_t     ofd;
-    double  errn, rms1, rms2, filterCoef[MAXPOLES+1];
     MYFLT   *sigbuf, *sigbuf2;      /* changed from short */
     int64_t    n;
     uint32_t     osiz, nb;
@@ -366,17 +557,13 @@ static int32_t lpanal(CSOUND *csound, int32_t argc, char **argv)
 
 /* Added by MR to handle pole storage */
 
-    int32_t     i, j, indic, storePoles;
-    int32_t     poleFound;
-    double  pr, pi, pm, pp, dPI;
-    double  polePart1[MAXPOLES], polePart2[MAXPOLES];
-    double  z1, workArray1[MAXPOLES];
-#ifdef _DEBUG
-    double  polyReal[MAXPOLES], polyImag[MAXPOLES];
-#endif
+    int32_t     i, storePoles;
+    double  dPI;
     LPANAL_GLOBALS *lpg;
     int32_t new_format=0;
     FILE    *oFd;
+    LPBATCH batch;
+    int32_t nthreads = 1;
 
     lpc.debug   = 0;
     lpc.verbose = 0;
@@ -486,6 +673,8 @@ static int32_t lpanal(CSOUND *csound, int32_t argc, char **argv)
           // new
           lpc.newmethod = 1;
           break;
+        case 'j':       FIND(Str("no number of threads"))
+                        sscanf(s,"%d",&nthreads); break;
         default:
           {
             char errmsg[256];
@@ -505,9 +694,7 @@ static int32_t lpanal(CSOUND *csound, int32_t argc, char **argv)
     outfilnam = *argv;
     if (UNLIKELY(lpc.poleCount > MAXPOLES))
       quit(csound,Str("poles exceeds maximum allowed"));
-    /* Allocate space now */
-    coef = (MYFLT*) csound->Malloc(csound, (NDATA+lpc.poleCount*2)*sizeof(MYFLT));
-    /* Space allocated */
+    nthreads = util_nthreads(nthreads);
     if (UNLIKELY(slice < lpc.poleCount * 5))
       csound->Warning(csound,"%s", Str("hopsize may be too small, "
                                  "recommend at least poleCount * 5\n"));
@@ -619,8 +806,6 @@ static int32_t lpanal(CSOUND *csound, int32_t argc, char **argv)
     /* Space for a array */
     lpc.a = (double (*)[MAXPOLES])
       csound->Malloc(csound, MAXPOLES * MAXPOLES * sizeof(double));
-    lpc.x = (double *) csound->Malloc(csound,   /* alloc a double array */
-                                      lpc.WINDIN * sizeof(double));
 #ifdef TRACE
     csound->FileOpen2(csound, &trace, CSFILE_STD, "lpanal.trace", "w", NULL,
                       CSFTYPE_OTHER_TEXT, 0);
@@ -632,130 +817,57 @@ static int32_t lpanal(CSOUND *csound, int32_t argc, char **argv)
       csound->Message(csound, "using Durbin method \n");
     lpc.storePoles = storePoles;
 
+    /* a few frames per thread, one when running serially */
+    memset(&batch, 0, sizeof(LPBATCH));
+    batch.size = (nthreads > 1 ? nthreads * 8 : 1);
+    batch.first = 1;
+    batch.nvals = lph->nvals;
+    batch.dPI = dPI;
+    batch.new_format = new_format;
+    if (new_format)
+      batch.oFd = oFd;
+    else
+      batch.ofd = ofd;
+    batch.osiz = osiz;
+    batch.lpc = (LPC *) csound->Malloc(csound, nthreads * sizeof(LPC));
+    for (i = 0; i < nthreads; i++) {
+      batch.lpc[i] = lpc;
+      if (i > 0) {
+        batch.lpc[i].a = (double (*)[MAXPOLES])
+          csound->Malloc(csound, MAXPOLES * MAXPOLES * sizeof(double));
+        batch.lpc[i].setup =
+          csound->LPsetup(csound,lpc.WINDIN,lpc.poleCount);
+      }
+    }
+    batch.sig = (MYFLT *) csound->Malloc(csound, (size_t) batch.size
+                                         * lpc.WINDIN * sizeof(MYFLT));
+    batch.x = (double *) csound->Malloc(csound, (size_t) batch.size
+                                        * lpc.WINDIN * sizeof(double));
+    batch.coef = (MYFLT *) csound->Calloc(csound, (size_t) batch.size
+                                          * batch.nvals * sizeof(MYFLT));
+    batch.found = (int32_t *) csound->Malloc(csound,
+                                             batch.size * sizeof(int32_t));
+
     /* Do the analysis */
     do {
-      MYFLT *fp1;
-      double *dfp;
+      MYFLT *coef;
 
-      /* Analyze current frame */
+      /* Take in current frame */
 #ifdef TRACE_POLES
       csound->Message
         (csound, "%s", Str("Starting new frame...\n"));
 #endif
       counter++;
-      alpol(csound, &lpc, sigbuf, &errn, &rms1, &rms2, filterCoef);
-      /* Transfer results */
-      coef[0] = (MYFLT)rms2;
-      coef[1] = (MYFLT)rms1;
-      coef[2] = (MYFLT)errn;
+      lp_input(&lpc, sigbuf, batch.sig + batch.count * lpc.WINDIN,
+               batch.x + batch.count * lpc.WINDIN);
+      coef = batch.coef + batch.count * batch.nvals;
       if (lpc.doPitch)
         coef[3] = getpch(csound, sigbuf, lpg);
       else coef[3] = FL(0.0);
-      if (lpc.debug) csound->Message(csound,"%d\t%9.4f\t%9.4f\t%9.4f\t%9.4f\n",
-                                 counter, coef[0], coef[1], coef[2], coef[3]);
-#ifdef TRACE
-      if (lpc.debug) fprintf(trace,"%d\t%9.4f\t%9.4f\t%9.4f\t%9.4f\n",
-                         counter, coef[0], coef[1], coef[2], coef[3]);
-#endif
   /*  for (fp1=coef+NDATA, dfp=cc+poleCount, n=poleCount; n--; ) */
   /*    *fp1++ = - (MYFLT) *--dfp; */  /* rev coefs & chng sgn */
-#if 0
-      CS_SPRINTF(lpc.pwindow.caption, "pitch: %8.2f", coef[3]);
-      display(csound, &lpc.pwindow);
-#endif
-
-      /* Prepare buffer for output */
-
-      if (storePoles) {
-        /* Treat (swap) filter coefs for resolution */
-
-        filterCoef[lpc.poleCount] = 1.0;
-        for (i=0; i<(lpc.poleCount+1)/2; i++) {
-          j = lpc.poleCount-1-i;
-          z1 = filterCoef[i];
-          filterCoef[i] = filterCoef[j];
-          filterCoef[j] = z1;
-        }
-
-        /* Get the Filter Poles */
-
-        polyzero(lpc.poleCount,filterCoef,polePart1,polePart2,
-                 &poleFound,2000,&indic,workArray1);
-
-        if (UNLIKELY(poleFound<lpc.poleCount)) {
-          csound->Message(csound,
-                          Str("Found only %d poles...sorry\n"), poleFound);
-          csound->Message(csound,
-                          Str("wanted %d poles\n"), lpc.poleCount);
-          return -1;
-        }
-        InvertPoles(lpc.poleCount,polePart1,polePart2);
-
-#ifdef TRACE_POLES
-        DumpPoles(csound,
-                  lpc.poleCount, polePart1, polePart2, 0, "Extracted Poles");
-#endif
-
-#ifdef _DEBUG
-        /* Resynthetize the filter for check */
-        InvertPoles(lpc.poleCount,polePart1,polePart2);
-
-        synthetize(lpc.poleCount,polePart1,polePart2,polyReal,polyImag);
-        for (i=0; i<lpc.poleCount; i++) {
-#ifdef TRACE_FILTER
-          csound->Message(csound, "filterCoef: %f\n", filterCoef[i]);
-#endif
-          if (UNLIKELY(filterCoef[i]-polyReal[lpc.poleCount-i]>1e-10))
-            csound->Message(csound, Str("Error in coef %d : %f <> %f\n"),
-                                    i, filterCoef[i], polyReal[lpc.poleCount-i]);
-        }
-        csound->Message(csound,".");
-        InvertPoles(lpc.poleCount,polePart1,polePart2);
-#endif
-        /* Switch to pole magnitude and phase */
-
-        for (i=0; i<lpc.poleCount;i++) {
-          /* Store magnitude and phase (PI,-PI) */
-          pr = polePart1[i];
-          pi = polePart2[i];
-          pm = hypot(pr, pi);
-          if (pm!=0) {
-            pp = atan2(pi,pr);
-            if (pp>dPI)
-              pp = 2*dPI-pp;
-          }
-          else
-            pp = 0;
-          polePart1[i] = pm;
-          polePart2[i] = pp;
-        }
-
-  /*    DumpPoles(csound, poleCount,polePart1,polePart2,1,"About to store"); */
-
-        /* Store in output buffer */
-        fp1 = coef+NDATA;
-        for (i=0; i<lpc.poleCount;i++) {
-          *fp1++ = (MYFLT)polePart1[i];
-          *fp1++ = (MYFLT)polePart2[i];
-        }
-      }
-      else {
-        /* Move filter data into output buffer */
-        dfp = filterCoef+lpc.poleCount;
-        fp1 = coef+NDATA;
-        for (n=0;n<lpc.poleCount; n++)
-          *fp1++ = - (MYFLT) *--dfp;
-      }
-
-      /* Write frame to disk */
-      if (new_format) {
-        uint32_t i, j;
-        for (i=0, j=0; i<osiz; i+=sizeof(MYFLT), j++)
-          fprintf(oFd, "%a\n", (double)coef[j]);
-      }
-      else
-        if (UNLIKELY((nb = write(ofd, (char *)coef, osiz)) != osiz))
-          quit(csound, Str("write error"));
+      if (++batch.count == batch.size && lp_flush(csound, &batch, nthreads))
+        return -1;
       memcpy(sigbuf, sigbuf2, sizeof(MYFLT)*slice);
 
       /* Some unused stuff. I think from when all snd was in mem */
@@ -766,18 +878,28 @@ static int32_t lpanal(CSOUND *csound, int32_t argc, char **argv)
       /* Get next sound frame */
       if ((n = csound->getsndin(csound, infd, sigbuf2, slice, p)) == 0)
         break;          /* refill til EOF */
-      if (UNLIKELY(!csound->CheckEvents(csound)))
+      if (UNLIKELY(!csound->CheckEvents(csound))) {
+        lp_flush(csound, &batch, nthreads);
         return -1;
+      }
     } while (counter < analframes); /* or nsmps done */
+    if (lp_flush(csound, &batch, nthreads))
+      return -1;
 #if 0
     /* clean up stuff */
     dispexit(csound);
 #endif
     csound->Message(csound, Str("%d lpc frames written to %s\n"),
                             counter, outfilnam);
-    csound->Free(csound, lpc.a);
-    csound->Free(csound, lpc.x);
-    csound->Free(csound, coef);
+    for (i = 0; i < nthreads; i++) {
+      csound->Free(csound, batch.lpc[i].a);
+      csound->LPfree(csound, batch.lpc[i].setup);
+    }
+    csound->Free(csound, batch.lpc);
+    csound->Free(csound, batch.sig);
+    csound->Free(csound, batch.x);
+    csound->Free(csound, batch.coef);
+    csound->Free(csound, batch.found);
     csound->Free(csound, lpg->Dwind_dbuf);
     for (i=0;  i<FREQS; ++i) {
       csound->Free(csound, lpg->tphi[i]);
@@ -814,21 +936,16 @@ static MYFLT noise(MYFLT a) {
 
 static void alpol(CSOUND *csound, LPC *thislp, MYFLT *sig, double *errn,
                   double *rms1, double *rms2, double *b)
-                                        /* sig now MYFLT */
+                                        /* sig now MYFLT, only used by the
+                                           Durbin method */
                                         /* b filled here */
 {
   if(!thislp->newmethod) {
     double v[MAXPOLES];
-    double *xp;
     double sum, sumx, sumy;
     int32_t i, j, k, limit;
 
-   /* Transfer signal in x array */
-    for (xp=thislp->x; xp-thislp->x < thislp->WINDIN;++xp,++sig) {
-      /* VL 24.06.21 - adding a little noise to allow pole analysis
-         to be carried out with silences */
-      *xp = (double) *sig + (thislp->storePoles ? noise(0.0001) : 0.);
-    }
+   /* The signal is already in the x array, see lp_input() */
 
    /* Build system to be solved */
     for (i=0; i < thislp->poleCount;++i) {
@@ -998,6 +1115,7 @@ static const char *usage_txt[] = {
   Str_noop("-g\tgraphical display of results"),
   Str_noop("-a\t\talternate (pole) file storage"),
   Str_noop("-n\t\t use Durbin method for linear prediction"),
+  Str_noop("-j<threads>\tanalyse frames on several threads (default 1)"),
   Str_noop("-- fname\tLog output to file"),
   Str_noop("see also:  Csound Manual Appendix"),
     NULL
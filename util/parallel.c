@@ -0,0 +1,84 @@
+/*
+    parallel.c:
+
+    Copyright (C) 2026 The Csound Developers
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+#include "std_util.h"
+#include "parallel.h"
+
+typedef struct {
+    CSOUND  *csound;
+    UTIL_JOB job;
+    void    *data;
+    int     count, first, step, thread;
+} UTIL_THREAD;
+
+static uintptr_t util_thread(void *arg)
+{
+    UTIL_THREAD *t = (UTIL_THREAD*) arg;
+    int         i;
+
+    for (i = t->first; i < t->count; i += t->step)
+      t->job(t->csound, t->data, i, t->thread);
+    return 0;
+}
+
+int util_nthreads(int nthreads)
+{
+    if (nthreads < 1)
+      return 1;
+    return (nthreads > UTIL_MAXTHREADS ? UTIL_MAXTHREADS : nthreads);
+}
+
+void util_parallel(CSOUND *csound, int nthreads, int count, UTIL_JOB job,
+                   void *data)
+{
+    UTIL_THREAD thr[UTIL_MAXTHREADS];
+    void        *tid[UTIL_MAXTHREADS];
+    int         i;
+
+    if (count <= 0)
+      return;
+    job(csound, data, 0, 0);
+    nthreads = util_nthreads(nthreads);
+    if (nthreads > count - 1)
+      nthreads = (count > 1 ? count - 1 : 1);
+    /* items are dealt out in turn, so neighbouring frames, which cost
+       about the same, end up on different threads */
+    for (i = 0; i < nthreads; i++) {
+      thr[i].csound = csound;
+      thr[i].job = job;
+      thr[i].data = data;
+      thr[i].count = count;
+      thr[i].first = i + 1;
+      thr[i].step = nthreads;
+      thr[i].thread = i;
+    }
+    for (i = 1; i < nthreads; i++)
+      tid[i] = csound->CreateThread(util_thread, &thr[i]);
+    util_thread(&thr[0]);
+    for (i = 1; i < nthreads; i++) {
+      if (tid[i] != NULL)
+        csound->JoinThread(tid[i]);
+      else
+        util_thread(&thr[i]);       /* could not start it: do it here */
+    }
+}
@@ -0,0 +1,49 @@
+/*
+    parallel.h:
+
+    Copyright (C) 2026 The Csound Developers
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+#ifndef CSOUND_UTIL_PARALLEL_H
+#define CSOUND_UTIL_PARALLEL_H
+
+/* Frame-parallel helper for the analysis utilities (-j option).
+ *
+ * util_parallel() calls job(csound, data, item, thread) once for every
+ * item in 0..count-1, spread over up to 'nthreads' threads; thread
+ * numbers are 0..nthreads-1 and can index per thread scratch space.
+ * Item 0 is always done first on the calling thread, before any other
+ * thread starts, so that state which is set up lazily and is not
+ * thread safe (the FFT tables) already exists when the threads run.
+ * Jobs must not print or call CheckEvents(); results are collected
+ * by the caller afterwards, in order, so output does not depend on
+ * the number of threads.
+ */
+
+#define UTIL_MAXTHREADS (64)
+
+typedef void (*UTIL_JOB)(CSOUND *, void *data, int item, int thread);
+
+/* clamp a -j argument to 1..UTIL_MAXTHREADS */
+int  util_nthreads(int nthreads);
+void util_parallel(CSOUND *, int nthreads, int count, UTIL_JOB job,
+                   void *data);
+
+#endif      /* CSOUND_UTIL_PARALLEL_H */
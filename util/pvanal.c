@@ -38,6 +38,7 @@
 #include "cwindow.h"
 #include "soundio.h"
 #include "pvfileio.h"
+#include "parallel.h"
 #include <math.h>
 #include <ctype.h>
 #include <sndfile.h>
@@ -117,9 +118,11 @@ static  int32_t pvxanal(CSOUND *csound, SOUNDIN *p, SNDFILE *fd,
                         int64_t srate, int64_t chans, int64_t fftsize,
                         int64_t overlap, int64_t winsize,
                         pv_wtype wintype,
-                        double beta, int32_t displays);
-static  int64_t    generate_frame(CSOUND*, PVX *pvx, MYFLT *fbuf, float *outanal,
-                                        int64_t samps, int32_t frametype);
+                        double beta, int32_t displays, int32_t nthreads);
+static  void    frame_input(PVX *pvx, MYFLT *fbuf, MYFLT *anal, int64_t samps);
+static  void    frame_spectrum(CSOUND *, void *data, int item, int thread);
+static  void    frame_output(PVX *pvx, MYFLT *anal, const double *phase,
+                             float *outanal);
 static  void    chan_split(CSOUND*, const MYFLT *inbuf, MYFLT **chbuf,
                                     int64_t insize, int64_t chans);
 static  int32_t     init(CSOUND *csound,
@@ -164,6 +167,7 @@ static int32_t pvanal(CSOUND *csound, int32_t argc, char **argv)
     char    err_msg[512];
     double  beta = 6.8;
     int32_t displays = 0;
+    int32_t nthreads = 1;
 
 
     if (UNLIKELY(!(--argc)))
@@ -224,6 +228,9 @@ static int32_t pvanal(CSOUND *csound, int32_t argc, char **argv)
           break;
         case 'g':  displays = 1;
             break;
+        case 'j':  FIND(Str("no number of threads"));
+          sscanf(s, "%d", &nthreads);
+          break;
         case 'G':  FIND(Str("no latch"));
           sscanf(s, "%d", &latch);
           displays = 1;
@@ -301,7 +308,8 @@ static int32_t pvanal(CSOUND *csound, int32_t argc, char **argv)
     if (UNLIKELY(pvxanal(csound, p, infd, outfilnam, p->sr,
                         ((!channel || channel == ALLCHNLS) ? p->nchanls : 1),
                         frameSize, frameIncr, frameSize * 2,
-                         WindowType, beta, displays) != 0)) {
+                         WindowType, beta, displays,
+                         util_nthreads(nthreads)) != 0)) {
       csound->Message(csound, "%s", Str("error generating pvocex file.\n"));
       return -1;
     }
@@ -324,6 +332,7 @@ static const char *pvanal_usage_txt[] = {
   Str_noop("    -H: use Hamming window instead of the default (von Hann)"),
   Str_noop("    -K: use Kaiser window"),
   Str_noop("    -B <beta>: parameter for Kaiser window"),
+  Str_noop("    -j <threads>: analyse frames on several threads"),
     NULL
 };
 
@@ -399,27 +408,78 @@ static void PVDisplay_Display(PVDISPLAY *p, int32_t frame)
     p->dispFrame++;
 }
 
+/* Frames waiting to be converted and written.  frame_input() windows
+   each frame into a slot in order; the transforms of a full batch are
+   then done in parallel (-j) and the frames finished and written in
+   the same order as before, so the file does not depend on -j. */
+
+typedef struct {
+    PVX     **pvx;
+    int32_t size, count;        /* slots, slots in use */
+    int32_t *chan;              /* channel of each frame */
+    MYFLT   *anal;              /* N + 2 values per slot */
+    double  *phase;             /* N/2 + 1 input phases per slot */
+    int64_t N, chans, blocks_written;
+    int32_t pvfile, nthreads, displays;
+    float   **frame;
+    PVDISPLAY *disp;
+} PVBATCH;
+
+static int32_t pvx_flush(CSOUND *csound, PVBATCH *b, int32_t tail)
+{
+    int32_t i, k;
+
+    util_parallel(csound, b->nthreads, b->count, frame_spectrum, b);
+    for (i = 0; i < b->count; i++) {
+      k = b->chan[i];
+      if (UNLIKELY(!csound->CheckEvents(csound)))
+        csound->LongJmp(csound, 1);
+      frame_output(b->pvx[k], b->anal + i * (b->N + 2),
+                   b->phase + i * (b->N / 2 + 1), b->frame[k]);
+      if (UNLIKELY(!csound->PVOC_PutFrames(csound, b->pvfile,
+                                           b->frame[k], 1))) {
+        csound->Message(csound,
+                        Str("pvxanal: error writing analysis frames: %s\n"),
+                        csound->PVOC_ErrorString(csound));
+        return 1;
+      }
+      b->blocks_written++;
+      if (b->displays) PVDisplay_Update(b->disp, b->frame[k]);
+      if (!tail) {
+        if ((b->blocks_written/b->chans) % 20 == 0) {
+          csound->Message(csound, "%"PRId64"\n", b->blocks_written/b->chans);
+        }
+        if (b->displays)
+          PVDisplay_Display(b->disp, (int32_t) (b->blocks_written / b->chans));
+      }
+      else if (b->displays && k == b->chans - 1)
+        PVDisplay_Display(b->disp, (int32_t) (b->blocks_written / b->chans));
+    }
+    b->count = 0;
+    return 0;
+}
+
 /* Only supports PVOC_AMP_FREQ format for now */
 
 /* cannot add display code, as we may have 8 channels here...*/
 
 static int32_t pvxanal(CSOUND *csound, SOUNDIN *p, SNDFILE *fd, const char *fname,
                    int64_t srate, int64_t chans, int64_t fftsize, int64_t overlap,
-                   int64_t winsize, pv_wtype wintype, double beta, int32_t displays)
+                   int64_t winsize, pv_wtype wintype, double beta, int32_t displays,
+                   int32_t nthreads)
 {
     int32_t         i, k, pvfile = -1, rc = 0;
     pv_stype    stype = STYPE_16;
     int64_t        buflen, buflen_samps;
     int64_t        sampsread;
-    int64_t        blocks_written = 0;     /* m/c framecount for user */
     PVX         *pvx[MAXPVXCHANS];
     MYFLT       *inbuf_c[MAXPVXCHANS];
     float       *frame_c[MAXPVXCHANS];  /* RWD : MUST be 32bit  */
     MYFLT       *inbuf = NULL;
-    float       *frame;                 /* RWD : MUST be 32bit  */
     MYFLT       *chanbuf;
     int64_t        total_sampsread = 0;
     PVDISPLAY   disp;
+    PVBATCH     batch;
 
     switch (p->format) {
       case AE_SHORT:  stype = STYPE_16; break;
@@ -457,6 +517,23 @@ static int32_t pvxanal(CSOUND *csound, SOUNDIN *p, SNDFILE *fd, const char *fnam
       frame_c[i] = (float*) csound->Malloc(csound,      /* RWD 32bit */
                                            (fftsize + 2) * sizeof(float));
     }
+    /* a few frames per thread, one when running serially */
+    memset(&batch, 0, sizeof(PVBATCH));
+    batch.pvx = pvx;
+    batch.nthreads = nthreads;
+    batch.size = (nthreads > 1 ? nthreads * 4 : 1);
+    batch.N = pvx[0]->N;
+    batch.chans = chans;
+    batch.displays = displays;
+    batch.frame = frame_c;
+    batch.disp = &disp;
+    batch.chan = (int32_t *) csound->Malloc(csound,
+                                            batch.size * sizeof(int32_t));
+    batch.anal = (MYFLT *) csound->Malloc(csound, batch.size * (batch.N + 2)
+                                                  * sizeof(MYFLT));
+    batch.phase = (double *) csound->Malloc(csound, batch.size
+                                                    * (batch.N / 2 + 1)
+                                                    * sizeof(double));
 
     pvfile  = csound->PVOC_CreateFile(csound, fname, fftsize, overlap, chans,
                                               PVOC_AMP_FREQ, srate, stype,
@@ -468,6 +545,7 @@ static int32_t pvxanal(CSOUND *csound, SOUNDIN *p, SNDFILE *fd, const char *fnam
       rc = 1;
       goto error;
     }
+    batch.pvfile = pvfile;
     if (displays)
     PVDisplay_Init(csound, &disp, (int32_t) fftsize,
                    (int32_t) (((int64_t) p->getframes * chans / overlap)
@@ -487,30 +565,19 @@ static int32_t pvxanal(CSOUND *csound, SOUNDIN *p, SNDFILE *fd, const char *fnam
 
       for (i = 0; i < sampsread/chans; i+= overlap) {
         for (k = 0; k < chans; k++) {
-          frame = frame_c[k];
           chanbuf = inbuf_c[k];
-          if (UNLIKELY(!csound->CheckEvents(csound)))
-            csound->LongJmp(csound, 1);
-          generate_frame(csound, pvx[k],chanbuf+i,frame,overlap,PVOC_AMP_FREQ);
-          if (UNLIKELY(!csound->PVOC_PutFrames(csound, pvfile, frame, 1))) {
-            csound->Message(csound,
-                            Str("pvxanal: error writing analysis frames: %s\n"),
-                            csound->PVOC_ErrorString(csound));
-            rc = 1;
+          frame_input(pvx[k], chanbuf+i,
+                      batch.anal + batch.count * (batch.N + 2), overlap);
+          batch.chan[batch.count++] = k;
+          if (batch.count == batch.size && (rc = pvx_flush(csound, &batch, 0)))
             goto error;
-          }
-          blocks_written++;
-          if (displays) PVDisplay_Update(&disp, frame);
-          if ((blocks_written/chans) % 20 == 0) {
-            csound->Message(csound, "%"PRId64"\n", blocks_written/chans);
-          }
-          if (displays)
-            PVDisplay_Display(&disp, (int32_t) (blocks_written / chans));
         }
       }
       if (total_sampsread >= p->getframes*chans)
         break;
     }
+    if ((rc = pvx_flush(csound, &batch, 0)))
+      goto error;
 
     /* write out remaining frames */
     sampsread = fftsize * chans;
@@ -520,25 +587,18 @@ static int32_t pvxanal(CSOUND *csound, SOUNDIN *p, SNDFILE *fd, const char *fnam
     chan_split(csound,inbuf,inbuf_c,sampsread,chans);
     for (i = 0; i < sampsread/chans; i+= overlap) {
       for (k = 0; k < chans; k++) {
-        frame = frame_c[k];
         chanbuf = inbuf_c[k];
-        if (!csound->CheckEvents(csound))
-          csound->LongJmp(csound, 1);
-        generate_frame(csound,pvx[k],chanbuf+i,frame,overlap,PVOC_AMP_FREQ);
-        if (UNLIKELY(!csound->PVOC_PutFrames(csound, pvfile, frame, 1))) {
-          csound->Message(csound,
-                          Str("pvxanal: error writing analysis frames: %s\n"),
-                          csound->PVOC_ErrorString(csound));
-          rc = 1;
+        frame_input(pvx[k], chanbuf+i,
+                    batch.anal + batch.count * (batch.N + 2), overlap);
+        batch.chan[batch.count++] = k;
+        if (batch.count == batch.size && (rc = pvx_flush(csound, &batch, 1)))
           goto error;
-        }
-        blocks_written++;
-        if (displays) PVDisplay_Update(&disp, frame);
       }
-      if (displays) PVDisplay_Display(&disp, (int32_t) (blocks_written / chans));
     }
+    if ((rc = pvx_flush(csound, &batch, 1)))
+      goto error;
     csound->Message(csound, Str("\n%"PRId64" %d-chan blocks written to %s\n"),
-                    (int64_t) blocks_written / (int64_t) chans,
+                    (int64_t) batch.blocks_written / (int64_t) chans,
                     (int32_t) chans, fname);
 
  error:
@@ -707,17 +767,14 @@ static int32_t init(CSOUND *csound,
 
 /* RWD outanal MUST be 32bit */
 
-static int64_t generate_frame(CSOUND *csound, PVX *pvx,
-                                           MYFLT *fbuf, float *outanal,
-                                           int64_t samps, int32_t frametype)
+/* First, serial part of a frame: take in the next 'samps' input samples
+   and leave the windowed and rotated frame in anal (N + 2 values). */
+
+static void frame_input(PVX *pvx, MYFLT *fbuf, MYFLT *anal, int64_t samps)
 {
     int32_t     got, tocp, i, j, k;
     int64_t    N = pvx->N;
-    MYFLT   *fp, *oi, *i0, *i1, real, imag, *anal, angleDif;
-    double  rratio, phase;
-    float   *ofp;           /* RWD MUST be 32bit */
-
-    anal = pvx->anal;
+    MYFLT   *fp;
 
     got = samps;            /* always assume */
     if (got < pvx->Dd)
@@ -775,50 +832,75 @@ static int64_t generate_frame(CSOUND *csound, PVX *pvx,
         k -= N;
       *(anal + k) += *(pvx->analWindow + i) * *(pvx->input + j);
     }
+
+    pvx->nI += pvx->D;                          /* increment time */
+    pvx->Dd = MIN(pvx->D,                       /* CARL */
+                  MAX(0, pvx->D + pvx->nMax - pvx->nI - pvx->analWinLen));
+}
+
+/* Second part, independent of other frames and run in parallel: the
+   transform, magnitudes and input phases of batch slot 'item'. */
+
+static void frame_spectrum(CSOUND *csound, void *data, int item, int thread)
+{
+    PVBATCH *b = (PVBATCH *) data;
+    PVX     *pvx = b->pvx[b->chan[item]];
+    MYFLT   *anal = b->anal + item * (b->N + 2), *i0, real, imag;
+    double  *phase = b->phase + item * (b->N / 2 + 1);
+    int32_t i;
+
+    IGN(thread);
     csound->RealFFTnp2(csound, anal, pvx->N);
+    for (i=0,i0=anal; i <= pvx->N2; i++,i0+=2) {
+      real = *i0;
+      imag = *(i0 + 1);
+      *i0 =(MYFLT) hypot((double)real, (double)imag);
+      if (*i0 >= FL(1.0E-10))
+        phase[i] = atan2((double)imag,(double)real);
+    }
+}
+
+/* Last part, serial again as it carries the phase of each channel from
+   one frame to the next: phase differences and the 32 bit frame. */
+
+static void frame_output(PVX *pvx, MYFLT *anal, const double *phase,
+                         float *outanal)
+{
+    int32_t     i;
+    int64_t    N = pvx->N;
+    MYFLT   *fp, *oi, *i0, *i1, angleDif;
+    float   *ofp;           /* RWD MUST be 32bit */
+
     /* conversion: The real and imaginary values in anal are converted to
        magnitude and angle-difference-per-second (assuming an
        intermediate sampling rate of rIn) and are returned in
        anal. */
-    /* only support this format for now, in Csound */
-    if (frametype == PVOC_AMP_FREQ) {
-      for (i=0,i0=anal,i1=anal+1,oi=pvx->oldInPhase;
-           i <= pvx->N2;
-           i++,i0+=2,i1+=2, oi++) {
-        real = *i0;
-        imag = *i1;
-        *i0 =(MYFLT) hypot((double)real, (double)imag);
-        /* phase unwrapping */
-        /*if (*i0 == 0.)*/
-        if (*i0 < FL(1.0E-10))        /* RWD don't mess with v small numbers! */
-          angleDif = FL(0.0);
-
-        else {
-          rratio = atan2((double)imag,(double)real);
-          angleDif  = (MYFLT)((phase = rratio) - *oi);
-          *oi = (MYFLT) phase;
-        }
+    /* only support PVOC_AMP_FREQ for now, in Csound */
+    for (i=0,i0=anal,i1=anal+1,oi=pvx->oldInPhase;
+         i <= pvx->N2;
+         i++,i0+=2,i1+=2, oi++) {
+      /* phase unwrapping */
+      /*if (*i0 == 0.)*/
+      if (*i0 < FL(1.0E-10))        /* RWD don't mess with v small numbers! */
+        angleDif = FL(0.0);
+
+      else {
+        angleDif  = (MYFLT)(phase[i] - *oi);
+        *oi = (MYFLT) phase[i];
+      }
 
-        if (angleDif > PI)
-          angleDif = (MYFLT)(angleDif - TWOPI);
-        if (angleDif < -PI)
-          angleDif = (MYFLT)(angleDif + TWOPI);
+      if (angleDif > PI)
+        angleDif = (MYFLT)(angleDif - TWOPI);
+      if (angleDif < -PI)
+        angleDif = (MYFLT)(angleDif + TWOPI);
 
-        /* add in filter center freq.*/
-        *i1 = angleDif * pvx->RoverTwoPi + ((MYFLT) i * pvx->Fexact);
-      }
+      /* add in filter center freq.*/
+      *i1 = angleDif * pvx->RoverTwoPi + ((MYFLT) i * pvx->Fexact);
     }
-    /* else must be PVOC_COMPLEX */
     fp = anal;
     ofp = outanal;
     for (i=0;i < N+2;i++)
       *ofp++ = (float) *fp++;  /* RWD need 32bit cast incase MYFLT is double */
-
-    pvx->nI += pvx->D;                          /* increment time */
-    pvx->Dd = MIN(pvx->D,                       /* CARL */
-                  MAX(0, pvx->D + pvx->nMax - pvx->nI - pvx->analWinLen));
-
-    return pvx->D;
 }
 
 static void chan_split(CSOUND *csound, const MYFLT *inbuf, MYFLT **chbuf,
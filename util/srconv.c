@@ -39,19 +39,24 @@
  *                    R = input sample rate (must be specified)
  *                    P = input sample rate / output sample rate
  *                    Q = quality factor (1 to 8: default = 2)
+ *                    j = number of threads (default: one per channel)
  *                    if a time-varying control file is given, it must be last
  *
  *    MODIFIED:  John ffitch December 2000; changes to Csound context
+ *               The filtering now uses the polyphase kernels of
+ *               OOps/resample.c, with channels and segments of the
+ *               output converted in parallel.
  */
 
 #include "std_util.h"
 #include "soundio.h"
+#include "resample.h"
 #include <math.h>
 #include <ctype.h>
 
 #define IBUF    (4096)
-#define IBUF2   (IBUF/2)
 #define OBUF    (4096)
+#define MAXTHREADS (64)
 
 #define FIND(MSG)                                                   \
 {                                                                   \
@@ -61,9 +66,6 @@
       }                                                             \
 }
 
-//static  void    kaiser(int, float *, int, int, double);
-
-#if 0
 static  void    usage(CSOUND *);
 
 static int writebuffer(CSOUND *csound, MYFLT *out_buf, int *block,
@@ -143,71 +145,87 @@ static void dieu(CSOUND *csound, char *s)
     usage(csound);
 }
 
-static int srconv(CSOUND *csound, int argc, char **argv)
+/* one unit of work: a range of output frames of one channel */
+
+typedef struct {
+    const RESAMPLER *r;
+    const MYFLT *in;            /* first sample of the channel */
+    const double *pos;          /* input position of each output frame */
+    MYFLT   *out;               /* first output sample of the range */
+    int32_t nin, nout, chans;
+} SRCJOB;
+
+typedef struct {
+    SRCJOB  *job;
+    int     njobs, first, step;
+} SRCTHREAD;
+
+static uintptr_t srconv_thread(void *arg)
 {
-    MYFLT
-      *input,     /* pointer to start of input buffer */
-      *output,    /* pointer to start of output buffer */
-      *nextIn,    /* pointer to next empty word in input */
-      *nextOut,   /* pointer to next empty word in output */
-      *fxval = 0, /* pointer to startb of time-array for time-vary function */
-      *fyval = 0, /* pointer to start of P-scale-array for time-vary func */
-      *i0,        /* pointer */
-      *i1;        /* pointer */
-
-    float
-      *window,    /* pointer to center of analysis window */
-      *wj,        /* pointer to window */
-      *wj1;       /* pointer to window */
+    SRCTHREAD *t = (SRCTHREAD*) arg;
+    int       i;
 
-    int
-      M = 2401,   /* length of window impulse response */
-      N = 120,    /* length of sinc period */
-      L = 120,    /* internal sample rate is L*Rin */
-      m,          /* current input sample in buffer */
-      o,          /* current input at L*Rin mod L */
-      del,        /* increment */
-      WinLen,     /* half-length of window at L*Rin */
-      wLen,       /* half-length of window at Rin */
-      jMin,       /* initial offset in window */
-      mMax;       /* maximum valid m */
-
-    long
-      n,                        /* current input sample */
-      nMax = 2000000000;        /* last input sample (unless EOF) */
+    for (i = t->first; i < t->njobs; i += t->step) {
+      SRCJOB *j = &t->job[i];
+      resamp_gather(j->r, j->in, j->nin, j->chans, j->pos,
+                    j->out, j->nout, j->chans);
+    }
+    return 0;
+}
+
+/* time-varying ratio: linear interpolation of (time, ratio) pairs */
+
+static MYFLT tv_ratio(const MYFLT *fxval, const MYFLT *fyval, int tvlen,
+                      int *seg, MYFLT time)
+{
+    while (*seg < tvlen - 1 && time >= fxval[*seg + 1])
+      (*seg)++;
+    if (*seg >= tvlen - 1)
+      return fyval[tvlen - 1];
+    return fyval[*seg] + (fyval[*seg + 1] - fyval[*seg])
+                         * (time - fxval[*seg])
+                         / (fxval[*seg + 1] - fxval[*seg]);
+}
 
+static int srconv(CSOUND *csound, int argc, char **argv)
+{
     MYFLT
-      beta = FL(6.8),           /* parameter for Kaiser window */
-      sum,                      /* scale factor for renormalizing windows */
-      fdel,                     /* float del */
-      idel,                     /* float del */
-      fo,                       /* float o */
-      of,                       /* fractional o */
-      fL = (MYFLT) L,           /* float L */
-      iw,                       /* interpolated window */
-      tvx0 = 0,                 /* current x value of time-var function */
-      tvx1 = 0,                 /* next x value of time-var function */
-      tvdx,                     /* tvx1 - tvx0 */
-      tvy0 = 0,                 /* current y value of time-var function */
-      tvy1 = 0,                 /* next y value of time-var function */
-      tvdy,                     /* tvy1 - tvy0 */
-      tvslope = 0,              /* tvdy / tvdx */
-      time,                     /* n / Rin */
-      invRin,                   /* 1. / Rin */
+      *input = NULL,            /* whole input file, interleaved */
+      *output = NULL,           /* whole output file, interleaved */
+      *fxval = NULL,            /* time values of time-vary function */
+      *fyval = NULL,            /* ratio values of time-vary function */
       P = FL(0.0),              /* Rin / Rout */
+      Pmax,                     /* largest ratio, sets the filter cutoff */
       Rin = FL(0.0),            /* input sampling rate */
-      Rout = FL(0.0);           /* output sample rate */
+      Rout = FL(0.0),           /* output sample rate */
+      scl;
+
+    double
+      *pos = NULL,              /* input position of each output frame */
+      x;
+
+    int32_t
+      nin = 0,                  /* input frames */
+      nout,                     /* output frames */
+      nalloc,
+      taps,
+      seglen;
 
     int
-      i,k,                      /* index variables */
-      nread,                    /* number of bytes read */
+      i, j,
+      nread,
       tvflg = 0,                /* flag for time-varying time-scaling */
-      tvnxt = 0,                /* counter for stepping thru time-var func */
-      tvlen,                    /* length of time-varying function */
+      tvlen = 0,                /* length of time-varying function */
+      tvseg = 0,
       Chans = 1,                /* number of channels */
-      chan,                     /* current channel */
-      Q = 2;                    /* quality factor */
-
+      Q = 2,                    /* quality factor */
+      nthreads = 0,             /* worker threads, 0: one per channel */
+      nsegs, njobs;
+
+    RESAMPLER   *r = NULL;
+    SRCJOB      *job = NULL;
+    SRCTHREAD   thr[MAXTHREADS];
+    void        *tid[MAXTHREADS];
     FILE        *tvfp = NULL;   /* time-vary function file */
     SOUNDIN     *p;
     int         channel = ALLCHNLS;
@@ -223,8 +241,8 @@ static int srconv(CSOUND *csound, int argc, char **argv)
     int         block = 0;
     char        err_msg[256];
 
+    memset(&O, 0, sizeof(OPARMS));
     O.outformat = AE_SHORT;
-    /* csound->e0dbfs = csound->dbfs_to_float = FL(1.0);*/
 
     if ((envoutyp = csound->GetEnv(csound, "SFOUTYP")) != NULL) {
       if (strcmp(envoutyp, "AIFF") == 0)
@@ -305,6 +323,11 @@ static int srconv(CSOUND *csound, int argc, char **argv)
             sscanf(s,"%d", &Q);
             while (*++s);
             break;
+          case 'j':
+            FIND(Str("No j argument"))
+            sscanf(s,"%d", &nthreads);
+            while (*++s);
+            break;
           case 'P':
             FIND(Str("No P argument"))
 #if defined(USE_DOUBLE)
@@ -356,12 +379,8 @@ static int srconv(CSOUND *csound, int argc, char **argv)
       csound->ErrorMsg(csound, Str("error while opening %s"), infile);
       return -1;
     }
-    if (Rin == FL(0.0))
-      Rin = (MYFLT)p->sr;
-    if (Chans == 0)
-      Chans = (int) p->nchanls;
-    if (Chans == 0)
-      Chans = 1;
+    Rin = (MYFLT)p->sr;
+    Chans = (p->nchanls > 0 ? (int) p->nchanls : 1);
 
     if ((P != FL(0.0)) && (Rout != FL(0.0))) {
       strNcpy(err_msg, Str("srconv: cannot specify both -r and -P"), 256);
@@ -371,9 +390,10 @@ static int srconv(CSOUND *csound, int argc, char **argv)
       Rout = Rin / P;
     else if (Rout == FL(0.0))
       Rout = Rin;
+    P = Rin / Rout;
+    Pmax = P;
 
     if (tvflg) {
-      P = FL(0.0);        /* will be reset to max in time-vary function */
       if ((tvfp = fopen(bfile, "r")) == NULL) {
         strNcpy(err_msg,
                 Str("srconv: cannot open time-vary function file"), 256);
@@ -383,64 +403,47 @@ static int srconv(CSOUND *csound, int argc, char **argv)
       (void) csound->CreateFileHandle(csound, &tvfp, CSFILE_STD, bfile);
       if (UNLIKELY(fscanf(tvfp, "%d", &tvlen) != 1))
         csound->Message(csound, "%s", Str("Read failure\n"));
-      if (UNLKELY(tvlen <= 0)) {
-            strNcpy(err_msg, Str("srconv: tvlen <= 0 "), 256);
-            goto err_rtn_msg;
-       }
+      if (UNLIKELY(tvlen <= 0)) {
+        strNcpy(err_msg, Str("srconv: tvlen <= 0 "), 256);
+        goto err_rtn_msg;
+      }
       fxval = (MYFLT*) csound->Malloc(csound, tvlen * sizeof(MYFLT));
       fyval = (MYFLT*) csound->Malloc(csound, tvlen * sizeof(MYFLT));
-      i0 = fxval;
-      i1 = fyval;
-      for (i = 0; i < tvlen; i++, i0++, i1++) {
+      Pmax = FL(0.0);
+      for (i = 0; i < tvlen; i++) {
 #ifdef USE_DOUBLE
-        if ((fscanf(tvfp, "%lf %lf", i0, i1)) != 2)
+        if ((fscanf(tvfp, "%lf %lf", &fxval[i], &fyval[i])) != 2)
 #else
-        if ((fscanf(tvfp, "%f %f", i0, i1)) != 2)
+        if ((fscanf(tvfp, "%f %f", &fxval[i], &fyval[i])) != 2)
 #endif
           {
             strNcpy(err_msg, Str("srconv: too few x-y pairs "
                                  "in time-vary function file"), 256);
             goto err_rtn_msg;
           }
-        if (*i1 > P)
-          P = *i1;
+        if (fyval[i] <= FL(0.0)) {
+          strNcpy(err_msg, Str("srconv: invalid initial y value "
+                               "in time-vary function"), 256);
+          goto err_rtn_msg;
+        }
+        if (i > 0 && fxval[i] <= fxval[i - 1]) {
+          strNcpy(err_msg,
+                  Str("srconv: invalid x values in time-vary function"), 256);
+          goto err_rtn_msg;
+        }
+        if (fyval[i] > Pmax)
+          Pmax = fyval[i];
       }
-      Rout = Rin / P;    /* this is min Rout */
-      tvx0 = fxval[0];
-      tvx1 = fxval[1];
-      tvy0 = fyval[0];
-      tvy1 = fyval[1];
-      tvdx = tvx1 - tvx0;
-      if (tvx0 != FL(0.0)) {
+      if (fxval[0] != FL(0.0)) {
         strNcpy(err_msg, Str("srconv: first x value "
                              "in time-vary function must be 0"), 256);
         goto err_rtn_msg;
       }
-      if (tvy0 <= FL(0.0)) {
-        strNcpy(err_msg, Str("srconv: invalid initial y value "
-                             "in time-vary function"),256);
-        goto err_rtn_msg;
-      }
-      if (tvdx <= FL(0.0)) {
-        strNcpy(err_msg,
-                       Str("srconv: invalid x values in time-vary function"),
-                       256);
-        goto err_rtn_msg;
-      }
-      tvdy = tvy1 - tvy0;
-      tvslope = tvdy / tvdx;
-      tvnxt = 1;
-    }
-    /* This is not right *********  */
-    if (P != FL(0.0)) {
-      csound->SetUtilSr(csound,Rin);
-    }
-    if (P == FL(0.0)) {
-      csound->SetUtilSr(csound,Rout);
+      Rout = Rin / Pmax;    /* this is min Rout */
     }
 
     if (O.outformat == 0)
-      O.outformat = AE_SHORT;//p->format;
+      O.outformat = AE_SHORT;
     O.sfsampsize = csound->sfsampsize(FORMAT2SF(O.outformat));
     if (O.filetyp == TYP_RAW) {
       O.sfheader = 0;
@@ -448,12 +451,6 @@ static int srconv(CSOUND *csound, int argc, char **argv)
     }
     else
       O.sfheader = 1;
-#ifdef NeXT
-    if (O.outfilename == NULL && !O.filetyp)
-      O.outfilename = "test.snd";
-    else if (O.outfilename == NULL)
-      O.outfilename = "test";
-#else
     if (O.outfilename == NULL) {
       if (O.filetyp == TYP_WAV)
         O.outfilename = "test.wav";
@@ -462,14 +459,12 @@ static int srconv(CSOUND *csound, int argc, char **argv)
       else
         O.outfilename = "test";
     }
-#endif
     {
       SF_INFO sfinfo;
       char    *name;
       memset(&sfinfo, 0, sizeof(SF_INFO));
       sfinfo.samplerate = (int) ((double) Rout + 0.5);
-      sfinfo.channels = (int) p->nchanls;
-      //printf("filetyp=%x outformat=%x\n", O.filetyp, O.outformat);
+      sfinfo.channels = Chans;
       sfinfo.format = TYPE2SF(O.filetyp) | FORMAT2SF(O.outformat);
       if (strcmp(O.outfilename, "stdout") != 0) {
         name = csound->FindOutputFile(csound, O.outfilename, "SFDIR");
@@ -484,7 +479,8 @@ static int srconv(CSOUND *csound, int argc, char **argv)
                                                            O.outformat),
                                    1, 0);
         else {
-          snprintf(err_msg, 256, Str("libsndfile error: %s\n"), sf_strerror(NULL));
+          snprintf(err_msg, 256, Str("libsndfile error: %s\n"),
+                   sf_strerror(NULL));
           goto err_rtn_msg;
         }
         csound->Free(csound, name);
@@ -500,8 +496,8 @@ static int srconv(CSOUND *csound, int argc, char **argv)
                                       O.outfilename);
       sf_command(outfd, SFC_SET_CLIPPING, NULL, SF_TRUE);
     }
-    csound->SetUtilSr(csound, (MYFLT)p->sr);
-    csound->SetUtilNchnls(csound, Chans = p->nchanls);
+    csound->SetUtilSr(csound, Rin);
+    csound->SetUtilNchnls(csound, Chans);
 
     outbufsiz = OBUF * O.sfsampsize;                   /* calc outbuf size */
     csound->Message(csound, Str("writing %d-byte blks of %s to %s"),
@@ -509,277 +505,125 @@ static int srconv(CSOUND *csound, int argc, char **argv)
                     O.outfilename);
     csound->Message(csound, " (%s)\n", csound->type2string(O.filetyp));
 
- /* this program performs arbitrary sample-rate conversion
-    with high fidelity.  the method is to step through the
-    input at the desired sampling increment, and to compute
-    the output points as appropriately weighted averages of
-    the surrounding input points.  there are two cases to
-    consider: 1) sample rates are in a small-integer ratio -
-    weights are obtained from table, 2) sample rates are in
-    a large-integer ratio - weights are linearly
-    interpolated from table.  */
-
- /* calculate increment: if decimating, then window is impulse response of low-
-    pass filter with cutoff frequency at half of Rout; if interpolating,
-    then window is ipulse response of lowpass filter with cutoff frequency
-    at half of Rin. */
-
-    fdel = ((MYFLT) (L * Rin) / Rout);
-    del = (int) ((double) fdel + 0.5);
-    idel = (MYFLT) del;
-    if (del > L)
-      N = del;
-    if ((Q >= 1) && (Q <= 8))
-      M = Q * N * 10 + 1;
-    if (tvflg)
-      fdel = tvy0 * L;
-
-    invRin  =  FL(1.0) / Rin;
-
-    /* make window: the window is the product of a kaiser and a sin(x)/x */
-    window = (float*) csound->Calloc(csound, (size_t) (M + 2) * sizeof(float));
-    WinLen = (M-1)/2;
-    window += WinLen;
-    wLen = (M/2 - L) / L;
-
-    kaiser(M, window, WinLen, 1, (double) beta);
-
-    for (i = 1; i <= WinLen; i++) {
-      double  tmp = (double) N;
-      tmp = tmp * sin(PI * (double) i / tmp) / (PI * (double) i);
-      window[i] = (float) ((double) window[i] * tmp);
-    }
-
-    if (Rout < Rin) {
-#if 0
-      sum = (MYFLT) window[0];
-      for (i = L-1; i <= WinLen; i += L)
-        sum += (MYFLT) window[i];
-      sum = FL(2.0) / sum;
-#else
-      sum = Rout / (Rin * (MYFLT) window[0]);
-#endif
-    }
-    else
-      sum = FL(1.0) / (MYFLT) window[0];
-
-    window[0] = (float) ((double) window[0] * (double) sum);
-    for (i = 1; i <= WinLen; i++) {
-      window[i] = (float) ((double) window[i] * (double) sum);
-      *(window - i) = window[i];
+ /* read the whole input: every output frame may need any input frame
+    when the ratio is time-varying, and it lets the channels and
+    segments below be converted independently */
+
+    nalloc = IBUF;
+    input = (MYFLT*) csound->Malloc(csound, (size_t) nalloc * Chans
+                                            * sizeof(MYFLT));
+    scl = FL(1.0) / csound->Get0dBFS(csound);
+    while ((nread = csound->getsndin(csound, inf, input + (size_t) nin * Chans,
+                                     IBUF * Chans, p)) > 0) {
+      for (i = 0; i < nread; i++)
+        input[(size_t) nin * Chans + i] *= scl;
+      nin += nread / Chans;
+      if (nread < IBUF * Chans)
+        break;
+      if (nin + IBUF > nalloc) {
+        nalloc *= 2;
+        input = (MYFLT*) csound->ReAlloc(csound, input, (size_t) nalloc
+                                         * Chans * sizeof(MYFLT));
+      }
     }
 
-    window[WinLen + 1] = 0.0f;
-
- /* set up input buffer:  nextIn always points to the next empty
-    word in the input buffer.  If the buffer is full, then
-    nextIn jumps back to the beginning, and the old values
-    are written over. */
-
-    input = (MYFLT*) csound->Calloc(csound, (size_t) IBUF * sizeof(MYFLT));
-
- /* set up output buffer:  nextOut always points to the next empty
-    word in the output buffer.  If the buffer is full, then
-    it is flushed, and nextOut jumps back to the beginning. */
-
-    output = (MYFLT*) csound->Calloc(csound, (size_t) OBUF * sizeof(MYFLT));
-    nextOut = output;
-
- /* initialization: */
-
-    nread = csound->getsndin(csound, inf, input, IBUF2, p);
-    for(i=0; i < nread; i++)
-       input[i] *= 1.0/csound->Get0dBFS(csound);
-    nMax = (long)(input_dur * p->sr);
-    nextIn = input + nread;
-    for (i = nread; i < IBUF2; i++)
-      *(nextIn++) = FL(0.0);
-    jMin = -(wLen + 1) * L;
-    mMax = IBUF2;
-    o = n = m = 0;
-    fo = FL(0.0);
-
- /* main loop:   If nMax is not specified it is assumed to be very large
-    and then readjusted when read detects the end of input. */
-
-    while (n < nMax) {
-
-      time = n * invRin;
-
-      /* case 1:  (Rin / Rout) * 120 = integer  */
+ /* input position of each output frame */
 
-      if ((tvflg == 0) && (idel == fdel)) {
-        /* apply window (window is sampled at L * Rin) */
-
-        for (chan = 0; chan < Chans; chan++) {
-          *nextOut = FL(0.0);
-          k = Chans * (m - wLen) + chan - Chans;
-          if (k < 0)
-            k += IBUF;
-          wj = window + jMin - o;
-          for (i = -wLen; i <= wLen+1; i++){
-            wj += L;
-            k += Chans;
-            if (k >= IBUF)
-              k -= IBUF;
-            *nextOut += (MYFLT) *wj * *(input + k);
-          }
-          nextOut++;
-          if (nextOut >= (output + OBUF)) {
-            nextOut = output;
-            writebuffer(csound, output, &block, outfd, OBUF, &O);
-          }
-        }
-
-        /* move window (window advances by del samples at L*Rin sample rate) */
-
-        o += del;
-        while (o >= L) {
-          o -= L;
-          n++;
-          m++;
-          if ((Chans * (m + wLen + 1)) >= mMax) {
-            if (!csound->CheckEvents(csound))
-              csound->LongJmp(csound, 1);
-            mMax += IBUF2;
-            if (nextIn >= (input + IBUF))
-              nextIn = input;
-            nread = csound->getsndin(csound, inf, nextIn, IBUF2, p);
-            for(i=0; i < nread; i++)
-               input[i] *= 1.0/csound->Get0dBFS(csound);
-            nextIn += nread;
-            if (nread < IBUF2)
-              nMax = n + wLen + (nread / Chans) + 1;
-            for (i = nread; i < IBUF2; i++)
-              *(nextIn++) = FL(0.0);
-          }
-          if ((Chans * m) >= IBUF) {
-            m = 0;
-            mMax = IBUF2;
-          }
-        }
+    nalloc = (int32_t) ((double) nin / (double) (tvflg ? FL(1.0) : P)) + 16;
+    pos = (double*) csound->Malloc(csound, (size_t) nalloc * sizeof(double));
+    for (nout = 0, x = 0.0; x < (double) nin; nout++) {
+      if (nout >= nalloc) {
+        nalloc *= 2;
+        pos = (double*) csound->ReAlloc(csound, pos, (size_t) nalloc
+                                                     * sizeof(double));
       }
+      pos[nout] = x;
+      if (tvflg)
+        P = tv_ratio(fxval, fyval, tvlen, &tvseg, (MYFLT) (x / (double) Rin));
+      x += (double) P;
+    }
 
-      /* case 2: (Rin / Rout) * 120 = non-integer constant */
-
-      else {
-
-        /* apply window (window values are linearly interpolated) */
-
-        for (chan = 0; chan < Chans; chan++) {
-          *nextOut = FL(0.0);
-          o = (int)fo;
-          of = fo - o;
-          wj = window + jMin - o;
-          wj1 = wj + 1;
-          k = Chans * (m - wLen) + chan - Chans;
-          if (k < 0)
-            k += IBUF;
-          for (i = -wLen; i <= wLen+1; i++) {
-            wj += L;
-            wj1 += L;
-            k += Chans;
-            if (k >= IBUF)
-              k -= IBUF;
-            iw = (MYFLT) *wj + of * ((MYFLT) *wj1 - (MYFLT) *wj);
-            *nextOut += iw * *(input + k);
-          }
-          nextOut++;
-          if (nextOut >= (output + OBUF)) {
-            nextOut = output;
-            writebuffer(csound, output, &block, outfd, OBUF, &O);
-          }
-        }
-
-        /* move window */
-
-        fo += fdel;
-        while (fo >= fL) {
-          fo -= fL;
-          n++;
-          m++;
-          if ((Chans * (m + wLen + 1)) >= mMax) {
-            if (!csound->CheckEvents(csound))
-              csound->LongJmp(csound, 1);
-            mMax += IBUF2;
-            if (nextIn >= (input + IBUF))
-              nextIn = input;
-            nread = csound->getsndin(csound, inf, nextIn, IBUF2, p);
-            for(i=0; i < nread; i++)
-               input[i] *= 1.0/csound->Get0dBFS(csound);
-            nextIn += nread;
-            if (nread < IBUF2)
-              nMax = n + wLen + (nread / Chans) + 1;
-            for (i = nread; i < IBUF2; i++)
-              *(nextIn++) = FL(0.0);
-          }
-          if ((Chans * m) >= IBUF) {
-            m = 0;
-            mMax = IBUF2;
-          }
-        }
-
-        if (tvflg && (time > FL(0.0))) {
-          while (tvflg && (time >= tvx1)) {
-            if (++tvnxt >= tvlen)
-              tvflg = 0;
-            else {
-              tvx0 = tvx1;
-              tvx1 = fxval[tvnxt];
-              tvy0 = tvy1;
-              tvy1 = fyval[tvnxt];
-              tvdx = tvx1 - tvx0;
-              if (tvdx <= FL(0.0)) {
-                strNcpy(err_msg, Str("srconv: invalid x values "
-                                     "in time-vary function"), 256);
-                goto err_rtn_msg;
-              }
-              tvdy = tvy1 - tvy0;
-              tvslope = tvdy / tvdx;
-            }
-          }
-          P = tvy0 + tvslope * (time - tvx0);
-          fdel = (MYFLT) L * P;
-        }
+ /* when decimating, the kernel is the impulse response of a low-pass
+    filter at half of the lowest Rout, and is widened to keep the
+    same transition band relative to the output */
+
+    taps = (int32_t) (16 * ((Q >= 1 && Q <= 8) ? Q : 2)
+                      * (Pmax > FL(1.0) ? Pmax : FL(1.0)));
+    r = resamp_new(csound, taps, (Pmax > FL(1.0) ? FL(1.0) / Pmax : FL(1.0)));
+
+    output = (MYFLT*) csound->Malloc(csound, (size_t) (nout > 0 ? nout : 1)
+                                             * Chans * sizeof(MYFLT));
+    if (nthreads <= 0)
+      nthreads = Chans;
+    if (nthreads > MAXTHREADS)
+      nthreads = MAXTHREADS;
+    nsegs = (nthreads + Chans - 1) / Chans;
+    seglen = (nout + nsegs - 1) / nsegs;
+    job = (SRCJOB*) csound->Calloc(csound, (size_t) nsegs * Chans
+                                           * sizeof(SRCJOB));
+    for (njobs = 0, i = 0; i < nsegs; i++) {
+      int32_t start = i * seglen;
+      if (start >= nout)
+        break;
+      for (j = 0; j < Chans; j++, njobs++) {
+        job[njobs].r = r;
+        job[njobs].in = input + j;
+        job[njobs].nin = nin;
+        job[njobs].chans = Chans;
+        job[njobs].pos = pos + start;
+        job[njobs].out = output + (size_t) start * Chans + j;
+        job[njobs].nout = (start + seglen <= nout ? seglen : nout - start);
       }
+    }
+    if (nthreads > njobs)
+      nthreads = (njobs > 0 ? njobs : 1);
+    for (i = 0; i < nthreads; i++) {
+      thr[i].job = job;
+      thr[i].njobs = njobs;
+      thr[i].first = i;
+      thr[i].step = nthreads;
+    }
+    for (i = 1; i < nthreads; i++)
+      tid[i] = csound->CreateThread(srconv_thread, &thr[i]);
+    srconv_thread(&thr[0]);
+    for (i = 1; i < nthreads; i++) {
+      if (tid[i] != NULL)
+        csound->JoinThread(tid[i]);
+      else
+        srconv_thread(&thr[i]);     /* could not start it: do it here */
+    }
 
+    for (i = 0; i < nout * Chans; i += OBUF) {
+      if (!csound->CheckEvents(csound))
+        csound->LongJmp(csound, 1);
+      writebuffer(csound, output + i, &block, outfd,
+                  (nout * Chans - i < OBUF ? nout * Chans - i : OBUF), &O);
     }
-    nread = nextOut - output;
-    writebuffer(csound, output, &block, outfd, nread, &O);
     csound->Message(csound, "\n\n");
     if (O.ringbell)
       csound->MessageS(csound, CSOUNDMSG_REALTIME, "\a");
+    resamp_free(csound, r);
+    csound->Free(csound, job);
+    csound->Free(csound, output);
+    csound->Free(csound, pos);
+    csound->Free(csound, input);
+    csound->Free(csound, fxval);
+    csound->Free(csound, fyval);
     return 0;
 
  err_rtn_msg:
     csound->ErrorMsg(csound, err_msg);
+    csound->Free(csound, fxval);
+    csound->Free(csound, fyval);
     return -1;
 }
-#else
-
-#ifndef WIN32
-#include <unistd.h>
-#endif
-
-static int srconv(CSOUND *csound, int argc, char **argv)
-{
-  (void) argc;
-    csound->Message(csound, "%s",
-                    Str("Do not use srconv but the src_conv program\n"));
-#ifndef MSVC
-    return execv("src_conv", argv);
-#else
-    return 0;
-#endif
-}
-#endif
 
-#if 0
 static const char *usage_txt[] = {
   Str_noop("usage: srconv [flags] infile\n\nflags:"),
   Str_noop("-P num\tpitch transposition ratio (srate/r) [do not specify "
            "both P and r]"),
   Str_noop("-Q num\tquality factor (1 to 8: default = 2)"),
+  Str_noop("-j num\tnumber of threads (default: one per channel)"),
   Str_noop("-i filnam\tbreak file"),
   Str_noop("-r num\toutput sample rate (must be specified)"),
   Str_noop("-o fnam\tsound output filename\n"),
@@ -811,54 +655,6 @@ static void usage(CSOUND *csound)
       csound->Message(csound, "%s\n", Str(usage_txt[i]));
 }
 
-static double ino(double x)
-{
-    double  y, t, e, de, sde, xi;
-    int     i;
-
-    y = x * 0.5;
-    t = 1.0e-08;
-    e = 1.0;
-    de = 1.0;
-    for (i = 1; i <= 25; i++) {
-      xi = (double) i;
-      de = de * y / xi;
-      sde = de * de;
-      e += sde;
-      if (e * t > sde)
-        break;
-    }
-    return e;
-}
-
-static void kaiser(int nf, float *w, int n, int ieo, double beta)
-{
-
-/*
-   nf = filter length in samples
-    w = window array of size n
-    n = filter half length=(nf+1)/2
-  ieo = even odd indicator--ieo=0 if nf even
- beta = parameter of kaiser window
-*/
-
-    double  bes, xind, xi;
-    int     i;
-
-    bes = ino(beta);
-    xind = (double) ((nf - 1) * (nf - 1));
-
-    for (i = 0; i < n; i++) {
-      xi = (double) i;
-      if (ieo == 0)
-        xi += 0.5;
-      xi = 4.0 * xi * xi;
-      xi = sqrt(1.0 - (double) (xi / xind));
-      w[i] = (float) (ino(beta * xi) / bes);
-    }
-}
-#endif
-
 /* module interface */
 
 int srconv_init_(CSOUND *csound)